@@ -318,6 +318,12 @@ ifneq ($(seqfail), 0)
     CFLAGS += -DCONFIG_SEQFAIL
 endif
 
+jit ?= 0
+
+ifneq ($(jit), 0)
+    CFLAGS += -DCONFIG_JIT
+endif
+
 mad_gc ?= 0
 
 ifneq ($(mad_gc), 0)
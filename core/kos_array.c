@@ -125,6 +125,9 @@ KOS_OBJ_ID KOS_new_array(KOS_CONTEXT ctx,
                 array = OBJPTR(ARRAY, saved_array.o);
 
                 KOS_atomic_write_relaxed_ptr(array->data, OBJID(ARRAY_STORAGE, storage));
+
+                /* The array could have survived GC while allocating storage */
+                kos_write_barrier(saved_array.o);
             }
             else
                 array = KOS_NULL;
@@ -222,6 +225,9 @@ static void copy_buf(KOS_CONTEXT        ctx,
     (void)KOS_atomic_cas_strong_ptr(array->data,
                                     OBJID(ARRAY_STORAGE, old_buf),
                                     OBJID(ARRAY_STORAGE, new_buf));
+
+    kos_write_barrier(OBJID(ARRAY_STORAGE, new_buf));
+    kos_write_barrier(OBJID(ARRAY, array));
 }
 
 KOS_OBJ_ID KOS_array_read(KOS_CONTEXT ctx, KOS_OBJ_ID obj_id, int idx)
@@ -294,6 +300,7 @@ int KOS_array_write(KOS_CONTEXT ctx, KOS_OBJ_ID obj_id, int idx, KOS_OBJ_ID valu
                     buf = new_buf;
                 }
                 else if (KOS_atomic_cas_weak_ptr(buf->buf[bufidx], cur, value)) {
+                    kos_write_barrier(OBJID(ARRAY_STORAGE, buf));
                     error = KOS_SUCCESS;
                     break;
                 }
@@ -347,6 +354,7 @@ KOS_OBJ_ID KOS_array_cas(KOS_CONTEXT ctx,
                     break;
                 }
                 else if (KOS_atomic_cas_weak_ptr(buf->buf[bufidx], cur, new_value)) {
+                    kos_write_barrier(OBJID(ARRAY_STORAGE, buf));
                     retval = cur;
                     break;
                 }
@@ -378,10 +386,14 @@ static int resize_storage(KOS_CONTEXT ctx,
 
         atomic_fill_ptr(&new_buf->buf[0], KOS_atomic_read_relaxed_u32(new_buf->capacity), TOMBSTONE);
 
-        if ( ! old_buf)
+        if ( ! old_buf) {
             (void)KOS_atomic_cas_strong_ptr(OBJPTR(ARRAY, array.o)->data, KOS_BADPTR, OBJID(ARRAY_STORAGE, new_buf));
-        else if (KOS_atomic_cas_strong_ptr(old_buf->next, KOS_BADPTR, OBJID(ARRAY_STORAGE, new_buf)))
+            kos_write_barrier(array.o);
+        }
+        else if (KOS_atomic_cas_strong_ptr(old_buf->next, KOS_BADPTR, OBJID(ARRAY_STORAGE, new_buf))) {
+            kos_write_barrier(OBJID(ARRAY_STORAGE, old_buf));
             copy_buf(ctx, OBJPTR(ARRAY, array.o), old_buf, new_buf);
+        }
         else {
             KOS_ARRAY_STORAGE *const buf = get_next(old_buf);
 
@@ -411,6 +423,35 @@ int kos_array_copy_storage(KOS_CONTEXT ctx,
     return resize_storage(ctx, obj_id, capacity);
 }
 
+KOS_OBJ_ID kos_array_clone(KOS_CONTEXT ctx,
+                           KOS_OBJ_ID  obj_id)
+{
+    KOS_LOCAL      src;
+    KOS_OBJ_ID     array_obj;
+    const uint32_t size = KOS_get_array_size(obj_id);
+
+    assert( ! IS_BAD_PTR(obj_id));
+    assert(GET_OBJ_TYPE(obj_id) == OBJ_ARRAY);
+
+    KOS_init_local_with(ctx, &src, obj_id);
+
+    /* Small arrays are allocated together with their storage */
+    array_obj = KOS_new_array(ctx, size);
+
+    if ( ! IS_BAD_PTR(array_obj) && size) {
+        KOS_ATOMIC(KOS_OBJ_ID) *const src_buf = kos_get_array_buffer(OBJPTR(ARRAY, src.o));
+        KOS_ATOMIC(KOS_OBJ_ID) *const dst_buf = kos_get_array_buffer(OBJPTR(ARRAY, array_obj));
+        uint32_t                      i;
+
+        for (i = 0; i < size; i++)
+            KOS_atomic_write_relaxed_ptr(dst_buf[i], KOS_atomic_read_relaxed_obj(src_buf[i]));
+    }
+
+    KOS_destroy_top_local(ctx, &src);
+
+    return array_obj;
+}
+
 int KOS_array_reserve(KOS_CONTEXT ctx, KOS_OBJ_ID obj_id, uint32_t new_capacity)
 {
     int       error = KOS_ERROR_EXCEPTION;
@@ -557,6 +598,7 @@ KOS_OBJ_ID KOS_array_slice(KOS_CONTEXT ctx,
                     KOS_ATOMIC(KOS_OBJ_ID) *dest = &dest_buf->buf[0];
 
                     KOS_atomic_write_relaxed_ptr(new_array->data, OBJID(ARRAY_STORAGE, dest_buf));
+                    kos_write_barrier(ret.o);
 
                     while (idx < new_len) {
 
@@ -700,6 +742,9 @@ int KOS_array_insert(KOS_CONTEXT ctx,
                                 (unsigned)(src_end - mid));
     }
 
+    if (dest_buf)
+        kos_write_barrier(OBJID(ARRAY_STORAGE, dest_buf));
+
     if (src_delta < dest_delta)
         TRY(KOS_array_resize(ctx, dest.o, dest_len - dest_delta + src_delta));
 
@@ -768,6 +813,8 @@ int KOS_array_push(KOS_CONTEXT ctx,
             break;
     }
 
+    kos_write_barrier(OBJID(ARRAY_STORAGE, buf));
+
     if (idx)
         *idx = len;
 
@@ -854,5 +901,8 @@ int KOS_array_fill(KOS_CONTEXT ctx,
         }
     }
 
+    if (buf)
+        kos_write_barrier(OBJID(ARRAY_STORAGE, buf));
+
     return KOS_SUCCESS;
 }
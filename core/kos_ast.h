@@ -36,6 +36,7 @@ typedef enum KOS_NODE_TYPE_U {
     NT_ASSIGNMENT,          /* single variable assignment */
     NT_MULTI_ASSIGNMENT,    /* multiple variable assignment */
     NT_INTERPOLATED_STRING, /* string interpolation */
+    NT_INLINE,              /* inlined function invocation */
 
     NT_LEFT_HAND_SIDE,      /* first argument to assignment */
     NT_NAME,                /* function name, not referred to inside the function */
@@ -72,6 +72,11 @@ static int object_literal(KOS_COMP_UNIT      *program,
                           KOS_VAR            *class_var,
                           KOS_REG            *prototype);
 
+static int check_duplicate_prop(KOS_COMP_UNIT       *program,
+                                KOS_RED_BLACK_NODE **prop_str_idcs,
+                                const KOS_AST_NODE  *prop_node,
+                                int                  str_idx);
+
 static int gen_new_reg(KOS_COMP_UNIT *program,
                        KOS_REG      **out_reg)
 {
@@ -290,13 +295,16 @@ static int count_used_regs(KOS_COMP_UNIT *program)
 
 /* Lookup variable in local scopes.
  * Arguments in registers, including ellipsis, are treated as local variables.
- * Skip other arguments, globals and modules. */
+ * Skip other arguments, globals, modules and variables in cells. */
 static int lookup_local_var(KOS_COMP_UNIT      *program,
                             const KOS_AST_NODE *node,
                             KOS_REG           **reg)
 {
     int error = KOS_SUCCESS;
 
+    if (node->is_var && node->u.var->in_cell)
+        return KOS_SUCCESS;
+
     /* Function-local variable or argument, but not a non-public global */
     if (node->is_local_var) {
 
@@ -328,6 +336,15 @@ static int lookup_local_var(KOS_COMP_UNIT      *program,
             *reg = var->reg;
         }
     }
+    /* Constant from an outer scope, which was bound to this function by value */
+    else if (node->is_var && node->u.var->by_value && ! node->is_const_fun) {
+
+        const KOS_VAR_REF *ref = kos_find_var_ref(program->cur_frame, node->u.var);
+
+        assert(ref);
+        assert(ref->reg);
+        *reg = ref->reg;
+    }
 
     return error;
 }
@@ -345,7 +362,7 @@ static int gen_reg_for_assigned_var(KOS_COMP_UNIT      *program,
     assert( ! node->is_scope);
     assert(var);
 
-    if ( ! (var->type & (VAR_LOCALS_AND_ARGS | VAR_ARGUMENT_IN_REG)) || ! node->is_local_var)
+    if ( ! (var->type & (VAR_LOCALS_AND_ARGS | VAR_ARGUMENT_IN_REG)) || ! node->is_local_var || var->in_cell)
         return KOS_SUCCESS;
 
     if (existing_var) {
@@ -387,7 +404,30 @@ static int lookup_var(KOS_COMP_UNIT      *program,
 
         *out_var = var;
 
-        if (is_local_arg) {
+        /* Modified variable captured by closures, the cell is the container */
+        if (var->in_cell) {
+            var->array_idx = 0;
+
+            if (node->is_local_var) {
+                if ( ! var->reg) {
+                    const int error = gen_reg(program, &var->reg);
+                    if (error)
+                        return error;
+                    var->reg->tmp = 0;
+                }
+
+                if (reg)
+                    *reg = var->reg;
+            }
+            else if (reg) {
+                const KOS_VAR_REF *ref = kos_find_var_ref(program->cur_frame, var);
+
+                assert(ref);
+                assert(ref->reg);
+                *reg = ref->reg;
+            }
+        }
+        else if (is_local_arg) {
             if (reg) {
                 assert((var->type & VAR_ARGUMENT) && ! (var->type & VAR_ARGUMENT_IN_REG));
                 assert(program->cur_frame->args_reg);
@@ -447,10 +487,10 @@ static int compare_strings(const char *a, unsigned len_a, KOS_UTF8_ESCAPE escape
     return result;
 }
 
-static void get_token_str(const KOS_TOKEN *token,
-                          const char     **out_begin,
-                          uint16_t        *out_length,
-                          KOS_UTF8_ESCAPE *out_escape)
+void kos_get_token_str(const KOS_TOKEN *token,
+                       const char     **out_begin,
+                       uint16_t        *out_length,
+                       KOS_UTF8_ESCAPE *out_escape)
 {
     const char *begin  = token->begin;
     uint16_t    length = token->length;
@@ -513,7 +553,7 @@ static int strings_compare_item(void               *what,
     if (str->header.type != KOS_COMP_CONST_STRING)
         return (int)KOS_COMP_CONST_STRING < (int)str->header.type ? -1 : 1;
 
-    get_token_str(token, &begin, &length, &escape);
+    kos_get_token_str(token, &begin, &length, &escape);
 
     return compare_strings(begin,    length,      escape,
                            str->str, str->length, str->escape);
@@ -554,6 +594,12 @@ static int constants_compare_node(KOS_RED_BLACK_NODE *a,
                  ? -1 : 0;
 
         case KOS_COMP_CONST_PROTOTYPE:
+            /* fall through */
+        case KOS_COMP_CONST_SWITCH:
+            /* fall through */
+        case KOS_COMP_CONST_OBJ_TEMPLATE:
+            /* fall through */
+        case KOS_COMP_CONST_ARRAY_TEMPLATE:
             return const_a->index < const_b->index ? -1 : 0;
     }
 }
@@ -599,7 +645,7 @@ static int gen_str_esc(KOS_COMP_UNIT   *program,
             uint16_t        length;
             KOS_UTF8_ESCAPE tok_escape;
 
-            get_token_str(token, &begin, &length, &tok_escape);
+            kos_get_token_str(token, &begin, &length, &tok_escape);
 
             if (tok_escape == KOS_UTF8_NO_ESCAPE)
                 escape = KOS_UTF8_NO_ESCAPE;
@@ -621,6 +667,36 @@ static int gen_str_esc(KOS_COMP_UNIT   *program,
     return error;
 }
 
+static int get_numeric_literal(KOS_COMP_UNIT      *program,
+                               const KOS_AST_NODE *node,
+                               KOS_NUMERIC        *numeric)
+{
+    int error = KOS_SUCCESS;
+
+    assert(node->type == NT_NUMERIC_LITERAL);
+
+    if (node->token.type == TT_NUMERIC_BINARY) {
+
+        const KOS_NUMERIC *value = (const KOS_NUMERIC *)node->token.begin;
+
+        assert(node->token.length == sizeof(KOS_NUMERIC));
+
+        *numeric = *value;
+    }
+    else
+        error = kos_parse_numeric(node->token.begin,
+                                  node->token.begin + node->token.length,
+                                  numeric);
+
+    if (error) {
+        program->error_token = &node->token;
+        program->error_str   = str_err_invalid_numeric_literal;
+        error                = KOS_ERROR_COMPILE_FAILED;
+    }
+
+    return error;
+}
+
 static int gen_str(KOS_COMP_UNIT   *program,
                    const KOS_TOKEN *token,
                    int             *str_idx)
@@ -831,7 +907,7 @@ static int gen_instr(KOS_COMP_UNIT *program,
             int32_t value = (int32_t)va_arg(args, int32_t);
 
             if (i == 0) {
-                assert(value >= INSTR_BREAKPOINT && value <= INSTR_CANCEL);
+                assert(value >= INSTR_BREAKPOINT && value < KOS_FIRST_QUICK_INSTR);
                 instr = (KOS_BYTECODE_INSTR)value;
                 buf[cur_offs++] = (uint8_t)value;
             }
@@ -926,15 +1002,12 @@ static int gen_instr5(KOS_COMP_UNIT *program,
     return gen_instr(program, 5, opcode, operand1, operand2, operand3, operand4, operand5);
 }
 
-static int gen_load_number(KOS_COMP_UNIT      *program,
-                           int32_t             reg,
-                           const KOS_NUMERIC  *numeric)
+static int gen_num_const(KOS_COMP_UNIT     *program,
+                         const KOS_NUMERIC *numeric,
+                         int32_t           *const_idx)
 {
     KOS_COMP_CONST *constant;
 
-    if (numeric->type == KOS_INTEGER_VALUE && is_sint8(numeric->u.i))
-        return gen_instr2(program, INSTR_LOAD_INT8, reg, (int32_t)numeric->u.i);
-
     constant = (KOS_COMP_CONST *)kos_red_black_find(program->constants,
                                                     (void *)numeric,
                                                     numbers_compare_item);
@@ -960,7 +1033,74 @@ static int gen_load_number(KOS_COMP_UNIT      *program,
         add_constant(program, constant);
     }
 
-    return gen_instr2(program, INSTR_LOAD_CONST, reg, (int32_t)constant->index);
+    *const_idx = (int32_t)constant->index;
+
+    return KOS_SUCCESS;
+}
+
+static int gen_load_number(KOS_COMP_UNIT      *program,
+                           int32_t             reg,
+                           const KOS_NUMERIC  *numeric)
+{
+    int32_t const_idx = 0;
+    int     error;
+
+    if (numeric->type == KOS_INTEGER_VALUE && is_sint8(numeric->u.i))
+        return gen_instr2(program, INSTR_LOAD_INT8, reg, (int32_t)numeric->u.i);
+
+    error = gen_num_const(program, numeric, &const_idx);
+
+    if ( ! error)
+        error = gen_instr2(program, INSTR_LOAD_CONST, reg, const_idx);
+
+    return error;
+}
+
+/* Loads a value which does not change while the function is running, e.g. a constant.
+ * Inside of a loop, the value may have already been loaded into a register before the loop. */
+static int gen_load_invariant(KOS_COMP_UNIT *program,
+                              KOS_REG      **reg,
+                              int            instr,
+                              int32_t        operand)
+{
+    KOS_FRAME     *frame = program->cur_frame;
+    KOS_CONST_REG *const_reg;
+    int            error;
+
+    if ( ! *reg) {
+        for (const_reg = frame->const_regs; const_reg; const_reg = const_reg->next) {
+            if (const_reg->instr == instr && const_reg->operand == operand) {
+                *reg = const_reg->reg;
+                return KOS_SUCCESS;
+            }
+        }
+    }
+
+    TRY(gen_reg(program, reg));
+
+    TRY(gen_instr2(program, instr, (*reg)->reg, operand));
+
+    if (frame->hoist_consts) {
+
+        assert((*reg)->tmp);
+
+        const_reg = (KOS_CONST_REG *)KOS_mempool_alloc(&program->allocator, sizeof(KOS_CONST_REG));
+        if ( ! const_reg)
+            RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+        const_reg->next    = frame->const_regs;
+        const_reg->reg     = *reg;
+        const_reg->instr   = instr;
+        const_reg->operand = operand;
+
+        frame->const_regs = const_reg;
+        ++frame->num_const_regs;
+
+        (*reg)->tmp = 0;
+    }
+
+cleanup:
+    return error;
 }
 
 static int gen_instr_get_elem(KOS_COMP_UNIT      *program,
@@ -1034,12 +1174,50 @@ static int gen_instr_set_array_var_elem(KOS_COMP_UNIT      *program,
         return gen_instr_set_elem(program, node, cont_reg->reg, cont_var->array_idx, src_reg);
 }
 
+/* Creates a new cell for a variable, which is modified and captured by closures.
+ * A new cell is created every time the variable is declared, e.g. in every iteration
+ * of a loop, so that each closure sees the variable from the iteration in which
+ * the closure was created. */
+static int gen_new_cell(KOS_COMP_UNIT *program,
+                        KOS_VAR       *var)
+{
+    int error = KOS_SUCCESS;
+
+    assert(var->in_cell);
+
+    if ( ! var->reg) {
+        TRY(gen_reg(program, &var->reg));
+        var->reg->tmp = 0;
+    }
+
+    TRY(gen_instr2(program, INSTR_NEW_ARRAY8, var->reg->reg, 1));
+
+cleanup:
+    return error;
+}
+
+/* Creates cells for declared variables, which are modified and captured by closures */
+static int gen_new_cells(KOS_COMP_UNIT      *program,
+                         const KOS_AST_NODE *node)
+{
+    int error = KOS_SUCCESS;
+
+    for ( ; node; node = node->next) {
+        if (node->type == NT_IDENTIFIER && node->u.var->in_cell)
+            TRY(gen_new_cell(program, node->u.var));
+    }
+
+cleanup:
+    return error;
+}
+
 typedef struct JUMP_ENTRY_S {
     int     jump_instr_offs;    /* Offset of the jump instruction */
     int     target_offs;        /* Offset of the jump's target */
     int     orig_instr_offs;    /* Original offset of the jump instruction before size adjustments */
     uint8_t instr_base_size;    /* Size of jump instruction, excluding immediate operand */
     uint8_t imm_size;           /* Size of immediate operand */
+    uint8_t fixed_imm;          /* Immediate operand has fixed size, used in jump tables */
 } JUMP_ENTRY;
 
 static int add_jump_instr_at_offset(KOS_COMP_UNIT *program, uint32_t *jump_entry, int jump_instr_offs)
@@ -1055,6 +1233,7 @@ static int add_jump_instr_at_offset(KOS_COMP_UNIT *program, uint32_t *jump_entry
         new_entry->orig_instr_offs = jump_instr_offs;
         new_entry->instr_base_size = 0;
         new_entry->imm_size        = 1; /* Initially offset 0 is written, takes 1 byte */
+        new_entry->fixed_imm       = 0;
 
         *jump_entry = (uint32_t)item_offs;
     }
@@ -1087,6 +1266,47 @@ static int add_jump_instr_with_target(KOS_COMP_UNIT *program, int target_offs)
     return error;
 }
 
+/* Writes signed immediate operand padded to KOS_JUMP_TABLE_ENTRY_SIZE - 1 bytes */
+static void write_fixed_simm(uint8_t *bytecode, int32_t value)
+{
+    const uint32_t uvalue = encode_signed(value);
+
+    assert(uvalue <= 0x0FFFFFFFu);
+
+    bytecode[0] = (uint8_t)( uvalue         & 0x7Fu) | 0x80u;
+    bytecode[1] = (uint8_t)((uvalue >> 7)  & 0x7Fu) | 0x80u;
+    bytecode[2] = (uint8_t)((uvalue >> 14) & 0x7Fu) | 0x80u;
+    bytecode[3] = (uint8_t)( uvalue >> 21);
+}
+
+/* Generates a jump table entry, which is a JUMP instruction with fixed size,
+ * so that the interpreter can find the entry by its index. */
+static int gen_jump_table_entry(KOS_COMP_UNIT *program, uint32_t *jump_entry)
+{
+    const int   jump_instr_offs = program->cur_offs;
+    KOS_VECTOR *code_buf        = &program->code_gen_buf;
+    JUMP_ENTRY *entry;
+    int         error;
+
+    TRY(add_jump_instr(program, jump_entry));
+
+    TRY(gen_instr1(program, INSTR_JUMP, 0));
+
+    TRY(KOS_vector_resize(code_buf, (size_t)jump_instr_offs + KOS_JUMP_TABLE_ENTRY_SIZE));
+
+    write_fixed_simm((uint8_t *)&code_buf->buffer[jump_instr_offs + 1], 0);
+
+    program->cur_offs = jump_instr_offs + KOS_JUMP_TABLE_ENTRY_SIZE;
+
+    entry = (JUMP_ENTRY *)&program->jump_buf.buffer[*jump_entry];
+
+    entry->imm_size  = KOS_JUMP_TABLE_ENTRY_SIZE - 1;
+    entry->fixed_imm = 1;
+
+cleanup:
+    return error;
+}
+
 static int write_jump_offs(KOS_COMP_UNIT *program,
                            JUMP_ENTRY    *entry)
 {
@@ -1111,12 +1331,18 @@ static int write_jump_offs(KOS_COMP_UNIT *program,
 
     jump_offs = entry->target_offs - (entry->jump_instr_offs + entry->instr_base_size + entry->imm_size);
 
+    buf += (opcode == INSTR_CATCH) ? 2 : (opcode == INSTR_NEXT_JUMP) ? 3 : 1;
+
+    if (entry->fixed_imm) {
+        assert(opcode == INSTR_JUMP);
+        write_fixed_simm(buf, jump_offs);
+        return KOS_SUCCESS;
+    }
+
     write_simm(packed_imm, &imm_size, jump_offs);
 
     assert(imm_size == entry->imm_size);
 
-    buf += (opcode == INSTR_CATCH) ? 2 : (opcode == INSTR_NEXT_JUMP) ? 3 : 1;
-
     if (imm_size == 1)
         *buf = packed_imm[0];
     else {
@@ -1148,6 +1374,9 @@ static uint8_t update_imm_size(JUMP_ENTRY *const entry)
     uint8_t prev_imm_size;
     uint8_t delta;
 
+    if (entry->fixed_imm)
+        return 0;
+
     do {
         int target_offs = entry->target_offs;
 
@@ -1263,7 +1492,7 @@ static int update_jumps(KOS_COMP_UNIT *program,
         if (error)
             return error;
 
-        delta = entry->imm_size - 1u;
+        delta = entry->fixed_imm ? 0u : (uint8_t)(entry->imm_size - 1u);
 
         /* Update addr2line mappings up to this jump */
         for ( ; (addr2line < addr2line_end) && (addr2line->offs <= (unsigned int)entry->orig_instr_offs); ++addr2line)
@@ -1283,6 +1512,478 @@ static int update_jumps(KOS_COMP_UNIT *program,
     return KOS_SUCCESS;
 }
 
+#define PEEP_DELETED 1U /* Instruction has been removed */
+#define PEEP_TARGET  2U /* Instruction is a target of a jump */
+#define PEEP_PINNED  4U /* Jump table entry, must stay in place */
+
+typedef struct PEEP_INSTR_S {
+    int     offs;       /* Offset of the instruction in code_gen_buf */
+    int     new_offs;   /* Offset of the instruction after deleted instructions are removed */
+    int     jump_idx;   /* Index of the instruction's jump entry or -1 */
+    uint8_t size;
+    uint8_t flags;
+} PEEP_INSTR;
+
+typedef struct PEEPHOLE_S {
+    uint8_t    *code;
+    JUMP_ENTRY *jumps;
+    PEEP_INSTR *instrs;
+    int         num_instrs;
+    int         num_deleted;
+    int         end_offs;
+} PEEPHOLE;
+
+static int is_jump_instr(uint8_t opcode)
+{
+    return opcode == INSTR_JUMP      ||
+           opcode == INSTR_JUMP_COND ||
+           opcode == INSTR_JUMP_NOT_COND;
+}
+
+/* Returns non-zero for instructions which only write to a register and don't have
+ * any side effects, so the write can be removed if the register is overwritten */
+static int is_simple_load(uint8_t opcode)
+{
+    switch (opcode) {
+
+        case INSTR_LOAD_INT8:   /* fall through */
+        case INSTR_LOAD_CONST:  /* fall through */
+        case INSTR_LOAD_TRUE:   /* fall through */
+        case INSTR_LOAD_FALSE:  /* fall through */
+        case INSTR_LOAD_VOID:   /* fall through */
+        case INSTR_MOVE:
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static int find_peep_instr(const PEEPHOLE *ph, int offs)
+{
+    int begin = 0;
+    int end   = ph->num_instrs;
+
+    while (begin < end) {
+        const int mid = (begin + end) / 2;
+
+        if (ph->instrs[mid].offs < offs)
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+
+    assert(begin == ph->num_instrs ? offs == ph->end_offs : ph->instrs[begin].offs == offs);
+
+    return begin;
+}
+
+static int next_live_instr(const PEEPHOLE *ph, int idx)
+{
+    while (idx < ph->num_instrs && (ph->instrs[idx].flags & PEEP_DELETED))
+        ++idx;
+
+    return idx;
+}
+
+static uint8_t get_peep_opcode(const PEEPHOLE *ph, int idx)
+{
+    return ph->code[ph->instrs[idx].offs];
+}
+
+/* Returns index of the first live instruction executed after the jump is taken */
+static int get_jump_target(const PEEPHOLE *ph, int idx)
+{
+    const PEEP_INSTR *const instr = &ph->instrs[idx];
+
+    assert(instr->jump_idx >= 0);
+
+    return next_live_instr(ph, find_peep_instr(ph, ph->jumps[instr->jump_idx].target_offs));
+}
+
+static void set_peep_target(PEEPHOLE *ph, int idx, int target)
+{
+    const PEEP_INSTR *const instr = &ph->instrs[idx];
+
+    assert(instr->jump_idx >= 0);
+
+    if (target < ph->num_instrs) {
+        ph->jumps[instr->jump_idx].target_offs = ph->instrs[target].offs;
+        ph->instrs[target].flags |= PEEP_TARGET;
+    }
+    else
+        ph->jumps[instr->jump_idx].target_offs = ph->end_offs;
+}
+
+static void delete_peep_instr(PEEPHOLE *ph, int idx)
+{
+    PEEP_INSTR *const instr = &ph->instrs[idx];
+
+    assert( ! (instr->flags & PEEP_DELETED));
+
+    instr->flags |= PEEP_DELETED;
+    ++ph->num_deleted;
+
+    /* Jumps to the deleted instruction will land on the next instruction */
+    if (instr->flags & PEEP_TARGET) {
+        const int next = next_live_instr(ph, idx + 1);
+
+        if (next < ph->num_instrs)
+            ph->instrs[next].flags |= PEEP_TARGET;
+    }
+}
+
+/* Redirects jumps which land on other jumps to the final destination */
+static int thread_jump(PEEPHOLE *ph, int idx)
+{
+    const uint8_t opcode     = get_peep_opcode(ph, idx);
+    const uint8_t cond_reg   = ph->code[ph->instrs[idx].offs + ph->instrs[idx].size - 1];
+    const int     old_target = get_jump_target(ph, idx);
+    int           target     = old_target;
+    int           hops;
+
+    /* Limit the number of hops in case the jumps form a loop */
+    for (hops = 0; hops < 16 && target < ph->num_instrs && target != idx; hops++) {
+
+        const PEEP_INSTR *const tgt_instr  = &ph->instrs[target];
+        const uint8_t           tgt_opcode = get_peep_opcode(ph, target);
+
+        if (tgt_instr->jump_idx < 0)
+            break;
+
+        if (tgt_opcode == INSTR_JUMP)
+            target = get_jump_target(ph, target);
+
+        else if ((opcode != INSTR_JUMP) &&
+                 ((tgt_opcode == INSTR_JUMP_COND) || (tgt_opcode == INSTR_JUMP_NOT_COND)) &&
+                 (ph->code[tgt_instr->offs + tgt_instr->size - 1] == cond_reg))
+
+            /* Conditional jump on the same register is either always taken or never taken */
+            target = (tgt_opcode == opcode) ? get_jump_target(ph, target)
+                                            : next_live_instr(ph, target + 1);
+        else
+            break;
+    }
+
+    if (target == old_target)
+        return 0;
+
+    set_peep_target(ph, idx, target);
+    return 1;
+}
+
+/* Deletes instructions following an unconditional jump, return or throw,
+ * up to the next instruction which is a jump target */
+static int delete_unreachable(PEEPHOLE *ph, int idx)
+{
+    int changed = 0;
+
+    for ( ; idx < ph->num_instrs; idx++) {
+
+        const uint8_t flags = ph->instrs[idx].flags;
+
+        if (flags & PEEP_DELETED)
+            continue;
+
+        if (flags & PEEP_TARGET)
+            break;
+
+        delete_peep_instr(ph, idx);
+        changed = 1;
+    }
+
+    return changed;
+}
+
+static int peephole_pass(PEEPHOLE *ph)
+{
+    PEEP_INSTR *const instrs  = ph->instrs;
+    uint8_t    *const code    = ph->code;
+    int               changed = 0;
+    int               i;
+
+    /* Recalculate jump targets, some instructions may no longer be targets */
+    for (i = 0; i < ph->num_instrs; i++)
+        instrs[i].flags &= ~PEEP_TARGET;
+
+    for (i = 0; i < ph->num_instrs; i++) {
+        if ( ! (instrs[i].flags & PEEP_DELETED) && (instrs[i].jump_idx >= 0)) {
+            const int target = get_jump_target(ph, i);
+
+            if (target < ph->num_instrs)
+                instrs[target].flags |= PEEP_TARGET;
+        }
+    }
+
+    for (i = 0; i < ph->num_instrs; i++) {
+
+        PEEP_INSTR *const instr = &instrs[i];
+        const uint8_t     opcode = code[instr->offs];
+        int               next;
+
+        if (instr->flags & PEEP_DELETED)
+            continue;
+
+        next = next_live_instr(ph, i + 1);
+
+        switch (opcode) {
+
+            case INSTR_JUMP:
+                /* fall through */
+            case INSTR_JUMP_COND:
+                /* fall through */
+            case INSTR_JUMP_NOT_COND: {
+                int target;
+
+                if (instr->jump_idx < 0)
+                    break;
+
+                changed |= thread_jump(ph, i);
+
+                if (instr->flags & PEEP_PINNED)
+                    break;
+
+                target = get_jump_target(ph, i);
+
+                /* Remove jump to the next instruction */
+                if (target == next) {
+                    delete_peep_instr(ph, i);
+                    changed = 1;
+                }
+                else if (opcode == INSTR_JUMP) {
+
+                    /* Replace jump to return with return */
+                    if ((target < ph->num_instrs) &&
+                        (get_peep_opcode(ph, target) == INSTR_RETURN) &&
+                        (instrs[target].size == instr->size)) {
+
+                        memcpy(&code[instr->offs], &code[instrs[target].offs], instr->size);
+                        instr->jump_idx = -1;
+                        changed = 1;
+                    }
+
+                    changed |= delete_unreachable(ph, next);
+                }
+                /* Invert condition of conditional jump over unconditional jump */
+                else if ((next < ph->num_instrs) &&
+                         (get_peep_opcode(ph, next) == INSTR_JUMP) &&
+                         ! (instrs[next].flags & (PEEP_TARGET | PEEP_PINNED)) &&
+                         (target == next_live_instr(ph, next + 1))) {
+
+                    code[instr->offs] = (opcode == INSTR_JUMP_COND) ? INSTR_JUMP_NOT_COND : INSTR_JUMP_COND;
+
+                    set_peep_target(ph, i, get_jump_target(ph, next));
+                    delete_peep_instr(ph, next);
+                    changed = 1;
+                }
+                break;
+            }
+
+            case INSTR_RETURN:
+                /* fall through */
+            case INSTR_THROW:
+                /* fall through */
+            case INSTR_TAIL_CALL:
+                /* fall through */
+            case INSTR_TAIL_CALL_N:
+                /* fall through */
+            case INSTR_TAIL_CALL_FUN:
+                changed |= delete_unreachable(ph, next);
+                break;
+
+            case INSTR_MOVE:
+                if (code[instr->offs + 1] == code[instr->offs + 2]) {
+                    delete_peep_instr(ph, i);
+                    changed = 1;
+                    break;
+                }
+
+                /* Remove move back to the source register */
+                if ((next < ph->num_instrs) &&
+                    (get_peep_opcode(ph, next) == INSTR_MOVE) &&
+                    ! (instrs[next].flags & PEEP_TARGET) &&
+                    (code[instrs[next].offs + 1] == code[instr->offs + 2]) &&
+                    (code[instrs[next].offs + 2] == code[instr->offs + 1])) {
+
+                    delete_peep_instr(ph, next);
+                    changed = 1;
+                    break;
+                }
+                /* fall through */
+
+            default:
+                /* Remove load into a register, which is immediately overwritten */
+                if (is_simple_load(opcode) &&
+                    (next < ph->num_instrs) &&
+                    is_simple_load(get_peep_opcode(ph, next)) &&
+                    (code[instrs[next].offs + 1] == code[instr->offs + 1]) &&
+                    ((get_peep_opcode(ph, next) != INSTR_MOVE) ||
+                     (code[instrs[next].offs + 2] != code[instr->offs + 1]))) {
+
+                    delete_peep_instr(ph, i);
+                    changed = 1;
+                }
+                break;
+        }
+    }
+
+    return changed;
+}
+
+/* Removes deleted instructions from the code and updates jumps and addr2line */
+static int compact_peephole(KOS_COMP_UNIT *program,
+                            PEEPHOLE      *ph,
+                            size_t         addr2line_start_offs,
+                            size_t         jump_buf_offs)
+{
+    struct KOS_COMP_ADDR_TO_LINE_S *addr2line =
+        (struct KOS_COMP_ADDR_TO_LINE_S *)
+            (program->addr2line_gen_buf.buffer + addr2line_start_offs);
+    struct KOS_COMP_ADDR_TO_LINE_S *const addr2line_end =
+        (struct KOS_COMP_ADDR_TO_LINE_S *)
+            (program->addr2line_gen_buf.buffer + program->addr2line_gen_buf.size);
+    struct KOS_COMP_ADDR_TO_LINE_S *addr2line_out = addr2line;
+
+    int cur_offs  = ph->num_instrs ? ph->instrs[0].offs : ph->end_offs;
+    int num_jumps = 0;
+    int i;
+
+    for (i = 0; i < ph->num_instrs; i++) {
+
+        PEEP_INSTR *const instr = &ph->instrs[i];
+
+        instr->new_offs = cur_offs;
+
+        if (instr->flags & PEEP_DELETED)
+            continue;
+
+        memmove(&ph->code[cur_offs], &ph->code[instr->offs], instr->size);
+
+        cur_offs += instr->size;
+    }
+
+    /* Entries are sorted by instruction offset, so they can be compacted in place */
+    for (i = 0; i < ph->num_instrs; i++) {
+
+        const PEEP_INSTR *const instr = &ph->instrs[i];
+        JUMP_ENTRY              entry;
+        int                     target;
+
+        if ((instr->flags & PEEP_DELETED) || (instr->jump_idx < 0))
+            continue;
+
+        assert(instr->jump_idx >= num_jumps);
+
+        entry  = ph->jumps[instr->jump_idx];
+        target = find_peep_instr(ph, entry.target_offs);
+
+        entry.jump_instr_offs = instr->new_offs;
+        entry.orig_instr_offs = instr->new_offs;
+        entry.target_offs     = (target < ph->num_instrs) ? ph->instrs[target].new_offs : cur_offs;
+
+        ph->jumps[num_jumps++] = entry;
+    }
+
+    program->jump_buf.size = (unsigned int)(jump_buf_offs + (size_t)num_jumps * sizeof(JUMP_ENTRY));
+
+    /* Map addr2line entries to new offsets, if multiple entries end up at the same
+     * offset, keep the last one, which belongs to the instruction at that offset */
+    for ( ; addr2line < addr2line_end; ++addr2line) {
+
+        const int idx = find_peep_instr(ph, (int)addr2line->offs);
+
+        addr2line->offs = (idx < ph->num_instrs) ? (uint32_t)ph->instrs[idx].new_offs : (uint32_t)cur_offs;
+
+        if ((addr2line_out > (struct KOS_COMP_ADDR_TO_LINE_S *)
+                             (program->addr2line_gen_buf.buffer + addr2line_start_offs)) &&
+            (addr2line_out[-1].offs == addr2line->offs))
+            --addr2line_out;
+
+        *(addr2line_out++) = *addr2line;
+    }
+
+    program->addr2line_gen_buf.size = (unsigned int)((char *)addr2line_out - program->addr2line_gen_buf.buffer);
+
+    program->code_gen_buf.size      = (unsigned int)cur_offs;
+    program->cur_offs               = cur_offs;
+    program->cur_frame->num_instr  -= (uint32_t)ph->num_deleted;
+
+    return KOS_SUCCESS;
+}
+
+/* Peephole optimizer, applied to the function's code before jump offsets
+ * are written, while jumps are still tracked by their targets:
+ * - jump threading,
+ * - removal of jumps to the next instruction,
+ * - replacing jumps to return with return,
+ * - inverting conditional jumps over unconditional jumps,
+ * - removal of unreachable code,
+ * - removal of redundant moves and of loads which are immediately overwritten. */
+static int peephole(KOS_COMP_UNIT *program,
+                    int            fun_start_offs,
+                    size_t         addr2line_start_offs,
+                    size_t         jump_buf_offs)
+{
+    const int   fun_size = program->cur_offs - fun_start_offs;
+    JUMP_ENTRY *jump     = (JUMP_ENTRY *)&program->jump_buf.buffer[jump_buf_offs];
+    JUMP_ENTRY *jump_end = (JUMP_ENTRY *)&program->jump_buf.buffer[program->jump_buf.size];
+    PEEPHOLE    ph;
+    int         offs;
+    int         error;
+
+    /* Each instruction has at least one byte */
+    TRY(KOS_vector_resize(&program->peephole_buf, (size_t)fun_size * sizeof(PEEP_INSTR)));
+
+    ph.code        = (uint8_t *)program->code_gen_buf.buffer;
+    ph.jumps       = jump;
+    ph.instrs      = (PEEP_INSTR *)program->peephole_buf.buffer;
+    ph.num_instrs  = 0;
+    ph.num_deleted = 0;
+    ph.end_offs    = program->cur_offs;
+
+    for (offs = fun_start_offs; offs < ph.end_offs; ) {
+
+        PEEP_INSTR *const instr  = &ph.instrs[ph.num_instrs++];
+        const uint8_t     opcode = ph.code[offs];
+
+        instr->offs     = offs;
+        instr->new_offs = offs;
+        instr->size     = (uint8_t)kos_get_instr_size(&ph.code[offs]);
+        instr->flags    = 0;
+        instr->jump_idx = -1;
+
+        if ((jump < jump_end) && (jump->jump_instr_offs == offs)) {
+
+            assert(jump->orig_instr_offs == offs);
+
+            instr->jump_idx = (int)(jump - ph.jumps);
+
+            if (jump->fixed_imm)
+                instr->flags = PEEP_PINNED;
+
+            ++jump;
+        }
+        /* All jumps are expected to have jump entries, bail if not */
+        else if (is_jump_instr(opcode) || (opcode == INSTR_CATCH) || (opcode == INSTR_NEXT_JUMP))
+            return KOS_SUCCESS;
+
+        offs += instr->size;
+    }
+
+    assert(offs == ph.end_offs);
+    assert(jump == jump_end);
+
+    if (peephole_pass(&ph)) {
+
+        while (peephole_pass(&ph)) { }
+
+        TRY(compact_peephole(program, &ph, addr2line_start_offs, jump_buf_offs));
+    }
+
+cleanup:
+    return error;
+}
+
 static KOS_SCOPE *push_scope(KOS_COMP_UNIT      *program,
                              const KOS_AST_NODE *node)
 {
@@ -1309,6 +2010,61 @@ static void free_scope_reg(KOS_COMP_UNIT *program,
         free_reg(program, var->reg);
         var->reg = KOS_NULL;
     }
+
+    if (var->prop_regs) {
+        KOS_REG **prop_reg;
+
+        for (prop_reg = var->prop_regs; *prop_reg; ++prop_reg) {
+            (*prop_reg)->tmp = 1;
+            free_reg(program, *prop_reg);
+        }
+
+        var->prop_regs = KOS_NULL;
+    }
+}
+
+static int is_scope_reg(const KOS_VAR *var,
+                        const KOS_REG *reg)
+{
+    if (reg == var->reg)
+        return 1;
+
+    if (var->prop_regs) {
+        KOS_REG **prop_reg;
+
+        for (prop_reg = var->prop_regs; *prop_reg; ++prop_reg)
+            if (reg == *prop_reg)
+                return 1;
+    }
+
+    return 0;
+}
+
+/* Release registers of variables which are not used after the statement */
+static void release_dead_vars(KOS_COMP_UNIT      *program,
+                              const KOS_AST_NODE *stmt,
+                              KOS_REG           **reg)
+{
+    KOS_SCOPE *scope = program->scope_stack;
+
+    for (;;) {
+        KOS_VAR *var;
+
+        for (var = scope->vars; var; var = var->scope_next) {
+            if (var->release_node != stmt || ! (var->reg || var->prop_regs))
+                continue;
+
+            if (*reg && is_scope_reg(var, *reg))
+                *reg = KOS_NULL;
+
+            free_scope_reg(program, var);
+        }
+
+        if (scope->has_frame)
+            break;
+
+        scope = scope->parent_scope;
+    }
 }
 
 static void pop_scope(KOS_COMP_UNIT *program)
@@ -1333,11 +2089,12 @@ typedef struct KOS_IMPORT_INFO_S {
     const KOS_AST_NODE *next;
 } KOS_IMPORT_INFO;
 
-static int import_global(const char *global_name,
-                         uint16_t    global_length,
-                         int         module_idx,
-                         int         global_idx,
-                         void       *cookie)
+static int import_global(const char                  *global_name,
+                         uint16_t                     global_length,
+                         int                          module_idx,
+                         int                          global_idx,
+                         const KOS_COMP_GLOBAL_CONST *value,
+                         void                        *cookie)
 {
     int              error = KOS_SUCCESS;
     KOS_IMPORT_INFO *info  = (KOS_IMPORT_INFO *)cookie;
@@ -1468,6 +2225,9 @@ static int append_frame(KOS_COMP_UNIT     *program,
 
     assert((unsigned int)program->cur_offs == program->code_gen_buf.size);
 
+    if (program->optimize)
+        TRY(peephole(program, fun_start_offs, addr2line_start_offs, jump_buf_offs));
+
     TRY(update_jumps(program, jump_buf_offs, addr2line_start_offs));
 
     assert((unsigned int)program->cur_offs == program->code_gen_buf.size);
@@ -1698,6 +2458,10 @@ static int process_scope(KOS_COMP_UNIT      *program,
                 assert(used_regs == initial_used_regs + skip_tmp);
             }
 #endif
+
+            /* The last statement in global scope returns its value */
+            if (child->next || ! global)
+                release_dead_vars(program, child, &reg);
         }
 
         if (global)
@@ -1825,7 +2589,6 @@ static int gen_cond_jump_inner(KOS_COMP_UNIT      *program,
             TRY(gen_cond_jump_inner(program, node, opcode, jump_array, &local_jump_array));
 
             update_jump_array(program, &local_jump_array, program->cur_offs);
-            /* TODO delete previous jump instruction if it has jump offset 0 */
 
             node = node->next;
             assert(node);
@@ -1841,7 +2604,6 @@ static int gen_cond_jump_inner(KOS_COMP_UNIT      *program,
             TRY(gen_cond_jump_inner(program, node, negate_jump_opcode(opcode), near_jump_array, &local_jump_array));
 
             update_jump_array(program, &local_jump_array, program->cur_offs);
-            /* TODO delete previous jump instruction if it has jump offset 0 */
 
             node = node->next;
             assert(node);
@@ -2195,16 +2957,159 @@ static void finish_fallthrough(KOS_COMP_UNIT *program)
     }
 }
 
-/* Saves last try scope before the loop, used for restoring catch offset */
-static KOS_SCOPE *push_try_scope(KOS_COMP_UNIT *program)
+/* Saves last try scope before the loop, used for restoring catch offset */
+static KOS_SCOPE *push_try_scope(KOS_COMP_UNIT *program)
+{
+    KOS_SCOPE *prev_try_scope = program->cur_frame->last_try_scope;
+    KOS_SCOPE *scope          = find_try_scope(program->scope_stack);
+
+    if (scope)
+        program->cur_frame->last_try_scope = scope;
+
+    return prev_try_scope;
+}
+
+/* Checks if node loads a value, which does not change while the function is running */
+static int is_invariant(const KOS_AST_NODE *node)
+{
+    const KOS_VAR *var;
+
+    switch (node->type) {
+
+        case NT_NUMERIC_LITERAL:
+            /* fall through */
+        case NT_STRING_LITERAL:
+            return 1;
+
+        case NT_IDENTIFIER:
+            break;
+
+        default:
+            return 0;
+    }
+
+    if (node->is_const_fun)
+        return 1;
+
+    assert(node->is_var);
+    var = node->u.var;
+    assert(var);
+
+    return var->type == VAR_MODULE || (var->type == VAR_GLOBAL && var->is_const);
+}
+
+static int hoist_invariant(KOS_COMP_UNIT      *program,
+                           const KOS_AST_NODE *node)
+{
+    KOS_REG *reg   = KOS_NULL;
+    int      error = KOS_SUCCESS;
+
+    if (is_invariant(node) && program->cur_frame->num_const_regs < KOS_MAX_LOOP_CONSTS) {
+
+        error = visit_node(program, node, &reg);
+
+        if (reg)
+            free_reg(program, reg);
+    }
+
+    return error;
+}
+
+/* Finds constants used as operands inside a loop and loads them into registers.
+ * Only operands which are loaded into temporary registers are considered,
+ * for example property names are encoded directly in instructions. */
+static int find_loop_consts(KOS_COMP_UNIT      *program,
+                            const KOS_AST_NODE *node)
+{
+    int error = KOS_SUCCESS;
+
+    for ( ; node; node = node->next) {
+
+        const KOS_AST_NODE *child;
+
+        switch (node->type) {
+
+            case NT_FUNCTION_LITERAL:
+                /* fall through */
+            case NT_CONSTRUCTOR_LITERAL:
+                /* fall through */
+            case NT_CLASS_LITERAL:
+                /* Other functions have their own registers */
+                continue;
+
+            case NT_OPERATOR:
+                if (node->token.op == OT_LOGNOT || node->token.op == OT_LOGAND ||
+                    node->token.op == OT_LOGOR  || node->token.op == OT_LOGTRI ||
+                    node->token.keyword == KW_IN || node->token.keyword == KW_PROPERTYOF ||
+                    node->token.keyword == KW_DELETE)
+                    break;
+
+                for (child = node->children; child; child = child->next)
+                    TRY(hoist_invariant(program, child));
+                break;
+
+            case NT_ASSIGNMENT:
+                if (node->token.op != OT_SET && node->token.op != OT_SETCONCAT)
+                    TRY(hoist_invariant(program, node->children->next));
+                break;
+
+            case NT_INVOCATION:
+                TRY(hoist_invariant(program, node->children));
+                break;
+
+            default:
+                break;
+        }
+
+        TRY(find_loop_consts(program, node->children));
+    }
+
+cleanup:
+    return error;
+}
+
+/* Loads constants used inside of a loop into registers before the loop */
+static int hoist_loop_consts(KOS_COMP_UNIT      *program,
+                             const KOS_AST_NODE *node,
+                             KOS_CONST_REG     **outer_consts)
+{
+    KOS_FRAME *const frame = program->cur_frame;
+    int              error = KOS_SUCCESS;
+
+    *outer_consts = frame->const_regs;
+
+    if (program->optimize) {
+        assert( ! frame->hoist_consts);
+
+        frame->hoist_consts = 1;
+
+        error = find_loop_consts(program, node);
+
+        frame->hoist_consts = 0;
+    }
+
+    return error;
+}
+
+/* Releases registers with constants hoisted out of a loop */
+static void release_loop_consts(KOS_COMP_UNIT *program,
+                                KOS_CONST_REG *outer_consts)
 {
-    KOS_SCOPE *prev_try_scope = program->cur_frame->last_try_scope;
-    KOS_SCOPE *scope          = find_try_scope(program->scope_stack);
+    KOS_FRAME *const frame = program->cur_frame;
 
-    if (scope)
-        program->cur_frame->last_try_scope = scope;
+    while (frame->const_regs != outer_consts) {
 
-    return prev_try_scope;
+        KOS_CONST_REG *const_reg = frame->const_regs;
+
+        assert(const_reg);
+        assert( ! const_reg->reg->tmp);
+
+        const_reg->reg->tmp = 1;
+        free_reg(program, const_reg->reg);
+
+        frame->const_regs = const_reg->next;
+        --frame->num_const_regs;
+    }
 }
 
 static int repeat(KOS_COMP_UNIT      *program,
@@ -2212,8 +3117,9 @@ static int repeat(KOS_COMP_UNIT      *program,
 {
     int             error;
     int             test_instr_offs;
-    const int       loop_start_offs = program->cur_offs;
+    int             loop_start_offs;
     KOS_REG        *reg             = KOS_NULL;
+    KOS_CONST_REG  *outer_consts    = KOS_NULL;
     KOS_BREAK_OFFS *old_break_offs  = program->cur_frame->break_offs;
     KOS_SCOPE      *prev_try_scope  = push_try_scope(program);
 
@@ -2221,6 +3127,11 @@ static int repeat(KOS_COMP_UNIT      *program,
 
     node = node->children;
     assert(node);
+
+    TRY(hoist_loop_consts(program, node, &outer_consts));
+
+    loop_start_offs = program->cur_offs;
+
     TRY(visit_node(program, node, &reg));
     assert(!reg);
 
@@ -2251,6 +3162,8 @@ static int repeat(KOS_COMP_UNIT      *program,
     if (reg)
         free_reg(program, reg);
 
+    release_loop_consts(program, outer_consts);
+
     program->cur_frame->last_try_scope = prev_try_scope;
 
 cleanup:
@@ -2269,17 +3182,20 @@ static int while_stmt(KOS_COMP_UNIT      *program,
 
     if ( ! kos_node_is_falsy(program, cond_node)) {
 
-        KOS_REG   *reg = KOS_NULL;
-        JUMP_ARRAY start_jump_array;
-        JUMP_ARRAY end_jump_array;
-        int        loop_start_offs;
-        int        continue_tgt_offs;
+        KOS_REG       *reg          = KOS_NULL;
+        KOS_CONST_REG *outer_consts = KOS_NULL;
+        JUMP_ARRAY     start_jump_array;
+        JUMP_ARRAY     end_jump_array;
+        int            loop_start_offs;
+        int            continue_tgt_offs;
 
         program->cur_frame->break_offs = KOS_NULL;
 
         init_jump_array(&start_jump_array);
         init_jump_array(&end_jump_array);
 
+        TRY(hoist_loop_consts(program, cond_node, &outer_consts));
+
         continue_tgt_offs = program->cur_offs;
 
         TRY(gen_cond_jump(program, cond_node, INSTR_JUMP_NOT_COND, &end_jump_array));
@@ -2301,6 +3217,8 @@ static int while_stmt(KOS_COMP_UNIT      *program,
         update_jump_array(program, &start_jump_array, loop_start_offs);
         update_jump_array(program, &end_jump_array, program->cur_offs);
         finish_break_continue(program, continue_tgt_offs, old_break_offs);
+
+        release_loop_consts(program, outer_consts);
     }
 
     program->cur_frame->last_try_scope = prev_try_scope;
@@ -2499,8 +3417,10 @@ static int for_in(KOS_COMP_UNIT      *program,
     KOS_REG            *item_reg       = KOS_NULL;
     KOS_REG            *item_cont_reg  = KOS_NULL;
     KOS_VAR            *item_var       = KOS_NULL;
+    KOS_CONST_REG      *outer_consts   = KOS_NULL;
     KOS_BREAK_OFFS     *old_break_offs = program->cur_frame->break_offs;
     KOS_SCOPE          *prev_try_scope = push_try_scope(program);
+    KOS_NODE_TYPE       lhs_type;
 
     program->cur_frame->break_offs = KOS_NULL;
 
@@ -2510,11 +3430,12 @@ static int for_in(KOS_COMP_UNIT      *program,
     assert(assg_node);
     assert(assg_node->type == NT_IN);
 
+    TRY(hoist_loop_consts(program, assg_node->next, &outer_consts));
+
     var_node = assg_node->children;
     assert(var_node);
-    assert(var_node->type == NT_VAR   ||
-           var_node->type == NT_CONST ||
-           var_node->type == NT_LEFT_HAND_SIDE);
+    lhs_type = (KOS_NODE_TYPE)var_node->type;
+    assert(lhs_type == NT_VAR || lhs_type == NT_CONST || lhs_type == NT_LEFT_HAND_SIDE);
 
     expr_node = var_node->next;
     assert(expr_node);
@@ -2548,8 +3469,8 @@ static int for_in(KOS_COMP_UNIT      *program,
             if ( ! item_reg) {
                 TRY(lookup_var(program, var_node, &item_var, &item_cont_reg));
 
-                assert(item_var->type != VAR_LOCAL);
-                assert(item_var->type != VAR_ARGUMENT_IN_REG);
+                assert(item_var->in_cell || item_var->type != VAR_LOCAL);
+                assert(item_var->in_cell || item_var->type != VAR_ARGUMENT_IN_REG);
                 assert(item_var->type != VAR_MODULE);
             }
         }
@@ -2583,8 +3504,8 @@ static int for_in(KOS_COMP_UNIT      *program,
                 if ( ! dst_reg) {
                     TRY(lookup_var(program, cur_var_node, &item_var, &item_cont_reg));
 
-                    assert(item_var->type != VAR_LOCAL);
-                    assert(item_var->type != VAR_ARGUMENT_IN_REG);
+                    assert(item_var->in_cell || item_var->type != VAR_LOCAL);
+                    assert(item_var->in_cell || item_var->type != VAR_ARGUMENT_IN_REG);
                     assert(item_var->type != VAR_MODULE);
                 }
             }
@@ -2596,6 +3517,9 @@ static int for_in(KOS_COMP_UNIT      *program,
 
             TRY(gen_instr2(program, INSTR_NEXT, dst_reg->reg, item_reg->reg));
 
+            if (item_var && item_var->in_cell && (lhs_type != NT_LEFT_HAND_SIDE))
+                TRY(gen_new_cell(program, item_var));
+
             if (item_var)
                 TRY(gen_instr_set_array_var_elem(program, cur_var_node, item_var, item_cont_reg, dst_reg->reg));
 
@@ -2609,6 +3533,9 @@ static int for_in(KOS_COMP_UNIT      *program,
         assert( ! item_reg);
         TRY(gen_reg(program, &item_reg));
 
+        if (item_var->in_cell && (lhs_type != NT_LEFT_HAND_SIDE))
+            TRY(gen_new_cell(program, item_var));
+
         TRY(gen_instr_set_array_var_elem(program, var_node, item_var, item_cont_reg, item_reg->reg));
     }
 
@@ -2648,12 +3575,16 @@ static int for_in(KOS_COMP_UNIT      *program,
                 continue;
             }
 
+            /* Cells of loop variables are owned by the closures created in the loop */
+            if (cur_var_node->u.var->in_cell && (lhs_type != NT_LEFT_HAND_SIDE))
+                continue;
+
             assert( ! item_var);
             assert( ! item_cont_reg);
             TRY(lookup_var(program, cur_var_node, &item_var, &item_cont_reg));
 
-            assert(item_var->type != VAR_LOCAL);
-            assert(item_var->type != VAR_ARGUMENT_IN_REG);
+            assert(item_var->in_cell || item_var->type != VAR_LOCAL);
+            assert(item_var->in_cell || item_var->type != VAR_ARGUMENT_IN_REG);
             assert(item_var->type != VAR_MODULE);
 
             TRY(gen_reg(program, &dst_reg));
@@ -2668,7 +3599,7 @@ static int for_in(KOS_COMP_UNIT      *program,
             item_cont_reg = KOS_NULL;
         }
     }
-    else if (item_var) {
+    else if (item_var && ! (item_var->in_cell && (lhs_type != NT_LEFT_HAND_SIDE))) {
         assert(item_reg);
         TRY(gen_instr1(program, INSTR_LOAD_VOID, item_reg->reg));
 
@@ -2680,6 +3611,8 @@ static int for_in(KOS_COMP_UNIT      *program,
     free_reg(program, iter_reg);
     iter_reg = KOS_NULL;
 
+    release_loop_consts(program, outer_consts);
+
     pop_scope(program);
 
     program->cur_frame->last_try_scope = prev_try_scope;
@@ -2700,6 +3633,7 @@ static int for_range(KOS_COMP_UNIT      *program,
     KOS_REG            *step_reg       = KOS_NULL;
     KOS_REG            *item_cont_reg  = KOS_NULL;
     KOS_VAR            *item_var       = KOS_NULL;
+    KOS_CONST_REG      *outer_consts   = KOS_NULL;
     KOS_BREAK_OFFS     *old_break_offs = program->cur_frame->break_offs;
     KOS_SCOPE          *prev_try_scope = push_try_scope(program);
     KOS_NODE_TYPE       lhs_type;
@@ -2717,6 +3651,8 @@ static int for_range(KOS_COMP_UNIT      *program,
     assert(assg_node);
     assert(assg_node->type == NT_IN);
 
+    TRY(hoist_loop_consts(program, assg_node->next, &outer_consts));
+
     var_node = assg_node->children;
     assert(var_node);
     lhs_type = (KOS_NODE_TYPE)var_node->type;
@@ -2752,8 +3688,8 @@ static int for_range(KOS_COMP_UNIT      *program,
 
             TRY(lookup_var(program, var_node, &item_var, &item_cont_reg));
 
-            assert(item_var->type != VAR_LOCAL);
-            assert(item_var->type != VAR_ARGUMENT_IN_REG);
+            assert(item_var->in_cell || item_var->type != VAR_LOCAL);
+            assert(item_var->in_cell || item_var->type != VAR_ARGUMENT_IN_REG);
             assert(item_var->type != VAR_MODULE);
         }
 
@@ -2862,8 +3798,12 @@ static int for_range(KOS_COMP_UNIT      *program,
 
     if ((iter_reg != item_reg) && item_reg)
         TRY(gen_instr2(program, INSTR_MOVE, item_reg->reg, iter_reg->reg));
-    else if (item_var)
+    else if (item_var) {
+        if (item_var->in_cell && (lhs_type != NT_LEFT_HAND_SIDE))
+            TRY(gen_new_cell(program, item_var));
+
         TRY(gen_instr_set_array_var_elem(program, var_node, item_var, item_cont_reg, iter_reg->reg));
+    }
 
     TRY(gen_reg(program, &reg));
     TRY(gen_instr3(program, INSTR_CMP_LT, reg->reg,
@@ -2875,7 +3815,8 @@ static int for_range(KOS_COMP_UNIT      *program,
 
     if ((lhs_type == NT_LEFT_HAND_SIDE) && item_reg)
         TRY(gen_instr1(program, INSTR_LOAD_VOID, item_reg->reg));
-    else if (item_var) {
+    /* Cells of loop variables are owned by the closures created in the loop */
+    else if (item_var && ! (item_var->in_cell && (lhs_type != NT_LEFT_HAND_SIDE))) {
         assert(iter_reg);
         assert(iter_reg->tmp);
 
@@ -2894,6 +3835,8 @@ static int for_range(KOS_COMP_UNIT      *program,
     free_reg(program, end_reg);
     free_reg(program, step_reg);
 
+    release_loop_consts(program, outer_consts);
+
     pop_scope(program);
 
     program->cur_frame->last_try_scope = prev_try_scope;
@@ -2998,8 +3941,189 @@ cleanup:
 typedef struct KOS_SWITCH_CASE_S {
     uint32_t to_jump_entry;
     uint32_t final_jump_entry;
+    int      body_offs;
 } KOS_SWITCH_CASE;
 
+typedef struct KOS_SWITCH_TABLE_S {
+    uint32_t *jump_entries; /* Jump table entries, the first one is taken if no case matches */
+    int      *case_idx;     /* Index of case for each entry or -1 if the entry has no case */
+    int       num_entries;
+} KOS_SWITCH_TABLE;
+
+static const KOS_AST_NODE *get_case_value(KOS_COMP_UNIT      *program,
+                                          const KOS_AST_NODE *node)
+{
+    const KOS_AST_NODE *const_node;
+
+    assert(node->type == NT_CASE);
+    assert(node->children);
+
+    const_node = kos_get_const(program, node->children);
+
+    return const_node ? const_node : node->children;
+}
+
+static int get_int_case_value(const KOS_AST_NODE *node,
+                              int64_t            *value)
+{
+    KOS_NUMERIC numeric;
+
+    if (node->type != NT_NUMERIC_LITERAL)
+        return 0;
+
+    if (node->token.type == TT_NUMERIC_BINARY) {
+
+        assert(node->token.length == sizeof(KOS_NUMERIC));
+
+        numeric = *(const KOS_NUMERIC *)node->token.begin;
+    }
+    else if (kos_parse_numeric(node->token.begin,
+                               node->token.begin + node->token.length,
+                               &numeric))
+        return 0;
+
+    if (numeric.type != KOS_INTEGER_VALUE)
+        return 0;
+
+    *value = numeric.u.i;
+    return 1;
+}
+
+/* Generates SWITCH.INT or SWITCH.STR followed by a jump table, if all cases
+ * are integer or string constants.  Integer cases must be dense, so that
+ * at least half of the jump table entries are used.  If a jump table is not
+ * suitable, sets num_entries to 0 and generates nothing. */
+static int gen_switch_table(KOS_COMP_UNIT      *program,
+                            const KOS_AST_NODE *first_case_node,
+                            const KOS_REG      *value_reg,
+                            KOS_SWITCH_TABLE   *table)
+{
+    const KOS_AST_NODE *node;
+    int64_t             min_value     = 0;
+    int64_t             max_value     = 0;
+    int64_t             value         = 0;
+    int                 num_int_cases = 0;
+    int                 num_str_cases = 0;
+    int                 i_case;
+    int                 i;
+    int                 error         = KOS_SUCCESS;
+
+    table->num_entries = 0;
+
+    if ( ! program->optimize)
+        return KOS_SUCCESS;
+
+    for (node = first_case_node; node; node = node->next) {
+
+        const KOS_AST_NODE *value_node;
+
+        if (node->type == NT_DEFAULT)
+            continue;
+
+        value_node = get_case_value(program, node);
+
+        if (value_node->type == NT_STRING_LITERAL)
+            ++num_str_cases;
+        else if (get_int_case_value(value_node, &value)) {
+            if ( ! num_int_cases || value < min_value)
+                min_value = value;
+            if ( ! num_int_cases || value > max_value)
+                max_value = value;
+            ++num_int_cases;
+        }
+        else
+            return KOS_SUCCESS;
+    }
+
+    if ((num_int_cases && num_str_cases) || (num_int_cases + num_str_cases < KOS_MIN_SWITCH_TABLE))
+        return KOS_SUCCESS;
+
+    if (num_int_cases) {
+        /* Minimum value is encoded as signed immediate operand, which is at most 4 bytes */
+        if (min_value < -0x4000000 || min_value > 0x4000000)
+            return KOS_SUCCESS;
+
+        if ((uint64_t)max_value - (uint64_t)min_value >= (uint64_t)num_int_cases * 2U)
+            return KOS_SUCCESS;
+
+        table->num_entries = (int)(max_value - min_value) + 2;
+    }
+    else
+        table->num_entries = num_str_cases + 1;
+
+    table->jump_entries = (uint32_t *)KOS_mempool_alloc(&program->allocator,
+                                                        sizeof(uint32_t) * table->num_entries);
+    table->case_idx     = (int *)KOS_mempool_alloc(&program->allocator,
+                                                   sizeof(int) * table->num_entries);
+
+    if ( ! table->jump_entries || ! table->case_idx)
+        RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+    for (i = 0; i < table->num_entries; i++)
+        table->case_idx[i] = -1;
+
+    if (num_int_cases) {
+
+        for (i_case = 0, node = first_case_node; node; node = node->next, ++i_case) {
+
+            if (node->type == NT_DEFAULT)
+                continue;
+
+            get_int_case_value(get_case_value(program, node), &value);
+
+            i = (int)(value - min_value) + 1;
+
+            /* With duplicate cases, the first one wins */
+            if (table->case_idx[i] < 0)
+                table->case_idx[i] = i_case;
+        }
+
+        TRY(gen_instr3(program,
+                       INSTR_SWITCH_INT,
+                       value_reg->reg,
+                       (int32_t)min_value,
+                       table->num_entries - 1));
+    }
+    else {
+
+        KOS_COMP_SWITCH *const switch_const = (KOS_COMP_SWITCH *)KOS_mempool_alloc(
+                &program->allocator, sizeof(KOS_COMP_SWITCH) + sizeof(uint32_t) * (num_str_cases - 1));
+
+        if ( ! switch_const)
+            RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+        switch_const->header.type = KOS_COMP_CONST_SWITCH;
+        switch_const->num_cases   = (uint32_t)num_str_cases;
+
+        for (i = 1, i_case = 0, node = first_case_node; node; node = node->next, ++i_case) {
+
+            int str_idx = 0;
+
+            if (node->type == NT_DEFAULT)
+                continue;
+
+            TRY(gen_str(program, &get_case_value(program, node)->token, &str_idx));
+
+            switch_const->case_str_idx[i - 1] = (uint32_t)str_idx;
+            table->case_idx[i++]              = i_case;
+        }
+
+        add_constant(program, &switch_const->header);
+
+        TRY(gen_instr3(program,
+                       INSTR_SWITCH_STR,
+                       value_reg->reg,
+                       (int32_t)switch_const->header.index,
+                       num_str_cases));
+    }
+
+    for (i = 0; i < table->num_entries; i++)
+        TRY(gen_jump_table_entry(program, &table->jump_entries[i]));
+
+cleanup:
+    return error;
+}
+
 static int count_siblings(const KOS_AST_NODE *node)
 {
     int count = 0;
@@ -3024,6 +4148,7 @@ static int switch_stmt(KOS_COMP_UNIT      *program,
     uint32_t            final_jump_entry = KOS_NO_JUMP;
     KOS_SWITCH_CASE    *cases            = KOS_NULL;
     KOS_BREAK_OFFS     *old_break_offs   = program->cur_frame->break_offs;
+    KOS_SWITCH_TABLE    table;
 
     program->cur_frame->break_offs = KOS_NULL;
 
@@ -3075,9 +4200,18 @@ static int switch_stmt(KOS_COMP_UNIT      *program,
 
     first_case_node = node;
 
+    TRY(gen_switch_table(program, first_case_node, value_reg, &table));
+
     for (i_case = 0; node; node = node->next, ++i_case) {
 
-        if (node->type == NT_CASE) {
+        if (table.num_entries) {
+
+            cases[i_case].to_jump_entry = KOS_NO_JUMP;
+
+            if (node->type == NT_DEFAULT)
+                i_default_case = i_case;
+        }
+        else if (node->type == NT_CASE) {
 
             KOS_REG            *case_reg   = KOS_NULL;
             KOS_REG            *result_reg = KOS_NULL;
@@ -3144,10 +4278,12 @@ static int switch_stmt(KOS_COMP_UNIT      *program,
 
     assert(i_default_case < 0 || cases[i_default_case].to_jump_entry == KOS_NO_JUMP);
 
-    TRY(add_jump_instr(program, (i_default_case >= 0)
-                                ? &cases[i_default_case].to_jump_entry
-                                : &final_jump_entry));
-    TRY(gen_instr1(program, INSTR_JUMP, 0));
+    if ( ! table.num_entries) {
+        TRY(add_jump_instr(program, (i_default_case >= 0)
+                                    ? &cases[i_default_case].to_jump_entry
+                                    : &final_jump_entry));
+        TRY(gen_instr1(program, INSTR_JUMP, 0));
+    }
 
     node = first_case_node;
 
@@ -3159,9 +4295,13 @@ static int switch_stmt(KOS_COMP_UNIT      *program,
 
         child_node = child_node->next;
 
-        assert(cases[i_case].to_jump_entry != KOS_NO_JUMP);
+        cases[i_case].body_offs = program->cur_offs;
+
+        if ( ! table.num_entries) {
+            assert(cases[i_case].to_jump_entry != KOS_NO_JUMP);
 
-        set_jump_target(program, cases[i_case].to_jump_entry, program->cur_offs);
+            set_jump_target(program, cases[i_case].to_jump_entry, program->cur_offs);
+        }
 
         if (i_case)
             finish_fallthrough(program);
@@ -3191,6 +4331,15 @@ static int switch_stmt(KOS_COMP_UNIT      *program,
     if (final_jump_entry != KOS_NO_JUMP)
         set_jump_target(program, final_jump_entry, program->cur_offs);
 
+    for (i_case = 0; i_case < table.num_entries; ++i_case) {
+
+        const int case_idx = (table.case_idx[i_case] >= 0) ? table.case_idx[i_case] : i_default_case;
+
+        set_jump_target(program,
+                        table.jump_entries[i_case],
+                        (case_idx >= 0) ? cases[case_idx].body_offs : program->cur_offs);
+    }
+
     for (i_case = 0; i_case < num_cases; ++i_case) {
 
         const uint32_t entry = cases[i_case].final_jump_entry;
@@ -3280,7 +4429,12 @@ static int try_stmt(KOS_COMP_UNIT      *program,
         assert(variable->u.var);
 
         TRY(lookup_local_var(program, variable, &except_reg));
-        assert(except_reg);
+
+        /* Exception is moved to a new cell when entering the catch clause */
+        if ( ! except_reg) {
+            assert(variable->u.var->in_cell);
+            TRY(gen_reg(program, &except_reg));
+        }
 
         scope->catch_ref.catch_reg = except_reg;
     }
@@ -3330,6 +4484,13 @@ static int try_stmt(KOS_COMP_UNIT      *program,
 
         TRY(restore_parent_scope_catch(program));
 
+        if (except_reg->tmp) {
+            KOS_VAR *var = catch_node->children->children->u.var;
+
+            TRY(gen_new_cell(program, var));
+            TRY(gen_instr_set_elem(program, node, var->reg->reg, 0, except_reg->reg));
+        }
+
         node = node->next;
         assert(node);
         assert(!node->next);
@@ -3464,11 +4625,12 @@ static KOS_REG *super_prototype(KOS_COMP_UNIT      *program,
     return program->cur_frame->base_proto_reg;
 }
 
-static int get_global_idx(const char *global_name,
-                          uint16_t    global_length,
-                          int         module_idx,
-                          int         global_idx,
-                          void       *cookie)
+static int get_global_idx(const char                  *global_name,
+                          uint16_t                     global_length,
+                          int                          module_idx,
+                          int                          global_idx,
+                          const KOS_COMP_GLOBAL_CONST *value,
+                          void                        *cookie)
 {
     *(int *)cookie = global_idx;
     return KOS_SUCCESS;
@@ -3495,7 +4657,7 @@ static int refinement_module(KOS_COMP_UNIT      *program,
         KOS_UTF8_ESCAPE escape;
 
         /* TODO this does not work for escaped strings, kos_comp_resolve_global assumes NO_ESCAPE */
-        get_token_str(&node->token, &begin, &length, &escape);
+        kos_get_token_str(&node->token, &begin, &length, &escape);
 
         error = kos_comp_resolve_global(program->ctx,
                                         module_var->array_idx,
@@ -3679,6 +4841,23 @@ static int refinement(KOS_COMP_UNIT      *program,
 
     if ((node->type == NT_IDENTIFIER) && node->is_var) {
         module_var = node->u.var;
+
+        /* Property of an object literal replaced with registers */
+        if (module_var->is_scalar) {
+            int idx;
+
+            assert(ref_type == NT_REFINEMENT);
+            assert( ! out_obj);
+            assert(module_var->prop_regs);
+            assert(node->next->type == NT_STRING_LITERAL);
+
+            idx = kos_find_scalar_prop(module_var->value, &node->next->token);
+            assert(idx >= 0);
+
+            *reg = module_var->prop_regs[idx];
+            return KOS_SUCCESS;
+        }
+
         if (module_var->type != VAR_MODULE)
             module_var = KOS_NULL;
     }
@@ -3877,19 +5056,139 @@ static int estimate_initial_array_size(const KOS_AST_NODE *node)
     return KOS_min(count, 127);
 }
 
+static KOS_COMP_TEMPLATE *alloc_template(KOS_COMP_UNIT             *program,
+                                         enum KOS_COMP_CONST_TYPE_E type,
+                                         uint32_t                   num_items)
+{
+    KOS_COMP_TEMPLATE *const templ = (KOS_COMP_TEMPLATE *)KOS_mempool_alloc(
+            &program->allocator, sizeof(KOS_COMP_TEMPLATE) + sizeof(uint32_t) * (num_items - 1U));
+
+    if (templ) {
+        templ->header.type = type;
+        templ->num_items   = num_items;
+    }
+
+    return templ;
+}
+
+/* Returns non-zero if the value of the node can be stored in a template */
+static int is_template_literal(const KOS_AST_NODE *node)
+{
+    switch (node->type) {
+
+        case NT_NUMERIC_LITERAL: /* fall through */
+        case NT_STRING_LITERAL:  /* fall through */
+        case NT_BOOL_LITERAL:    /* fall through */
+        case NT_VOID_LITERAL:
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static int gen_template_value(KOS_COMP_UNIT      *program,
+                              const KOS_AST_NODE *node,
+                              uint32_t           *value)
+{
+    int error = KOS_SUCCESS;
+
+    switch (node->type) {
+
+        case NT_NUMERIC_LITERAL: {
+            KOS_NUMERIC numeric;
+            int32_t     const_idx = 0;
+
+            TRY(get_numeric_literal(program, node, &numeric));
+            TRY(gen_num_const(program, &numeric, &const_idx));
+
+            *value = (uint32_t)const_idx;
+            break;
+        }
+
+        case NT_STRING_LITERAL: {
+            int str_idx = 0;
+
+            TRY(gen_str(program, &node->token, &str_idx));
+
+            *value = (uint32_t)str_idx;
+            break;
+        }
+
+        case NT_BOOL_LITERAL:
+            *value = node->token.keyword == KW_TRUE ? KOS_COMP_TEMPLATE_TRUE : KOS_COMP_TEMPLATE_FALSE;
+            break;
+
+        default:
+            assert(node->type == NT_VOID_LITERAL);
+            *value = KOS_COMP_TEMPLATE_VOID;
+            break;
+    }
+
+cleanup:
+    return error;
+}
+
+/* Returns number of leading elements of an array literal, which can be stored
+ * in a template.  Non-constant elements are set with SET.ELEM8 after the template
+ * is copied, so only constant elements can be stored beyond index 127. */
+static int count_array_template_items(const KOS_AST_NODE *node,
+                                      int                *num_consts)
+{
+    int count = 0;
+
+    *num_consts = 0;
+
+    for ( ; node && node->type != NT_EXPAND; node = node->next, ++count) {
+
+        if (is_template_literal(node))
+            ++*num_consts;
+        else if (count > 127)
+            break;
+    }
+
+    return count;
+}
+
 static int gen_array(KOS_COMP_UNIT      *program,
                      const KOS_AST_NODE *node,
                      KOS_REG           **reg)
 {
-    int       error;
-    int       i;
-    const int num_fixed = estimate_initial_array_size(node);
+    int                error;
+    int                i;
+    int                num_consts = 0;
+    int                num_fixed  = count_array_template_items(node, &num_consts);
+    KOS_COMP_TEMPLATE *templ      = KOS_NULL;
 
     if (is_var_used(program, node, *reg))
         *reg = KOS_NULL;
 
     TRY(gen_reg(program, reg));
-    TRY(gen_load_array(program, node, (*reg)->reg, num_fixed));
+
+    if (num_consts >= KOS_MIN_ARRAY_TEMPLATE) {
+
+        const KOS_AST_NODE *elem_node = node;
+
+        templ = alloc_template(program, KOS_COMP_CONST_ARRAY_TEMPLATE, (uint32_t)num_fixed);
+        if ( ! templ)
+            RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+        for (i = 0; i < num_fixed; elem_node = elem_node->next, ++i) {
+            if (is_template_literal(elem_node))
+                TRY(gen_template_value(program, elem_node, &templ->items[i]));
+            else
+                templ->items[i] = KOS_COMP_TEMPLATE_VOID;
+        }
+
+        add_constant(program, &templ->header);
+
+        TRY(gen_instr2(program, INSTR_NEW_ARRAY_TEMPLATE, (*reg)->reg, (int32_t)templ->header.index));
+    }
+    else {
+        num_fixed = estimate_initial_array_size(node);
+
+        TRY(gen_load_array(program, node, (*reg)->reg, num_fixed));
+    }
 
     for (i = 0; node; node = node->next, ++i) {
 
@@ -3897,6 +5196,10 @@ static int gen_array(KOS_COMP_UNIT      *program,
         KOS_REG            *arg       = KOS_NULL;
         const int           expand    = node->type == NT_EXPAND ? 1 : 0;
 
+        /* Constant elements are already stored in the template */
+        if (templ && (i < num_fixed) && is_template_literal(elem_node))
+            continue;
+
         if (expand) {
             elem_node = node->children;
             assert(elem_node);
@@ -3909,8 +5212,10 @@ static int gen_array(KOS_COMP_UNIT      *program,
 
         assert(arg);
 
-        if (i < num_fixed)
+        if (i < num_fixed) {
+            assert(i <= 127);
             TRY(gen_instr3(program, INSTR_SET_ELEM8, (*reg)->reg, i, arg->reg));
+        }
         else if (expand)
             TRY(gen_instr2(program, INSTR_PUSH_EX, (*reg)->reg, arg->reg));
         else
@@ -4170,25 +5475,87 @@ static int invocation(KOS_COMP_UNIT      *program,
         if ( ! *reg && instr == INSTR_CALL)
             *reg = args;
 
-        if ( ! obj) {
-            TRY(gen_reg(program, &obj));
-            TRY(gen_instr1(program, INSTR_LOAD_VOID, obj->reg));
-        }
+        if ( ! obj) {
+            TRY(gen_reg(program, &obj));
+            TRY(gen_instr1(program, INSTR_LOAD_VOID, obj->reg));
+        }
+
+        if (instr == INSTR_CALL)
+            TRY(gen_instr4(program, instr, (*reg)->reg, fun->reg, obj->reg, args->reg));
+        else {
+            assert(instr == INSTR_TAIL_CALL);
+            TRY(gen_instr3(program, instr, fun->reg, obj->reg, args->reg));
+        }
+
+        if (args != *reg)
+            free_reg(program, args);
+    }
+
+    free_reg(program, fun);
+    if (obj)
+        free_reg(program, obj);
+
+cleanup:
+    return error;
+}
+
+static int inlined_invocation(KOS_COMP_UNIT      *program,
+                              const KOS_AST_NODE *node,
+                              KOS_REG           **reg)
+{
+    int                 error = KOS_SUCCESS;
+    const KOS_AST_NODE *params_node;
+    const KOS_AST_NODE *assg_node;
+
+    params_node = node->children;
+    assert(params_node);
+    assert(params_node->type == NT_PARAMETERS);
+
+    /* Evaluate arguments, which are bound to temporary variables */
+    for (assg_node = params_node->children; assg_node; assg_node = assg_node->next) {
+
+        KOS_REG *arg_reg = KOS_NULL;
+        KOS_VAR *var;
+
+        assert(assg_node->type == NT_ASSIGNMENT);
+        assert(assg_node->children->type == NT_IDENTIFIER);
+
+        var = assg_node->children->u.var;
+        assert(var);
+        assert(var->type == VAR_LOCAL);
+        assert( ! var->reg);
+
+        TRY(visit_node(program, assg_node->children->next, &arg_reg));
+        assert(arg_reg);
 
-        if (instr == INSTR_CALL)
-            TRY(gen_instr4(program, instr, (*reg)->reg, fun->reg, obj->reg, args->reg));
+        if (arg_reg->tmp)
+            var->reg = arg_reg;
         else {
-            assert(instr == INSTR_TAIL_CALL);
-            TRY(gen_instr3(program, instr, fun->reg, obj->reg, args->reg));
+            TRY(gen_reg(program, &var->reg));
+            TRY(gen_instr2(program, INSTR_MOVE, var->reg->reg, arg_reg->reg));
         }
 
-        if (args != *reg)
-            free_reg(program, args);
+        var->reg->tmp = 0;
     }
 
-    free_reg(program, fun);
-    if (obj)
-        free_reg(program, obj);
+    node = params_node->next;
+    assert(node);
+    assert( ! node->next);
+
+    TRY(visit_node(program, node, reg));
+
+    /* Release temporary variables, unless the expression returned one of them */
+    for (assg_node = params_node->children; assg_node; assg_node = assg_node->next) {
+
+        KOS_VAR *var = assg_node->children->u.var;
+
+        if (var->reg == *reg) {
+            var->reg->tmp = 1;
+            var->reg      = KOS_NULL;
+        }
+        else
+            free_scope_reg(program, var);
+    }
 
 cleanup:
     return error;
@@ -4411,6 +5778,7 @@ static int check_if_node_is_register(const KOS_AST_NODE *node,
     return reg &&
            node->type == NT_IDENTIFIER &&
            node->is_local_var &&
+           ! node->u.var->in_cell &&
            node->u.var->reg == reg;
 }
 
@@ -5043,8 +6411,8 @@ static int assign_non_local(KOS_COMP_UNIT      *program,
 
     TRY(lookup_var(program, node, &var, &container_reg));
 
-    assert(var->type != VAR_LOCAL);
-    assert(var->type != VAR_ARGUMENT_IN_REG);
+    assert(var->in_cell || var->type != VAR_LOCAL);
+    assert(var->in_cell || var->type != VAR_ARGUMENT_IN_REG);
     assert(var->type != VAR_MODULE);
 
     if (assg_op != OT_SET) {
@@ -5170,6 +6538,241 @@ cleanup:
     return error;
 }
 
+/* Declaration of an object literal, which is only used to read its properties.
+ * Instead of creating the object, each property is kept in its own register. */
+static int scalar_object(KOS_COMP_UNIT      *program,
+                         KOS_VAR            *var,
+                         const KOS_AST_NODE *node)
+{
+    KOS_RED_BLACK_NODE *prop_str_idcs = KOS_NULL;
+    const KOS_AST_NODE *child;
+    int                 num_props     = 0;
+    int                 i;
+    int                 error         = KOS_SUCCESS;
+
+    assert(node == var->value);
+    assert(node->type == NT_OBJECT_LITERAL);
+    assert( ! var->reg);
+    assert( ! var->prop_regs);
+
+    for (child = node->children; child; child = child->next)
+        ++num_props;
+
+    var->prop_regs = (KOS_REG **)KOS_mempool_alloc(&program->allocator,
+                                                   sizeof(KOS_REG *) * (size_t)(num_props + 1));
+    if ( ! var->prop_regs)
+        RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+    memset(var->prop_regs, 0, sizeof(KOS_REG *) * (size_t)(num_props + 1));
+
+    for (i = 0, node = node->children; node; node = node->next, ++i) {
+
+        int                 str_idx;
+        const KOS_AST_NODE *prop_node = node->children;
+        KOS_REG            *prop      = KOS_NULL;
+
+        assert(node->type == NT_PROPERTY);
+        assert(prop_node);
+        assert(prop_node->type == NT_STRING_LITERAL);
+
+        /* Report duplicate properties the same way as for a real object literal */
+        TRY(gen_str(program, &prop_node->token, &str_idx));
+        TRY(check_duplicate_prop(program, &prop_str_idcs, prop_node, str_idx));
+
+        TRY(gen_reg(program, &var->prop_regs[i]));
+        var->prop_regs[i]->tmp = 0;
+
+        prop = var->prop_regs[i];
+
+        TRY(visit_node(program, prop_node->next, &prop));
+        assert(prop);
+
+        if (prop != var->prop_regs[i]) {
+            TRY(gen_instr2(program, INSTR_MOVE, var->prop_regs[i]->reg, prop->reg));
+            free_reg(program, prop);
+        }
+    }
+
+cleanup:
+    return error;
+}
+
+static int is_side_effect_free(const KOS_AST_NODE *node)
+{
+    for ( ; node; node = node->next) {
+        switch (node->type) {
+
+            case NT_IDENTIFIER:
+                /* fall through */
+            case NT_NUMERIC_LITERAL:
+                /* fall through */
+            case NT_STRING_LITERAL:
+                /* fall through */
+            case NT_BOOL_LITERAL:
+                /* fall through */
+            case NT_VOID_LITERAL:
+                break;
+
+            default:
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int copy_to_tmp_reg(KOS_COMP_UNIT *program,
+                           KOS_REG      **reg)
+{
+    KOS_REG  *src   = *reg;
+    KOS_REG  *copy  = KOS_NULL;
+    const int error = gen_reg(program, &copy);
+
+    if (error)
+        return error;
+
+    *reg = copy;
+
+    return gen_instr2(program, INSTR_MOVE, copy->reg, src->reg);
+}
+
+static int is_unpacked_array(const KOS_AST_NODE *node,
+                             const KOS_AST_NODE *array_node)
+{
+    int num_targets = 0;
+    int num_elems   = 0;
+
+    if (array_node->type != NT_ARRAY_LITERAL)
+        return 0;
+
+    for ( ; node; node = node->next)
+        ++num_targets;
+
+    for (array_node = array_node->children; array_node; array_node = array_node->next) {
+        if (array_node->type == NT_EXPAND)
+            return 0;
+        ++num_elems;
+    }
+
+    /* Not enough elements results in an exception */
+    return num_elems >= num_targets;
+}
+
+/* Multi assignment from an array literal, the array is not created.
+ * All elements are evaluated first and then assigned to the targets. */
+static int unpack_array(KOS_COMP_UNIT      *program,
+                        int                 is_lhs,
+                        const KOS_AST_NODE *node,
+                        const KOS_AST_NODE *elem_node)
+{
+    const KOS_AST_NODE *target;
+    KOS_REG           **elems;
+    KOS_REG            *aux         = KOS_NULL;
+    int                 num_elems   = 0;
+    int                 has_members = 0;
+    int                 i;
+    int                 error       = KOS_SUCCESS;
+
+    for (target = elem_node; target; target = target->next)
+        ++num_elems;
+
+    elems = (KOS_REG **)KOS_mempool_alloc(&program->allocator, sizeof(KOS_REG *) * (size_t)num_elems);
+    if ( ! elems)
+        RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+    target = node;
+
+    for (i = 0; elem_node; elem_node = elem_node->next, ++i) {
+
+        KOS_REG *dest = KOS_NULL;
+
+        if (target) {
+            /* New variables are not visible in the array, so evaluate directly into them */
+            if ( ! is_lhs && target->type == NT_IDENTIFIER)
+                TRY(gen_reg_for_assigned_var(program, target, 0, &dest));
+
+            if (target->type == NT_REFINEMENT || target->type == NT_SLICE)
+                has_members = 1;
+
+            target = target->next;
+        }
+
+        elems[i] = dest;
+
+        TRY(visit_node(program, elem_node, &elems[i]));
+        assert(elems[i]);
+
+        if (dest && elems[i] != dest) {
+            TRY(gen_instr2(program, INSTR_MOVE, dest->reg, elems[i]->reg));
+            free_reg(program, elems[i]);
+            elems[i] = dest;
+        }
+        /* Subsequent elements can modify the variable */
+        else if ( ! dest && ! elems[i]->tmp && ! is_side_effect_free(elem_node->next))
+            TRY(copy_to_tmp_reg(program, &elems[i]));
+    }
+
+    for (i = 0, target = node; i < num_elems; ++i) {
+
+        KOS_REG *reg = KOS_NULL;
+        int      j;
+
+        if ( ! target) {
+            free_reg(program, elems[i]);
+            continue;
+        }
+
+        /* Assigning to a member can invoke a setter, which can modify variables */
+        if (has_members) {
+            for (j = i; j < num_elems; ++j)
+                if ( ! elems[j]->tmp)
+                    TRY(copy_to_tmp_reg(program, &elems[j]));
+            has_members = 0;
+        }
+
+        if (target->type == NT_IDENTIFIER)
+            TRY(gen_reg_for_assigned_var(program, target, 1, &reg));
+
+        if (reg) {
+            /* Preserve values of variables which are yet to be assigned, e.g. a, b = [b, a] */
+            for (j = i + 1; j < num_elems; ++j)
+                if (elems[j] == reg)
+                    TRY(copy_to_tmp_reg(program, &elems[j]));
+
+            if (elems[i] != reg) {
+                TRY(gen_instr2(program, INSTR_MOVE, reg->reg, elems[i]->reg));
+                free_reg(program, elems[i]);
+            }
+        }
+        else {
+            reg = elems[i];
+
+            if (target->type == NT_REFINEMENT)
+                TRY(assign_member(program, OT_SET, target, reg, &aux));
+
+            else if (target->type == NT_IDENTIFIER)
+                TRY(assign_non_local(program, OT_SET, target, reg, &aux));
+
+            else if (target->type != NT_PLACEHOLDER) {
+
+                assert(target->type == NT_SLICE);
+                TRY(assign_slice(program, target, reg));
+                reg = KOS_NULL; /* assign_slice frees the register */
+            }
+
+            assert( ! aux);
+
+            if (reg)
+                free_reg(program, reg);
+        }
+
+        target = target->next;
+    }
+
+cleanup:
+    return error;
+}
+
 static int assignment(KOS_COMP_UNIT      *program,
                       const KOS_AST_NODE *assg_node)
 {
@@ -5209,11 +6812,22 @@ static int assignment(KOS_COMP_UNIT      *program,
     node = node->children;
     assert(node);
 
+    if ( ! is_lhs)
+        TRY(gen_new_cells(program, node));
+
+    if (node_type == NT_MULTI_ASSIGNMENT && is_unpacked_array(node, rhs_node)) {
+        assert(assg_node->token.op == OT_SET);
+        return unpack_array(program, is_lhs, node, rhs_node->children);
+    }
+
     if (node_type == NT_ASSIGNMENT) {
 
         assert( ! node->next);
         assert(node->type != NT_PLACEHOLDER);
 
+        if ( ! is_lhs && node->u.var->is_scalar)
+            return scalar_object(program, node->u.var, rhs_node);
+
         if (assg_node->token.op != OT_SET)
             /* TODO check lhs variable type */
             TRY(check_const_literal(program, rhs_node,
@@ -5379,41 +6993,41 @@ static int identifier(KOS_COMP_UNIT      *program,
         assert(constant->header.type == KOS_COMP_CONST_FUNCTION);
         assert(constant->load_instr == INSTR_LOAD_CONST);
 
-        TRY(gen_reg(program, reg));
-
-        TRY(gen_instr2(program,
-                       INSTR_LOAD_CONST,
-                       (*reg)->reg,
-                       (int32_t)constant->header.index));
+        TRY(gen_load_invariant(program, reg, INSTR_LOAD_CONST, (int32_t)constant->header.index));
     }
     else {
 
         KOS_VAR *var           = KOS_NULL;
         KOS_REG *container_reg = KOS_NULL;
 
-        TRY(gen_reg(program, reg));
-
         TRY(lookup_var(program, node, &var, &container_reg));
 
-        assert(var->type != VAR_LOCAL);
-        assert(var->type != VAR_ARGUMENT_IN_REG);
+        assert(var->in_cell || var->type != VAR_LOCAL);
+        assert(var->in_cell || var->type != VAR_ARGUMENT_IN_REG);
 
         switch (var->type) {
 
             case VAR_GLOBAL:
-                TRY(gen_instr2(program, INSTR_GET_GLOBAL, (*reg)->reg, var->array_idx));
+                if (var->is_const)
+                    TRY(gen_load_invariant(program, reg, INSTR_GET_GLOBAL, var->array_idx));
+                else {
+                    TRY(gen_reg(program, reg));
+                    TRY(gen_instr2(program, INSTR_GET_GLOBAL, (*reg)->reg, var->array_idx));
+                }
                 break;
 
             case VAR_IMPORTED:
+                TRY(gen_reg(program, reg));
                 TRY(gen_instr3(program, INSTR_GET_MOD_ELEM, (*reg)->reg, var->module_idx, var->array_idx));
                 break;
 
             case VAR_MODULE:
-                TRY(gen_instr2(program, INSTR_GET_MOD, (*reg)->reg, var->array_idx));
+                TRY(gen_load_invariant(program, reg, INSTR_GET_MOD, var->array_idx));
                 break;
 
             default:
                 assert(container_reg);
+                TRY(gen_reg(program, reg));
                 TRY(gen_instr_get_elem(program, node, (*reg)->reg, container_reg->reg, var->array_idx));
                 break;
         }
@@ -5428,30 +7042,18 @@ static int numeric_literal(KOS_COMP_UNIT      *program,
                            KOS_REG           **reg)
 {
     KOS_NUMERIC numeric;
+    int32_t     const_idx;
     int         error;
 
-    TRY(gen_reg(program, reg));
-
-    if (node->token.type == TT_NUMERIC_BINARY) {
-
-        const KOS_NUMERIC *value = (const KOS_NUMERIC *)node->token.begin;
-
-        assert(node->token.length == sizeof(KOS_NUMERIC));
+    TRY(get_numeric_literal(program, node, &numeric));
 
-        numeric = *value;
-    }
-    else
-        error = kos_parse_numeric(node->token.begin,
-                                  node->token.begin + node->token.length,
-                                  &numeric);
+    if (numeric.type == KOS_INTEGER_VALUE && is_sint8(numeric.u.i))
+        TRY(gen_load_invariant(program, reg, INSTR_LOAD_INT8, (int32_t)numeric.u.i));
+    else {
+        TRY(gen_num_const(program, &numeric, &const_idx));
 
-    if (error) {
-        program->error_token = &node->token;
-        program->error_str   = str_err_invalid_numeric_literal;
-        error = KOS_ERROR_COMPILE_FAILED;
+        TRY(gen_load_invariant(program, reg, INSTR_LOAD_CONST, const_idx));
     }
-    else
-        error = gen_load_number(program, (*reg)->reg, &numeric);
 
 cleanup:
     return error;
@@ -5466,12 +7068,8 @@ static int string_literal(KOS_COMP_UNIT      *program,
 
     error = gen_str(program, &node->token, &str_idx);
 
-    if (!error) {
-        error = gen_reg(program, reg);
-
-        if (!error)
-            error = gen_instr2(program, INSTR_LOAD_CONST, (*reg)->reg, str_idx);
-    }
+    if (!error)
+        error = gen_load_invariant(program, reg, INSTR_LOAD_CONST, str_idx);
 
     return error;
 }
@@ -5556,6 +7154,28 @@ static int gen_closure_regs(KOS_RED_BLACK_NODE *node,
     return error;
 }
 
+static int gen_var_ref_regs(KOS_RED_BLACK_NODE *node,
+                            void               *cookie)
+{
+    KOS_VAR_REF          *ref  = (KOS_VAR_REF *)node;
+    KOS_GEN_CLOSURE_ARGS *args = (KOS_GEN_CLOSURE_ARGS *)cookie;
+
+    const int error = gen_reg(args->program, &ref->reg);
+
+    if ( ! error) {
+        ++args->num_binds;
+        ref->reg->tmp = 0;
+        ref->reg_idx  = ref->reg->reg;
+        if (args->bind_reg == KOS_NO_REG)
+            args->bind_reg = (uint8_t)ref->reg_idx;
+        else {
+            assert((unsigned)ref->reg_idx == args->bind_reg + args->num_binds - 1U);
+        }
+    }
+
+    return error;
+}
+
 typedef struct KOS_BIND_ARGS_S {
     KOS_COMP_UNIT *program;
     KOS_REG       *func_reg;
@@ -5632,6 +7252,39 @@ cleanup:
     return error;
 }
 
+static int gen_var_binds(KOS_RED_BLACK_NODE *node,
+                         void               *cookie)
+{
+    const KOS_VAR_REF *ref  = (const KOS_VAR_REF *)node;
+    KOS_BIND_ARGS     *args = (KOS_BIND_ARGS *)cookie;
+    const KOS_VAR     *var  = ref->var;
+    int                src_reg;
+
+    assert(ref->reg);
+    assert(ref->reg_idx >= args->delta);
+
+    /* Copy the value from the variable in the parent function or from
+     * the parent function's own copy */
+    if (var->scope->owning_frame == args->parent_frame) {
+        assert(var->reg);
+        src_reg = var->reg->reg;
+    }
+    else {
+        const KOS_VAR_REF *other_ref = kos_find_var_ref(args->parent_frame, var);
+
+        assert(other_ref);
+        assert(args->parent_frame->num_binds);
+
+        src_reg = other_ref->reg_idx;
+    }
+
+    return gen_instr3(args->program,
+                      INSTR_BIND,
+                      args->func_reg->reg,
+                      ref->reg_idx - args->delta,
+                      src_reg);
+}
+
 static void free_arg_reg(KOS_COMP_UNIT *program,
                          KOS_VAR       *var)
 {
@@ -5953,6 +7606,9 @@ static int gen_function(KOS_COMP_UNIT      *program,
         /* Closures from outer scopes */
         TRY(kos_red_black_walk(frame->closures, gen_closure_regs, &args));
 
+        /* Constants from outer scopes */
+        TRY(kos_red_black_walk(frame->captured_vars, gen_var_ref_regs, &args));
+
         constant->bind_reg  = args.bind_reg;
         constant->num_binds = args.num_binds;
     }
@@ -5985,6 +7641,23 @@ static int gen_function(KOS_COMP_UNIT      *program,
     for (var = scope->vars; var; var = var->scope_next)
         free_arg_reg(program, var);
 
+    /* Move modified arguments captured by closures to cells */
+    for (var = scope->vars; var; var = var->scope_next) {
+        if (var->in_cell) {
+            KOS_REG *cell_reg = KOS_NULL;
+
+            assert(var->type == VAR_ARGUMENT_IN_REG);
+            assert(var->reg);
+
+            TRY(gen_reg(program, &cell_reg));
+            TRY(gen_instr2(program, INSTR_NEW_ARRAY8, cell_reg->reg, 1));
+            TRY(gen_instr3(program, INSTR_SET_ELEM8, cell_reg->reg, 0, var->reg->reg));
+            TRY(gen_instr2(program, INSTR_MOVE, var->reg->reg, cell_reg->reg));
+
+            free_reg(program, cell_reg);
+        }
+    }
+
     /* Invoke super constructor if not invoked explicitly */
     if (needs_super_ctor && ! frame->uses_base_ctor)
         TRY(super_invocation(program, KOS_NULL, KOS_NULL));
@@ -6091,6 +7764,7 @@ static int function_literal(KOS_COMP_UNIT      *program,
         bind_args.parent_frame = program->cur_frame;
         bind_args.delta        = constant->bind_reg;
         TRY(kos_red_black_walk(frame->closures, gen_binds, &bind_args));
+        TRY(kos_red_black_walk(frame->captured_vars, gen_var_binds, &bind_args));
     }
 
     /* Find the first default arg */
@@ -6237,6 +7911,83 @@ static int prop_compare_node(KOS_RED_BLACK_NODE *a,
     return a_node->str_idx - b_node->str_idx;
 }
 
+static int check_duplicate_prop(KOS_COMP_UNIT       *program,
+                                KOS_RED_BLACK_NODE **prop_str_idcs,
+                                const KOS_AST_NODE  *prop_node,
+                                int                  str_idx)
+{
+    KOS_OBJECT_PROP_DUPE *new_node;
+
+    if (kos_red_black_find(*prop_str_idcs, (void *)(intptr_t)str_idx, prop_compare_item)) {
+        program->error_token = &prop_node->token;
+        program->error_str   = str_err_duplicate_property;
+        return KOS_ERROR_COMPILE_FAILED;
+    }
+
+    new_node = (KOS_OBJECT_PROP_DUPE *)
+        KOS_mempool_alloc(&program->allocator, sizeof(KOS_OBJECT_PROP_DUPE));
+
+    if ( ! new_node)
+        return KOS_ERROR_OUT_OF_MEMORY;
+
+    new_node->str_idx = str_idx;
+
+    kos_red_black_insert(prop_str_idcs,
+                         (KOS_RED_BLACK_NODE *)new_node,
+                         prop_compare_node);
+
+    return KOS_SUCCESS;
+}
+
+/* Generates a template with all property names of an object literal
+ * and values of properties, which are literals */
+static int gen_obj_template(KOS_COMP_UNIT       *program,
+                            const KOS_AST_NODE  *node,
+                            KOS_RED_BLACK_NODE **prop_str_idcs,
+                            int                  num_props,
+                            int32_t             *const_idx)
+{
+    int                error = KOS_SUCCESS;
+    uint32_t           i     = 0;
+    KOS_COMP_TEMPLATE *templ = alloc_template(program,
+                                              KOS_COMP_CONST_OBJ_TEMPLATE,
+                                              (uint32_t)num_props * 2U);
+
+    if ( ! templ)
+        RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+    for ( ; node; node = node->next, i += 2) {
+
+        int                 str_idx    = 0;
+        const KOS_AST_NODE *prop_node  = node->children;
+        const KOS_AST_NODE *value_node = prop_node->next;
+
+        assert(node->type == NT_PROPERTY);
+        assert(prop_node->type == NT_STRING_LITERAL);
+        assert(value_node);
+
+        TRY(gen_str(program, &prop_node->token, &str_idx));
+
+        TRY(check_duplicate_prop(program, prop_str_idcs, prop_node, str_idx));
+
+        templ->items[i] = (uint32_t)str_idx;
+
+        if (is_template_literal(value_node))
+            TRY(gen_template_value(program, value_node, &templ->items[i + 1]));
+        else
+            templ->items[i + 1] = KOS_COMP_TEMPLATE_VOID;
+    }
+
+    assert(i == templ->num_items);
+
+    add_constant(program, &templ->header);
+
+    *const_idx = (int32_t)templ->header.index;
+
+cleanup:
+    return error;
+}
+
 static int object_literal(KOS_COMP_UNIT      *program,
                           const KOS_AST_NODE *node,
                           KOS_REG           **reg,
@@ -6244,24 +7995,39 @@ static int object_literal(KOS_COMP_UNIT      *program,
                           KOS_REG            *prototype)
 {
     KOS_RED_BLACK_NODE *prop_str_idcs = KOS_NULL;
-    int                 proto_reg;
+    const KOS_AST_NODE *child;
+    int                 num_props     = 0;
+    int                 use_template  = 0;
     int                 error;
 
+    for (child = node->children; child; child = child->next)
+        ++num_props;
+
     if (prototype) {
         if ( ! *reg || (*reg == prototype && ! prototype->tmp)) {
             *reg = KOS_NULL;
             TRY(gen_reg(program, reg));
         }
 
-        proto_reg = prototype->reg;
+        TRY(gen_instr2(program, INSTR_NEW_OBJ, (*reg)->reg, prototype->reg));
     }
     else {
         TRY(gen_reg(program, reg));
 
-        proto_reg = KOS_NO_REG;
-    }
+        /* The template holds a property table which already has all the properties,
+         * so setting the remaining non-constant properties does not resize it */
+        if (num_props >= KOS_MIN_OBJ_TEMPLATE) {
+            int32_t const_idx = 0;
 
-    TRY(gen_instr2(program, INSTR_NEW_OBJ, (*reg)->reg, proto_reg));
+            TRY(gen_obj_template(program, node->children, &prop_str_idcs, num_props, &const_idx));
+
+            TRY(gen_instr2(program, INSTR_NEW_OBJ_TEMPLATE, (*reg)->reg, const_idx));
+
+            use_template = 1;
+        }
+        else
+            TRY(gen_instr2(program, INSTR_NEW_OBJ, (*reg)->reg, KOS_NO_REG));
+    }
 
     assert(*reg);
 
@@ -6274,30 +8040,18 @@ static int object_literal(KOS_COMP_UNIT      *program,
         assert(node->type == NT_PROPERTY);
         assert(prop_node);
         assert(prop_node->type == NT_STRING_LITERAL);
+        assert(prop_node->next);
 
-        TRY(gen_str(program, &prop_node->token, &str_idx));
-
-        if (kos_red_black_find(prop_str_idcs, (void *)(intptr_t)str_idx, prop_compare_item)) {
-            program->error_token = &prop_node->token;
-            program->error_str   = str_err_duplicate_property;
-            RAISE_ERROR(KOS_ERROR_COMPILE_FAILED);
-        }
-        else {
-            KOS_OBJECT_PROP_DUPE *new_node = (KOS_OBJECT_PROP_DUPE *)
-                KOS_mempool_alloc(&program->allocator, sizeof(KOS_OBJECT_PROP_DUPE));
-
-            if ( ! new_node)
-                RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+        /* Property values which are literals are already stored in the template */
+        if (use_template && is_template_literal(prop_node->next))
+            continue;
 
-            new_node->str_idx = str_idx;
+        TRY(gen_str(program, &prop_node->token, &str_idx));
 
-            kos_red_black_insert(&prop_str_idcs,
-                                 (KOS_RED_BLACK_NODE *)new_node,
-                                 prop_compare_node);
-        }
+        if ( ! use_template)
+            TRY(check_duplicate_prop(program, &prop_str_idcs, prop_node, str_idx));
 
         prop_node = prop_node->next;
-        assert(prop_node);
         assert(!prop_node->next);
 
         assert(prop_node->type != NT_CONSTRUCTOR_LITERAL);
@@ -6539,6 +8293,9 @@ static int visit_node(KOS_COMP_UNIT      *program,
         case NT_OPERATOR:
             error = process_operator(program, node, reg);
             break;
+        case NT_INLINE:
+            error = inlined_invocation(program, node, reg);
+            break;
         case NT_ASSIGNMENT:
             /* fall through */
         case NT_MULTI_ASSIGNMENT:
@@ -6601,8 +8358,9 @@ void kos_compiler_init(KOS_COMP_UNIT *program,
 {
     memset(program, 0, sizeof(*program));
 
-    program->optimize = 1;
-    program->file_id  = file_id;
+    program->optimize     = 1;
+    program->inline_funcs = 1;
+    program->file_id      = file_id;
 
     KOS_mempool_init(&program->allocator);
 
@@ -6611,6 +8369,7 @@ void kos_compiler_init(KOS_COMP_UNIT *program,
     KOS_vector_init(&program->addr2line_buf);
     KOS_vector_init(&program->addr2line_gen_buf);
     KOS_vector_init(&program->jump_buf);
+    KOS_vector_init(&program->peephole_buf);
 }
 
 int kos_compiler_compile(KOS_COMP_UNIT *program,
@@ -6643,6 +8402,8 @@ int kos_compiler_compile(KOS_COMP_UNIT *program,
 
     TRY(kos_allocate_args(program, ast));
 
+    kos_compute_live_ranges(ast);
+
     {
         PROF_ZONE_N(COMPILER, generate_code)
 
@@ -6666,6 +8427,7 @@ void kos_compiler_destroy(KOS_COMP_UNIT *program)
     KOS_vector_destroy(&program->addr2line_gen_buf);
     KOS_vector_destroy(&program->addr2line_buf);
     KOS_vector_destroy(&program->jump_buf);
+    KOS_vector_destroy(&program->peephole_buf);
 
     kos_destroy_hash_table(&program->variables);
 
@@ -44,6 +44,7 @@ typedef struct KOS_VAR_S {
     const KOS_TOKEN    *token;
     KOS_REG            *reg;
     const KOS_AST_NODE *value;
+    KOS_REG           **prop_regs;         /* Registers holding properties of a scalar-replaced object */
     struct KOS_VAR_S   *shadowed_var;      /* Shadowed variable in the hash table                   */
     uint32_t            hash;              /* Hash used as index in the hash table                  */
     int                 num_reads;         /* Number of reads from a variable (including closures)  */
@@ -51,11 +52,17 @@ typedef struct KOS_VAR_S {
     int                 num_assignments;   /* Number of writes to a variable (including closures)   */
     int                 local_reads;       /* Number of local reads from a variable                 */
     int                 local_assignments; /* Number of local writes to a variable                  */
+    int                 num_prop_reads;    /* Number of local reads of object literal properties    */
     int                 module_idx;        /* Index of module when type == VAR_IMPORTED             */
     int                 array_idx;
+    const KOS_AST_NODE *release_node;      /* Last statement in var's scope which uses the variable */
     unsigned            type         : 7;
     unsigned            is_const     : 1;
     unsigned            has_defaults : 1;
+    unsigned            by_value     : 1; /* Closures capture a copy of the value         */
+    unsigned            early_bind   : 1; /* Captured by a closure before being assigned */
+    unsigned            is_scalar    : 1; /* Object literal replaced with its properties  */
+    unsigned            in_cell      : 1; /* Modified, captured by closures in a cell     */
 } KOS_VAR;
 
 #define KOS_NO_JUMP (~0u)
@@ -71,6 +78,14 @@ typedef struct KOS_RETURN_OFFS_S {
     uint32_t                  entry;
 } KOS_RETURN_OFFS;
 
+/* Register holding a constant loaded before a loop */
+typedef struct KOS_CONST_REG_S {
+    struct KOS_CONST_REG_S *next;
+    KOS_REG                *reg;
+    int32_t                 instr;   /* Instruction which loads the constant */
+    int32_t                 operand; /* Operand of the instruction           */
+} KOS_CONST_REG;
+
 typedef struct KOS_CATCH_REF_S {
     struct KOS_SCOPE_S *next;            /* Used by child_scopes */
     struct KOS_SCOPE_S *child_scopes;    /* List of child scopes which need to update catch offset to this scope */
@@ -107,6 +122,7 @@ typedef struct KOS_FRAME_S {
     KOS_REG                    *base_ctor_reg;
     KOS_REG                    *base_proto_reg;
     KOS_RED_BLACK_NODE         *closures;
+    KOS_RED_BLACK_NODE         *captured_vars;    /* Variables from outer scopes captured by value */
     struct KOS_FRAME_S         *parent_frame;
     const KOS_TOKEN            *fun_token;
     KOS_BREAK_OFFS             *break_offs;
@@ -114,15 +130,19 @@ typedef struct KOS_FRAME_S {
     KOS_SCOPE                  *last_try_scope;
     const KOS_TOKEN            *yield_token;
     struct KOS_COMP_FUNCTION_S *constant;         /* The template for the constant object, used with LOAD.CONST */
+    KOS_CONST_REG              *const_regs;       /* Constants hoisted out of loops                             */
     int                         num_def_used;     /* Number of used default args, for optimization              */
     int                         num_binds;        /* Number of closure accesses, for optimization               */
     int                         num_binds_prev;   /* Number of closure accesses in previous optimization cycle  */
     int                         num_self_refs;    /* Number of function's self-references                       */
+    int                         num_inlined;      /* Number of AST nodes inlined into this function             */
+    int                         num_const_regs;   /* Number of constants hoisted out of loops                   */
     int                         num_regs;
     uint32_t                    num_instr;
     unsigned                    uses_base_ctor  : 1;
     unsigned                    uses_base_proto : 1;
     unsigned                    is_open         : 1; /* Set to 1 when processing this frame */
+    unsigned                    hoist_consts    : 1; /* Set to 1 when loading constants before a loop */
 } KOS_FRAME;
 
 typedef struct KOS_SCOPE_REF_S {
@@ -137,12 +157,24 @@ typedef struct KOS_SCOPE_REF_S {
     unsigned           exported_args;
 } KOS_SCOPE_REF;
 
+/* Constant variable from an outer scope, which is bound to the closure by value */
+typedef struct KOS_VAR_REF_S {
+    KOS_RED_BLACK_NODE rb_tree_node;
+
+    KOS_VAR           *var;
+    KOS_REG           *reg;
+    int                reg_idx;
+} KOS_VAR_REF;
+
 enum KOS_COMP_CONST_TYPE_E {
     KOS_COMP_CONST_INTEGER,
     KOS_COMP_CONST_FLOAT,
     KOS_COMP_CONST_STRING,
     KOS_COMP_CONST_FUNCTION,
-    KOS_COMP_CONST_PROTOTYPE
+    KOS_COMP_CONST_PROTOTYPE,
+    KOS_COMP_CONST_SWITCH,
+    KOS_COMP_CONST_OBJ_TEMPLATE,
+    KOS_COMP_CONST_ARRAY_TEMPLATE
 };
 
 enum KOS_COMP_FUNC_FLAGS_E {
@@ -208,6 +240,28 @@ typedef struct KOS_COMP_FUNCTION_S {
     uint32_t       arg_name_str_idx[1]; /* Array of constant indexes containing argument names */
 } KOS_COMP_FUNCTION;
 
+/* Table for SWITCH.STR, the case string at index i maps to jump table entry i + 1 */
+typedef struct KOS_COMP_SWITCH_S {
+    KOS_COMP_CONST header;
+    uint32_t       num_cases;
+    uint32_t       case_str_idx[1];     /* Array of constant indexes containing case strings */
+} KOS_COMP_SWITCH;
+
+/* Special values in a template, which do not refer to constants */
+#define KOS_COMP_TEMPLATE_VOID  0xFFFFFFFFU
+#define KOS_COMP_TEMPLATE_FALSE 0xFFFFFFFEU
+#define KOS_COMP_TEMPLATE_TRUE  0xFFFFFFFDU
+
+/* Template for NEW.OBJ.TEMPLATE and NEW.ARRAY.TEMPLATE.  For objects, items
+ * are pairs of key string index and value, for arrays items are values.
+ * Values are constant indexes or KOS_COMP_TEMPLATE_* special values.
+ * Non-constant values are stored as void and set after the template is copied. */
+typedef struct KOS_COMP_TEMPLATE_S {
+    KOS_COMP_CONST header;
+    uint32_t       num_items;
+    uint32_t       items[1];
+} KOS_COMP_TEMPLATE;
+
 typedef struct KOS_PRE_GLOBAL_S {
     struct KOS_PRE_GLOBAL_S *next;
     KOS_AST_NODE             node;
@@ -232,6 +286,7 @@ typedef struct KOS_COMP_UNIT_S {
     const char          *error_str;
 
     int                  optimize;
+    int                  inline_funcs; /* Enables inlining of calls to small functions */
     int                  num_optimizations;
 
     uint16_t             file_id;
@@ -267,6 +322,8 @@ typedef struct KOS_COMP_UNIT_S {
     KOS_VECTOR           addr2line_gen_buf;
 
     KOS_VECTOR           jump_buf;
+
+    KOS_VECTOR           peephole_buf;
 } KOS_COMP_UNIT;
 
 void kos_compiler_init(KOS_COMP_UNIT *program,
@@ -291,6 +348,14 @@ void kos_compiler_destroy(KOS_COMP_UNIT *program);
 const KOS_AST_NODE *kos_get_const(KOS_COMP_UNIT      *program,
                                   const KOS_AST_NODE *node);
 
+int kos_find_scalar_prop(const KOS_AST_NODE *obj_node,
+                         const KOS_TOKEN    *key);
+
+void kos_get_token_str(const KOS_TOKEN *token,
+                       const char     **out_begin,
+                       uint16_t        *out_length,
+                       KOS_UTF8_ESCAPE *out_escape);
+
 int kos_node_is_truthy(KOS_COMP_UNIT      *program,
                        const KOS_AST_NODE *node);
 
@@ -306,11 +371,20 @@ int kos_optimize(KOS_COMP_UNIT *program,
 int kos_allocate_args(KOS_COMP_UNIT *program,
                       KOS_AST_NODE  *ast);
 
+void kos_compute_live_ranges(const KOS_AST_NODE *ast);
+
 int kos_is_self_ref_func(const KOS_AST_NODE *node);
 
 KOS_SCOPE_REF *kos_find_scope_ref(KOS_FRAME *frame,
                                   KOS_SCOPE *closure);
 
+KOS_VAR_REF *kos_find_var_ref(KOS_FRAME     *frame,
+                              const KOS_VAR *var);
+
+int kos_add_var_ref(KOS_COMP_UNIT *program,
+                    KOS_FRAME     *frame,
+                    KOS_VAR       *var);
+
 int kos_get_module_path_name(KOS_COMP_UNIT       *program,
                              const KOS_AST_NODE  *node,
                              const char         **module_name,
@@ -324,11 +398,26 @@ int kos_comp_import_module(void       *ctx,
                            uint16_t    name_len,
                            int        *module_idx);
 
-typedef int (*KOS_COMP_WALK_GLOBALS_CALLBACK)(const char *global_name,
-                                              uint16_t    global_length,
-                                              int         module_idx,
-                                              int         global_idx,
-                                              void       *cookie);
+/* Value of a global, which does not change after its module has been loaded */
+typedef struct KOS_COMP_GLOBAL_CONST_S {
+    KOS_NODE_TYPE type;        /* NT_NUMERIC_LITERAL, NT_STRING_LITERAL, NT_BOOL_LITERAL or NT_VOID_LITERAL */
+    int           is_float;
+    int64_t       int_value;   /* Value of integer or boolean */
+    double        float_value;
+    const char   *str;         /* UTF-8 string without escape sequences, valid only during the callback */
+    uint16_t      str_len;
+} KOS_COMP_GLOBAL_CONST;
+
+typedef int (*KOS_COMP_WALK_GLOBALS_CALLBACK)(const char                  *global_name,
+                                              uint16_t                     global_length,
+                                              int                          module_idx,
+                                              int                          global_idx,
+                                              const KOS_COMP_GLOBAL_CONST *value, /* NULL if not constant */
+                                              void                        *cookie);
+
+int kos_collapse_global_const(KOS_COMP_UNIT               *program,
+                              KOS_AST_NODE                *node,
+                              const KOS_COMP_GLOBAL_CONST *value);
 
 int kos_comp_resolve_global(void                          *vframe,
                             int                            module_idx,
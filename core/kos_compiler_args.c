@@ -44,11 +44,29 @@ static void update_scope_ref(KOS_COMP_UNIT *program,
         }
 }
 
+static int add_var_refs(KOS_COMP_UNIT *program,
+                        KOS_VAR       *var)
+{
+    KOS_SCOPE *const closure = &var->scope->owning_frame->scope;
+    KOS_SCOPE       *scope;
+    int              error   = KOS_SUCCESS;
+
+    /* Capture the variable in all inner functions which use it */
+    for (scope = program->scope_stack; scope != closure && ! error; scope = scope->parent_scope)
+        if (scope->is_function) {
+            assert(scope->has_frame);
+            error = kos_add_var_ref(program, (KOS_FRAME *)scope, var);
+        }
+
+    return error;
+}
+
 /* TODO why do we need this?
- * This is done only to update exported_args and exported_local counts in refs.
+ * This is done only to update exported_args and exported_local counts in refs
+ * and to record variables captured by value in inner functions.
  */
-static void mark_independent_var(KOS_COMP_UNIT      *program,
-                                 const KOS_AST_NODE *node)
+static int mark_independent_var(KOS_COMP_UNIT      *program,
+                                const KOS_AST_NODE *node)
 {
     KOS_VAR *var = node->u.var;
 
@@ -56,16 +74,21 @@ static void mark_independent_var(KOS_COMP_UNIT      *program,
     assert(node->is_var);
     assert(var);
 
-    if ( ! node->is_local_var && ! node->is_const_fun) {
+    if (node->is_local_var || node->is_const_fun)
+        return KOS_SUCCESS;
 
-        assert(var->type == VAR_INDEPENDENT_LOCAL    ||
-               var->type == VAR_INDEPENDENT_ARGUMENT ||
-               var->type == VAR_INDEPENDENT_ARG_IN_REG);
+    assert(var->num_reads || var->num_assignments);
 
-        assert(var->num_reads || var->num_assignments);
+    if (var->by_value)
+        return add_var_refs(program, var);
 
-        update_scope_ref(program, var->type, var->scope);
-    }
+    assert(var->type == VAR_INDEPENDENT_LOCAL    ||
+           var->type == VAR_INDEPENDENT_ARGUMENT ||
+           var->type == VAR_INDEPENDENT_ARG_IN_REG);
+
+    update_scope_ref(program, var->type, var->scope);
+
+    return KOS_SUCCESS;
 }
 
 static KOS_SCOPE *push_scope(KOS_COMP_UNIT      *program,
@@ -225,8 +248,15 @@ static void update_arguments(KOS_COMP_UNIT *program,
                 else
                     var->type = VAR_ARGUMENT_IN_REG;
             }
-            else
+            else {
+                /* Arguments in the rest array cannot be copied to closures */
+                if (var->by_value) {
+                    var->type     = VAR_INDEPENDENT_ARGUMENT;
+                    var->by_value = 0;
+                    var->in_cell  = 0;
+                }
                 var->array_idx -= (int)KOS_MAX_ARGS_IN_REGS - 1;
+            }
         }
 
         arg_node = arg_node->next;
@@ -359,10 +389,10 @@ cleanup:
     return error;
 }
 
-static void identifier(KOS_COMP_UNIT      *program,
-                       const KOS_AST_NODE *node)
+static int identifier(KOS_COMP_UNIT      *program,
+                      const KOS_AST_NODE *node)
 {
-    mark_independent_var(program, node);
+    return mark_independent_var(program, node);
 }
 
 static int assignment(KOS_COMP_UNIT *program,
@@ -410,7 +440,7 @@ static int assignment(KOS_COMP_UNIT *program,
     for ( ; node; node = node->next) {
 
         if (node->type == NT_IDENTIFIER)
-            mark_independent_var(program, node);
+            TRY(mark_independent_var(program, node));
         else {
             assert(node->type != NT_LINE_LITERAL &&
                    node->type != NT_THIS_LITERAL &&
@@ -460,7 +490,7 @@ static int try_stmt(KOS_COMP_UNIT *program,
         assert( ! var_node->next);
         assert(var_node->type == NT_IDENTIFIER);
 
-        mark_independent_var(program, var_node);
+        TRY(mark_independent_var(program, var_node));
 
         TRY(visit_node(program, scope_node));
     }
@@ -490,6 +520,32 @@ static int for_in_stmt(KOS_COMP_UNIT *program,
     return error;
 }
 
+static int inlined_invocation(KOS_COMP_UNIT *program,
+                              KOS_AST_NODE  *node)
+{
+    int           error = KOS_SUCCESS;
+    KOS_AST_NODE *assg_node;
+
+    node = node->children;
+    assert(node);
+    assert(node->type == NT_PARAMETERS);
+
+    /* Arguments bound to temporary variables */
+    for (assg_node = node->children; assg_node; assg_node = assg_node->next) {
+        assert(assg_node->type == NT_ASSIGNMENT);
+        assert(assg_node->children->next);
+        TRY(visit_node(program, assg_node->children->next));
+    }
+
+    /* Inlined expression */
+    node = node->next;
+    assert(node);
+    TRY(visit_node(program, node));
+
+cleanup:
+    return error;
+}
+
 static int visit_node(KOS_COMP_UNIT *program,
                       KOS_AST_NODE  *node)
 {
@@ -513,8 +569,7 @@ static int visit_node(KOS_COMP_UNIT *program,
             break;
 
         case NT_IDENTIFIER:
-            identifier(program, node);
-            error = KOS_SUCCESS;
+            error = identifier(program, node);
             break;
 
         case NT_ASSIGNMENT:
@@ -533,6 +588,10 @@ static int visit_node(KOS_COMP_UNIT *program,
             error = for_in_stmt(program, node);
             break;
 
+        case NT_INLINE:
+            error = inlined_invocation(program, node);
+            break;
+
         case NT_EMPTY:
             /* fall through */
         case NT_FALLTHROUGH:
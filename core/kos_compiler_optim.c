@@ -3,6 +3,7 @@
  */
 
 #include "kos_compiler.h"
+#include "kos_config.h"
 #include "kos_misc.h"
 #include "kos_perf.h"
 #include "kos_try.h"
@@ -179,6 +180,125 @@ const KOS_AST_NODE *kos_get_const(KOS_COMP_UNIT      *program,
     return var->is_const ? var->value : KOS_NULL;
 }
 
+int kos_collapse_global_const(KOS_COMP_UNIT               *program,
+                              KOS_AST_NODE                *node,
+                              const KOS_COMP_GLOBAL_CONST *value)
+{
+    switch (value->type) {
+
+        case NT_NUMERIC_LITERAL: {
+            KOS_NUMERIC numeric;
+
+            if (value->is_float) {
+                numeric.type = KOS_FLOAT_VALUE;
+                numeric.u.d  = value->float_value;
+            }
+            else {
+                numeric.type = KOS_INTEGER_VALUE;
+                numeric.u.i  = value->int_value;
+            }
+
+            return collapse_numeric(program, node, &numeric);
+        }
+
+        case NT_STRING_LITERAL: {
+            char *const str = (char *)KOS_mempool_alloc(&program->allocator, (size_t)value->str_len + 2U);
+
+            if ( ! str)
+                return KOS_ERROR_OUT_OF_MEMORY;
+
+            str[0] = '"';
+            memcpy(&str[1], value->str, value->str_len);
+            str[value->str_len + 1] = '"';
+
+            collapse(node, NT_STRING_LITERAL, TT_STRING, KW_NONE, str, (uint16_t)(value->str_len + 2U));
+            break;
+        }
+
+        case NT_BOOL_LITERAL:
+            collapse(node, NT_BOOL_LITERAL, TT_KEYWORD, value->int_value ? KW_TRUE : KW_FALSE, KOS_NULL, 0);
+            break;
+
+        default:
+            assert(value->type == NT_VOID_LITERAL);
+            collapse(node, NT_VOID_LITERAL, TT_KEYWORD, KW_VOID, KOS_NULL, 0);
+            break;
+    }
+
+    ++program->num_optimizations;
+
+    return KOS_SUCCESS;
+}
+
+static int get_key_str(const KOS_TOKEN *token,
+                       const char     **begin,
+                       uint16_t        *length)
+{
+    KOS_UTF8_ESCAPE escape;
+
+    kos_get_token_str(token, begin, length, &escape);
+
+    /* Keys with escape sequences are not compared */
+    return ! memchr(*begin, '\\', *length);
+}
+
+/* Returns index of the property with the given key in an object literal or -1 */
+int kos_find_scalar_prop(const KOS_AST_NODE *obj_node,
+                         const KOS_TOKEN    *key)
+{
+    const char *key_str;
+    uint16_t    key_len;
+    int         idx = 0;
+
+    assert(obj_node->type == NT_OBJECT_LITERAL);
+
+    if ( ! get_key_str(key, &key_str, &key_len))
+        return -1;
+
+    for (obj_node = obj_node->children; obj_node; obj_node = obj_node->next, ++idx) {
+
+        const KOS_AST_NODE *prop_node = obj_node->children;
+        const char         *prop_str;
+        uint16_t            prop_len;
+
+        assert(obj_node->type == NT_PROPERTY);
+        assert(prop_node);
+        assert(prop_node->type == NT_STRING_LITERAL);
+
+        if ( ! get_key_str(&prop_node->token, &prop_str, &prop_len))
+            return -1;
+
+        if (prop_len == key_len && ! memcmp(prop_str, key_str, key_len))
+            return idx;
+    }
+
+    return -1;
+}
+
+/* Object literal can be replaced with registers if all its keys are unique */
+static int is_scalar_candidate(const KOS_AST_NODE *obj_node)
+{
+    const KOS_AST_NODE *prop_node;
+    int                 idx = 0;
+
+    if ( ! obj_node || obj_node->type != NT_OBJECT_LITERAL)
+        return 0;
+
+    for (prop_node = obj_node->children; prop_node; prop_node = prop_node->next, ++idx) {
+
+        if (idx >= KOS_MAX_SCALAR_PROPS)
+            return 0;
+
+        assert(prop_node->type == NT_PROPERTY);
+        assert(prop_node->children);
+
+        if (kos_find_scalar_prop(obj_node, &prop_node->children->token) != idx)
+            return 0;
+    }
+
+    return 1;
+}
+
 int kos_node_is_truthy(KOS_COMP_UNIT      *program,
                        const KOS_AST_NODE *node)
 {
@@ -252,6 +372,8 @@ static KOS_SCOPE *push_scope(KOS_COMP_UNIT      *program,
         var->num_assignments   = 0;
         var->local_reads       = 0;
         var->local_assignments = 0;
+        var->num_prop_reads    = 0;
+        var->early_bind        = 0;
     }
 
     program->scope_stack = scope;
@@ -296,6 +418,34 @@ static int count_and_update_var(KOS_COMP_UNIT *program,
         var->type = (var->type == VAR_INDEPENDENT_ARGUMENT) ? VAR_ARGUMENT : VAR_LOCAL;
     }
 
+    /* Constants are copied to closures, so they don't need to live in a reentrant frame,
+     * unless a closure is created before the constant is assigned, e.g. when a function
+     * refers to itself.  Modified variables are moved to single-element cells, which
+     * are created when the variable is declared and are copied to closures instead. */
+    if ((var->type == VAR_INDEPENDENT_LOCAL || var->type == VAR_INDEPENDENT_ARGUMENT) &&
+        ! var->early_bind                                                             &&
+        var != scope->ellipsis) {
+
+        var->type     = (var->type == VAR_INDEPENDENT_ARGUMENT) ? VAR_ARGUMENT : VAR_LOCAL;
+        var->by_value = 1;
+    }
+
+    /* Variables which became constants or are no longer used by closures don't need cells */
+    var->in_cell = var->by_value                                 &&
+                   ! var->is_const                               &&
+                   (var->num_reads       != var->local_reads ||
+                    var->num_assignments != var->local_assignments);
+
+    /* Replace object literal with registers if it does not escape the function,
+     * i.e. it is only used to read its properties */
+    var->is_scalar = program->optimize                        &&
+                     var->type == VAR_LOCAL                   &&
+                     var->is_const                            &&
+                     var->num_reads                           &&
+                     var->num_reads == var->local_reads       &&
+                     var->num_reads == var->num_prop_reads    &&
+                     is_scalar_candidate(var->value);
+
     /* Count only used local variables */
     if ((var->type & VAR_LOCAL) && var->num_reads
         /* Count ellipsis only if it's independent, in which case it is relocated
@@ -742,10 +892,10 @@ static int check_self_ref_fun(KOS_VAR *var)
 static void mark_binds(KOS_COMP_UNIT *program,
                        KOS_VAR       *var)
 {
-    assert((var->type != VAR_LOCAL) && (var->type != VAR_ARGUMENT));
+    assert(var->by_value || ((var->type != VAR_LOCAL) && (var->type != VAR_ARGUMENT)));
     assert(var->scope);
 
-    if (var->type & VAR_INDEPENDENT) {
+    if ((var->type & VAR_INDEPENDENT) || var->by_value) {
 
         KOS_FRAME       *frame           = program->cur_frame;
         KOS_FRAME *const target_frame    = var->scope->owning_frame;
@@ -1044,7 +1194,8 @@ static void identifier(KOS_COMP_UNIT *program,
 
     lookup_var(program, node, &var, &is_local);
 
-    if ( ! is_local && var->is_const && var->value) {
+    /* Imported constants are treated as locals in the global scope */
+    if (( ! is_local || var->type == VAR_IMPORTED) && var->is_const && var->value) {
 
         const KOS_AST_NODE *const const_node = var->value;
 
@@ -1128,23 +1279,31 @@ static int assignment(KOS_COMP_UNIT *program,
     if (kos_is_self_ref_func(lhs_node)) {
 
         KOS_VAR *fun_var = lhs_node->children->u.var;
+        int      num_binds;
         assert( ! lhs_node->children->is_scope);
         assert(lhs_node->children->is_var);
         assert(fun_var);
 
+        num_binds = fun_var->num_reads - fun_var->local_reads;
+
         if (rhs_node->type == NT_FUNCTION_LITERAL)
             TRY(function_literal(program, rhs_node, fun_var));
         else {
             assert(rhs_node->type == NT_CLASS_LITERAL);
             TRY(class_literal(program, rhs_node, fun_var));
         }
+
+        /* The function refers to itself through a closure, which is bound before
+         * the variable is assigned */
+        if (fun_var->num_reads - fun_var->local_reads != num_binds)
+            fun_var->early_bind = 1;
     }
     else {
         TRY(visit_node(program, rhs_node, &t));
         assert(t == TERM_NONE);
     }
 
-    /* TODO optimize multi assignment from array literal (don't create array) */
+    /* Multi assignment from array literal is unpacked into registers during code generation */
 
     for ( ; node; node = node->next) {
 
@@ -1189,7 +1348,11 @@ static int assignment(KOS_COMP_UNIT *program,
                    node->type != NT_THIS_LITERAL &&
                    node->type != NT_SUPER_PROTO_LITERAL);
             ++num_used;
-            TRY(visit_node(program, node, &t));
+            /* Assigned property is not a property read */
+            if (node->type == NT_REFINEMENT)
+                TRY(visit_child_nodes(program, node));
+            else
+                TRY(visit_node(program, node, &t));
         }
     }
 
@@ -1665,7 +1828,7 @@ static int operator_token(KOS_COMP_UNIT *program,
                           KOS_AST_NODE  *node)
 {
     int                 error = KOS_SUCCESS;
-    int                 t;
+    int                 t     = TERM_NONE;
     KOS_AST_NODE       *a     = node->children;
     KOS_AST_NODE       *b;
     KOS_AST_NODE       *c     = KOS_NULL;
@@ -1680,7 +1843,11 @@ static int operator_token(KOS_COMP_UNIT *program,
     assert(a);
     b = a->next;
 
-    TRY(visit_node(program, a, &t));
+    /* Deleted property is not a property read */
+    if (node->token.keyword == KW_DELETE && a->type == NT_REFINEMENT)
+        TRY(visit_child_nodes(program, a));
+    else
+        TRY(visit_node(program, a, &t));
     assert(t == TERM_NONE);
 
     if (b) {
@@ -2051,11 +2218,606 @@ static void this_literal(KOS_COMP_UNIT *program, KOS_AST_NODE *node)
     scope->uses_this = 1;
 }
 
+typedef struct KOS_INLINE_ARGS_S {
+    const KOS_SCOPE *fun_scope;
+    int              num_params;
+    int              num_args;                       /* Number of arguments passed to the function */
+    const KOS_VAR   *params[KOS_MAX_INLINE_ARGS];
+    KOS_AST_NODE    *args[KOS_MAX_INLINE_ARGS];      /* Nodes substituted for parameters           */
+    KOS_AST_NODE    *call_args[KOS_MAX_INLINE_ARGS]; /* Arguments passed to the function           */
+} KOS_INLINE_ARGS;
+
+/* Checks if argument can be substituted for a parameter in the inlined expression.
+ * Arguments must not have side effects and their values cannot be changed
+ * by the inlined expression, so it does not matter when they are evaluated. */
+static int is_inline_arg(const KOS_AST_NODE *node)
+{
+    const KOS_VAR      *var;
+    const KOS_AST_NODE *value;
+
+    if (node->type == NT_NUMERIC_LITERAL)
+        return 1;
+
+    if (node->type != NT_IDENTIFIER || ! node->is_local_var)
+        return 0;
+
+    assert(node->is_var);
+    var = node->u.var;
+    assert(var);
+
+    /* Independent variables and variables in cells can be modified
+     * by calls inside the inlined expression */
+    if ((var->type != VAR_LOCAL && var->type != VAR_ARGUMENT) || var->in_cell)
+        return 0;
+
+    /* Constants of other types than numbers would be type-checked at compile time,
+     * turning run time errors into compile errors */
+    value = var->value;
+    if ( ! value)
+        return 1;
+
+    switch (value->type) {
+
+        case NT_NUMERIC_LITERAL:
+            /* fall through */
+        case NT_INVOCATION:
+            /* fall through */
+        case NT_REFINEMENT:
+            /* fall through */
+        case NT_OPT_REFINEMENT:
+            /* fall through */
+        case NT_SLICE:
+            return 1;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+static int find_inline_param(const KOS_INLINE_ARGS *inl,
+                             const KOS_VAR         *var)
+{
+    int i;
+
+    for (i = 0; i < inl->num_params; i++)
+        if (inl->params[i] == var)
+            return i;
+
+    return -1;
+}
+
+/* Checks if identifier in the inlined expression refers to something
+ * which is accessible in the same way from any function */
+static int is_inline_identifier(const KOS_AST_NODE    *node,
+                                const KOS_INLINE_ARGS *inl)
+{
+    KOS_VAR *var = node->u.var;
+
+    assert(node->is_var);
+    assert(var);
+
+    if (var->scope == inl->fun_scope)
+        return find_inline_param(inl, var) >= 0;
+
+    if (var->type & (VAR_GLOBAL | VAR_MODULE | VAR_IMPORTED))
+        return 1;
+
+    /* Constants, which will be replaced with their values */
+    if (var->is_const && var->value) {
+        switch (var->value->type) {
+
+            case NT_NUMERIC_LITERAL:
+                /* fall through */
+            case NT_STRING_LITERAL:
+                /* fall through */
+            case NT_BOOL_LITERAL:
+                /* fall through */
+            case NT_VOID_LITERAL:
+                return 1;
+
+            default:
+                break;
+        }
+    }
+
+    /* Functions loaded as constants, which don't need closures */
+    return node->is_const_fun && is_const_fun(var);
+}
+
+/* Returns number of nodes in the expression or -1 if the expression cannot be inlined */
+static int count_inline_nodes(const KOS_AST_NODE    *node,
+                              const KOS_INLINE_ARGS *inl)
+{
+    int count = 0;
+
+    for ( ; node; node = node->next) {
+
+        switch (node->type) {
+
+            case NT_IDENTIFIER:
+                if ( ! is_inline_identifier(node, inl))
+                    return -1;
+                break;
+
+            case NT_OPERATOR:
+                /* fall through */
+            case NT_INVOCATION:
+                /* fall through */
+            case NT_REFINEMENT:
+                /* fall through */
+            case NT_OPT_REFINEMENT:
+                /* fall through */
+            case NT_SLICE:
+                /* fall through */
+            case NT_EXPAND:
+                /* fall through */
+            case NT_ARRAY_LITERAL:
+                /* fall through */
+            case NT_INTERPOLATED_STRING:
+                /* fall through */
+            case NT_NUMERIC_LITERAL:
+                /* fall through */
+            case NT_STRING_LITERAL:
+                /* fall through */
+            case NT_LINE_LITERAL:
+                /* fall through */
+            case NT_BOOL_LITERAL:
+                /* fall through */
+            case NT_VOID_LITERAL:
+                break;
+
+            default:
+                return -1;
+        }
+
+        if (node->children) {
+            const int num_children = count_inline_nodes(node->children, inl);
+
+            if (num_children < 0)
+                return -1;
+
+            count += num_children;
+        }
+
+        if (++count > KOS_MAX_INLINE_NODES)
+            return -1;
+    }
+
+    return count;
+}
+
+/* Returns expression returned by the invoked function if the invocation can be inlined */
+static const KOS_AST_NODE *get_inline_expr(const KOS_AST_NODE *node,
+                                           KOS_INLINE_ARGS    *inl)
+{
+    const KOS_AST_NODE *fun_node;
+    const KOS_AST_NODE *param_node;
+    KOS_AST_NODE       *arg_node;
+    const KOS_AST_NODE *body_node;
+    const KOS_FRAME    *frame;
+    const KOS_VAR      *var;
+
+    node = node->children;
+    assert(node);
+
+    if (node->type != NT_IDENTIFIER)
+        return KOS_NULL;
+
+    assert(node->is_var);
+    var = node->u.var;
+    assert(var);
+
+    if ( ! var->is_const || ! var->value || var->value->type != NT_FUNCTION_LITERAL)
+        return KOS_NULL;
+
+    fun_node = var->value;
+    assert(fun_node->is_scope);
+    frame = (const KOS_FRAME *)fun_node->u.scope;
+    assert(frame->scope.has_frame);
+
+    /* Don't inline recursive calls and generators */
+    if (frame->is_open || frame->yield_token)
+        return KOS_NULL;
+
+    param_node = fun_node->children->next;
+    assert(param_node->type == NT_PARAMETERS);
+
+    body_node = param_node->next->next;
+    assert(body_node->type == NT_SCOPE);
+
+    /* Function body must consist of a single return statement with a value */
+    body_node = body_node->children;
+    if ( ! body_node || body_node->next || body_node->type != NT_RETURN || ! body_node->children)
+        return KOS_NULL;
+
+    inl->fun_scope  = &frame->scope;
+    inl->num_params = 0;
+    inl->num_args   = 0;
+
+    arg_node = node->next;
+
+    for (param_node = param_node->children; param_node; param_node = param_node->next) {
+
+        const KOS_AST_NODE *ident_node = param_node;
+        KOS_AST_NODE       *def_node   = KOS_NULL;
+
+        if (inl->num_params == KOS_MAX_INLINE_ARGS)
+            return KOS_NULL;
+
+        if (param_node->type == NT_ASSIGNMENT) {
+            ident_node = param_node->children;
+            def_node   = ident_node->next;
+        }
+        else if (param_node->type != NT_IDENTIFIER)
+            return KOS_NULL; /* Ellipsis */
+
+        assert(ident_node->type == NT_IDENTIFIER);
+        assert(ident_node->is_var);
+
+        if (arg_node) {
+            if (arg_node->type == NT_NAMED_ARGUMENTS ||
+                arg_node->type == NT_EXPAND          ||
+                arg_node->type == NT_PLACEHOLDER)
+                return KOS_NULL;
+            inl->args[inl->num_params]      = arg_node;
+            inl->call_args[inl->num_args++] = arg_node;
+            arg_node = arg_node->next;
+        }
+        else if (def_node && def_node->type == NT_NUMERIC_LITERAL)
+            inl->args[inl->num_params] = def_node;
+        else
+            return KOS_NULL;
+
+        inl->params[inl->num_params++] = ident_node->u.var;
+    }
+
+    /* Extra arguments */
+    if (arg_node)
+        return KOS_NULL;
+
+    return body_node->children;
+}
+
+static KOS_AST_NODE *alloc_inline_node(KOS_COMP_UNIT   *program,
+                                       KOS_NODE_TYPE    type,
+                                       const KOS_TOKEN *token)
+{
+    KOS_AST_NODE *node = (KOS_AST_NODE *)KOS_mempool_alloc(&program->allocator, sizeof(KOS_AST_NODE));
+
+    if (node) {
+        memset(node, 0, sizeof(*node));
+        node->token = *token;
+        node->type  = type;
+    }
+
+    return node;
+}
+
+/* Arguments which have side effects or which can change are evaluated once,
+ * before the inlined expression, and stored in temporary variables.
+ * Returns parameters node, which binds the arguments to the temporary variables. */
+static int bind_inline_args(KOS_COMP_UNIT      *program,
+                            const KOS_AST_NODE *call_node,
+                            KOS_INLINE_ARGS    *inl,
+                            KOS_AST_NODE      **out_params)
+{
+    KOS_AST_NODE **assg_ptr    = KOS_NULL;
+    KOS_AST_NODE  *params_node = KOS_NULL;
+    int            i;
+
+    for (i = 0; i < inl->num_args; i++)
+        inl->call_args[i]->next = KOS_NULL;
+
+    for (i = 0; i < inl->num_params; i++) {
+
+        KOS_AST_NODE *arg_node = inl->args[i];
+        KOS_AST_NODE *assg_node;
+        KOS_AST_NODE *ident_node;
+        KOS_VAR      *var;
+
+        if (is_inline_arg(arg_node))
+            continue;
+
+        if ( ! params_node) {
+            params_node = alloc_inline_node(program, NT_PARAMETERS, &call_node->token);
+            if ( ! params_node)
+                return KOS_ERROR_OUT_OF_MEMORY;
+            assg_ptr = &params_node->children;
+        }
+
+        var        = (KOS_VAR *)KOS_mempool_alloc(&program->allocator, sizeof(KOS_VAR));
+        assg_node  = alloc_inline_node(program, NT_ASSIGNMENT, &call_node->token);
+        ident_node = alloc_inline_node(program, NT_IDENTIFIER, inl->params[i]->token);
+        if ( ! var || ! assg_node || ! ident_node)
+            return KOS_ERROR_OUT_OF_MEMORY;
+
+        memset(var, 0, sizeof(*var));
+        var->scope    = program->scope_stack;
+        var->token    = inl->params[i]->token;
+        var->type     = VAR_LOCAL;
+        var->is_const = 1;
+
+        ident_node->token.line    = call_node->token.line;
+        ident_node->token.column  = call_node->token.column;
+        ident_node->token.file_id = call_node->token.file_id;
+        ident_node->u.var         = var;
+        ident_node->is_var        = 1;
+        ident_node->is_local_var  = 1;
+        ident_node->next          = arg_node;
+
+        assg_node->children = ident_node;
+
+        *assg_ptr = assg_node;
+        assg_ptr  = &assg_node->next;
+
+        inl->args[i] = ident_node;
+    }
+
+    *out_params = params_node;
+
+    return KOS_SUCCESS;
+}
+
+/* Restores the list of arguments of the original invocation */
+static void unbind_inline_args(const KOS_INLINE_ARGS *inl)
+{
+    int i;
+
+    for (i = 1; i < inl->num_args; i++)
+        inl->call_args[i - 1]->next = inl->call_args[i];
+}
+
+static KOS_AST_NODE *clone_inline_nodes(KOS_COMP_UNIT         *program,
+                                        const KOS_AST_NODE    *node,
+                                        const KOS_INLINE_ARGS *inl,
+                                        const KOS_TOKEN       *call_token)
+{
+    KOS_AST_NODE  *first    = KOS_NULL;
+    KOS_AST_NODE **node_ptr = &first;
+
+    for ( ; node; node = node->next) {
+
+        const KOS_AST_NODE *src  = node;
+        KOS_AST_NODE       *copy = (KOS_AST_NODE *)KOS_mempool_alloc(&program->allocator,
+                                                                    sizeof(KOS_AST_NODE));
+        if ( ! copy)
+            return KOS_NULL;
+
+        if (node->type == NT_IDENTIFIER && node->u.var->scope == inl->fun_scope) {
+            const int idx = find_inline_param(inl, node->u.var);
+
+            assert(idx >= 0);
+            src = inl->args[idx];
+        }
+
+        *copy      = *src;
+        copy->next = KOS_NULL;
+
+        /* Code from the inlined function is attributed to the invocation */
+        if (src == node) {
+            copy->token.line    = call_token->line;
+            copy->token.column  = call_token->column;
+            copy->token.file_id = call_token->file_id;
+        }
+
+        if (src->children) {
+            copy->children = clone_inline_nodes(program, src->children, inl, call_token);
+            if ( ! copy->children)
+                return KOS_NULL;
+        }
+
+        *node_ptr = copy;
+        node_ptr  = &copy->next;
+    }
+
+    return first;
+}
+
+/* Replaces invocation of a small function with the expression returned by the function */
+static int inline_invocation(KOS_COMP_UNIT *program,
+                             KOS_AST_NODE  *node,
+                             int           *inlined)
+{
+    KOS_INLINE_ARGS     inl;
+    KOS_AST_NODE        orig_node;
+    KOS_AST_NODE       *expr_node;
+    KOS_AST_NODE       *params_node       = KOS_NULL;
+    const KOS_AST_NODE *src_node;
+    KOS_FRAME          *frame             = program->cur_frame;
+    const int           num_optimizations = program->num_optimizations;
+    const int           num_inlined       = frame->num_inlined;
+    int                 num_nodes;
+    int                 error;
+    int                 t;
+
+    *inlined = 0;
+
+    src_node = get_inline_expr(node, &inl);
+    if ( ! src_node)
+        return KOS_SUCCESS;
+
+    num_nodes = count_inline_nodes(src_node, &inl);
+    if ((num_nodes < 0) || (num_inlined + num_nodes > KOS_MAX_INLINE_GROWTH))
+        return KOS_SUCCESS;
+
+    TRY(bind_inline_args(program, node, &inl, &params_node));
+
+    expr_node = clone_inline_nodes(program, src_node, &inl, &node->token);
+    if ( ! expr_node)
+        RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+    orig_node = *node;
+
+    if (params_node) {
+        memset(node, 0, sizeof(*node));
+        node->next        = orig_node.next;
+        node->children    = params_node;
+        node->token       = orig_node.token;
+        node->type        = NT_INLINE;
+        params_node->next = expr_node;
+    }
+    else {
+        *node      = *expr_node;
+        node->next = orig_node.next;
+    }
+
+    frame->num_inlined += num_nodes;
+
+    error = visit_node(program, node, &t);
+
+    /* Constant arguments can expose errors, which are detected at compile time,
+     * e.g. division by zero.  Keep the original invocation, which will fail at run time. */
+    if (error == KOS_ERROR_COMPILE_FAILED) {
+        *node                      = orig_node;
+        frame->num_inlined         = num_inlined;
+        program->num_optimizations = num_optimizations;
+        program->error_str         = KOS_NULL;
+        program->error_token       = KOS_NULL;
+        unbind_inline_args(&inl);
+        return KOS_SUCCESS;
+    }
+
+    if ( ! error) {
+        ++program->num_optimizations;
+        *inlined = 1;
+    }
+
+cleanup:
+    return error;
+}
+
+/* Visits arguments bound to temporary variables, then the inlined expression */
+static int inlined_invocation(KOS_COMP_UNIT *program,
+                              KOS_AST_NODE  *node)
+{
+    int           error = KOS_SUCCESS;
+    KOS_AST_NODE *assg_node;
+    int           t;
+
+    node = node->children;
+    assert(node);
+    assert(node->type == NT_PARAMETERS);
+
+    for (assg_node = node->children; assg_node; assg_node = assg_node->next) {
+        assert(assg_node->type == NT_ASSIGNMENT);
+        assert(assg_node->children);
+        assert(assg_node->children->type == NT_IDENTIFIER);
+        assert(assg_node->children->next);
+
+        TRY(visit_node(program, assg_node->children->next, &t));
+    }
+
+    node = node->next;
+    assert(node);
+    assert( ! node->next);
+
+    TRY(visit_node(program, node, &t));
+
+cleanup:
+    return error;
+}
+
+typedef struct KOS_GLOBAL_CONST_INFO_S {
+    KOS_COMP_UNIT *program;
+    KOS_AST_NODE  *node;
+} KOS_GLOBAL_CONST_INFO;
+
+static int collapse_module_global(const char                  *global_name,
+                                  uint16_t                     global_length,
+                                  int                          module_idx,
+                                  int                          global_idx,
+                                  const KOS_COMP_GLOBAL_CONST *value,
+                                  void                        *cookie)
+{
+    KOS_GLOBAL_CONST_INFO *const info = (KOS_GLOBAL_CONST_INFO *)cookie;
+
+    if ( ! value)
+        return KOS_SUCCESS;
+
+    return kos_collapse_global_const(info->program, info->node, value);
+}
+
+static int refinement(KOS_COMP_UNIT *program,
+                      KOS_AST_NODE  *node)
+{
+    const KOS_AST_NODE *obj_node = node->children;
+    const KOS_AST_NODE *key_node;
+    int                 error;
+
+    assert(obj_node);
+    key_node = obj_node->next;
+    assert(key_node);
+
+    /* Replace constant from another module with its value */
+    if (obj_node->type == NT_IDENTIFIER          &&
+        obj_node->u.var->type == VAR_MODULE      &&
+        key_node->type == NT_STRING_LITERAL) {
+
+        KOS_GLOBAL_CONST_INFO info;
+        const char           *begin;
+        uint16_t              length;
+        KOS_UTF8_ESCAPE       escape;
+
+        info.program = program;
+        info.node    = node;
+
+        kos_get_token_str(&key_node->token, &begin, &length, &escape);
+
+        /* Unknown globals are reported during code generation */
+        error = kos_comp_resolve_global(program->ctx,
+                                        obj_node->u.var->array_idx,
+                                        begin,
+                                        length,
+                                        collapse_module_global,
+                                        &info);
+        if (error == KOS_ERROR_OUT_OF_MEMORY)
+            return error;
+
+        if (node->type != NT_REFINEMENT)
+            return KOS_SUCCESS;
+    }
+
+    TRY(visit_child_nodes(program, node));
+
+    /* Count reads of properties of local object literals, which are candidates
+     * for scalar replacement */
+    if (obj_node->type == NT_IDENTIFIER && obj_node->is_local_var && key_node->type == NT_STRING_LITERAL) {
+
+        KOS_VAR *var = KOS_NULL;
+
+        lookup_var(program, obj_node, &var, KOS_NULL);
+
+        if (var->value                                &&
+            var->value->type == NT_OBJECT_LITERAL     &&
+            kos_find_scalar_prop(var->value, &key_node->token) >= 0)
+
+            ++var->num_prop_reads;
+    }
+
+cleanup:
+    return error;
+}
+
 static int invocation(KOS_COMP_UNIT *program, KOS_AST_NODE *node)
 {
     const KOS_AST_NODE *child_node = node->children;
+    int                 error      = KOS_SUCCESS;
+    int                 t;
 
     assert(child_node);
+
+    if (program->inline_funcs && child_node->type == NT_IDENTIFIER) {
+
+        int inlined;
+
+        error = inline_invocation(program, node, &inlined);
+
+        if (error || inlined)
+            return error;
+    }
+
     if (child_node->type == NT_REFINEMENT || child_node->type == NT_OPT_REFINEMENT) {
 
         child_node = child_node->children;
@@ -2077,7 +2839,20 @@ static int invocation(KOS_COMP_UNIT *program, KOS_AST_NODE *node)
         scope->uses_this = 1;
     }
 
-    return visit_child_nodes(program, node);
+    node = node->children;
+
+    /* The object on which a method is invoked escapes as this,
+     * so the method lookup does not count as a property read */
+    if (node->type == NT_REFINEMENT) {
+        TRY(visit_child_nodes(program, node));
+        node = node->next;
+    }
+
+    for ( ; node; node = node->next)
+        TRY(visit_node(program, node, &t));
+
+cleanup:
+    return error;
 }
 
 static int visit_node(KOS_COMP_UNIT *program,
@@ -2185,6 +2960,10 @@ static int visit_node(KOS_COMP_UNIT *program,
             error = invocation(program, node);
             break;
 
+        case NT_INLINE:
+            error = inlined_invocation(program, node);
+            break;
+
         case NT_EMPTY:
             /* fall through */
         case NT_FALLTHROUGH:
@@ -2214,9 +2993,11 @@ static int visit_node(KOS_COMP_UNIT *program,
             error = KOS_SUCCESS;
             break;
 
-        case NT_ASSERT:
-            /* fall through */
         case NT_REFINEMENT:
+            error = refinement(program, node);
+            break;
+
+        case NT_ASSERT:
             /* fall through */
         case NT_OPT_REFINEMENT:
             /* fall through */
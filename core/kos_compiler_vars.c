@@ -262,6 +262,58 @@ static int add_scope_ref(KOS_COMP_UNIT *program,
     return error;
 }
 
+static int compare_ptr(const void *a,
+                       const void *b)
+{
+    return ((uintptr_t)a < (uintptr_t)b) ? -1 :
+           ((uintptr_t)a > (uintptr_t)b) ? 1 : 0;
+}
+
+static int var_ref_compare_item(void               *what,
+                                KOS_RED_BLACK_NODE *node)
+{
+    return compare_ptr(what, ((const KOS_VAR_REF *)node)->var);
+}
+
+static int var_ref_compare_node(KOS_RED_BLACK_NODE *a,
+                                KOS_RED_BLACK_NODE *b)
+{
+    return compare_ptr(((const KOS_VAR_REF *)a)->var, ((const KOS_VAR_REF *)b)->var);
+}
+
+KOS_VAR_REF *kos_find_var_ref(KOS_FRAME     *frame,
+                              const KOS_VAR *var)
+{
+    return (KOS_VAR_REF *)kos_red_black_find(frame->captured_vars,
+                                             (void *)var,
+                                             var_ref_compare_item);
+}
+
+int kos_add_var_ref(KOS_COMP_UNIT *program,
+                    KOS_FRAME     *frame,
+                    KOS_VAR       *var)
+{
+    KOS_VAR_REF *ref = kos_find_var_ref(frame, var);
+
+    if (ref)
+        return KOS_SUCCESS;
+
+    ref = (KOS_VAR_REF *)KOS_mempool_alloc(&program->allocator, sizeof(KOS_VAR_REF));
+
+    if ( ! ref)
+        return KOS_ERROR_OUT_OF_MEMORY;
+
+    ref->var     = var;
+    ref->reg     = KOS_NULL;
+    ref->reg_idx = -1;
+
+    kos_red_black_insert(&frame->captured_vars,
+                         (KOS_RED_BLACK_NODE *)ref,
+                         var_ref_compare_node);
+
+    return KOS_SUCCESS;
+}
+
 static int lookup_and_mark_var(KOS_COMP_UNIT *program,
                                KOS_AST_NODE  *node,
                                KOS_VAR      **out_var)
@@ -508,11 +560,12 @@ typedef struct KOS_IMPORT_INFO_V_S {
     KOS_AST_NODE **tail;
 } KOS_IMPORT_INFO_V;
 
-static int import_global(const char *global_name,
-                         uint16_t    global_length,
-                         int         module_idx,
-                         int         global_idx,
-                         void       *cookie)
+static int import_global(const char                  *global_name,
+                         uint16_t                     global_length,
+                         int                          module_idx,
+                         int                          global_idx,
+                         const KOS_COMP_GLOBAL_CONST *value,
+                         void                        *cookie)
 {
     KOS_IMPORT_INFO_V *info   = (KOS_IMPORT_INFO_V *)cookie;
     KOS_AST_NODE      *g_node = info->node;
@@ -557,6 +610,24 @@ static int import_global(const char *global_name,
             var->type       = VAR_IMPORTED;
             var->module_idx = module_idx;
             var->array_idx  = global_idx;
+
+            /* The optimizer replaces reads of imported constants with their values */
+            if (value) {
+                KOS_AST_NODE *const_node = (KOS_AST_NODE *)
+                    KOS_mempool_alloc(&info->program->allocator, sizeof(KOS_AST_NODE));
+
+                if ( ! const_node)
+                    return KOS_ERROR_OUT_OF_MEMORY;
+
+                memset(const_node, 0, sizeof(*const_node));
+                const_node->token = g_node->token;
+
+                error = kos_collapse_global_const(info->program, const_node, value);
+                if (error)
+                    return error;
+
+                var->value = const_node;
+            }
         }
 
         error = enable_var(info->program, var);
@@ -1245,6 +1316,72 @@ int kos_compiler_process_vars(KOS_COMP_UNIT *program,
     return visit_node(program, ast);
 }
 
+/* Statement currently being processed in a scope */
+typedef struct KOS_LIVE_STMT_S {
+    const struct KOS_LIVE_STMT_S *outer;
+    const KOS_SCOPE              *scope;
+    const KOS_AST_NODE           *stmt;
+} KOS_LIVE_STMT;
+
+/* Finds the last statement in variable's scope which uses the variable.
+ * Control never returns to a statement in the same scope once it has been
+ * executed, unless the whole scope is entered again (e.g. in a loop), in which
+ * case the variable is declared again.  Therefore the variable's register can
+ * be released after that statement.  Only non-independent local variables and
+ * arguments can be released early, because closures may use them after that point.
+ * Variables captured by value are used by closures only when the closures are
+ * created, so references from inner functions extend their live range.
+ * Variables declared outside of a statement list, e.g. for-in loop variables
+ * or catch variables, are never found and are released at the end of scope. */
+static void live_range_node(const KOS_AST_NODE  *node,
+                            const KOS_LIVE_STMT *stmt)
+{
+    if (node->type == NT_IDENTIFIER) {
+
+        KOS_VAR *const var = node->is_var ? node->u.var : KOS_NULL;
+
+        if (var && (node->is_local_var || var->by_value) &&
+            (var->type == VAR_LOCAL || var->type == VAR_ARGUMENT_IN_REG)) {
+
+            for ( ; stmt; stmt = stmt->outer) {
+
+                /* Arguments are declared in function's scope, which is the parent of function body */
+                const KOS_SCOPE *const scope = (var->type == VAR_LOCAL) ? stmt->scope : stmt->scope->parent_scope;
+
+                if (scope == var->scope) {
+                    var->release_node = stmt->stmt;
+                    break;
+                }
+            }
+        }
+    }
+    else if ((node->type == NT_SCOPE) && node->is_scope) {
+
+        KOS_LIVE_STMT live;
+
+        live.outer = stmt;
+        live.scope = node->u.scope;
+
+        for (node = node->children; node; node = node->next) {
+            live.stmt = node;
+            live_range_node(node, &live);
+        }
+    }
+    else {
+        for (node = node->children; node; node = node->next)
+            live_range_node(node, stmt);
+    }
+}
+
+void kos_compute_live_ranges(const KOS_AST_NODE *ast)
+{
+    PROF_ZONE(COMPILER)
+
+    assert(ast->type == NT_SCOPE);
+
+    live_range_node(ast, KOS_NULL);
+}
+
 static int predefine_global(KOS_COMP_UNIT      *program,
                             const char         *name,
                             uint16_t            name_len,
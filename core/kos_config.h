@@ -27,13 +27,29 @@
 #else
 #   define KOS_MAX_HEAP_SIZE    (64U * 1024U * 1024U)
 #endif
-#define KOS_GC_THRESHOLD        75U /* Percentage of max heap size at which to collect garbage */
+#define KOS_MIN_HEAP_SIZE       (KOS_MAX_HEAP_SIZE / 16U) /* Default min heap size at which to collect garbage */
+#define KOS_GC_THRESHOLD        75U /* Max percentage of the GC threshold occupied by objects after GC */
+#define KOS_GC_TIME_TARGET      5U  /* Default target percentage of time spent in GC */
+#define KOS_NURSERY_SIZE        (KOS_MAX_HEAP_SIZE / 32U) /* Size of new pages which triggers minor GC */
+#define KOS_MAX_GC_WORKERS      64U /* Max number of dedicated GC threads */
 #define KOS_MAX_HEAP_OBJ_SIZE   512U
 #define KOS_STACK_OBJ_SIZE      4096U
 
 #define KOS_MAX_AST_DEPTH       100
+#define KOS_MAX_INLINE_NODES    24    /* Max size of expression returned by an inlined function */
+#define KOS_MAX_INLINE_GROWTH   256   /* Max number of AST nodes inlined into a single function */
+#define KOS_MAX_INLINE_ARGS     8     /* Max number of parameters of an inlined function */
+#define KOS_MAX_LOOP_CONSTS     8     /* Max number of constants hoisted out of loops in a function */
+#define KOS_MIN_SWITCH_TABLE    4     /* Min number of constant cases for which switch uses a jump table */
+#define KOS_MIN_OBJ_TEMPLATE    5     /* Min number of properties for which object literal uses a template */
+#define KOS_MIN_ARRAY_TEMPLATE  5     /* Min number of constant elements for which array literal uses a template */
+#define KOS_MAX_SCALAR_PROPS    8     /* Max number of properties of an object literal replaced with registers */
 #define KOS_BUF_ALLOC_SIZE      0x10000U
 #define KOS_VEC_MAX_INC_SIZE    262144U
+#define KOS_MAX_PROP_CACHES     1024U /* Max number of property access caches per function */
+#define KOS_MAX_SHAPE_PROPS     16U   /* Objects with more properties use hash tables */
+#define KOS_MAX_SHAPES          4096U /* Max number of object shapes per instance */
+#define KOS_MAX_DEOPTS          16U   /* Max number of deoptimizations before a function stops quickening */
 #ifdef CONFIG_FUZZ
 #   define KOS_MAX_CODE_SIZE    0x10000U
 #   define KOS_MAX_STACK_DEPTH  64U
@@ -54,4 +70,13 @@
 #   define KOS_DISPATCH_TABLE   0
 #endif
 
+#if defined(CONFIG_JIT) && defined(__x86_64__) && defined(__linux__)
+#   define KOS_JIT              1
+#endif
+#ifdef NDEBUG
+#   define KOS_JIT_THRESHOLD    1000U /* Number of calls and loop iterations before a function is compiled */
+#else
+#   define KOS_JIT_THRESHOLD    2U
+#endif
+
 #endif
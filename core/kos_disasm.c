@@ -12,7 +12,7 @@
 #include <stdio.h>
 #include <string.h>
 
-static int get_num_operands(KOS_BYTECODE_INSTR instr)
+int kos_get_num_operands(KOS_BYTECODE_INSTR instr)
 {
     switch (instr) {
 
@@ -33,6 +33,8 @@ static int get_num_operands(KOS_BYTECODE_INSTR instr)
         case INSTR_LOAD_FUN:            /* fall through */
         case INSTR_NEW_ARRAY8:          /* fall through */
         case INSTR_NEW_OBJ:             /* fall through */
+        case INSTR_NEW_OBJ_TEMPLATE:    /* fall through */
+        case INSTR_NEW_ARRAY_TEMPLATE:  /* fall through */
         case INSTR_NEW_ITER:            /* fall through */
         case INSTR_MOVE:                /* fall through */
         case INSTR_GET_PROTO:           /* fall through */
@@ -88,7 +90,20 @@ static int get_num_operands(KOS_BYTECODE_INSTR instr)
         case INSTR_BIND:                /* fall through */
         case INSTR_NEXT_JUMP:           /* fall through */
         case INSTR_TAIL_CALL:           /* fall through */
-        case INSTR_TAIL_CALL_FUN:
+        case INSTR_TAIL_CALL_FUN:       /* fall through */
+        case INSTR_SWITCH_INT:          /* fall through */
+        case INSTR_SWITCH_STR:          /* fall through */
+        case INSTR_ADD_SMALLINT:        /* fall through */
+        case INSTR_SUB_SMALLINT:        /* fall through */
+        case INSTR_ADD_FLOAT:           /* fall through */
+        case INSTR_SUB_FLOAT:           /* fall through */
+        case INSTR_MUL_FLOAT:           /* fall through */
+        case INSTR_CMP_EQ_SMALLINT:     /* fall through */
+        case INSTR_CMP_NE_SMALLINT:     /* fall through */
+        case INSTR_CMP_LE_SMALLINT:     /* fall through */
+        case INSTR_CMP_LT_SMALLINT:     /* fall through */
+        case INSTR_CMP_EQ_STR:          /* fall through */
+        case INSTR_CMP_NE_STR:
             return 3;
 
         case INSTR_CALL:                /* fall through */
@@ -110,6 +125,10 @@ int kos_get_operand_size(KOS_BYTECODE_INSTR instr, int op)
             /* fall through */
         case INSTR_LOAD_FUN:
             /* fall through */
+        case INSTR_NEW_OBJ_TEMPLATE:
+            /* fall through */
+        case INSTR_NEW_ARRAY_TEMPLATE:
+            /* fall through */
         case INSTR_GET_GLOBAL:
             /* fall through */
         case INSTR_GET_MOD_ELEM:
@@ -144,14 +163,44 @@ int kos_get_operand_size(KOS_BYTECODE_INSTR instr, int op)
                 return -1;
             break;
 
+        case INSTR_SWITCH_INT:
+            /* fall through */
+        case INSTR_SWITCH_STR:
+            if (op > 0)
+                return -1;
+            break;
+
         default:
             break;
     }
     return 1;
 }
 
-/* Returns number of bytes after the offset in the instruction or -1 if not offset */
-static int get_offset_operand_tail(KOS_BYTECODE_INSTR instr, int op)
+uint32_t kos_get_instr_size(const uint8_t *bytecode)
+{
+    const KOS_BYTECODE_INSTR instr        = (KOS_BYTECODE_INSTR)*bytecode;
+    const int                num_operands = kos_get_num_operands(instr);
+    uint32_t                 size         = 1;
+    int                      iop;
+
+    for (iop = 0; iop < num_operands; iop++) {
+        const int opsize = kos_get_operand_size(instr, iop);
+
+        if (opsize == -1) {
+            const KOS_IMM imm = kos_is_signed_op(instr, iop)
+                              ? kos_load_simm(bytecode + size)
+                              : kos_load_uimm(bytecode + size);
+
+            size += (uint32_t)imm.size;
+        }
+        else
+            size += (uint32_t)opsize;
+    }
+
+    return size;
+}
+
+int kos_get_offset_operand_tail(KOS_BYTECODE_INSTR instr, int op)
 {
     switch (instr) {
 
@@ -193,6 +242,10 @@ int kos_is_register(KOS_BYTECODE_INSTR instr, int op)
             /* fall through */
         case INSTR_NEW_ARRAY8:
             /* fall through */
+        case INSTR_NEW_OBJ_TEMPLATE:
+            /* fall through */
+        case INSTR_NEW_ARRAY_TEMPLATE:
+            /* fall through */
         case INSTR_GET_GLOBAL:
             /* fall through */
         case INSTR_GET_MOD_ELEM:
@@ -202,6 +255,10 @@ int kos_is_register(KOS_BYTECODE_INSTR instr, int op)
         case INSTR_BIND_SELF:
             /* fall through */
         case INSTR_CATCH:
+            /* fall through */
+        case INSTR_SWITCH_INT:
+            /* fall through */
+        case INSTR_SWITCH_STR:
             return op > 0 ? 0 : 1;
 
         case INSTR_GET_ELEM8:
@@ -278,6 +335,8 @@ int kos_is_signed_op(KOS_BYTECODE_INSTR instr, int op)
         case INSTR_SET_ELEM8:
             /* fall through */
         case INSTR_CATCH:
+            /* fall through */
+        case INSTR_SWITCH_INT:
             if (op == 1)
                 return 1;
             break;
@@ -297,7 +356,7 @@ int kos_is_signed_op(KOS_BYTECODE_INSTR instr, int op)
     return 0;
 }
 
-static int is_constant(KOS_BYTECODE_INSTR instr, int op)
+int kos_is_constant_op(KOS_BYTECODE_INSTR instr, int op)
 {
     switch (instr) {
 
@@ -305,6 +364,10 @@ static int is_constant(KOS_BYTECODE_INSTR instr, int op)
             /* fall through */
         case INSTR_LOAD_FUN:
             /* fall through */
+        case INSTR_NEW_OBJ_TEMPLATE:
+            /* fall through */
+        case INSTR_NEW_ARRAY_TEMPLATE:
+            /* fall through */
         case INSTR_GET_PROP8:
             /* fall through */
         case INSTR_GET_PROP8_OPT:
@@ -316,6 +379,9 @@ static int is_constant(KOS_BYTECODE_INSTR instr, int op)
         case INSTR_HAS_SH_PROP8:
             return ! kos_is_register(instr, op);
 
+        case INSTR_SWITCH_STR:
+            return op == 1;
+
         default:
             break;
     }
@@ -394,9 +460,32 @@ static const char *const str_instr[] = {
     "YIELD",
     "THROW",
     "CATCH",
-    "CANCEL"
+    "CANCEL",
+    "SWITCH.INT",
+    "SWITCH.STR",
+    "NEW.OBJ.TEMPLATE",
+    "NEW.ARRAY.TEMPLATE",
+    "ADD.SMALLINT",
+    "SUB.SMALLINT",
+    "ADD.FLOAT",
+    "SUB.FLOAT",
+    "MUL.FLOAT",
+    "CMP.EQ.SMALLINT",
+    "CMP.NE.SMALLINT",
+    "CMP.LE.SMALLINT",
+    "CMP.LT.SMALLINT",
+    "CMP.EQ.STR",
+    "CMP.NE.STR"
 };
 
+const char *kos_get_instr_name(KOS_BYTECODE_INSTR instr)
+{
+    assert(instr >= INSTR_BREAKPOINT && instr < INSTR_LAST_OPCODE);
+    assert((unsigned)(INSTR_LAST_OPCODE - INSTR_BREAKPOINT) == sizeof(str_instr)/sizeof(str_instr[0]));
+
+    return str_instr[instr - INSTR_BREAKPOINT];
+}
+
 int kos_disassemble(const char                   *filename,
                     const uint8_t                *bytecode,
                     uint32_t                      size,
@@ -444,8 +533,8 @@ int kos_disassemble(const char                   *filename,
             ++line_addr;
         }
 
-        str_opcode   = str_instr[opcode - INSTR_BREAKPOINT];
-        num_operands = get_num_operands((KOS_BYTECODE_INSTR)opcode);
+        str_opcode   = kos_get_instr_name((KOS_BYTECODE_INSTR)opcode);
+        num_operands = kos_get_num_operands((KOS_BYTECODE_INSTR)opcode);
 
         dis[0]   = 0;
         dis_size = 0;
@@ -478,12 +567,12 @@ int kos_disassemble(const char                   *filename,
                 for (i = 0; i < opsize; i++)
                     value |= (int32_t)((uint32_t)bytecode[instr_size + i] << (8 * i));
 
-            if (is_constant((KOS_BYTECODE_INSTR)opcode, iop)) {
+            if (kos_is_constant_op((KOS_BYTECODE_INSTR)opcode, iop)) {
                 constant     = (uint32_t)value;
                 has_constant = 1;
             }
 
-            tail = get_offset_operand_tail((KOS_BYTECODE_INSTR)opcode, iop);
+            tail = kos_get_offset_operand_tail((KOS_BYTECODE_INSTR)opcode, iop);
             if (tail >= 0)
                 pr_size = snprintf(dis_num, sizeof(dis_num), "%08X",
                                    value + offs + instr_size + opsize + tail);
@@ -542,7 +631,7 @@ int kos_disassemble(const char                   *filename,
             bin[bin_len++] = ' ';
         bin[bin_len] = 0;
 
-        printf("%s%-15s%s%s\n", bin, str_opcode, dis, const_str);
+        printf("%s%-14s %s%s\n", bin, str_opcode, dis, const_str);
 
         bytecode += instr_size;
         offs     += instr_size;
@@ -11,12 +11,24 @@
 struct KOS_LINE_ADDR_S;
 struct KOS_VECTOR_S;
 
+int kos_get_num_operands(KOS_BYTECODE_INSTR instr);
+
 int kos_get_operand_size(KOS_BYTECODE_INSTR instr, int op);
 
+/* Returns number of bytes after the offset in the instruction or -1 if not offset */
+int kos_get_offset_operand_tail(KOS_BYTECODE_INSTR instr, int op);
+
+/* Returns non-zero if the operand is an index of a module constant */
+int kos_is_constant_op(KOS_BYTECODE_INSTR instr, int op);
+
 int kos_is_register(KOS_BYTECODE_INSTR instr, int op);
 
 int kos_is_signed_op(KOS_BYTECODE_INSTR instr, int op);
 
+uint32_t kos_get_instr_size(const uint8_t *bytecode);
+
+const char *kos_get_instr_name(KOS_BYTECODE_INSTR instr);
+
 typedef int (*KOS_PRINT_CONST)(void                *cookie,
                                struct KOS_VECTOR_S *cstr_buf,
                                uint32_t             const_index);
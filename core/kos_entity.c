@@ -44,9 +44,47 @@ KOS_OBJ_ID KOS_new_int(KOS_CONTEXT ctx, int64_t value)
     return OBJID(INTEGER, integer);
 }
 
+#ifdef KOS_SMALL_FLOATS
+typedef union KOS_FLOAT_BITS_U {
+    double   d;
+    uint64_t u;
+} KOS_FLOAT_BITS;
+
+#define SMALL_FLOAT_TAG  ((uint64_t)3U)
+#define SMALL_FLOAT_ZERO (((uint64_t)1U << 63) | SMALL_FLOAT_TAG)
+
+static KOS_OBJ_ID new_small_float(double value)
+{
+    KOS_FLOAT_BITS bits;
+    unsigned       top_exp;
+
+    bits.d = value;
+
+    /* Top three bits of the exponent must be either 011 or 100 */
+    top_exp = (unsigned)(bits.u >> 60) & 7U;
+
+    if ((top_exp == 3U || top_exp == 4U) && (bits.u != ((uint64_t)3U << 60)))
+        return (KOS_OBJ_ID)(uintptr_t)((bits.u << 3) | (bits.u >> 61) | SMALL_FLOAT_TAG);
+
+    if ( ! bits.u)
+        return (KOS_OBJ_ID)(uintptr_t)SMALL_FLOAT_ZERO;
+
+    return KOS_BADPTR;
+}
+#endif
+
 KOS_OBJ_ID KOS_new_float(KOS_CONTEXT ctx, double value)
 {
-    KOS_FLOAT *number = (KOS_FLOAT *)kos_alloc_object(ctx,
+    KOS_FLOAT *number;
+
+#ifdef KOS_SMALL_FLOATS
+    const KOS_OBJ_ID small_float = new_small_float(value);
+
+    if ( ! IS_BAD_PTR(small_float))
+        return small_float;
+#endif
+
+    number = (KOS_FLOAT *)kos_alloc_object(ctx,
                                                       KOS_ALLOC_MOVABLE,
                                                       OBJ_FLOAT,
                                                       sizeof(KOS_FLOAT));
@@ -59,6 +97,29 @@ KOS_OBJ_ID KOS_new_float(KOS_CONTEXT ctx, double value)
     return OBJID(FLOAT, number);
 }
 
+double KOS_get_float(KOS_OBJ_ID obj_id)
+{
+    assert(GET_OBJ_TYPE(obj_id) == OBJ_FLOAT);
+
+#ifdef KOS_SMALL_FLOATS
+    if (IS_SMALL_FLOAT(obj_id)) {
+        KOS_FLOAT_BITS bits;
+        uint64_t       value = (uint64_t)(uintptr_t)obj_id;
+
+        if (value == SMALL_FLOAT_ZERO)
+            return 0.0;
+
+        /* Restore the two top exponent bits from the third one */
+        value  = (value & ~SMALL_FLOAT_TAG) | (2U - (unsigned)(value >> 63));
+        bits.u = (value >> 3) | (value << 61);
+
+        return bits.d;
+    }
+#endif
+
+    return OBJPTR(FLOAT, obj_id)->value;
+}
+
 KOS_OBJ_ID KOS_new_function(KOS_CONTEXT ctx)
 {
     KOS_FUNCTION *func = (KOS_FUNCTION *)kos_alloc_object(ctx,
@@ -84,6 +145,7 @@ KOS_OBJ_ID KOS_new_function(KOS_CONTEXT ctx)
         func->defaults              = KOS_VOID;
         func->arg_map               = KOS_VOID;
         func->handler               = KOS_NULL;
+        func->fast_handler          = KOS_NULL;
         func->generator_stack_frame = KOS_BADPTR;
 
         KOS_atomic_write_relaxed_u32(func->state, KOS_FUN);
@@ -116,14 +178,15 @@ KOS_OBJ_ID kos_copy_function(KOS_CONTEXT ctx,
 
         KOS_atomic_write_relaxed_u32(dest->state, KOS_atomic_read_relaxed_u32(src->state));
 
-        dest->opts       = src->opts;
-        dest->bytecode   = src->bytecode;
-        dest->module     = src->module;
-        dest->name       = src->name;
-        dest->closures   = src->closures;
-        dest->defaults   = src->defaults;
-        dest->arg_map    = src->arg_map;
-        dest->handler    = src->handler;
+        dest->opts         = src->opts;
+        dest->bytecode     = src->bytecode;
+        dest->module       = src->module;
+        dest->name         = src->name;
+        dest->closures     = src->closures;
+        dest->defaults     = src->defaults;
+        dest->arg_map      = src->arg_map;
+        dest->handler      = src->handler;
+        dest->fast_handler = src->fast_handler;
     }
 
     KOS_destroy_top_local(ctx, &obj);
@@ -211,14 +274,15 @@ KOS_OBJ_ID KOS_new_class(KOS_CONTEXT ctx, KOS_OBJ_ID proto_obj)
         OBJPTR(CLASS, func.o)->opts.this_reg     = KOS_NO_REG;
         OBJPTR(CLASS, func.o)->opts.bind_reg     = KOS_NO_REG;
 
-        OBJPTR(CLASS, func.o)->dummy      = KOS_CTOR;
-        OBJPTR(CLASS, func.o)->bytecode   = KOS_BADPTR;
-        OBJPTR(CLASS, func.o)->module     = KOS_BADPTR;
-        OBJPTR(CLASS, func.o)->name       = KOS_STR_EMPTY;
-        OBJPTR(CLASS, func.o)->closures   = KOS_VOID;
-        OBJPTR(CLASS, func.o)->defaults   = KOS_VOID;
-        OBJPTR(CLASS, func.o)->arg_map    = KOS_VOID;
-        OBJPTR(CLASS, func.o)->handler    = KOS_NULL;
+        OBJPTR(CLASS, func.o)->dummy        = KOS_CTOR;
+        OBJPTR(CLASS, func.o)->bytecode     = KOS_BADPTR;
+        OBJPTR(CLASS, func.o)->module       = KOS_BADPTR;
+        OBJPTR(CLASS, func.o)->name         = KOS_STR_EMPTY;
+        OBJPTR(CLASS, func.o)->closures     = KOS_VOID;
+        OBJPTR(CLASS, func.o)->defaults     = KOS_VOID;
+        OBJPTR(CLASS, func.o)->arg_map      = KOS_VOID;
+        OBJPTR(CLASS, func.o)->handler      = KOS_NULL;
+        OBJPTR(CLASS, func.o)->fast_handler = KOS_NULL;
         KOS_atomic_write_relaxed_ptr(OBJPTR(CLASS, func.o)->prototype, proto.o);
         KOS_atomic_write_relaxed_ptr(OBJPTR(CLASS, func.o)->props,     KOS_BADPTR);
 
@@ -335,6 +399,23 @@ KOS_OBJ_ID KOS_new_builtin_function(KOS_CONTEXT          ctx,
     return KOS_destroy_top_locals(ctx, &name, &func);
 }
 
+KOS_OBJ_ID KOS_new_fast_builtin_function(KOS_CONTEXT               ctx,
+                                         KOS_OBJ_ID                name_obj,
+                                         KOS_FAST_FUNCTION_HANDLER handler,
+                                         const KOS_CONVERT        *args)
+{
+    KOS_OBJ_ID func_obj;
+
+    assert(handler);
+
+    func_obj = KOS_new_builtin_function(ctx, name_obj, kos_call_fast_handler, args);
+
+    if ( ! IS_BAD_PTR(func_obj))
+        OBJPTR(FUNCTION, func_obj)->fast_handler = handler;
+
+    return func_obj;
+}
+
 KOS_OBJ_ID KOS_new_builtin_class(KOS_CONTEXT          ctx,
                                  KOS_OBJ_ID           name_obj,
                                  KOS_FUNCTION_HANDLER handler,
@@ -467,7 +548,7 @@ int kos_is_truthy(KOS_OBJ_ID obj_id)
             break;
 
         case OBJ_FLOAT:
-            ret = OBJPTR(FLOAT, obj_id)->value != 0.0;
+            ret = KOS_get_float(obj_id) != 0.0;
             break;
 
         case OBJ_VOID:
@@ -13,6 +13,7 @@
 #include "../inc/kos_string.h"
 #include "kos_config.h"
 #include "kos_debug.h"
+#include "kos_jit.h"
 #include "kos_math.h"
 #include "kos_object_internal.h"
 #include "kos_perf.h"
@@ -60,6 +61,12 @@ static void update_child_ptr(KOS_OBJ_ID *obj_id_ptr);
 
 static void help_gc(KOS_CONTEXT ctx);
 
+static void set_new_object_black(KOS_HEAP *heap, KOS_OBJ_HEADER *hdr);
+
+static void abandon_concurrent_marking(KOS_HEAP *heap);
+
+static void stop_gc_workers(KOS_HEAP *heap);
+
 #ifdef CONFIG_MAD_GC
 #define KOS_MAX_LOCKED_PAGES 256
 
@@ -76,13 +83,30 @@ struct KOS_MARK_GROUP_S {
     KOS_OBJ_ID      objs[62];
 };
 
+enum KOS_MARK_MODE_E {
+    MARK_ALL,       /* Major GC, mark all reachable objects                   */
+    MARK_CONCURRENT,/* Major GC, mark in the background while mutators run    */
+    MARK_YOUNG,     /* Minor GC, mark only reachable objects in young pages   */
+    VERIFY_NO_YOUNG /* Debug check that old objects don't point to young ones */
+};
+
 struct KOS_MARK_CONTEXT_S {
-    KOS_MARK_GROUP *current;
-    KOS_HEAP       *heap;
+    KOS_MARK_GROUP      *current;
+    KOS_HEAP            *heap;
+    enum KOS_MARK_MODE_E mode;
 };
 
 typedef struct KOS_MARK_CONTEXT_S KOS_MARK_CONTEXT;
 
+/* Limits the amount of work done in one incremental marking slice */
+struct KOS_MARK_BUDGET_S {
+    int64_t  end_time_us; /* Time when the slice ends, 0 if not limited      */
+    uint32_t max_bytes;   /* Size of objects to mark, 0 if not limited       */
+    uint32_t num_bytes;   /* Size of objects marked so far                   */
+};
+
+typedef struct KOS_MARK_BUDGET_S KOS_MARK_BUDGET;
+
 static int is_page_full(KOS_PAGE *page)
 {
     return KOS_atomic_read_relaxed_u32(page->num_allocated) == KOS_SLOTS_PER_PAGE;
@@ -234,16 +258,40 @@ int kos_heap_init(KOS_INSTANCE *inst)
     heap->malloc_size     = 0;
     heap->max_heap_size   = KOS_MAX_HEAP_SIZE;
     heap->max_malloc_size = KOS_MAX_HEAP_SIZE;
-    heap->gc_threshold    = (uint32_t)(((uint64_t)KOS_MAX_HEAP_SIZE * KOS_GC_THRESHOLD) / 100U);
+    heap->gc_threshold    = KOS_MIN_HEAP_SIZE;
+    heap->min_heap_size   = KOS_MIN_HEAP_SIZE;
+    heap->soft_max_size   = (uint32_t)(((uint64_t)KOS_MAX_HEAP_SIZE * KOS_GC_THRESHOLD) / 100U);
+    heap->gc_time_target  = KOS_GC_TIME_TARGET;
+    heap->num_young_pages = 0;
     heap->free_pages      = KOS_NULL;
     heap->used_pages.head = KOS_NULL;
     heap->used_pages.tail = KOS_NULL;
+    heap->evac_pages[0]   = KOS_NULL;
+    heap->evac_pages[1]   = KOS_NULL;
     heap->pools           = KOS_NULL;
     heap->walk_threads    = 0U;
     heap->threads_to_stop = 0U;
     heap->gc_cycles       = 0U;
-
-    KOS_atomic_write_relaxed_u32(heap->gc_state,   GC_INACTIVE);
+    heap->minor_gc_cycles = 0U;
+    heap->gc_minor        = 0U;
+    heap->mark_thread     = KOS_NULL;
+    heap->slice_us        = 0U;
+    heap->slice_bytes     = 0U;
+    heap->num_slices      = 0U;
+    heap->max_slice_us    = 0U;
+    heap->gc_workers      = KOS_NULL;
+    heap->num_gc_workers  = 0U;
+    heap->stop_gc_workers = 0U;
+    heap->evacuation      = KOS_NULL;
+    heap->gc_time_us      = 0U;
+    heap->sizing_time_us  = KOS_get_time_us();
+
+    memset(heap->slice_hist, 0, sizeof(heap->slice_hist));
+
+    KOS_atomic_write_relaxed_u32(heap->gc_state,        GC_INACTIVE);
+    KOS_atomic_write_relaxed_u32(heap->concurrent_mark, CONCURRENT_IDLE);
+    KOS_atomic_write_relaxed_u32(heap->busy_markers,    0U);
+    KOS_atomic_write_relaxed_u32(heap->idle_markers,    0U);
     KOS_atomic_write_relaxed_ptr(heap->walk_pages, (KOS_PAGE *)KOS_NULL);
 
 #ifdef CONFIG_MAD_GC
@@ -299,6 +347,17 @@ int kos_heap_init(KOS_INSTANCE *inst)
         return error;
     }
 
+    error = kos_create_cond_var(&heap->mark_cond);
+    if (error) {
+        kos_destroy_cond_var(&heap->helper_cond);
+        kos_destroy_cond_var(&heap->walk_cond);
+        kos_destroy_cond_var(&heap->engagement_cond);
+        kos_destroy_mutex(&heap->mutex);
+        kos_destroy_mutex(&heap->free_mark_groups.mutex);
+        kos_destroy_mutex(&heap->objects_to_mark.mutex);
+        return error;
+    }
+
     return KOS_SUCCESS;
 }
 
@@ -372,14 +431,26 @@ static void finalize_object(KOS_CONTEXT     ctx,
 
             if (obj->data) {
 
-                if ( ! IS_BAD_PTR(obj->object))
-                    finalize_object(ctx, (KOS_OBJ_HEADER *)((intptr_t)obj->object - 1), stats);
+                if ( ! IS_BAD_PTR(obj->object)) {
+
+                    KOS_OBJ_HEADER *const obj_hdr = (KOS_OBJ_HEADER *)((intptr_t)obj->object - 1);
+
+#ifdef KOS_JIT
+                    if (obj->is_bytecode)
+                        kos_jit_free((KOS_BYTECODE *)obj_hdr);
+#endif
+
+                    finalize_object(ctx, obj_hdr, stats);
+                }
 
                 gc_trace(("free huge %p\n", (void *)obj->data));
 
                 KOS_free_aligned(obj->data);
 
+                /* Objects can be finalized by multiple threads during evacuation */
+                kos_lock_mutex(get_heap(ctx)->mutex);
                 get_heap(ctx)->malloc_size -= obj->size;
+                kos_unlock_mutex(get_heap(ctx)->mutex);
 
                 stats->size_freed += obj->size;
 
@@ -441,6 +512,10 @@ void kos_heap_destroy(KOS_INSTANCE *inst)
     /* Disable GC */
     inst->flags |= KOS_INST_MANUAL_GC;
 
+    stop_gc_workers(&inst->heap);
+
+    abandon_concurrent_marking(&inst->heap);
+
     kos_heap_release_thread_page(&inst->threads.main_thread);
 
 #ifdef CONFIG_MAD_GC
@@ -510,6 +585,7 @@ void kos_heap_destroy(KOS_INSTANCE *inst)
         KOS_free(pool);
     }
 
+    kos_destroy_cond_var(&inst->heap.mark_cond);
     kos_destroy_cond_var(&inst->heap.helper_cond);
     kos_destroy_cond_var(&inst->heap.walk_cond);
     kos_destroy_cond_var(&inst->heap.engagement_cond);
@@ -705,6 +781,50 @@ static int alloc_page_pool(KOS_HEAP *heap)
     return KOS_SUCCESS;
 }
 
+#ifndef CONFIG_MAD_GC
+/* Returns pools in which all pages are free to the system, until heap size
+ * drops to max_size. */
+static void release_free_pools(KOS_HEAP *heap, uint32_t max_size)
+{
+    KOS_POOL **pool_ptr = &heap->pools;
+
+    while (*pool_ptr && (heap->heap_size > max_size)) {
+
+        KOS_POOL *const pool      = *pool_ptr;
+        uint8_t  *const begin     = (uint8_t *)pool->memory;
+        uint8_t  *const end       = begin + pool->alloc_size;
+        KOS_PAGE      **page_ptr  = &heap->free_pages;
+        KOS_PAGE       *page;
+        uint32_t        num_free  = 0U;
+
+        for (page = heap->free_pages; page; page = page->next)
+            if (((uint8_t *)page >= begin) && ((uint8_t *)page < end))
+                ++num_free;
+
+        if (num_free < (pool->alloc_size >> KOS_PAGE_BITS)) {
+            pool_ptr = &pool->next;
+            continue;
+        }
+
+        while (*page_ptr) {
+            page = *page_ptr;
+
+            if (((uint8_t *)page >= begin) && ((uint8_t *)page < end))
+                *page_ptr = page->next;
+            else
+                page_ptr = &page->next;
+        }
+
+        *pool_ptr = pool->next;
+
+        heap->heap_size -= pool->alloc_size;
+
+        KOS_free_aligned(pool->memory);
+        KOS_free(pool);
+    }
+}
+#endif
+
 static KOS_PAGE *alloc_page(KOS_HEAP *heap)
 {
     KOS_PAGE *page = heap->free_pages;
@@ -732,11 +852,23 @@ static KOS_PAGE *alloc_page(KOS_HEAP *heap)
 
     KOS_PERF_CNT(alloc_free_page);
 
+    KOS_atomic_write_relaxed_u32(page->flags, 0U);
+
+    /* Objects allocated during background marking are marked in the bitmap */
+    if (KOS_atomic_read_relaxed_u32(heap->concurrent_mark) != CONCURRENT_IDLE)
+        memset((uint8_t *)page + KOS_BITMAP_OFFS, 0, KOS_BITMAP_SIZE);
+
     page->next = KOS_NULL;
     return page;
 }
 
-static int collect_garbage_last_resort_locked(KOS_CONTEXT ctx, KOS_GC_STATS *stats)
+static int collect_garbage(KOS_CONTEXT   ctx,
+                           int           minor,
+                           KOS_GC_STATS *out_stats);
+
+static int collect_garbage_locked(KOS_CONTEXT   ctx,
+                                  int           minor,
+                                  KOS_GC_STATS *stats)
 {
     KOS_HEAP *const heap = get_heap(ctx);
     int             error;
@@ -751,19 +883,40 @@ static int collect_garbage_last_resort_locked(KOS_CONTEXT ctx, KOS_GC_STATS *sta
     kos_unlock_mutex(heap->mutex);
 
     /* TODO add and use kos_collect_garbage_locked() */
-    error = KOS_collect_garbage(ctx, stats);
+    error = collect_garbage(ctx, minor, stats);
 
     kos_lock_mutex(heap->mutex);
 
     return error;
 }
 
+static int collect_garbage_last_resort_locked(KOS_CONTEXT ctx, KOS_GC_STATS *stats)
+{
+    KOS_HEAP *const heap = get_heap(ctx);
+
+    /* Objects allocated during background marking survive remark, so finish
+     * the pending GC cycle first and then collect all garbage */
+    if (KOS_atomic_read_relaxed_u32(heap->concurrent_mark) != CONCURRENT_IDLE) {
+
+        const int error = collect_garbage_locked(ctx, 0, KOS_NULL);
+
+        if (error)
+            return error;
+    }
+
+    return collect_garbage_locked(ctx, 0, stats);
+}
+
+static int begin_concurrent_marking(KOS_CONTEXT ctx);
+
+static int mark_incrementally(KOS_CONTEXT ctx);
+
 static int try_collect_garbage(KOS_CONTEXT ctx)
 {
-#ifndef CONFIG_MAD_GC
     KOS_HEAP *const heap  = get_heap(ctx);
-#endif
+    int             minor = 0;
     int             error = KOS_SUCCESS;
+    uint32_t        concurrent_mark;
 
     /* Don't try to collect garbage when the garbage collector is running */
     if (KOS_atomic_read_relaxed_u32(ctx->gc_state) != GC_INACTIVE)
@@ -772,14 +925,35 @@ static int try_collect_garbage(KOS_CONTEXT ctx)
     if (ctx->inst->flags & KOS_INST_MANUAL_GC)
         return KOS_SUCCESS;
 
+    concurrent_mark = KOS_atomic_read_relaxed_u32(heap->concurrent_mark);
+
+    /* Let the heap grow while objects are being marked in the background,
+     * finish the GC cycle once marking is done.  In incremental mode,
+     * perform one slice of marking each time a new page is needed. */
+    if (concurrent_mark == CONCURRENT_ACTIVE)
+        return heap->mark_thread ? KOS_SUCCESS : mark_incrementally(ctx);
+
 #ifndef CONFIG_MAD_GC
-    if (heap->used_heap_size > heap->gc_threshold ||
-        heap->malloc_size > heap->max_malloc_size)
+    /* Collect only young objects if the nursery is full, but the heap is not */
+    if (concurrent_mark == CONCURRENT_IDLE &&
+        heap->used_heap_size <= heap->gc_threshold &&
+        heap->malloc_size <= heap->max_malloc_size) {
+
+        if (heap->num_young_pages < KOS_NURSERY_SIZE / KOS_PAGE_SIZE)
+            return KOS_SUCCESS;
+
+        minor = 1;
+    }
 #endif
+
+    if ( ! minor && (concurrent_mark == CONCURRENT_IDLE) &&
+        ((ctx->inst->flags & KOS_INST_CONCURRENT_GC) || heap->slice_us || heap->slice_bytes))
+        return begin_concurrent_marking(ctx);
+
     {
         KOS_GC_STATS stats = KOS_GC_STATS_INIT(0U);
 
-        error = collect_garbage_last_resort_locked(ctx, &stats);
+        error = collect_garbage_locked(ctx, minor, &stats);
 
         if ( ! error && stats.heap_size)
             error = KOS_SUCCESS_RETURN;
@@ -865,6 +1039,44 @@ void kos_heap_release_thread_page(KOS_CONTEXT ctx)
     }
 }
 
+static KOS_PAGE *get_object_page(KOS_OBJ_ID obj_id)
+{
+    assert( ! IS_BAD_PTR(obj_id));
+    assert(kos_is_tracked_object(obj_id));
+
+    /* Huge objects are located via their trackers, which reside in pages */
+    if ( ! kos_is_heap_object(obj_id)) {
+
+        obj_id = *(KOS_OBJ_ID *)((intptr_t)obj_id - 1 - sizeof(KOS_OBJ_ID));
+
+        assert(kos_is_heap_object(obj_id));
+        assert(READ_OBJ_TYPE(obj_id) == OBJ_HUGE_TRACKER);
+    }
+
+    return (KOS_PAGE *)((uintptr_t)obj_id & ~(uintptr_t)(KOS_PAGE_SIZE - 1));
+}
+
+static int is_old_object(KOS_OBJ_ID obj_id)
+{
+    return KOS_atomic_read_relaxed_u32(get_object_page(obj_id)->flags) & KOS_PAGE_OLD;
+}
+
+static void set_page_dirty(KOS_PAGE *page)
+{
+    const uint32_t flags = KOS_atomic_read_relaxed_u32(page->flags);
+
+    /* Young objects are always scanned by minor GC, but old pages are
+     * only scanned if they may contain pointers to young objects. */
+    if ((flags & (KOS_PAGE_OLD | KOS_PAGE_DIRTY)) == KOS_PAGE_OLD)
+        KOS_atomic_write_relaxed_u32(page->flags, flags | KOS_PAGE_DIRTY);
+}
+
+void kos_write_barrier(KOS_OBJ_ID obj_id)
+{
+    if ( ! IS_BAD_PTR(obj_id) && kos_is_tracked_object(obj_id))
+        set_page_dirty(get_object_page(obj_id));
+}
+
 #ifndef NDEBUG
 static void verify_heap_used_size(KOS_HEAP *heap)
 {
@@ -905,8 +1117,10 @@ static void *alloc_object(KOS_CONTEXT ctx,
 
         hdr = alloc_object_from_page(page, object_type, num_slots);
 
-        if (hdr)
+        if (hdr) {
+            set_new_object_black(get_heap(ctx), hdr);
             return hdr;
+        }
     }
 
     /* Slow path: find a non-full page in the heap which has enough room or
@@ -955,6 +1169,10 @@ static void *alloc_object(KOS_CONTEXT ctx,
         if ( ! hdr)
             continue;
 
+        /* New objects allocated in the remaining space of an old page are
+         * treated as old, the page is scanned during the next minor GC. */
+        set_page_dirty(old_page);
+
         heap->used_heap_size += num_slots << KOS_OBJ_ALIGN_BITS;
 
         /* Move full page to the back of the list */
@@ -1030,12 +1248,17 @@ static void *alloc_object(KOS_CONTEXT ctx,
 
             ctx->cur_page = page;
 
+            ++heap->num_young_pages;
+
             hdr = alloc_object_from_page(page, object_type, num_slots);
 
             assert(hdr);
         }
     }
 
+    if (hdr)
+        set_new_object_black(heap, hdr);
+
     PROF_PLOT("heap",     (int64_t)heap->used_heap_size)
     PROF_PLOT("off-heap", (int64_t)heap->malloc_size)
 
@@ -1044,9 +1267,10 @@ static void *alloc_object(KOS_CONTEXT ctx,
     return hdr;
 }
 
-static void *alloc_huge_object(KOS_CONTEXT ctx,
-                               KOS_TYPE    object_type,
-                               uint32_t    size)
+static void *alloc_huge_object(KOS_CONTEXT    ctx,
+                               KOS_ALLOC_FLAG flags,
+                               KOS_TYPE       object_type,
+                               uint32_t       size)
 {
     PROF_ZONE(HEAP)
 
@@ -1067,9 +1291,10 @@ static void *alloc_huge_object(KOS_CONTEXT ctx,
     if ( ! new_tracker)
         return KOS_NULL;
 
-    new_tracker->data   = KOS_NULL;
-    new_tracker->object = KOS_BADPTR;
-    new_tracker->size   = 0;
+    new_tracker->data        = KOS_NULL;
+    new_tracker->object      = KOS_BADPTR;
+    new_tracker->size        = 0;
+    new_tracker->is_bytecode = flags == KOS_ALLOC_BYTECODE;
 
     KOS_init_local_with(ctx, &tracker, OBJID(HUGE_TRACKER, new_tracker));
 
@@ -1141,8 +1366,8 @@ void *kos_alloc_object(KOS_CONTEXT    ctx,
         return KOS_NULL;
     }
 
-    if (size > KOS_MAX_HEAP_OBJ_SIZE || flags == KOS_ALLOC_IMMOVABLE)
-        obj = alloc_huge_object(ctx, object_type, size);
+    if (size > KOS_MAX_HEAP_OBJ_SIZE || flags != KOS_ALLOC_MOVABLE)
+        obj = alloc_huge_object(ctx, flags, object_type, size);
     else
         obj = alloc_object(ctx, object_type, size);
 
@@ -1269,17 +1494,27 @@ enum KOS_MARK_STATE_E {
     COLORMASK = 3
 };
 
+#define KOS_PAGE_GEN_FLAGS (KOS_PAGE_OLD | KOS_PAGE_SCAN | KOS_PAGE_DIRTY)
+
+static void set_marking_in_page(KOS_PAGE             *page,
+                                enum KOS_MARK_STATE_E state,
+                                uint32_t              flags)
+{
+    uint32_t *const bitmap    = (uint32_t *)((uint8_t *)page + KOS_BITMAP_OFFS);
+    const uint32_t  old_flags = KOS_atomic_read_relaxed_u32(page->flags);
+
+    memset(bitmap, state * 0x55, KOS_BITMAP_SIZE);
+
+    KOS_atomic_write_relaxed_u32(page->flags, (old_flags & KOS_PAGE_GEN_FLAGS) | flags);
+}
+
 static void set_marking_in_pages(KOS_PAGE             *page,
                                  enum KOS_MARK_STATE_E state,
                                  uint32_t              flags)
 {
     while (page) {
 
-        uint32_t *const bitmap = (uint32_t *)((uint8_t *)page + KOS_BITMAP_OFFS);
-
-        memset(bitmap, state * 0x55, KOS_BITMAP_SIZE);
-
-        KOS_atomic_write_relaxed_u32(page->flags, flags);
+        set_marking_in_page(page, state, flags);
 
         page = page->next;
     }
@@ -1289,7 +1524,23 @@ static void clear_marking(KOS_HEAP *heap)
 {
     PROF_ZONE(GC)
 
-    set_marking_in_pages(heap->used_pages.head, WHITE, 0);
+    if (heap->gc_minor) {
+
+        KOS_PAGE *page = heap->used_pages.head;
+
+        /* Marking in old pages is not used during minor GC */
+        for ( ; page; page = page->next) {
+            if ( ! (KOS_atomic_read_relaxed_u32(page->flags) & KOS_PAGE_OLD))
+                set_marking_in_page(page, WHITE, 0);
+#if defined(CONFIG_MAD_GC) && ! defined(NDEBUG)
+            /* Pointer update checks that all referenced objects are marked */
+            else
+                set_marking_in_page(page, BLACK, 0);
+#endif
+        }
+    }
+    else
+        set_marking_in_pages(heap->used_pages.head, WHITE, 0);
 
     heap->mark_error = KOS_SUCCESS;
 }
@@ -1438,6 +1689,14 @@ static uint32_t set_mark_state_loc(struct KOS_MARK_LOC_S mark_loc,
     return 1;
 }
 
+static void set_new_object_black(KOS_HEAP *heap, KOS_OBJ_HEADER *hdr)
+{
+    /* Objects allocated during background marking are not visited by the
+     * marking thread, instead they are scanned during remark. */
+    if (KOS_atomic_read_relaxed_u32(heap->concurrent_mark) != CONCURRENT_IDLE)
+        (void)set_mark_state_loc(get_mark_location((KOS_OBJ_ID)((intptr_t)hdr + 1)), COLORMASK);
+}
+
 static void clear_page_mark_state(KOS_PAGE *page, uint32_t size)
 {
     KOS_ATOMIC(uint32_t) *bitmap = get_bitmap(page);
@@ -1565,10 +1824,24 @@ static void free_all_mark_groups(KOS_MARK_CONTEXT *mark_ctx)
         free_mark_group(mark_ctx, group);
 }
 
+static int is_marking_skipped(KOS_MARK_CONTEXT *mark_ctx, KOS_OBJ_ID obj_id)
+{
+    if (mark_ctx->mode <= MARK_CONCURRENT || IS_BAD_PTR(obj_id) || ! kos_is_tracked_object(obj_id))
+        return 0;
+
+    /* Objects in old pages which are not scanned must only point to old objects */
+    assert(mark_ctx->mode == MARK_YOUNG || is_old_object(obj_id));
+
+    return mark_ctx->mode != MARK_YOUNG || is_old_object(obj_id);
+}
+
 static int mark_object_gray(KOS_MARK_CONTEXT *mark_ctx, KOS_OBJ_ID obj_id)
 {
     int error = KOS_SUCCESS;
 
+    if (is_marking_skipped(mark_ctx, obj_id))
+        return KOS_SUCCESS;
+
     if (set_mark_state(obj_id, GRAY))
         error = schedule_for_marking(mark_ctx, obj_id);
 
@@ -1582,46 +1855,154 @@ static void init_mark_context(KOS_MARK_CONTEXT *mark_ctx, KOS_HEAP *heap)
 {
     mark_ctx->current = KOS_NULL;
     mark_ctx->heap    = heap;
+    mark_ctx->mode    = heap->gc_minor ? MARK_YOUNG : MARK_ALL;
 }
 
-static int perform_gray_to_black_marking(KOS_MARK_CONTEXT       *mark_ctx,
-                                         enum WALK_THREAD_TYPE_E helper)
+static int is_mark_budget_exhausted(KOS_MARK_BUDGET *budget)
 {
-    KOS_MARK_GROUP *group;
-    int             error = KOS_SUCCESS;
+    if (budget->max_bytes && (budget->num_bytes >= budget->max_bytes))
+        return 1;
 
-    PROF_ZONE(GC)
+    return budget->end_time_us && (KOS_get_time_us() >= budget->end_time_us);
+}
 
-    begin_walk(mark_ctx->heap, helper);
+static int mark_objects_in_group(KOS_MARK_CONTEXT *mark_ctx,
+                                 KOS_MARK_GROUP   *group,
+                                 KOS_MARK_BUDGET  *budget)
+{
+    KOS_OBJ_ID       *ptr   = &group->objs[0];
+    KOS_OBJ_ID *const end   = ptr + group->num_objs;
+    int               error = KOS_SUCCESS;
 
-    group = get_next_scheduled_mark_group(mark_ctx);
+    while ((ptr != end) && ! error) {
 
-    while (group && ! error) {
+        const KOS_OBJ_ID obj_id = *(ptr++);
 
-        KOS_OBJ_ID       *ptr = &group->objs[0];
-        KOS_OBJ_ID *const end = ptr + group->num_objs;
+        error = mark_object_black(mark_ctx, obj_id);
 
-        while ((ptr != end) && ! error) {
+        if (budget && kos_is_tracked_object(obj_id))
+            budget->num_bytes += kos_get_object_size(*(KOS_OBJ_HEADER *)((intptr_t)obj_id - 1));
+    }
 
-            const KOS_OBJ_ID obj_id = *(ptr++);
+    free_mark_group(mark_ctx, group);
 
-            error = mark_object_black(mark_ctx, obj_id);
-        }
+    return error;
+}
+
+static void free_current_mark_group(KOS_MARK_CONTEXT *mark_ctx)
+{
+    KOS_MARK_GROUP *const group = mark_ctx->current;
 
+    if (group) {
+        mark_ctx->current = KOS_NULL;
         free_mark_group(mark_ctx, group);
+    }
+}
+
+/* Returns KOS_SUCCESS_RETURN if the budget has been exhausted before all
+ * scheduled objects were marked. */
+static int mark_scheduled_objects(KOS_MARK_CONTEXT *mark_ctx,
+                                  KOS_MARK_BUDGET  *budget)
+{
+    KOS_MARK_GROUP *group = get_next_scheduled_mark_group(mark_ctx);
+    int             error = KOS_SUCCESS;
+
+    while (group && ! error) {
+
+        error = mark_objects_in_group(mark_ctx, group, budget);
+
+        if ( ! error && budget && is_mark_budget_exhausted(budget))
+            return KOS_SUCCESS_RETURN;
 
         group = get_next_scheduled_mark_group(mark_ctx);
     }
 
-    if (error) {
-        group = mark_ctx->current;
+    if (error)
+        free_current_mark_group(mark_ctx);
+
+    return error;
+}
+
+/* Called by a marking thread which ran out of mark groups.  Waits until
+ * another marking thread publishes a mark group and takes it.  Returns
+ * KOS_NULL when no thread has any mark groups left. */
+static KOS_MARK_GROUP *steal_mark_group(KOS_HEAP *heap)
+{
+    KOS_MARK_GROUP *group;
+
+    KOS_atomic_add_u32(heap->idle_markers, 1U);
+    KOS_atomic_add_u32(heap->busy_markers, (uint32_t)-1);
+
+    for (;;) {
+        group = pop_mark_group(&heap->objects_to_mark);
 
         if (group) {
+            KOS_atomic_add_u32(heap->busy_markers, 1U);
+            break;
+        }
+
+        if ( ! KOS_atomic_read_relaxed_u32(heap->busy_markers))
+            break;
+
+        kos_yield();
+    }
+
+    KOS_atomic_add_u32(heap->idle_markers, (uint32_t)-1);
+
+    return group;
+}
+
+/* Marks objects together with other threads in a stopped world.  Each thread
+ * keeps marking its current mark group until it fills up, which keeps
+ * traversal local.  When another thread runs out of work, the current mark
+ * group is published, so that the idle thread can steal it. */
+static int mark_in_parallel(KOS_MARK_CONTEXT *mark_ctx)
+{
+    KOS_HEAP *const heap  = mark_ctx->heap;
+    int             error = KOS_SUCCESS;
+
+    KOS_atomic_add_u32(heap->busy_markers, 1U);
+
+    for (;;) {
+
+        KOS_MARK_GROUP *group = get_next_scheduled_mark_group(mark_ctx);
+
+        if ( ! group) {
+            group = steal_mark_group(heap);
+
+            if ( ! group)
+                return KOS_SUCCESS;
+        }
+
+        error = mark_objects_in_group(mark_ctx, group, KOS_NULL);
+
+        if (error)
+            break;
+
+        if (mark_ctx->current && KOS_atomic_read_relaxed_u32(heap->idle_markers)) {
+            push_scheduled(heap, mark_ctx->current);
             mark_ctx->current = KOS_NULL;
-            free_mark_group(mark_ctx, group);
         }
     }
 
+    free_current_mark_group(mark_ctx);
+
+    KOS_atomic_add_u32(heap->busy_markers, (uint32_t)-1);
+
+    return error;
+}
+
+static int perform_gray_to_black_marking(KOS_MARK_CONTEXT       *mark_ctx,
+                                         enum WALK_THREAD_TYPE_E helper)
+{
+    int error;
+
+    PROF_ZONE(GC)
+
+    begin_walk(mark_ctx->heap, helper);
+
+    error = mark_in_parallel(mark_ctx);
+
     end_walk(mark_ctx->heap, helper);
 
     return error;
@@ -1697,6 +2078,27 @@ static int mark_children_gray(KOS_MARK_CONTEXT *mark_ctx,
             break;
         }
 
+        case OBJ_SHAPED_STORAGE: {
+            KOS_ATOMIC(KOS_OBJ_ID) *item = &OBJPTR(SHAPED_STORAGE, obj_id)->values[0];
+            KOS_ATOMIC(KOS_OBJ_ID) *end  = item + OBJPTR(SHAPED_STORAGE, obj_id)->capacity;
+            for ( ; item < end; ++item)
+                TRY(mark_object_gray(mark_ctx, KOS_atomic_read_relaxed_obj(*item)));
+
+            TRY(mark_object_gray(mark_ctx, KOS_atomic_read_relaxed_obj(OBJPTR(SHAPED_STORAGE, obj_id)->shape)));
+            TRY(mark_object_gray(mark_ctx, KOS_atomic_read_relaxed_obj(OBJPTR(SHAPED_STORAGE, obj_id)->new_prop_table)));
+            break;
+        }
+
+        case OBJ_SHAPE: {
+            KOS_OBJ_ID *item = &OBJPTR(SHAPE, obj_id)->keys[0];
+            KOS_OBJ_ID *end  = item + OBJPTR(SHAPE, obj_id)->num_props;
+            for ( ; item < end; ++item)
+                TRY(mark_object_gray(mark_ctx, *item));
+
+            TRY(mark_object_black(mark_ctx, KOS_atomic_read_relaxed_obj(OBJPTR(SHAPE, obj_id)->transitions)));
+            break;
+        }
+
         case OBJ_ARRAY_STORAGE: {
             KOS_ATOMIC(KOS_OBJ_ID) *item = &OBJPTR(ARRAY_STORAGE, obj_id)->buf[0];
             KOS_ATOMIC(KOS_OBJ_ID) *end  = item + OBJPTR(ARRAY_STORAGE, obj_id)->capacity;
@@ -1729,6 +2131,7 @@ static int mark_children_gray(KOS_MARK_CONTEXT *mark_ctx,
             TRY(mark_object_black(mark_ctx, OBJPTR(MODULE, obj_id)->constants));
             TRY(mark_object_black(mark_ctx, OBJPTR(MODULE, obj_id)->global_names));
             TRY(mark_object_black(mark_ctx, OBJPTR(MODULE, obj_id)->globals));
+            TRY(mark_object_black(mark_ctx, OBJPTR(MODULE, obj_id)->const_globals));
             TRY(mark_object_black(mark_ctx, OBJPTR(MODULE, obj_id)->module_names));
             TRY(mark_object_black(mark_ctx, KOS_atomic_read_relaxed_obj(
                                             OBJPTR(MODULE, obj_id)->priv)));
@@ -1737,6 +2140,12 @@ static int mark_children_gray(KOS_MARK_CONTEXT *mark_ctx,
         case OBJ_STACK: {
             KOS_ATOMIC(KOS_OBJ_ID) *item = &OBJPTR(STACK, obj_id)->buf[0];
             KOS_ATOMIC(KOS_OBJ_ID) *end  = item + OBJPTR(STACK, obj_id)->size;
+
+            /* Stacks change constantly without write barriers, they are
+             * scanned during remark when the world is stopped. */
+            if (mark_ctx->mode == MARK_CONCURRENT)
+                break;
+
             for ( ; item < end; ++item)
                 TRY(mark_object_gray(mark_ctx, KOS_atomic_read_relaxed_obj(*item)));
             break;
@@ -1763,7 +2172,14 @@ static int mark_object_black(KOS_MARK_CONTEXT *mark_ctx,
 {
     int error = KOS_SUCCESS;
 
-    set_mark_state(obj_id, BLACK);
+    if (is_marking_skipped(mark_ctx, obj_id))
+        return KOS_SUCCESS;
+
+    /* Objects which are already black during background marking have either
+     * been scanned or have been allocated during marking and will be scanned
+     * during remark, possibly before they were fully initialized. */
+    if ( ! set_mark_state(obj_id, BLACK) && (mark_ctx->mode == MARK_CONCURRENT))
+        return KOS_SUCCESS;
 
     if ( ! IS_BAD_PTR(obj_id) && kos_is_tracked_object(obj_id))
         error = mark_children_gray(mark_ctx, obj_id);
@@ -1856,6 +2272,8 @@ static int mark_roots(KOS_CONTEXT ctx, KOS_MARK_CONTEXT *mark_ctx)
     TRY(mark_object_black(mark_ctx, inst->prototypes.thread_proto));
     TRY(mark_object_black(mark_ctx, inst->prototypes.module_proto));
 
+    TRY(mark_object_black(mark_ctx, inst->shapes.root));
+
     TRY(mark_object_black(mark_ctx, inst->modules.init_module));
     TRY(mark_object_black(mark_ctx, inst->modules.search_paths));
     TRY(mark_object_black(mark_ctx, inst->modules.module_names));
@@ -1882,42 +2300,351 @@ cleanup:
     return error;
 }
 
-#ifdef CONFIG_MAD_GC
-static void lock_pages(KOS_HEAP *heap, KOS_PAGE *pages)
+static int mark_children_in_page(KOS_MARK_CONTEXT *mark_ctx, KOS_PAGE *page)
 {
-    while (pages) {
+    int             error = KOS_SUCCESS;
+    uint8_t        *ptr   = (uint8_t *)get_slots(page);
+    uint8_t *const  end   = ptr + (KOS_atomic_read_relaxed_u32(page->num_allocated) << KOS_OBJ_ALIGN_BITS);
 
-        KOS_PAGE *page = pages;
-        uint32_t  i;
+    while (ptr < end) {
 
-        pages = page->next;
+        KOS_OBJ_HEADER *hdr  = (KOS_OBJ_HEADER *)ptr;
+        const uint32_t  size = kos_get_object_size(*hdr);
 
-        /* Only lock heap pages which are fully aligned with OS pages */
-        kos_mem_protect(page, KOS_PAGE_SIZE, KOS_NO_ACCESS);
+        assert(size > 0U);
 
-        if ( ! heap->locked_pages_last || heap->locked_pages_last->num_pages == KOS_MAX_LOCKED_PAGES) {
+        TRY(mark_children_gray(mark_ctx, (KOS_OBJ_ID)((intptr_t)hdr + 1)));
 
-            struct KOS_LOCKED_PAGES_S *locked_pages =
-                (struct KOS_LOCKED_PAGES_S *)KOS_malloc(sizeof(struct KOS_LOCKED_PAGES_S));
+        ptr += size;
+    }
 
-            if ( ! locked_pages) {
-                fprintf(stderr, "Failed to allocate memory to store locked pages\n");
-                exit(1);
-            }
+cleanup:
+    return error;
+}
 
-            locked_pages->num_pages = 0;
-            locked_pages->next      = KOS_NULL;
-            if (heap->locked_pages_last)
-                heap->locked_pages_last->next = locked_pages;
-            heap->locked_pages_last = locked_pages;
-            if ( ! heap->locked_pages_first)
-                heap->locked_pages_first = locked_pages;
-        }
+static int mark_old_pages(KOS_MARK_CONTEXT *mark_ctx, KOS_HEAP *heap)
+{
+    PROF_ZONE(GC)
 
-        i = heap->locked_pages_last->num_pages++;
+    int       error = KOS_SUCCESS;
+    KOS_PAGE *page  = heap->used_pages.head;
 
-        heap->locked_pages_last->pages[i] = page;
-    }
+    /* During minor GC, objects in old pages which can contain pointers to
+     * young objects are treated as roots.  Remaining old pages are skipped
+     * during pointer update after evacuation.  Pages receiving evacuated
+     * objects are never skipped. */
+    for ( ; page; page = page->next) {
+
+        const uint32_t flags = KOS_atomic_read_relaxed_u32(page->flags);
+
+        if ( ! (flags & KOS_PAGE_OLD))
+            continue;
+
+        if (flags & (KOS_PAGE_SCAN | KOS_PAGE_DIRTY))
+            TRY(mark_children_in_page(mark_ctx, page));
+        else if (page != heap->evac_pages[0] && page != heap->evac_pages[1])
+            KOS_atomic_write_relaxed_u32(page->flags, flags | KOS_PAGE_SKIP);
+    }
+
+cleanup:
+    return error;
+}
+
+#ifndef NDEBUG
+static void verify_old_pages(KOS_HEAP *heap)
+{
+    KOS_MARK_CONTEXT mark_ctx;
+    KOS_PAGE        *page = heap->used_pages.head;
+
+    init_mark_context(&mark_ctx, heap);
+    mark_ctx.mode = VERIFY_NO_YOUNG;
+
+    /* Detect missing write barriers */
+    for ( ; page; page = page->next) {
+        if (KOS_atomic_read_relaxed_u32(page->flags) & KOS_PAGE_SKIP) {
+            const int error = mark_children_in_page(&mark_ctx, page);
+
+            assert( ! error);
+            assert( ! mark_ctx.current);
+            (void)error;
+        }
+    }
+}
+#else
+#define verify_old_pages(heap) ((void)0)
+#endif
+
+static int mark_children_of_black_objects(KOS_MARK_CONTEXT *mark_ctx, KOS_PAGE *page)
+{
+    int             error = KOS_SUCCESS;
+    uint8_t        *ptr   = (uint8_t *)get_slots(page);
+    uint8_t *const  end   = ptr + (KOS_atomic_read_relaxed_u32(page->num_allocated) << KOS_OBJ_ALIGN_BITS);
+
+    while (ptr < end) {
+
+        KOS_OBJ_HEADER       *hdr    = (KOS_OBJ_HEADER *)ptr;
+        const uint32_t        size   = kos_get_object_size(*hdr);
+        const KOS_OBJ_ID      obj_id = (KOS_OBJ_ID)((intptr_t)hdr + 1);
+        struct KOS_MARK_LOC_S mark_loc;
+
+        assert(size > 0U);
+
+        mark_loc = get_mark_location(obj_id);
+
+        if (get_marking(&mark_loc) & BLACK)
+            TRY(mark_children_gray(mark_ctx, obj_id));
+
+        ptr += size;
+    }
+
+cleanup:
+    return error;
+}
+
+static int remark_pages(KOS_MARK_CONTEXT *mark_ctx, KOS_HEAP *heap)
+{
+    PROF_ZONE(GC)
+
+    int       error = KOS_SUCCESS;
+    KOS_PAGE *page  = heap->used_pages.head;
+
+    /* Objects modified after they were scanned by the marking thread reside
+     * in young pages, in old pages containing objects which are written to
+     * without write barriers or in old pages marked by write barriers. */
+    for ( ; page; page = page->next) {
+
+        const uint32_t flags = KOS_atomic_read_relaxed_u32(page->flags);
+
+        if ( ! (flags & KOS_PAGE_OLD) || (flags & (KOS_PAGE_SCAN | KOS_PAGE_DIRTY)))
+            TRY(mark_children_of_black_objects(mark_ctx, page));
+    }
+
+cleanup:
+    return error;
+}
+
+static void concurrent_marking_thread(void *cookie)
+{
+    KOS_HEAP *const  heap = (KOS_HEAP *)cookie;
+    KOS_MARK_CONTEXT mark_ctx;
+    int              error;
+
+    init_mark_context(&mark_ctx, heap);
+    mark_ctx.mode = MARK_CONCURRENT;
+
+    error = mark_scheduled_objects(&mark_ctx, KOS_NULL);
+
+    kos_lock_mutex(heap->mutex);
+
+    if (error)
+        heap->mark_error = error;
+
+    KOS_atomic_write_relaxed_u32(heap->concurrent_mark, CONCURRENT_DONE);
+
+    kos_broadcast_cond_var(heap->mark_cond);
+
+    kos_unlock_mutex(heap->mutex);
+}
+
+static unsigned get_slice_bucket(uint32_t time_us)
+{
+    static const uint32_t bucket_limits_us[KOS_GC_SLICE_BUCKETS - 1] = {
+        50U, 100U, 200U, 500U, 1000U, 2000U, 5000U
+    };
+
+    unsigned idx = 0;
+
+    while (idx < KOS_GC_SLICE_BUCKETS - 1 && time_us >= bucket_limits_us[idx])
+        ++idx;
+
+    return idx;
+}
+
+static void record_gc_slice(KOS_HEAP *heap, uint32_t time_us)
+{
+    ++heap->num_slices;
+
+    if (time_us > heap->max_slice_us)
+        heap->max_slice_us = time_us;
+
+    ++heap->slice_hist[get_slice_bucket(time_us)];
+
+    heap->gc_time_us += time_us;
+}
+
+static int mark_incrementally(KOS_CONTEXT ctx)
+{
+    PROF_ZONE(GC)
+
+    KOS_HEAP *const  heap   = get_heap(ctx);
+    const int64_t    time_0 = KOS_get_time_us();
+    KOS_MARK_CONTEXT mark_ctx;
+    KOS_MARK_BUDGET  budget;
+    int              error;
+
+    budget.end_time_us = heap->slice_us ? time_0 + (int64_t)heap->slice_us : 0;
+    budget.max_bytes   = heap->slice_bytes;
+    budget.num_bytes   = 0U;
+
+    /* Mutators are running during the slice, but other slices or GC cannot
+     * start, because they need the heap mutex held by the current thread */
+    init_mark_context(&mark_ctx, heap);
+    mark_ctx.mode = MARK_CONCURRENT;
+
+    error = mark_scheduled_objects(&mark_ctx, &budget);
+
+    if (error == KOS_SUCCESS_RETURN) {
+        if (mark_ctx.current) {
+            push_scheduled(heap, mark_ctx.current);
+            mark_ctx.current = KOS_NULL;
+        }
+    }
+    else {
+        if (error)
+            heap->mark_error = error;
+
+        KOS_atomic_write_relaxed_u32(heap->concurrent_mark, CONCURRENT_DONE);
+    }
+
+    record_gc_slice(heap, (uint32_t)(KOS_get_time_us() - time_0));
+
+    return KOS_SUCCESS;
+}
+
+static int begin_concurrent_marking(KOS_CONTEXT ctx)
+{
+    PROF_ZONE(GC)
+
+    KOS_HEAP *const  heap   = get_heap(ctx);
+    const int64_t    time_0 = KOS_get_time_us();
+    KOS_MARK_CONTEXT mark_ctx;
+    int              error;
+
+    assert(KOS_atomic_read_relaxed_u32(heap->concurrent_mark) == CONCURRENT_IDLE);
+    assert( ! heap->mark_thread);
+
+    /* Another thread has already started GC */
+    if (KOS_atomic_read_relaxed_u32(heap->gc_state) != GC_INACTIVE) {
+        help_gc(ctx);
+        return KOS_SUCCESS;
+    }
+
+    /* No garbage to collect, bail out early.  This can happen on init. */
+    if ( ! heap->used_pages.head && ! ctx->cur_page)
+        return KOS_SUCCESS;
+
+    KOS_atomic_write_release_u32(heap->gc_state, GC_INIT);
+
+    kos_set_global_event(ctx, KOS_EVENT_GC);
+
+    gc_trace(("GC ctx=%p begin concurrent marking\n", (void *)ctx));
+
+    KOS_atomic_write_relaxed_u32(ctx->gc_state, GC_ENGAGED);
+
+    release_current_page_locked(ctx);
+
+    /* Only mark roots while all threads are stopped, the rest of the marking
+     * is done by a background thread or in slices while the mutators are
+     * running. */
+    stop_the_world(ctx->inst); /* Remaining threads enter help_gc() */
+
+    assert( ! heap->gc_minor);
+
+    clear_marking(heap);
+
+    init_mark_context(&mark_ctx, heap);
+    error = mark_roots(ctx, &mark_ctx);
+
+    if (mark_ctx.current) {
+        push_scheduled(heap, mark_ctx.current);
+        mark_ctx.current = KOS_NULL;
+    }
+
+    KOS_atomic_write_relaxed_u32(heap->concurrent_mark, CONCURRENT_ACTIVE);
+
+    if (error)
+        heap->mark_error = error;
+
+    /* If the marking thread could not be started, remaining objects will be
+     * marked during remark.  Without the marking thread, remaining objects
+     * are marked incrementally in slices. */
+    if (error)
+        KOS_atomic_write_relaxed_u32(heap->concurrent_mark, CONCURRENT_DONE);
+    else if ((ctx->inst->flags & KOS_INST_CONCURRENT_GC) &&
+             kos_create_native_thread(&heap->mark_thread, concurrent_marking_thread, heap))
+        KOS_atomic_write_relaxed_u32(heap->concurrent_mark, CONCURRENT_DONE);
+
+    kos_clear_global_event(ctx, KOS_EVENT_GC);
+
+    KOS_atomic_write_relaxed_u32(ctx->gc_state,  GC_INACTIVE);
+    KOS_atomic_write_relaxed_u32(heap->gc_state, GC_INACTIVE);
+
+    release_helper_threads(heap);
+
+    record_gc_slice(heap, (uint32_t)(KOS_get_time_us() - time_0));
+
+    return KOS_SUCCESS;
+}
+
+static void abandon_concurrent_marking(KOS_HEAP *heap)
+{
+    KOS_MARK_CONTEXT mark_ctx;
+
+    if (KOS_atomic_read_relaxed_u32(heap->concurrent_mark) == CONCURRENT_IDLE)
+        return;
+
+    kos_lock_mutex(heap->mutex);
+
+    while (KOS_atomic_read_relaxed_u32(heap->concurrent_mark) == CONCURRENT_ACTIVE && heap->mark_thread)
+        kos_wait_cond_var(heap->mark_cond, heap->mutex);
+
+    kos_unlock_mutex(heap->mutex);
+
+    if (heap->mark_thread)
+        kos_join_native_thread(&heap->mark_thread);
+
+    init_mark_context(&mark_ctx, heap);
+    free_all_mark_groups(&mark_ctx);
+
+    KOS_atomic_write_relaxed_u32(heap->concurrent_mark, CONCURRENT_IDLE);
+}
+
+#ifdef CONFIG_MAD_GC
+static void lock_pages(KOS_HEAP *heap, KOS_PAGE *pages)
+{
+    while (pages) {
+
+        KOS_PAGE *page = pages;
+        uint32_t  i;
+
+        pages = page->next;
+
+        /* Only lock heap pages which are fully aligned with OS pages */
+        kos_mem_protect(page, KOS_PAGE_SIZE, KOS_NO_ACCESS);
+
+        if ( ! heap->locked_pages_last || heap->locked_pages_last->num_pages == KOS_MAX_LOCKED_PAGES) {
+
+            struct KOS_LOCKED_PAGES_S *locked_pages =
+                (struct KOS_LOCKED_PAGES_S *)KOS_malloc(sizeof(struct KOS_LOCKED_PAGES_S));
+
+            if ( ! locked_pages) {
+                fprintf(stderr, "Failed to allocate memory to store locked pages\n");
+                exit(1);
+            }
+
+            locked_pages->num_pages = 0;
+            locked_pages->next      = KOS_NULL;
+            if (heap->locked_pages_last)
+                heap->locked_pages_last->next = locked_pages;
+            heap->locked_pages_last = locked_pages;
+            if ( ! heap->locked_pages_first)
+                heap->locked_pages_first = locked_pages;
+        }
+
+        i = heap->locked_pages_last->num_pages++;
+
+        heap->locked_pages_last->pages[i] = page;
+    }
 }
 #endif
 
@@ -2027,49 +2754,212 @@ static unsigned unlock_pages(KOS_HEAP      *heap,
             ++num_unlocked;
         }
 
-        KOS_free(cur_locked_page_list);
+        KOS_free(cur_locked_page_list);
+    }
+
+    heap->locked_pages_first = KOS_NULL;
+    heap->locked_pages_last  = KOS_NULL;
+
+    return num_unlocked;
+}
+#else
+static unsigned unlock_pages(KOS_HEAP      *heap,
+                             KOS_PAGE_LIST *free_pages,
+                             KOS_GC_STATS  *stats)
+{
+    KOS_PAGE    **page_ptr     = &free_pages->head;
+    KOS_PAGE     *page         = *page_ptr;
+    KOS_PAGE     *prev         = KOS_NULL;
+    KOS_PAGE_LIST reclaimed    = { KOS_NULL, KOS_NULL };
+    unsigned      num_unlocked = 0U;
+
+    /* Find all free pages which had no evacuated objects and make them available */
+    while (page) {
+
+        if (KOS_atomic_read_relaxed_u32(page->num_allocated)) {
+            page_ptr = &page->next;
+            prev     = page;
+            page     = *page_ptr;
+        }
+        else {
+            KOS_PAGE *next = page->next;
+            *page_ptr      = next;
+            if ( ! next)
+                free_pages->tail = prev;
+            push_page_back(&reclaimed, page);
+            page = next;
+            ++num_unlocked;
+        }
+    }
+
+    reclaim_free_pages(heap, &reclaimed, stats);
+
+    return num_unlocked;
+}
+#endif
+
+static int is_scanned_object(KOS_OBJ_HEADER *hdr)
+{
+    switch (kos_get_object_type(*hdr)) {
+
+        case OBJ_INTEGER:
+            /* fall through */
+        case OBJ_FLOAT:
+            /* fall through */
+        case OBJ_STRING:
+            /* fall through */
+        case OBJ_OPAQUE:
+            /* fall through */
+        case OBJ_BUFFER_STORAGE:
+            /* fall through */
+        /* Writes to the following objects are tracked with kos_write_barrier() */
+        case OBJ_OBJECT:
+            /* fall through */
+        case OBJ_OBJECT_STORAGE:
+            /* fall through */
+        case OBJ_SHAPED_STORAGE:
+            /* fall through */
+        case OBJ_ARRAY:
+            /* fall through */
+        case OBJ_ARRAY_STORAGE:
+            return 0;
+
+        /* Decoded instructions in bytecode hold pointers to constants */
+        case OBJ_HUGE_TRACKER: {
+            const KOS_OBJ_ID object = ((KOS_HUGE_TRACKER *)hdr)->object;
+
+            return ! IS_BAD_PTR(object) &&
+                   (((KOS_HUGE_TRACKER *)hdr)->is_bytecode ||
+                    is_scanned_object((KOS_OBJ_HEADER *)((intptr_t)object - 1)));
+        }
+
+        default:
+            return 1;
+    }
+}
+
+static uint32_t get_old_page_flags(KOS_PAGE *page)
+{
+    uint8_t       *ptr = (uint8_t *)get_slots(page);
+    uint8_t *const end = ptr + (KOS_atomic_read_relaxed_u32(page->num_allocated) << KOS_OBJ_ALIGN_BITS);
+
+    while (ptr < end) {
+
+        KOS_OBJ_HEADER *hdr = (KOS_OBJ_HEADER *)ptr;
+
+        if (is_scanned_object(hdr))
+            return KOS_PAGE_OLD | KOS_PAGE_SCAN;
+
+        ptr += kos_get_object_size(*hdr);
+    }
+
+    return KOS_PAGE_OLD;
+}
+
+static void promote_pages(KOS_HEAP *heap)
+{
+    PROF_ZONE(GC)
+
+    KOS_PAGE *page = heap->used_pages.head;
+
+    /* After GC there are no more young objects */
+    for ( ; page; page = page->next) {
+
+        uint32_t flags = KOS_atomic_read_relaxed_u32(page->flags);
+
+        /* Dirty pages could have received new objects */
+        if ((flags & (KOS_PAGE_OLD | KOS_PAGE_DIRTY)) == KOS_PAGE_OLD)
+            flags &= KOS_PAGE_OLD | KOS_PAGE_SCAN;
+        else
+            flags = get_old_page_flags(page);
+
+        KOS_atomic_write_relaxed_u32(page->flags, flags);
+    }
+
+    heap->num_young_pages = 0;
+}
+
+static void *alloc_old_object(KOS_HEAP *heap,
+                              KOS_TYPE  object_type,
+                              uint32_t  size,
+                              int       scan)
+{
+    KOS_PAGE       *page      = heap->evac_pages[scan];
+    const uint32_t  num_slots = (size + sizeof(KOS_SLOT) - 1) >> KOS_OBJ_ALIGN_BITS;
+    KOS_OBJ_HEADER *hdr       = KOS_NULL;
+
+    if (page)
+        hdr = alloc_object_from_page(page, object_type, num_slots);
+
+    if ( ! hdr) {
+
+        kos_lock_mutex(heap->mutex);
+
+        page = alloc_page(heap);
+
+        if (page) {
+            KOS_atomic_write_relaxed_u32(page->flags,
+                                         KOS_PAGE_OLD | (scan ? KOS_PAGE_SCAN : 0U));
+
+            push_page_with_objects(heap, page);
+
+            heap->evac_pages[scan] = page;
+
+            hdr = alloc_object_from_page(page, object_type, num_slots);
+
+            assert(hdr);
+        }
+
+        kos_unlock_mutex(heap->mutex);
     }
 
-    heap->locked_pages_first = KOS_NULL;
-    heap->locked_pages_last  = KOS_NULL;
-
-    return num_unlocked;
-}
-#else
-static unsigned unlock_pages(KOS_HEAP      *heap,
-                             KOS_PAGE_LIST *free_pages,
-                             KOS_GC_STATS  *stats)
-{
-    KOS_PAGE    **page_ptr     = &free_pages->head;
-    KOS_PAGE     *page         = *page_ptr;
-    KOS_PAGE     *prev         = KOS_NULL;
-    KOS_PAGE_LIST reclaimed    = { KOS_NULL, KOS_NULL };
-    unsigned      num_unlocked = 0U;
+    /* If the heap is exhausted, use remaining space in any other page */
+    if ( ! hdr) {
 
-    /* Find all free pages which had no evacuated objects and make them available */
-    while (page) {
+        uint32_t flags;
 
-        if (KOS_atomic_read_relaxed_u32(page->num_allocated)) {
-            page_ptr = &page->next;
-            prev     = page;
-            page     = *page_ptr;
-        }
-        else {
-            KOS_PAGE *next = page->next;
-            *page_ptr      = next;
-            if ( ! next)
-                free_pages->tail = prev;
-            push_page_back(&reclaimed, page);
-            page = next;
-            ++num_unlocked;
+        for (page = heap->used_pages.head; page; page = page->next) {
+            hdr = alloc_object_from_page(page, object_type, num_slots);
+            if (hdr)
+                break;
         }
+
+        if ( ! hdr)
+            return KOS_NULL;
+
+        /* Pointers in the evacuated object must be updated */
+        flags = KOS_atomic_read_relaxed_u32(page->flags) & ~(uint32_t)KOS_PAGE_SKIP;
+
+        if (scan && (flags & KOS_PAGE_OLD))
+            flags |= KOS_PAGE_SCAN;
+
+        KOS_atomic_write_relaxed_u32(page->flags, flags);
     }
 
-    reclaim_free_pages(heap, &reclaimed, stats);
+    heap->used_heap_size += num_slots << KOS_OBJ_ALIGN_BITS;
 
-    return num_unlocked;
+    return hdr;
 }
+
+static void move_object(KOS_OBJ_HEADER *hdr,
+                        KOS_OBJ_HEADER *new_obj,
+                        uint32_t        size)
+{
+    memcpy(new_obj, hdr, size);
+
+    hdr->size_and_type = (KOS_OBJ_ID)((intptr_t)new_obj + 1);
+
+#ifdef CONFIG_PERF
+    if (size <= 32)
+        KOS_PERF_CNT(evac_object_size[0]);
+    else if (size <= 128)
+        KOS_PERF_CNT(evac_object_size[1]);
+    else if (size <= 256)
+        KOS_PERF_CNT(evac_object_size[2]);
+    else
+        KOS_PERF_CNT(evac_object_size[3]);
 #endif
+}
 
 static int evacuate_object(KOS_CONTEXT     ctx,
                            KOS_OBJ_HEADER *hdr,
@@ -2079,24 +2969,11 @@ static int evacuate_object(KOS_CONTEXT     ctx,
     const KOS_TYPE  type  = kos_get_object_type(*hdr);
     KOS_OBJ_HEADER *new_obj;
 
-    new_obj = (KOS_OBJ_HEADER *)alloc_object(ctx, type, size);
-
-    if (new_obj) {
-        memcpy(new_obj, hdr, size);
+    new_obj = (KOS_OBJ_HEADER *)alloc_old_object(get_heap(ctx), type, size,
+                                                 is_scanned_object(hdr));
 
-        hdr->size_and_type = (KOS_OBJ_ID)((intptr_t)new_obj + 1);
-
-#ifdef CONFIG_PERF
-        if (size <= 32)
-            KOS_PERF_CNT(evac_object_size[0]);
-        else if (size <= 128)
-            KOS_PERF_CNT(evac_object_size[1]);
-        else if (size <= 256)
-            KOS_PERF_CNT(evac_object_size[2]);
-        else
-            KOS_PERF_CNT(evac_object_size[3]);
-#endif
-    }
+    if (new_obj)
+        move_object(hdr, new_obj, size);
     else
         error = KOS_ERROR_OUT_OF_MEMORY;
 
@@ -2217,6 +3094,17 @@ static void update_child_ptrs(KOS_OBJ_HEADER *hdr)
                 *back_ref_ptr = OBJID(HUGE_TRACKER, tracker);
 
                 update_child_ptrs((KOS_OBJ_HEADER *)((intptr_t)object - 1));
+
+                /* Constants are also referenced by the module, so they don't need
+                 * to be marked, but the pointers must follow evacuated objects */
+                if (tracker->is_bytecode) {
+                    KOS_BYTECODE *const bytecode = (KOS_BYTECODE *)OBJPTR(OPAQUE, object);
+                    KOS_INSTR          *instr    = KOS_DECODED_INSTRS(bytecode);
+                    KOS_INSTR *const    end      = instr + bytecode->num_decoded;
+
+                    for ( ; instr < end; ++instr)
+                        update_child_ptr(&instr->constant);
+                }
             }
             break;
         }
@@ -2241,6 +3129,27 @@ static void update_child_ptrs(KOS_OBJ_HEADER *hdr)
             }
             break;
 
+        case OBJ_SHAPED_STORAGE:
+            update_child_ptr((KOS_OBJ_ID *)&((KOS_SHAPED_STORAGE *)hdr)->shape);
+            update_child_ptr((KOS_OBJ_ID *)&((KOS_SHAPED_STORAGE *)hdr)->new_prop_table);
+            {
+                KOS_ATOMIC(KOS_OBJ_ID) *item = &((KOS_SHAPED_STORAGE *)hdr)->values[0];
+                KOS_ATOMIC(KOS_OBJ_ID) *end  = item + ((KOS_SHAPED_STORAGE *)hdr)->capacity;
+                for ( ; item < end; ++item)
+                    update_child_ptr((KOS_OBJ_ID *)item);
+            }
+            break;
+
+        case OBJ_SHAPE:
+            update_child_ptr((KOS_OBJ_ID *)&((KOS_SHAPE *)hdr)->transitions);
+            {
+                KOS_OBJ_ID *item = &((KOS_SHAPE *)hdr)->keys[0];
+                KOS_OBJ_ID *end  = item + ((KOS_SHAPE *)hdr)->num_props;
+                for ( ; item < end; ++item)
+                    update_child_ptr(item);
+            }
+            break;
+
         case OBJ_ARRAY_STORAGE:
             update_child_ptr((KOS_OBJ_ID *)&((KOS_ARRAY_STORAGE *)hdr)->next);
             {
@@ -2297,6 +3206,7 @@ static void update_child_ptrs(KOS_OBJ_HEADER *hdr)
             update_child_ptr(&((KOS_MODULE *)hdr)->constants);
             update_child_ptr(&((KOS_MODULE *)hdr)->global_names);
             update_child_ptr(&((KOS_MODULE *)hdr)->globals);
+            update_child_ptr(&((KOS_MODULE *)hdr)->const_globals);
             update_child_ptr(&((KOS_MODULE *)hdr)->module_names);
             update_child_ptr((KOS_OBJ_ID *)&((KOS_MODULE *)hdr)->priv);
             break;
@@ -2385,8 +3295,13 @@ static void update_pages_after_evacuation(KOS_HEAP               *heap,
 
         begin_walk(heap, helper);
 
-        for (page = get_next_page(heap); page; page = get_next_page(heap))
-            update_page_after_evacuation(page, 0);
+        for (page = get_next_page(heap); page; page = get_next_page(heap)) {
+
+            /* Old pages which were not scanned during minor GC don't
+             * contain pointers to any evacuated objects. */
+            if ( ! (KOS_atomic_read_relaxed_u32(page->flags) & KOS_PAGE_SKIP))
+                update_page_after_evacuation(page, 0);
+        }
 
         end_walk(heap, helper);
     }
@@ -2435,6 +3350,9 @@ static void update_after_evacuation(KOS_CONTEXT ctx)
 
     update_pages_after_evacuation(heap, WALK_MAIN_THREAD);
 
+    /* Property caches hold raw pointers to prototypes */
+    kos_invalidate_prop_caches(inst);
+
     /* Update object pointers in instance */
 
     kos_lock_mutex(inst->threads.ctx_mutex);
@@ -2455,6 +3373,8 @@ static void update_after_evacuation(KOS_CONTEXT ctx)
     update_child_ptr(&inst->prototypes.thread_proto);
     update_child_ptr(&inst->prototypes.module_proto);
 
+    update_child_ptr(&inst->shapes.root);
+
     update_child_ptr(&inst->modules.init_module);
     update_child_ptr(&inst->modules.search_paths);
     update_child_ptr(&inst->modules.module_names);
@@ -2485,111 +3405,452 @@ static void update_after_evacuation(KOS_CONTEXT ctx)
         for (local = (KOS_LOCAL *)ctx->ulocal_list; local; local = local->next)
             update_child_ptr(&local->o);
 
-        ctx = ctx->next;
+        ctx = ctx->next;
+    }
+
+    kos_unlock_mutex(inst->threads.ctx_mutex);
+}
+
+static uint32_t get_num_slots_used(KOS_PAGE *page, uint32_t num_allocated)
+{
+    uint32_t              color;
+    uint32_t              num_used = 0;
+    KOS_SLOT             *ptr      = get_slots(page);
+    KOS_SLOT       *const end      = ptr + num_allocated;
+    struct KOS_MARK_LOC_S mark_loc = { KOS_NULL, 0 };
+
+    mark_loc.bitmap = get_bitmap(page);
+
+    assert(num_allocated == KOS_atomic_read_relaxed_u32(page->num_allocated));
+
+    color = skip_white(&ptr, end, &mark_loc);
+
+    while (color) {
+
+        KOS_OBJ_HEADER *const hdr   = (KOS_OBJ_HEADER *)ptr;
+        const uint32_t        size  = kos_get_object_size(*hdr);
+        const uint32_t        slots = size >> KOS_OBJ_ALIGN_BITS;
+
+        assert(color & BLACK);
+        assert((uint8_t *)ptr + size <= (uint8_t *)end);
+
+        num_used += slots;
+
+        advance_marking(&mark_loc, slots);
+
+        ptr = (KOS_SLOT *)((uint8_t *)ptr + size);
+
+        color = skip_white(&ptr, end, &mark_loc);
+    }
+
+    return num_used;
+}
+
+/* If the number of slots used reaches the threshold, then the page is
+ * exempt from evacuation. */
+#define UNUSED_SLOTS ((KOS_SLOTS_PER_PAGE * (100U - KOS_MIGRATION_THRESH)) / 100U)
+
+static int is_page_retained(uint32_t page_flags,
+                            uint32_t num_allocated,
+                            uint32_t num_slots_used)
+{
+#ifdef CONFIG_MAD_GC
+    (void)num_allocated;
+    (void)num_slots_used;
+
+    return (page_flags & KOS_PAGE_EVACUATED) ? 1 : 0;
+#else
+    (void)page_flags;
+
+    return num_allocated - num_slots_used < UNUSED_SLOTS;
+#endif
+}
+
+static void retain_page(KOS_CONTEXT   ctx,
+                        KOS_PAGE     *page,
+                        uint32_t      page_flags,
+                        uint32_t      num_allocated,
+                        uint32_t      num_slots_used,
+                        KOS_GC_STATS *stats)
+{
+    gc_trace(("GC ctx=%p -- retain page %p\n", (void *)ctx, (void *)page));
+
+    /* Mark unused objects as opaque so they don't participate in
+     * pointer update after evacuation. */
+    if (num_slots_used < num_allocated)
+        mark_unused_objects_opaque(ctx, page, stats);
+
+    if ( ! (page_flags & KOS_PAGE_EVACUATED)) {
+        ++stats->num_pages_kept;
+        stats->size_kept += num_slots_used << KOS_OBJ_ALIGN_BITS;
+        KOS_atomic_write_relaxed_u32(page->flags, page_flags | KOS_PAGE_EVACUATED);
+    }
+}
+
+static void drop_page(KOS_CONTEXT   ctx,
+                      KOS_PAGE     *page,
+                      KOS_GC_STATS *stats)
+{
+    gc_trace(("GC ctx=%p -- drop page %p\n", (void *)ctx, (void *)page));
+
+    ++stats->num_pages_dropped;
+
+    KOS_atomic_write_relaxed_u32(page->num_allocated, 0);
+
+    debug_fill_slots(page);
+}
+
+/* Shared state of evacuation performed by multiple threads */
+struct KOS_EVACUATION_S {
+    KOS_CONTEXT    ctx;        /* Context of the thread running GC, used for finalizers */
+    KOS_PAGE_LIST *free_pages; /* Pages from which all objects have been evacuated     */
+    KOS_GC_STATS  *stats;      /* Stats accumulated by all threads                     */
+    KOS_PAGE_LIST  deferred;   /* Pages left for the main thread when low on memory    */
+};
+
+/* State of a single thread taking part in evacuation */
+struct KOS_EVAC_CONTEXT_S {
+    KOS_PAGE     *evac_pages[2];  /* Pages receiving evacuated objects                */
+    KOS_PAGE     *spare_pages[2]; /* Free pages reserved for receiving objects        */
+    KOS_PAGE_LIST used_pages;     /* Retained pages and pages which received objects  */
+    KOS_PAGE_LIST free_pages;     /* Pages from which all objects have been evacuated */
+    KOS_PAGE_LIST deferred;       /* Pages not evacuated due to lack of free pages    */
+    KOS_GC_STATS  stats;
+    uint32_t      size_removed;   /* Used size of evacuated pages                     */
+    uint32_t      size_added;     /* Used size of pages which received objects        */
+};
+
+typedef struct KOS_EVAC_CONTEXT_S KOS_EVAC_CONTEXT;
+
+static void init_evac_context(KOS_EVAC_CONTEXT *evac_ctx)
+{
+    static const KOS_GC_STATS init_stats = KOS_GC_STATS_INIT(0U);
+
+    evac_ctx->evac_pages[0]   = KOS_NULL;
+    evac_ctx->evac_pages[1]   = KOS_NULL;
+    evac_ctx->spare_pages[0]  = KOS_NULL;
+    evac_ctx->spare_pages[1]  = KOS_NULL;
+    evac_ctx->used_pages.head = KOS_NULL;
+    evac_ctx->used_pages.tail = KOS_NULL;
+    evac_ctx->free_pages.head = KOS_NULL;
+    evac_ctx->free_pages.tail = KOS_NULL;
+    evac_ctx->deferred.head   = KOS_NULL;
+    evac_ctx->deferred.tail   = KOS_NULL;
+    evac_ctx->stats           = init_stats;
+    evac_ctx->size_removed    = 0U;
+    evac_ctx->size_added      = 0U;
+}
+
+/* Objects from one page always fit in one empty page, so evacuating a page
+ * takes at most one new page for each kind of object (scanned or not).
+ * Free pages are reserved upfront, so that evacuation of a page is never
+ * interrupted in the middle. */
+static int reserve_spare_pages(KOS_HEAP         *heap,
+                               KOS_EVAC_CONTEXT *evac_ctx,
+                               uint32_t          num_slots)
+{
+    int      error      = KOS_SUCCESS;
+    unsigned num_needed = 0U;
+    unsigned num_spare  = 0U;
+    unsigned i;
+
+    for (i = 0; i < 2; i++) {
+
+        KOS_PAGE *const page = evac_ctx->evac_pages[i];
+
+        if ( ! page || (KOS_SLOTS_PER_PAGE - KOS_atomic_read_relaxed_u32(page->num_allocated) < num_slots))
+            ++num_needed;
+
+        if (evac_ctx->spare_pages[i])
+            ++num_spare;
+    }
+
+    if (num_spare >= num_needed)
+        return KOS_SUCCESS;
+
+    kos_lock_mutex(heap->mutex);
+
+    for (i = 0; (i < 2) && (num_spare < num_needed); i++) {
+
+        if ( ! evac_ctx->spare_pages[i]) {
+
+            KOS_PAGE *const page = alloc_page(heap);
+
+            if ( ! page) {
+                error = KOS_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+
+            evac_ctx->spare_pages[i] = page;
+            ++num_spare;
+        }
+    }
+
+    kos_unlock_mutex(heap->mutex);
+
+    return error;
+}
+
+static KOS_OBJ_HEADER *alloc_evacuated_object(KOS_EVAC_CONTEXT *evac_ctx,
+                                              KOS_TYPE          object_type,
+                                              uint32_t          size,
+                                              int               scan)
+{
+    KOS_PAGE       *page      = evac_ctx->evac_pages[scan];
+    const uint32_t  num_slots = (size + sizeof(KOS_SLOT) - 1) >> KOS_OBJ_ALIGN_BITS;
+    KOS_OBJ_HEADER *hdr       = KOS_NULL;
+
+    if (page)
+        hdr = alloc_object_from_page(page, object_type, num_slots);
+
+    if ( ! hdr) {
+
+        const int idx = evac_ctx->spare_pages[0] ? 0 : 1;
+
+        page = evac_ctx->spare_pages[idx];
+        evac_ctx->spare_pages[idx] = KOS_NULL;
+
+        assert(page);
+
+        KOS_atomic_write_relaxed_u32(page->flags,
+                                     KOS_PAGE_OLD | (scan ? KOS_PAGE_SCAN : 0U));
+
+        push_page(&evac_ctx->used_pages, page);
+        evac_ctx->size_added += used_page_size(page);
+
+        evac_ctx->evac_pages[scan] = page;
+
+        hdr = alloc_object_from_page(page, object_type, num_slots);
+
+        assert(hdr);
+    }
+
+    evac_ctx->size_added += num_slots << KOS_OBJ_ALIGN_BITS;
+
+    return hdr;
+}
+
+/* Evacuates objects from a single page on any thread.  Returns
+ * KOS_ERROR_OUT_OF_MEMORY without touching the page if there were not
+ * enough free pages to receive the objects, the page is then deferred. */
+static int evacuate_page(KOS_CONTEXT       ctx,
+                         KOS_HEAP         *heap,
+                         KOS_EVAC_CONTEXT *evac_ctx,
+                         KOS_PAGE         *page)
+{
+    struct KOS_MARK_LOC_S mark_loc = { KOS_NULL, 0 };
+
+    unsigned       num_evac      = 0;
+    const uint32_t num_allocated = KOS_atomic_read_relaxed_u32(page->num_allocated);
+    const uint32_t page_flags    = KOS_atomic_read_relaxed_u32(page->flags);
+    uint32_t       num_slots_used;
+    KOS_SLOT      *ptr           = get_slots(page);
+    KOS_SLOT      *end           = ptr + num_allocated;
+
+    num_slots_used = (page_flags & KOS_PAGE_EVACUATED) ? num_allocated :
+                     get_num_slots_used(page, num_allocated);
+
+    if (is_page_retained(page_flags, num_allocated, num_slots_used)) {
+
+        retain_page(ctx, page, page_flags, num_allocated, num_slots_used, &evac_ctx->stats);
+
+        push_page(&evac_ctx->used_pages, page);
+        return KOS_SUCCESS;
+    }
+
+    if (num_slots_used && reserve_spare_pages(heap, evac_ctx, num_slots_used)) {
+        push_page_back(&evac_ctx->deferred, page);
+        return KOS_ERROR_OUT_OF_MEMORY;
+    }
+
+    gc_trace(("GC ctx=%p -- evac page %p\n", (void *)ctx, (void *)page));
+
+    evac_ctx->size_removed += used_page_size(page);
+
+    mark_loc.bitmap = get_bitmap(page);
+
+    while (ptr < end) {
+
+        KOS_OBJ_HEADER *hdr   = (KOS_OBJ_HEADER *)ptr;
+        const uint32_t  size  = kos_get_object_size(*hdr);
+        const uint32_t  color = get_marking(&mark_loc);
+
+        assert(size > 0U);
+        assert(color != GRAY);
+        assert(size <= (size_t)((uint8_t *)end - (uint8_t *)ptr));
+
+        if (color) {
+            KOS_OBJ_HEADER *const new_obj = alloc_evacuated_object(evac_ctx,
+                                                                   kos_get_object_type(*hdr),
+                                                                   size,
+                                                                   is_scanned_object(hdr));
+
+            move_object(hdr, new_obj, size);
+
+            ++num_evac;
+            evac_ctx->stats.size_evacuated += size;
+        }
+        else {
+            finalize_object(ctx, hdr, &evac_ctx->stats);
+
+            ++evac_ctx->stats.num_objs_freed;
+            evac_ctx->stats.size_freed += size;
+        }
+
+        advance_marking(&mark_loc, size >> KOS_OBJ_ALIGN_BITS);
+
+        ptr = (KOS_SLOT *)((uint8_t *)ptr + size);
+    }
+
+    evac_ctx->stats.num_objs_evacuated += num_evac;
+
+    /* Mark page which has no evacuated objects, such page can be re-used
+     * early before the end of evacuation when the heap is full. */
+    if ( ! num_evac)
+        drop_page(ctx, page, &evac_ctx->stats);
+
+    push_page_back(&evac_ctx->free_pages, page);
+
+    return KOS_SUCCESS;
+}
+
+static void append_pages(KOS_PAGE_LIST *list, KOS_PAGE_LIST *pages)
+{
+    if ( ! pages->head)
+        return;
+
+    if (list->tail)
+        list->tail->next = pages->head;
+    else {
+        assert( ! list->head);
+        list->head = pages->head;
+    }
+
+    list->tail = pages->tail;
+}
+
+static void add_evacuation_stats(KOS_GC_STATS       *stats,
+                                 const KOS_GC_STATS *thread_stats)
+{
+    stats->num_objs_evacuated += thread_stats->num_objs_evacuated;
+    stats->num_objs_freed     += thread_stats->num_objs_freed;
+    stats->num_objs_finalized += thread_stats->num_objs_finalized;
+    stats->num_pages_kept     += thread_stats->num_pages_kept;
+    stats->num_pages_dropped  += thread_stats->num_pages_dropped;
+    stats->size_evacuated     += thread_stats->size_evacuated;
+    stats->size_freed         += thread_stats->size_freed;
+    stats->size_kept          += thread_stats->size_kept;
+}
+
+/* Called with heap mutex held after the thread finished evacuating pages */
+static void merge_evac_context(KOS_HEAP         *heap,
+                               KOS_EVAC_CONTEXT *evac_ctx)
+{
+    KOS_EVACUATION *const evacuation = heap->evacuation;
+    KOS_PAGE             *page;
+    KOS_PAGE             *next;
+    unsigned              i;
+
+    /* Return reserved pages which have not been used */
+    for (i = 0; i < 2; i++) {
+
+        page = evac_ctx->spare_pages[i];
+
+        if (page) {
+            page->next       = heap->free_pages;
+            heap->free_pages = page;
+        }
+    }
+
+    for (page = evac_ctx->used_pages.head; page; page = next) {
+        next = page->next;
+        push_page(&heap->used_pages, page);
     }
 
-    kos_unlock_mutex(inst->threads.ctx_mutex);
-}
+    heap->used_heap_size += evac_ctx->size_added;
+    heap->used_heap_size -= evac_ctx->size_removed;
 
-static uint32_t get_num_slots_used(KOS_PAGE *page, uint32_t num_allocated)
-{
-    uint32_t              color;
-    uint32_t              num_used = 0;
-    KOS_SLOT             *ptr      = get_slots(page);
-    KOS_SLOT       *const end      = ptr + num_allocated;
-    struct KOS_MARK_LOC_S mark_loc = { KOS_NULL, 0 };
+    append_pages(evacuation->free_pages, &evac_ctx->free_pages);
+    append_pages(&evacuation->deferred, &evac_ctx->deferred);
 
-    mark_loc.bitmap = get_bitmap(page);
+    add_evacuation_stats(evacuation->stats, &evac_ctx->stats);
+}
 
-    assert(num_allocated == KOS_atomic_read_relaxed_u32(page->num_allocated));
+static void evacuate_pages(KOS_HEAP               *heap,
+                           enum WALK_THREAD_TYPE_E helper)
+{
+    PROF_ZONE(GC)
 
-    color = skip_white(&ptr, end, &mark_loc);
+    const KOS_CONTEXT ctx = heap->evacuation->ctx;
+    KOS_EVAC_CONTEXT  evac_ctx;
+    KOS_PAGE         *page;
 
-    while (color) {
+    init_evac_context(&evac_ctx);
 
-        KOS_OBJ_HEADER *const hdr   = (KOS_OBJ_HEADER *)ptr;
-        const uint32_t        size  = kos_get_object_size(*hdr);
-        const uint32_t        slots = size >> KOS_OBJ_ALIGN_BITS;
+    /* Survivors of minor GC are added to the last pages which received
+     * evacuated objects. */
+    if ( ! helper) {
+        evac_ctx.evac_pages[0] = heap->evac_pages[0];
+        evac_ctx.evac_pages[1] = heap->evac_pages[1];
+    }
 
-        assert(color & BLACK);
-        assert((uint8_t *)ptr + size <= (uint8_t *)end);
+    begin_walk(heap, helper);
 
-        num_used += slots;
+    /* When there are no more free pages, the remaining pages are left for
+     * the main thread, which can recover from running out of memory. */
+    for (page = get_next_page(heap); page; page = get_next_page(heap)) {
+        if (evacuate_page(ctx, heap, &evac_ctx, page))
+            break;
+    }
 
-        advance_marking(&mark_loc, slots);
+    end_walk(heap, helper);
 
-        ptr = (KOS_SLOT *)((uint8_t *)ptr + size);
+    merge_evac_context(heap, &evac_ctx);
 
-        color = skip_white(&ptr, end, &mark_loc);
+    if ( ! helper) {
+        heap->evac_pages[0] = evac_ctx.evac_pages[0];
+        heap->evac_pages[1] = evac_ctx.evac_pages[1];
     }
-
-    return num_used;
 }
 
-#define PAGE_ALREADY_EVACED 1U
-
-static int evacuate(KOS_CONTEXT              ctx,
-                    KOS_PAGE_LIST           *free_pages,
-                    KOS_GC_STATS            *out_stats,
-                    struct KOS_INCOMPLETE_S *incomplete)
+static int evacuate_remaining_pages(KOS_CONTEXT              ctx,
+                                    KOS_PAGE                *page,
+                                    KOS_PAGE_LIST           *free_pages,
+                                    KOS_GC_STATS            *out_stats,
+                                    struct KOS_INCOMPLETE_S *incomplete)
 {
     PROF_ZONE(GC)
 
     KOS_HEAP    *heap  = get_heap(ctx);
     int          error = KOS_SUCCESS;
-    KOS_PAGE    *page  = heap->used_pages.head;
     KOS_PAGE    *next;
     KOS_GC_STATS stats = *out_stats;
 
-    assert( ! KOS_is_exception_pending(ctx));
-
-    heap->used_pages.head = KOS_NULL;
-    heap->used_pages.tail = KOS_NULL;
-
     for ( ; page; page = next) {
 
         struct KOS_MARK_LOC_S mark_loc = { KOS_NULL, 0 };
 
-        unsigned       num_evac       = 0;
-        const uint32_t num_allocated  = KOS_atomic_read_relaxed_u32(page->num_allocated);
-        const uint32_t page_flags     = KOS_atomic_read_relaxed_u32(page->flags);
-        const uint32_t num_slots_used = (page_flags == PAGE_ALREADY_EVACED) ? num_allocated :
-                                        get_num_slots_used(page, num_allocated);
-        KOS_SLOT      *ptr            = get_slots(page);
-        KOS_SLOT      *end            = ptr + num_allocated;
+        unsigned       num_evac      = 0;
+        const uint32_t num_allocated = KOS_atomic_read_relaxed_u32(page->num_allocated);
+        const uint32_t page_flags    = KOS_atomic_read_relaxed_u32(page->flags);
+        uint32_t       num_slots_used;
+        KOS_SLOT      *ptr           = get_slots(page);
+        KOS_SLOT      *end           = ptr + num_allocated;
 
         heap->used_heap_size -= used_page_size(page);
 
         next = page->next;
 
-        mark_loc.bitmap = get_bitmap(page);
-
-        /* If the number of slots used reaches the threshold, then the page is
-         * exempt from evacuation. */
-        #define UNUSED_SLOTS ((KOS_SLOTS_PER_PAGE * (100U - KOS_MIGRATION_THRESH)) / 100U)
+        num_slots_used = (page_flags & KOS_PAGE_EVACUATED) ? num_allocated :
+                         get_num_slots_used(page, num_allocated);
 
-        if (
-#ifdef CONFIG_MAD_GC
-            page_flags == PAGE_ALREADY_EVACED
-#else
-            num_allocated - num_slots_used < UNUSED_SLOTS
-#endif
-            ) {
+        mark_loc.bitmap = get_bitmap(page);
 
-            gc_trace(("GC ctx=%p -- retain page %p\n", (void *)ctx, (void *)page));
+        if (is_page_retained(page_flags, num_allocated, num_slots_used)) {
 
-            /* Mark unused objects as opaque so they don't participate in
-             * pointer update after evacuation. */
-            if (num_slots_used < num_allocated)
-                mark_unused_objects_opaque(ctx, page, &stats);
+            retain_page(ctx, page, page_flags, num_allocated, num_slots_used, &stats);
 
             push_page_with_objects(heap, page);
-
-            if (num_slots_used != PAGE_ALREADY_EVACED) {
-                ++stats.num_pages_kept;
-                stats.size_kept += num_slots_used << KOS_OBJ_ALIGN_BITS;
-                KOS_atomic_write_relaxed_u32(page->flags, PAGE_ALREADY_EVACED);
-            }
             continue;
         }
 
@@ -2616,8 +3877,6 @@ static int evacuate(KOS_CONTEXT              ctx,
                      * Try to release any pages which had no objects evacuated
                      * and put them in the free pool. */
 
-                    release_current_page_locked(ctx);
-
                     if (unlock_pages(heap, free_pages, &stats)) {
                         error = evacuate_object(ctx, hdr, size);
 
@@ -2630,7 +3889,7 @@ static int evacuate(KOS_CONTEXT              ctx,
 
                         assert( ! ctx->cur_page);
 
-                        set_marking_in_pages(heap->used_pages.head, BLACK, PAGE_ALREADY_EVACED);
+                        set_marking_in_pages(heap->used_pages.head, BLACK, KOS_PAGE_EVACUATED);
 
                         mark_unused_objects_opaque(ctx, page, &stats);
 
@@ -2675,15 +3934,8 @@ static int evacuate(KOS_CONTEXT              ctx,
 
         /* Mark page which has no evacuated objects, such page can be re-used
          * early before the end of evacuation when the heap is full. */
-        if ( ! num_evac) {
-            gc_trace(("GC ctx=%p -- drop page %p\n", (void *)ctx, (void *)page));
-
-            ++stats.num_pages_dropped;
-
-            KOS_atomic_write_relaxed_u32(page->num_allocated, 0);
-
-            debug_fill_slots(page);
-        }
+        if ( ! num_evac)
+            drop_page(ctx, page, &stats);
 
         push_page_back(free_pages, page);
     }
@@ -2691,17 +3943,145 @@ static int evacuate(KOS_CONTEXT              ctx,
 cleanup:
     *out_stats = stats;
 
-    release_current_page_locked(ctx);
+    assert( ! ctx->cur_page);
 
     return error;
 }
 
-static void update_gc_threshold(KOS_HEAP *heap)
+static int evacuate(KOS_CONTEXT              ctx,
+                    KOS_PAGE_LIST           *free_pages,
+                    KOS_GC_STATS            *out_stats,
+                    struct KOS_INCOMPLETE_S *incomplete)
 {
-    if (heap->used_heap_size >= heap->gc_threshold)
-        heap->gc_threshold = heap->max_heap_size;
+    PROF_ZONE(GC)
+
+    KOS_HEAP      *heap  = get_heap(ctx);
+    KOS_PAGE      *page  = heap->used_pages.head;
+    KOS_PAGE      *next;
+    KOS_PAGE_LIST  pages = { KOS_NULL, KOS_NULL };
+    KOS_EVACUATION evacuation;
+
+    assert( ! KOS_is_exception_pending(ctx));
+
+    kos_lock_mutex(heap->mutex);
+
+    heap->used_pages.head = KOS_NULL;
+    heap->used_pages.tail = KOS_NULL;
+
+    /* Old pages are not evacuated during minor GC */
+    for ( ; page; page = next) {
+
+        next = page->next;
+
+        if (heap->gc_minor && (KOS_atomic_read_relaxed_u32(page->flags) & KOS_PAGE_OLD))
+            push_page(&heap->used_pages, page);
+        else
+            push_page_back(&pages, page);
+    }
+
+    evacuation.ctx           = ctx;
+    evacuation.free_pages    = free_pages;
+    evacuation.stats         = out_stats;
+    evacuation.deferred.head = KOS_NULL;
+    evacuation.deferred.tail = KOS_NULL;
+
+    heap->evacuation = &evacuation;
+
+    assert(heap->walk_threads == 0);
+    assert(KOS_atomic_read_relaxed_ptr(heap->walk_pages) == 0);
+
+    KOS_atomic_write_relaxed_ptr(heap->walk_pages, pages.head);
+
+    evacuate_pages(heap, WALK_MAIN_THREAD);
+
+    heap->evacuation = KOS_NULL;
+
+    /* Pages which could not be evacuated in parallel, because the heap ran
+     * out of free pages, are evacuated by the main thread, which can
+     * recover from this situation. */
+    pages = evacuation.deferred;
+    page  = (KOS_PAGE *)KOS_atomic_read_relaxed_ptr(heap->walk_pages);
+
+    KOS_atomic_write_relaxed_ptr(heap->walk_pages, (KOS_PAGE *)KOS_NULL);
+
+    if (pages.tail)
+        pages.tail->next = page;
     else
-        heap->gc_threshold = heap->max_heap_size * KOS_GC_THRESHOLD / 100U;
+        pages.head = page;
+
+    kos_unlock_mutex(heap->mutex);
+
+    if ( ! pages.head)
+        return KOS_SUCCESS;
+
+    return evacuate_remaining_pages(ctx, pages.head, free_pages, out_stats, incomplete);
+}
+
+/* Adjusts the GC threshold, i.e. the amount of memory which can be used by
+ * objects before the next major GC cycle, so that the fraction of time spent
+ * in GC pauses approaches the target.  The decision is made after each major
+ * GC cycle, based on all pauses since the previous decision, including minor
+ * GC cycles and incremental marking slices. */
+static void update_gc_threshold(KOS_HEAP     *heap,
+                                int           minor,
+                                KOS_GC_STATS *stats)
+{
+    const uint64_t now       = KOS_get_time_us();
+    const uint64_t total_us  = now - heap->sizing_time_us;
+    const uint32_t old_size  = heap->gc_threshold;
+    uint64_t       threshold = old_size;
+    uint64_t       live_size;
+    uint32_t       gc_percent;
+    unsigned       sizing    = KOS_HEAP_KEEP;
+
+    heap->gc_time_us += stats->time_stop_us + stats->time_mark_us +
+                        stats->time_evac_us + stats->time_update_us;
+
+    gc_percent = total_us ? (uint32_t)KOS_min((heap->gc_time_us * 100U) / total_us,
+                                              (uint64_t)100U)
+                          : 0U;
+
+    stats->gc_time_percent = gc_percent;
+
+    if ( ! minor) {
+
+        if (gc_percent > heap->gc_time_target)
+            threshold += threshold / 2U;
+        else if (gc_percent < heap->gc_time_target / 2U)
+            threshold -= threshold / 4U;
+
+        /* Leave room for new objects after live objects */
+        live_size = (uint64_t)heap->used_heap_size * 100U / KOS_GC_THRESHOLD;
+
+        threshold = KOS_max(threshold, live_size);
+        threshold = KOS_max(threshold, (uint64_t)heap->min_heap_size);
+
+        /* The soft limit is exceeded only if live objects don't fit */
+        if (live_size > heap->soft_max_size) {
+            threshold = heap->max_heap_size;
+            sizing    = KOS_HEAP_OVER_LIMIT;
+        }
+        else
+            threshold = KOS_min(threshold, (uint64_t)heap->soft_max_size);
+
+        threshold = KOS_min(threshold, (uint64_t)heap->max_heap_size);
+
+        if (sizing == KOS_HEAP_KEEP && threshold != old_size)
+            sizing = (threshold > old_size) ? KOS_HEAP_GROW : KOS_HEAP_SHRINK;
+
+        heap->gc_threshold   = (uint32_t)threshold;
+        heap->gc_time_us     = 0U;
+        heap->sizing_time_us = now;
+
+#ifndef CONFIG_MAD_GC
+        /* Return unused memory to the system when the heap shrinks */
+        if (heap->heap_size > heap->gc_threshold + KOS_NURSERY_SIZE)
+            release_free_pools(heap, heap->gc_threshold + KOS_NURSERY_SIZE);
+#endif
+    }
+
+    stats->heap_sizing  = sizing;
+    stats->gc_threshold = heap->gc_threshold;
 }
 
 static void engage_in_gc(KOS_CONTEXT ctx, enum GC_STATE_E new_state)
@@ -2719,6 +4099,134 @@ static void engage_in_gc(KOS_CONTEXT ctx, enum GC_STATE_E new_state)
     }
 }
 
+/* Called with heap mutex held by threads which help the main GC thread */
+static void help_with_walk(KOS_HEAP *heap, enum GC_STATE_E gc_state)
+{
+    switch (gc_state) {
+
+        case GC_MARK: {
+
+            KOS_MARK_CONTEXT mark_ctx;
+            int              error;
+
+            init_mark_context(&mark_ctx, heap);
+            error = perform_gray_to_black_marking(&mark_ctx, WALK_HELPER_THREAD);
+
+            if (error)
+                heap->mark_error = error;
+            break;
+        }
+
+        case GC_EVACUATE:
+            /* The main thread evacuates pages deferred due to low memory
+             * on its own */
+            if (heap->evacuation)
+                evacuate_pages(heap, WALK_HELPER_THREAD);
+            break;
+
+        case GC_UPDATE:
+            update_pages_after_evacuation(heap, WALK_HELPER_THREAD);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void gc_worker_thread(void *cookie)
+{
+    KOS_HEAP *const heap = (KOS_HEAP *)cookie;
+
+    kos_lock_mutex(heap->mutex);
+
+    for (;;) {
+
+        help_with_walk(heap, (enum GC_STATE_E)KOS_atomic_read_relaxed_u32(heap->gc_state));
+
+        if (heap->stop_gc_workers)
+            break;
+
+        /* Wait for GC to start or for more pages to be available for
+         * processing by helper threads. */
+        kos_wait_cond_var(heap->helper_cond, heap->mutex);
+    }
+
+    kos_unlock_mutex(heap->mutex);
+}
+
+static void stop_gc_workers(KOS_HEAP *heap)
+{
+    KOS_NATIVE_THREAD *workers;
+    uint32_t           num_workers;
+    uint32_t           i;
+
+    kos_lock_mutex(heap->mutex);
+
+    workers     = heap->gc_workers;
+    num_workers = heap->num_gc_workers;
+
+    heap->gc_workers      = KOS_NULL;
+    heap->num_gc_workers  = 0U;
+    heap->stop_gc_workers = 1U;
+
+    kos_broadcast_cond_var(heap->helper_cond);
+
+    kos_unlock_mutex(heap->mutex);
+
+    for (i = 0; i < num_workers; i++)
+        kos_join_native_thread(&workers[i]);
+
+    KOS_free(workers);
+
+    kos_lock_mutex(heap->mutex);
+
+    heap->stop_gc_workers = 0U;
+
+    kos_unlock_mutex(heap->mutex);
+}
+
+int KOS_instance_set_gc_workers(KOS_INSTANCE *inst,
+                                uint32_t      num_workers)
+{
+    KOS_HEAP *const    heap    = &inst->heap;
+    KOS_NATIVE_THREAD *workers = KOS_NULL;
+    int                error   = KOS_SUCCESS;
+    uint32_t           i;
+
+    stop_gc_workers(heap);
+
+    if (num_workers > KOS_MAX_GC_WORKERS)
+        num_workers = KOS_MAX_GC_WORKERS;
+
+    if ( ! num_workers)
+        return KOS_SUCCESS;
+
+    workers = (KOS_NATIVE_THREAD *)KOS_malloc(num_workers * sizeof(KOS_NATIVE_THREAD));
+    if ( ! workers)
+        return KOS_ERROR_OUT_OF_MEMORY;
+
+    for (i = 0; i < num_workers; i++) {
+        error = kos_create_native_thread(&workers[i], gc_worker_thread, heap);
+        if (error)
+            break;
+    }
+
+    /* Keep the workers which have been started successfully */
+    if ( ! i) {
+        KOS_free(workers);
+        workers = KOS_NULL;
+    }
+
+    kos_lock_mutex(heap->mutex);
+
+    heap->gc_workers     = workers;
+    heap->num_gc_workers = i;
+
+    kos_unlock_mutex(heap->mutex);
+
+    return error;
+}
+
 static void help_gc(KOS_CONTEXT ctx)
 {
     KOS_HEAP *const heap = get_heap(ctx);
@@ -2743,32 +4251,9 @@ static void help_gc(KOS_CONTEXT ctx)
 
     do {
         assert( ! ctx->cur_page);
+        assert(gc_state != GC_INACTIVE);
 
-        switch (gc_state) {
-
-            case GC_MARK: {
-
-                KOS_MARK_CONTEXT mark_ctx;
-                int              error;
-
-                init_mark_context(&mark_ctx, heap);
-                error = perform_gray_to_black_marking(&mark_ctx, WALK_HELPER_THREAD);
-
-                if (error)
-                    heap->mark_error = error;
-                break;
-            }
-
-            /* TODO help with evac */
-
-            case GC_UPDATE:
-                update_pages_after_evacuation(heap, WALK_HELPER_THREAD);
-                break;
-
-            default:
-                assert(gc_state != GC_INACTIVE);
-                break;
-        }
+        help_with_walk(heap, gc_state);
 
         /* Wait for GC state to change or for more pages to be available for
          * processing by helper threads. */
@@ -2867,8 +4352,9 @@ int KOS_resume_context(KOS_CONTEXT ctx)
     return error;
 }
 
-int KOS_collect_garbage(KOS_CONTEXT   ctx,
-                        KOS_GC_STATS *out_stats)
+static int collect_garbage(KOS_CONTEXT   ctx,
+                           int           minor,
+                           KOS_GC_STATS *out_stats)
 {
     PROF_ZONE(GC)
 
@@ -2879,6 +4365,7 @@ int KOS_collect_garbage(KOS_CONTEXT   ctx,
     KOS_PAGE_LIST    free_pages = { KOS_NULL, KOS_NULL };
     KOS_GC_STATS     stats      = KOS_GC_STATS_INIT(0U);
     int              error      = KOS_SUCCESS;
+    int              remark;
 
     /***********************************************************************/
     /* Initialize GC */
@@ -2887,6 +4374,12 @@ int KOS_collect_garbage(KOS_CONTEXT   ctx,
 
     kos_lock_mutex(heap->mutex);
 
+    /* Wait for the background marking thread to finish */
+    while (KOS_atomic_read_relaxed_u32(heap->concurrent_mark) == CONCURRENT_ACTIVE &&
+           heap->mark_thread &&
+           KOS_atomic_read_relaxed_u32(heap->gc_state) == GC_INACTIVE)
+        kos_wait_cond_var(heap->mark_cond, heap->mutex);
+
     if (KOS_atomic_read_relaxed_u32(heap->gc_state) != GC_INACTIVE) {
 
         help_gc(ctx);
@@ -2899,6 +4392,17 @@ int KOS_collect_garbage(KOS_CONTEXT   ctx,
         return KOS_SUCCESS;
     }
 
+    /* Finish the GC cycle started by background or incremental marking,
+     * objects which have not been marked by slices yet are marked now */
+    remark = KOS_atomic_read_relaxed_u32(heap->concurrent_mark) != CONCURRENT_IDLE;
+
+    if (remark) {
+        minor = 0;
+
+        if (heap->mark_thread)
+            kos_join_native_thread(&heap->mark_thread);
+    }
+
     KOS_atomic_write_release_u32(heap->gc_state, GC_INIT);
 
     kos_set_global_event(ctx, KOS_EVENT_GC);
@@ -2913,6 +4417,16 @@ int KOS_collect_garbage(KOS_CONTEXT   ctx,
 
     ++heap->gc_cycles;
 
+    /* Survivors of minor GC are added to the last pages which received
+     * evacuated objects, major GC moves all surviving objects. */
+    heap->gc_minor = (uint32_t)minor;
+    if (minor)
+        ++heap->minor_gc_cycles;
+    else {
+        heap->evac_pages[0] = KOS_NULL;
+        heap->evac_pages[1] = KOS_NULL;
+    }
+
     KOS_atomic_write_relaxed_u32(ctx->gc_state, GC_ENGAGED);
 
     release_current_page_locked(ctx);
@@ -2930,10 +4444,25 @@ int KOS_collect_garbage(KOS_CONTEXT   ctx,
 
     stats.initial_used_heap_size = heap->used_heap_size;
 
-    clear_marking(heap);
+    if (remark) {
+        /* New objects are no longer allocated black */
+        KOS_atomic_write_relaxed_u32(heap->concurrent_mark, CONCURRENT_IDLE);
 
-    init_mark_context(&mark_ctx, heap);
-    error = mark_roots(ctx, &mark_ctx);
+        init_mark_context(&mark_ctx, heap);
+        error = mark_roots(ctx, &mark_ctx);
+
+        if ( ! error)
+            error = remark_pages(&mark_ctx, heap);
+    }
+    else {
+        clear_marking(heap);
+
+        init_mark_context(&mark_ctx, heap);
+        error = mark_roots(ctx, &mark_ctx);
+
+        if ( ! error && minor)
+            error = mark_old_pages(&mark_ctx, heap);
+    }
 
     /***********************************************************************/
     /* Phase 2: Perform marking */
@@ -2944,6 +4473,9 @@ int KOS_collect_garbage(KOS_CONTEXT   ctx,
         error = gray_to_black(&mark_ctx, heap);
     }
 
+    if ( ! error && minor)
+        verify_old_pages(heap);
+
     assert( ! error || (error == KOS_ERROR_OUT_OF_MEMORY));
 
     /***********************************************************************/
@@ -3009,11 +4541,26 @@ int KOS_collect_garbage(KOS_CONTEXT   ctx,
     /***********************************************************************/
     /* Done, finish GC */
 
-    update_gc_threshold(heap);
+    promote_pages(heap);
 
-    stats.heap_size      = heap->heap_size;
-    stats.used_heap_size = heap->used_heap_size;
-    stats.malloc_size    = heap->malloc_size;
+    heap->gc_minor = 0U;
+
+    update_gc_threshold(heap, minor, &stats);
+
+    stats.heap_size        = heap->heap_size;
+    stats.used_heap_size   = heap->used_heap_size;
+    stats.malloc_size      = heap->malloc_size;
+    stats.num_minor_cycles = heap->minor_gc_cycles;
+    stats.num_major_cycles = heap->gc_cycles - heap->minor_gc_cycles;
+
+    /* Pauses from the beginning of the GC cycle and marking slices */
+    stats.num_slices        = heap->num_slices;
+    stats.time_max_slice_us = heap->max_slice_us;
+    memcpy(stats.time_slice_us, heap->slice_hist, sizeof(stats.time_slice_us));
+
+    heap->num_slices   = 0U;
+    heap->max_slice_us = 0U;
+    memset(heap->slice_hist, 0, sizeof(heap->slice_hist));
 
     verify_heap_used_size(heap);
 
@@ -3044,6 +4591,12 @@ int KOS_collect_garbage(KOS_CONTEXT   ctx,
                                      stats.time_update_us +
                                      stats.time_finish_us);
 
+    /* The final pause of the GC cycle */
+    ++stats.num_slices;
+    if (stats.time_total_us > stats.time_max_slice_us)
+        stats.time_max_slice_us = stats.time_total_us;
+    ++stats.time_slice_us[get_slice_bucket(stats.time_total_us)];
+
     if (ctx->inst->flags & KOS_INST_DEBUG) {
         printf("GC used/total [B] %x/%x -> %x/%x | malloc [B] %x -> %x : retained %u : time %u us\n",
                stats.initial_used_heap_size, stats.initial_heap_size,
@@ -3060,3 +4613,49 @@ int KOS_collect_garbage(KOS_CONTEXT   ctx,
 
     return error;
 }
+
+void KOS_instance_set_gc_budget(KOS_INSTANCE *inst,
+                                uint32_t      slice_us,
+                                uint32_t      slice_bytes)
+{
+    KOS_HEAP *const heap = &inst->heap;
+
+    kos_lock_mutex(heap->mutex);
+
+    heap->slice_us    = slice_us;
+    heap->slice_bytes = slice_bytes;
+
+    kos_unlock_mutex(heap->mutex);
+}
+
+void KOS_instance_set_heap_size(KOS_INSTANCE *inst,
+                                uint32_t      min_size,
+                                uint32_t      max_size,
+                                uint32_t      gc_time_percent)
+{
+    KOS_HEAP *const heap = &inst->heap;
+
+    kos_lock_mutex(heap->mutex);
+
+    heap->min_heap_size  = min_size;
+    heap->soft_max_size  = KOS_max(min_size, max_size);
+    heap->gc_time_target = gc_time_percent;
+
+    /* Apply the new limits immediately, before the next major GC cycle */
+    heap->gc_threshold = KOS_max(heap->gc_threshold, heap->min_heap_size);
+    heap->gc_threshold = KOS_min(heap->gc_threshold, heap->soft_max_size);
+
+    kos_unlock_mutex(heap->mutex);
+}
+
+int KOS_collect_garbage(KOS_CONTEXT   ctx,
+                        KOS_GC_STATS *out_stats)
+{
+    return collect_garbage(ctx, 0, out_stats);
+}
+
+int KOS_collect_young_garbage(KOS_CONTEXT   ctx,
+                              KOS_GC_STATS *out_stats)
+{
+    return collect_garbage(ctx, 1, out_stats);
+}
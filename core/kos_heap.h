@@ -10,7 +10,8 @@
 
 typedef enum KOS_ALLOC_FLAG_E {
     KOS_ALLOC_MOVABLE,
-    KOS_ALLOC_IMMOVABLE
+    KOS_ALLOC_IMMOVABLE,
+    KOS_ALLOC_BYTECODE  /* Immovable function bytecode, which owns its native code */
 } KOS_ALLOC_FLAG;
 
 enum GC_STATE_E {
@@ -27,6 +28,13 @@ enum GC_STATE_E {
     GC_UPDATE
 };
 
+/* heap->concurrent_mark */
+enum KOS_CONCURRENT_MARK_E {
+    CONCURRENT_IDLE,   /* Marking is only done while the world is stopped    */
+    CONCURRENT_ACTIVE, /* Marking thread or slices are walking the heap      */
+    CONCURRENT_DONE    /* Marking finished, remark has not run yet           */
+};
+
 int   kos_heap_init(KOS_INSTANCE *inst);
 
 void  kos_heap_destroy(KOS_INSTANCE *inst);
@@ -41,6 +49,10 @@ void *kos_alloc_object_page(KOS_CONTEXT ctx,
 
 void kos_heap_release_thread_page(KOS_CONTEXT ctx);
 
+/* Must be invoked after a pointer to another object is written into an
+ * existing object, array or their storage. */
+void kos_write_barrier(KOS_OBJ_ID obj_id);
+
 void kos_print_heap(KOS_CONTEXT ctx);
 
 #ifdef CONFIG_MAD_GC
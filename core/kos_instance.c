@@ -58,7 +58,8 @@ struct KOS_LIB_LIST_S {
 struct KOS_PERF_S kos_perf = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 },
     0, 0,
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+    0, 0,
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
     0, 0, 0, 0, 0, 0, 0, 0, 0,
     { 0, 0, 0, 0 },
     { 0, 0, 0, 0 },
@@ -263,6 +264,7 @@ static void setup_init_module(KOS_MODULE *init_module)
     init_module->constants      = KOS_BADPTR;
     init_module->global_names   = KOS_BADPTR;
     init_module->globals        = KOS_BADPTR;
+    init_module->const_globals  = KOS_BADPTR;
     init_module->module_names   = KOS_BADPTR;
     init_module->priv           = KOS_BADPTR;
     init_module->finalize       = KOS_NULL;
@@ -288,6 +290,8 @@ static KOS_OBJ_ID get_init_module(void)
 
 static void clear_instance(KOS_INSTANCE *inst)
 {
+    int i;
+
     /* Disable GC during early init */
     inst->flags = KOS_INST_MANUAL_GC;
 
@@ -309,6 +313,7 @@ static void clear_instance(KOS_INSTANCE *inst)
     inst->prototypes.ctrl_c_proto        = KOS_BADPTR;
     inst->prototypes.thread_proto        = KOS_BADPTR;
     inst->prototypes.module_proto        = KOS_BADPTR;
+    inst->shapes.root                    = KOS_BADPTR;
     inst->modules.search_paths           = KOS_BADPTR;
     inst->modules.module_names           = KOS_BADPTR;
     inst->modules.modules                = KOS_BADPTR;
@@ -316,11 +321,21 @@ static void clear_instance(KOS_INSTANCE *inst)
     inst->modules.module_inits           = KOS_BADPTR;
     inst->modules.libs                   = KOS_NULL;
     inst->modules.load_chain             = KOS_NULL;
+    inst->modules.cache_dir              = KOS_NULL;
     inst->threads.threads                = KOS_NULL;
     inst->threads.can_create             = 0;
     inst->threads.num_threads            = 0;
     inst->threads.max_threads            = KOS_MAX_THREADS;
 
+    KOS_atomic_write_relaxed_u32(inst->shapes.num_shapes, 0U);
+    KOS_atomic_write_relaxed_u32(inst->shapes.proto_epoch, 0U);
+    KOS_atomic_write_relaxed_u32(inst->jit.num_compiled, 0U);
+
+    for (i = 0; i < KOS_NUM_QUICK_INSTRS; i++) {
+        KOS_atomic_write_relaxed_u32(inst->quicken.num_quickened[i],   0U);
+        KOS_atomic_write_relaxed_u32(inst->quicken.num_deoptimized[i], 0U);
+    }
+
     init_context(&inst->threads.main_thread, inst);
 }
 
@@ -408,6 +423,8 @@ int KOS_instance_init(KOS_INSTANCE *inst,
 
     ctx = &inst->threads.main_thread;
 
+    TRY(kos_init_shapes(ctx));
+
     TRY(init_prototypes(ctx, &inst->prototypes));
 
     TRY_OBJID(inst->modules.module_names           = KOS_new_object(ctx));
@@ -424,6 +441,7 @@ int KOS_instance_init(KOS_INSTANCE *inst,
     init_module->inst                    = inst;
     TRY_OBJID(init_module->globals       = KOS_new_array(ctx, 0));
     TRY_OBJID(init_module->global_names  = KOS_new_object(ctx));
+    TRY_OBJID(init_module->const_globals = KOS_new_object(ctx));
     TRY_OBJID(init_module->module_names  = KOS_new_object(ctx));
 
     inst->modules.init_module = OBJID(MODULE, init_module);
@@ -436,6 +454,9 @@ int KOS_instance_init(KOS_INSTANCE *inst,
                          KOS_CONST_ID(str_err_panic)));
     TRY(KOS_set_property(ctx, inst->prototypes.ctrl_c_proto, KOS_CONST_ID(str_description),
                          KOS_CONST_ID(str_err_ctrl_c)));
+    TRY(KOS_set_builtin_dynamic_property(ctx, inst->prototypes.exception_proto, KOS_STR_BACKTRACE,
+                                         inst->modules.init_module, kos_get_backtrace_prop,
+                                         kos_set_backtrace_prop));
 
     *out_ctx = ctx;
 
@@ -535,6 +556,8 @@ void KOS_instance_destroy(KOS_INSTANCE *inst)
         KOS_free((void *)libs);
     }
 
+    KOS_free(inst->modules.cache_dir);
+
     kos_tls_destroy(inst->threads.thread_key);
 
     kos_destroy_mutex(&inst->threads.new_mutex);
@@ -570,6 +593,8 @@ void KOS_instance_destroy(KOS_INSTANCE *inst)
     PERF_VALUE(object_collision[1]);
     PERF_VALUE(object_collision[2]);
     PERF_VALUE(object_collision[3]);
+    PERF_VALUE(prop_cache_hit);
+    PERF_VALUE(prop_cache_miss);
     PERF_RATIO(array_salvage);
     PERF_VALUE(alloc_object);
     PERF_VALUE_NAME(new_object_integer,        new_object[0]);
@@ -591,6 +616,8 @@ void KOS_instance_destroy(KOS_INSTANCE *inst)
     PERF_VALUE_NAME(new_object_dynamic_prop,   new_object[16]);
     PERF_VALUE_NAME(new_object_iterator,       new_object[17]);
     PERF_VALUE_NAME(new_object_stack,          new_object[18]);
+    PERF_VALUE_NAME(new_object_shape,          new_object[19]);
+    PERF_VALUE_NAME(new_object_shaped_storage, new_object[20]);
     PERF_VALUE_NAME(alloc_object_32,        alloc_object_size[0]);
     PERF_VALUE_NAME(alloc_object_64_128,    alloc_object_size[1]);
     PERF_VALUE_NAME(alloc_object_160_256,   alloc_object_size[2]);
@@ -760,6 +787,32 @@ cleanup:
     return error;
 }
 
+int KOS_instance_set_cache_dir(KOS_CONTEXT ctx,
+                               const char *cache_dir)
+{
+    KOS_INSTANCE *const inst    = ctx->inst;
+    char               *new_dir = KOS_NULL;
+
+    if (cache_dir && *cache_dir) {
+        const size_t len = strlen(cache_dir);
+
+        /* Strip trailing path separator */
+        const size_t dir_len = (len > 1 && cache_dir[len - 1] == KOS_PATH_SEPARATOR) ? len - 1 : len;
+
+        new_dir = (char *)KOS_malloc(dir_len + 1);
+        if ( ! new_dir)
+            return KOS_ERROR_OUT_OF_MEMORY;
+
+        memcpy(new_dir, cache_dir, dir_len);
+        new_dir[dir_len] = '\0';
+    }
+
+    KOS_free(inst->modules.cache_dir);
+    inst->modules.cache_dir = new_dir;
+
+    return KOS_SUCCESS;
+}
+
 static int save_module_lib(KOS_CONTEXT ctx, KOS_SHARED_LIB lib)
 {
     KOS_LIB_LIST *libs;
@@ -942,7 +995,7 @@ KOS_OBJ_ID KOS_format_exception(KOS_CONTEXT ctx,
     value.o = KOS_get_property(ctx, exception, KOS_STR_VALUE);
     TRY_OBJID(value.o);
 
-    backtrace.o = KOS_get_property(ctx, exception, KOS_STR_BACKTRACE);
+    backtrace.o = kos_get_backtrace(ctx, exception);
     TRY_OBJID(backtrace.o);
 
     if (GET_OBJ_TYPE(backtrace.o) != OBJ_ARRAY)
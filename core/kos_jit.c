@@ -0,0 +1,933 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 Chris Dragan
+ */
+
+#include "kos_jit.h"
+
+#ifdef KOS_JIT
+
+#include "../inc/kos_array.h"
+#include "../inc/kos_atomic.h"
+#include "../inc/kos_constants.h"
+#include "../inc/kos_error.h"
+#include "../inc/kos_instance.h"
+#include "../inc/kos_malloc.h"
+#include "../inc/kos_memory.h"
+#include "../inc/kos_module.h"
+#include "kos_disasm.h"
+#include "kos_misc.h"
+#include "kos_object_internal.h"
+#include "kos_try.h"
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/*
+ * Baseline JIT for x86-64 (System V ABI).
+ *
+ * Each bytecode instruction is translated to a fixed native template.
+ * Registers of the function live in the stack frame and are read and written
+ * directly there, so the interpreter can take over at any instruction.
+ * Common cases (small integers, booleans) are handled inline, everything
+ * else goes through C helpers.  Instructions which don't affect control flow,
+ * such as property and element access, call the same functions which the
+ * interpreter uses to execute them.  Instructions which are not supported by
+ * the JIT, such as calls, return control to the interpreter, which executes
+ * them and then re-enters native code if enough instructions follow, which
+ * can be executed natively.
+ *
+ * Register assignment in native code:
+ *   rbx - pointer to the first register in the current stack frame
+ *   r12 - current thread context
+ *
+ * Native code block layout:
+ *   entry:    saves callee-saved registers and jumps to the requested instruction
+ *   epilogue: restores callee-saved registers and returns bytecode offset in eax
+ *   followed by templates for every instruction.
+ */
+
+typedef uint32_t (*KOS_JIT_ENTRY)(KOS_CONTEXT             ctx,
+                                  KOS_ATOMIC(KOS_OBJ_ID) *regs,
+                                  const uint8_t          *target);
+
+typedef struct KOS_JIT_CODE_S {
+    uint8_t  *code;        /* Executable memory                       */
+    size_t    code_size;   /* Size of executable memory mapping       */
+    uint32_t *next_entry;  /* Next offset worth entering native code  */
+    uint32_t  entries[1];  /* Native offset for each bytecode offset  */
+} KOS_JIT_CODE;
+
+/* Entry for an unsupported instruction, which exits to the interpreter right away */
+#define KOS_JIT_EXIT_ONLY 0x80000000U
+
+/* Entering and leaving native code has a cost, so native code is entered only
+ * where it runs at least this many instructions or a loop */
+#define KOS_JIT_MIN_RUN 4U
+
+/* Max number of bytes generated for a single instruction */
+#define KOS_JIT_MAX_TEMPLATE 256U
+
+typedef struct KOS_JIT_JUMP_S {
+    uint32_t code_offs; /* Offset of rel32 operand in native code */
+    uint32_t target;    /* Jump target bytecode offset            */
+} KOS_JIT_JUMP;
+
+typedef struct KOS_JIT_EMITTER_S {
+    KOS_VECTOR code;
+    KOS_VECTOR jumps;
+    uint32_t   epilogue;
+} KOS_JIT_EMITTER;
+
+enum KOS_X86_REG_E {
+    X86_RAX = 0,
+    X86_RCX = 1,
+    X86_RDX = 2,
+    X86_RBX = 3,
+    X86_RSP = 4,
+    X86_RBP = 5,
+    X86_RSI = 6,
+    X86_RDI = 7,
+    X86_R12 = 12
+};
+
+enum KOS_X86_CC_E {
+    X86_CC_O  = 0x0,
+    X86_CC_E  = 0x4,
+    X86_CC_NE = 0x5,
+    X86_CC_L  = 0xC,
+    X86_CC_LE = 0xE
+};
+
+#define FUNC_ADDR(func) ((uint64_t)(uintptr_t)(func))
+#define OBJ_ADDR(obj)   ((uint64_t)(uintptr_t)(obj))
+
+static void emit_u8(KOS_JIT_EMITTER *e, uint32_t value)
+{
+    assert(e->code.size < e->code.capacity);
+    e->code.buffer[e->code.size++] = (char)(uint8_t)value;
+}
+
+static void emit_u32(KOS_JIT_EMITTER *e, uint32_t value)
+{
+    emit_u8(e, value & 0xFFU);
+    emit_u8(e, (value >> 8) & 0xFFU);
+    emit_u8(e, (value >> 16) & 0xFFU);
+    emit_u8(e, value >> 24);
+}
+
+static void emit_u64(KOS_JIT_EMITTER *e, uint64_t value)
+{
+    emit_u32(e, (uint32_t)value);
+    emit_u32(e, (uint32_t)(value >> 32));
+}
+
+static uint32_t get_pos(const KOS_JIT_EMITTER *e)
+{
+    return (uint32_t)e->code.size;
+}
+
+/* mov reg, [rbx + kos_reg * 8] */
+static void emit_load_reg(KOS_JIT_EMITTER *e, int reg, uint32_t kos_reg)
+{
+    emit_u8(e, 0x48U | ((uint32_t)(reg >> 3) << 2));
+    emit_u8(e, 0x8BU);
+    emit_u8(e, 0x80U | ((uint32_t)(reg & 7) << 3) | X86_RBX);
+    emit_u32(e, kos_reg * (uint32_t)sizeof(KOS_OBJ_ID));
+}
+
+/* mov [rbx + kos_reg * 8], reg */
+static void emit_store_reg(KOS_JIT_EMITTER *e, uint32_t kos_reg, int reg)
+{
+    emit_u8(e, 0x48U | ((uint32_t)(reg >> 3) << 2));
+    emit_u8(e, 0x89U);
+    emit_u8(e, 0x80U | ((uint32_t)(reg & 7) << 3) | X86_RBX);
+    emit_u32(e, kos_reg * (uint32_t)sizeof(KOS_OBJ_ID));
+}
+
+/* mov reg, imm64 */
+static void emit_mov_imm64(KOS_JIT_EMITTER *e, int reg, uint64_t value)
+{
+    emit_u8(e, 0x48U | (uint32_t)(reg >> 3));
+    emit_u8(e, 0xB8U + (uint32_t)(reg & 7));
+    emit_u64(e, value);
+}
+
+/* mov reg32, imm32 (zero-extended) */
+static void emit_mov_imm32(KOS_JIT_EMITTER *e, int reg, uint32_t value)
+{
+    assert(reg < 8);
+    emit_u8(e, 0xB8U + (uint32_t)reg);
+    emit_u32(e, value);
+}
+
+/* mov dst, src */
+static void emit_mov(KOS_JIT_EMITTER *e, int dst, int src)
+{
+    emit_u8(e, 0x48U | ((uint32_t)(src >> 3) << 2) | (uint32_t)(dst >> 3));
+    emit_u8(e, 0x89U);
+    emit_u8(e, 0xC0U | ((uint32_t)(src & 7) << 3) | (uint32_t)(dst & 7));
+}
+
+static void emit_call(KOS_JIT_EMITTER *e, uint64_t func_addr)
+{
+    emit_mov_imm64(e, X86_RAX, func_addr);
+
+    /* call rax */
+    emit_u8(e, 0xFFU);
+    emit_u8(e, 0xD0U);
+}
+
+/* jcc rel8, returns position to pass to patch_rel8() */
+static uint32_t emit_jcc8(KOS_JIT_EMITTER *e, int cc)
+{
+    emit_u8(e, 0x70U | (uint32_t)cc);
+    emit_u8(e, 0U);
+    return get_pos(e);
+}
+
+/* jmp rel8, returns position to pass to patch_rel8() */
+static uint32_t emit_jmp8(KOS_JIT_EMITTER *e)
+{
+    emit_u8(e, 0xEBU);
+    emit_u8(e, 0U);
+    return get_pos(e);
+}
+
+/* Points short jump emitted at pos to the current position */
+static void patch_rel8(KOS_JIT_EMITTER *e, uint32_t pos)
+{
+    const uint32_t delta = get_pos(e) - pos;
+
+    assert(delta < 128U);
+    e->code.buffer[pos - 1] = (char)(uint8_t)delta;
+}
+
+/* Returns to the interpreter, which will continue at the specified instruction */
+static void emit_exit(KOS_JIT_EMITTER *e, uint32_t offs)
+{
+    emit_mov_imm32(e, X86_RAX, offs);
+
+    /* jmp epilogue */
+    emit_u8(e, 0xE9U);
+    emit_u32(e, e->epilogue - (get_pos(e) + 4U));
+}
+
+/* Exits to the interpreter if the helper returned KOS_BADPTR */
+static void emit_check_obj(KOS_JIT_EMITTER *e, uint32_t offs)
+{
+    uint32_t pos;
+
+    /* cmp rax, KOS_BADPTR */
+    emit_u8(e, 0x48U);
+    emit_u8(e, 0x83U);
+    emit_u8(e, 0xF8U);
+    emit_u8(e, (uint32_t)(uintptr_t)KOS_BADPTR);
+
+    pos = emit_jcc8(e, X86_CC_NE);
+    emit_exit(e, offs);
+    patch_rel8(e, pos);
+}
+
+/* Exits to the interpreter if the helper returned an error */
+static void emit_check_error(KOS_JIT_EMITTER *e, uint32_t offs)
+{
+    uint32_t pos;
+
+    /* test eax, eax */
+    emit_u8(e, 0x85U);
+    emit_u8(e, 0xC0U);
+
+    pos = emit_jcc8(e, X86_CC_E);
+    emit_exit(e, offs);
+    patch_rel8(e, pos);
+}
+
+/* Loads two registers into rax and rcx, jumps if any of them is not a small int.
+ * Returns position to pass to patch_rel8(). */
+static uint32_t emit_load_small_ints(KOS_JIT_EMITTER *e, uint32_t rsrc1, uint32_t rsrc2)
+{
+    emit_load_reg(e, X86_RAX, rsrc1);
+    emit_load_reg(e, X86_RCX, rsrc2);
+    emit_mov(e, X86_RDX, X86_RAX);
+
+    /* or rdx, rcx */
+    emit_u8(e, 0x48U);
+    emit_u8(e, 0x09U);
+    emit_u8(e, 0xCAU);
+
+    /* test dl, 1 */
+    emit_u8(e, 0xF6U);
+    emit_u8(e, 0xC2U);
+    emit_u8(e, 1U);
+
+    return emit_jcc8(e, X86_CC_NE);
+}
+
+/* Same check as KOS_handle_global_event(), done inline on the fast path */
+static void emit_global_event_check(KOS_JIT_EMITTER *e, uint32_t offs)
+{
+    uint32_t pos;
+
+    /* mov eax, [r12 + event_flags] */
+    emit_u8(e, 0x41U);
+    emit_u8(e, 0x8BU);
+    emit_u8(e, 0x84U);
+    emit_u8(e, 0x24U);
+    emit_u32(e, (uint32_t)offsetof(struct KOS_THREAD_CONTEXT_S, event_flags));
+
+    /* test eax, eax */
+    emit_u8(e, 0x85U);
+    emit_u8(e, 0xC0U);
+
+    pos = emit_jcc8(e, X86_CC_E);
+
+    emit_mov(e, X86_RDI, X86_R12);
+    emit_call(e, FUNC_ADDR(KOS_handle_global_event));
+    emit_check_error(e, offs);
+
+    patch_rel8(e, pos);
+}
+
+static int add_jump(KOS_JIT_EMITTER *e, uint32_t target)
+{
+    KOS_JIT_JUMP  *jump;
+    const size_t   old_size = e->jumps.size;
+    const int      error    = KOS_vector_resize(&e->jumps, old_size + sizeof(KOS_JIT_JUMP));
+
+    if ( ! error) {
+        jump            = (KOS_JIT_JUMP *)(e->jumps.buffer + old_size);
+        jump->code_offs = get_pos(e) - 4U;
+        jump->target    = target;
+    }
+
+    return error;
+}
+
+static KOS_OBJ_ID load_const(KOS_CONTEXT ctx, uint32_t idx)
+{
+    return KOS_array_read(ctx, OBJPTR(MODULE, KOS_get_module(ctx))->constants, (int)idx);
+}
+
+/* Quickened instructions are compiled like their generic counterparts */
+static KOS_BYTECODE_INSTR get_generic_instr(KOS_BYTECODE_INSTR instr)
+{
+    switch (instr) {
+        case INSTR_ADD_SMALLINT:    /* fall through */
+        case INSTR_ADD_FLOAT:       return INSTR_ADD;
+        case INSTR_SUB_SMALLINT:    /* fall through */
+        case INSTR_SUB_FLOAT:       return INSTR_SUB;
+        case INSTR_MUL_FLOAT:       return INSTR_MUL;
+        case INSTR_CMP_EQ_SMALLINT: /* fall through */
+        case INSTR_CMP_EQ_STR:      return INSTR_CMP_EQ;
+        case INSTR_CMP_NE_SMALLINT: /* fall through */
+        case INSTR_CMP_NE_STR:      return INSTR_CMP_NE;
+        case INSTR_CMP_LE_SMALLINT: return INSTR_CMP_LE;
+        case INSTR_CMP_LT_SMALLINT: return INSTR_CMP_LT;
+        default:                    return instr;
+    }
+}
+
+static void emit_prologue(KOS_JIT_EMITTER *e)
+{
+    /* push rbp; push rbx; push r12 - keeps stack aligned to 16 bytes */
+    emit_u8(e, 0x55U);
+    emit_u8(e, 0x53U);
+    emit_u8(e, 0x41U);
+    emit_u8(e, 0x54U);
+
+    emit_mov(e, X86_R12, X86_RDI);
+    emit_mov(e, X86_RBX, X86_RSI);
+
+    /* jmp rdx */
+    emit_u8(e, 0xFFU);
+    emit_u8(e, 0xE2U);
+
+    e->epilogue = get_pos(e);
+
+    /* pop r12; pop rbx; pop rbp; ret */
+    emit_u8(e, 0x41U);
+    emit_u8(e, 0x5CU);
+    emit_u8(e, 0x5BU);
+    emit_u8(e, 0x5DU);
+    emit_u8(e, 0xC3U);
+}
+
+static void emit_arith(KOS_JIT_EMITTER   *e,
+                       KOS_BYTECODE_INSTR instr,
+                       const uint8_t     *bytecode,
+                       const KOS_INSTR   *decoded,
+                       uint32_t           offs)
+{
+    const uint32_t rdest = bytecode[1];
+    const uint32_t rsrc1 = bytecode[2];
+    const uint32_t rsrc2 = bytecode[3];
+    uint32_t       slow  = 0;
+    uint32_t       ovf   = 0;
+    uint32_t       done  = 0;
+
+    if (instr == INSTR_ADD || instr == INSTR_SUB || instr == INSTR_MUL) {
+
+        slow = emit_load_small_ints(e, rsrc1, rsrc2);
+
+        /* Small ints are shifted left by one, so the result has the same representation */
+        if (instr == INSTR_ADD) {
+            /* add rax, rcx */
+            emit_u8(e, 0x48U);
+            emit_u8(e, 0x01U);
+            emit_u8(e, 0xC8U);
+        }
+        else if (instr == INSTR_SUB) {
+            /* sub rax, rcx */
+            emit_u8(e, 0x48U);
+            emit_u8(e, 0x29U);
+            emit_u8(e, 0xC8U);
+        }
+        else {
+            /* sar rax, 1 */
+            emit_u8(e, 0x48U);
+            emit_u8(e, 0xD1U);
+            emit_u8(e, 0xF8U);
+
+            /* imul rax, rcx */
+            emit_u8(e, 0x48U);
+            emit_u8(e, 0x0FU);
+            emit_u8(e, 0xAFU);
+            emit_u8(e, 0xC1U);
+        }
+
+        /* Overflow means the result does not fit in a small int */
+        ovf = emit_jcc8(e, X86_CC_O);
+
+        emit_store_reg(e, rdest, X86_RAX);
+        done = emit_jmp8(e);
+
+        patch_rel8(e, slow);
+        patch_rel8(e, ovf);
+    }
+
+    emit_mov(e, X86_RDI, X86_R12);
+    emit_mov_imm64(e, X86_RSI, OBJ_ADDR(decoded));
+    emit_load_reg(e, X86_RDX, rsrc1);
+    emit_load_reg(e, X86_RCX, rsrc2);
+    emit_call(e, FUNC_ADDR(kos_vm_arith));
+    emit_check_obj(e, offs);
+    emit_store_reg(e, rdest, X86_RAX);
+
+    if (done)
+        patch_rel8(e, done);
+}
+
+static void emit_compare(KOS_JIT_EMITTER   *e,
+                         KOS_BYTECODE_INSTR instr,
+                         const uint8_t     *bytecode,
+                         const KOS_INSTR   *decoded)
+{
+    const uint32_t rdest = bytecode[1];
+    const uint32_t rsrc1 = bytecode[2];
+    const uint32_t rsrc2 = bytecode[3];
+    uint32_t       slow;
+    uint32_t       done;
+    int            cc;
+
+    switch (instr) {
+        case INSTR_CMP_EQ: cc = X86_CC_E;  break;
+        case INSTR_CMP_NE: cc = X86_CC_NE; break;
+        case INSTR_CMP_LE: cc = X86_CC_LE; break;
+        default:           cc = X86_CC_L;  break;
+    }
+
+    slow = emit_load_small_ints(e, rsrc1, rsrc2);
+
+    emit_mov_imm64(e, X86_RDX, OBJ_ADDR(KOS_FALSE));
+    emit_mov_imm64(e, X86_RSI, OBJ_ADDR(KOS_TRUE));
+
+    /* cmp rax, rcx */
+    emit_u8(e, 0x48U);
+    emit_u8(e, 0x39U);
+    emit_u8(e, 0xC8U);
+
+    /* cmovcc rdx, rsi */
+    emit_u8(e, 0x48U);
+    emit_u8(e, 0x0FU);
+    emit_u8(e, 0x40U | (uint32_t)cc);
+    emit_u8(e, 0xD6U);
+
+    emit_store_reg(e, rdest, X86_RDX);
+    done = emit_jmp8(e);
+
+    patch_rel8(e, slow);
+
+    emit_mov(e, X86_RDI, X86_R12);
+    emit_mov_imm64(e, X86_RSI, OBJ_ADDR(decoded));
+    emit_load_reg(e, X86_RDX, rsrc1);
+    emit_load_reg(e, X86_RCX, rsrc2);
+    emit_call(e, FUNC_ADDR(kos_vm_compare));
+    emit_store_reg(e, rdest, X86_RAX);
+
+    patch_rel8(e, done);
+}
+
+/* Calls function shared with the interpreter, which executes the instruction */
+static void emit_exec(KOS_JIT_EMITTER *e,
+                      KOS_VM_EXEC      exec,
+                      const KOS_INSTR *decoded,
+                      uint32_t         offs)
+{
+    emit_mov(e, X86_RDI, X86_R12);
+
+    /* lea rsi, [rbx - offsetof(KOS_STACK_FRAME, regs)] */
+    emit_u8(e, 0x48U);
+    emit_u8(e, 0x8DU);
+    emit_u8(e, 0x80U | (X86_RSI << 3) | X86_RBX);
+    emit_u32(e, (uint32_t)0U - (uint32_t)offsetof(KOS_STACK_FRAME, regs));
+
+    emit_mov_imm64(e, X86_RDX, OBJ_ADDR(decoded));
+    emit_call(e, FUNC_ADDR(exec));
+    emit_check_error(e, offs);
+}
+
+/* Bitwise and, or and xor of two small ints produce a valid small int,
+ * because the tag bit is zero in both operands */
+static void emit_bitwise(KOS_JIT_EMITTER   *e,
+                         KOS_BYTECODE_INSTR instr,
+                         const uint8_t     *bytecode,
+                         const KOS_INSTR   *decoded,
+                         uint32_t           offs)
+{
+    uint32_t slow;
+    uint32_t done;
+
+    slow = emit_load_small_ints(e, bytecode[2], bytecode[3]);
+
+    /* and/or/xor rax, rcx */
+    emit_u8(e, 0x48U);
+    emit_u8(e, instr == INSTR_AND ? 0x21U : instr == INSTR_OR ? 0x09U : 0x31U);
+    emit_u8(e, 0xC8U);
+
+    emit_store_reg(e, bytecode[1], X86_RAX);
+    done = emit_jmp8(e);
+
+    patch_rel8(e, slow);
+    emit_exec(e, kos_vm_get_exec(instr), decoded, offs);
+    patch_rel8(e, done);
+}
+
+static uint32_t get_jump_target(KOS_BYTECODE_INSTR instr,
+                                const uint8_t     *bytecode,
+                                uint32_t           offs)
+{
+    const KOS_IMM  imm       = kos_load_simm(bytecode + 1);
+    const uint32_t instr_end = offs + 1U + (uint32_t)imm.size + (instr == INSTR_JUMP ? 0U : 1U);
+
+    return (uint32_t)((int32_t)instr_end + imm.value.sv);
+}
+
+static int emit_jump(KOS_JIT_EMITTER   *e,
+                     KOS_BYTECODE_INSTR instr,
+                     const uint8_t     *bytecode,
+                     uint32_t           offs,
+                     uint32_t           target)
+{
+    emit_global_event_check(e, offs);
+
+    if (instr == INSTR_JUMP) {
+        /* jmp rel32 */
+        emit_u8(e, 0xE9U);
+        emit_u32(e, 0U);
+    }
+    else {
+        const uint32_t rsrc = bytecode[1 + kos_load_simm(bytecode + 1).size];
+        uint32_t       is_true;
+        uint32_t       is_false;
+
+        emit_load_reg(e, X86_RAX, rsrc);
+
+        emit_mov_imm32(e, X86_RDX, 1U);
+
+        emit_mov_imm64(e, X86_RCX, OBJ_ADDR(KOS_TRUE));
+
+        /* cmp rax, rcx */
+        emit_u8(e, 0x48U);
+        emit_u8(e, 0x39U);
+        emit_u8(e, 0xC8U);
+
+        is_true = emit_jcc8(e, X86_CC_E);
+
+        /* xor edx, edx */
+        emit_u8(e, 0x31U);
+        emit_u8(e, 0xD2U);
+
+        emit_mov_imm64(e, X86_RCX, OBJ_ADDR(KOS_FALSE));
+
+        /* cmp rax, rcx */
+        emit_u8(e, 0x48U);
+        emit_u8(e, 0x39U);
+        emit_u8(e, 0xC8U);
+
+        is_false = emit_jcc8(e, X86_CC_E);
+
+        emit_mov(e, X86_RDI, X86_RAX);
+        emit_call(e, FUNC_ADDR(kos_is_truthy));
+
+        /* mov edx, eax */
+        emit_u8(e, 0x89U);
+        emit_u8(e, 0xC2U);
+
+        patch_rel8(e, is_true);
+        patch_rel8(e, is_false);
+
+        /* test edx, edx */
+        emit_u8(e, 0x85U);
+        emit_u8(e, 0xD2U);
+
+        /* jcc rel32 */
+        emit_u8(e, 0x0FU);
+        emit_u8(e, 0x80U | (uint32_t)(instr == INSTR_JUMP_COND ? X86_CC_NE : X86_CC_E));
+        emit_u32(e, 0U);
+    }
+
+    return add_jump(e, target);
+}
+
+static void emit_load_const(KOS_JIT_EMITTER *e,
+                            KOS_CONTEXT      ctx,
+                            KOS_OBJ_ID       module_obj,
+                            const uint8_t   *bytecode,
+                            uint32_t         offs)
+{
+    const KOS_IMM  imm   = kos_load_uimm(bytecode + 2);
+    const uint32_t rdest = bytecode[1];
+    KOS_OBJ_ID     value;
+
+    value = KOS_array_read(ctx, OBJPTR(MODULE, module_obj)->constants, (int)imm.value.uv);
+    if (IS_BAD_PTR(value))
+        KOS_clear_exception(ctx);
+
+    /* Values which are not heap objects are embedded directly in native code */
+    else if (IS_SMALL_INT(value) || IS_SMALL_FLOAT(value)) {
+        emit_mov_imm64(e, X86_RAX, OBJ_ADDR(value));
+        emit_store_reg(e, rdest, X86_RAX);
+        return;
+    }
+
+    emit_mov(e, X86_RDI, X86_R12);
+    emit_mov_imm32(e, X86_RSI, imm.value.uv);
+    emit_call(e, FUNC_ADDR(load_const));
+    emit_check_obj(e, offs);
+    emit_store_reg(e, rdest, X86_RAX);
+}
+
+/* Returns non-zero if the instruction was compiled, zero if it exits to the interpreter */
+static int emit_instr(KOS_JIT_EMITTER *e,
+                      KOS_CONTEXT      ctx,
+                      KOS_OBJ_ID       module_obj,
+                      const uint8_t   *bytecode,
+                      const KOS_INSTR *decoded,
+                      uint32_t         offs,
+                      uint32_t         size,
+                      int             *error)
+{
+    const KOS_BYTECODE_INSTR instr = get_generic_instr((KOS_BYTECODE_INSTR)*bytecode);
+
+    switch (instr) {
+
+        case INSTR_MOVE:
+            emit_load_reg(e, X86_RAX, bytecode[2]);
+            emit_store_reg(e, bytecode[1], X86_RAX);
+            break;
+
+        case INSTR_LOAD_INT8:
+            emit_mov_imm64(e, X86_RAX, OBJ_ADDR(TO_SMALL_INT((int8_t)bytecode[2])));
+            emit_store_reg(e, bytecode[1], X86_RAX);
+            break;
+
+        case INSTR_LOAD_TRUE:
+            /* fall through */
+        case INSTR_LOAD_FALSE:
+            /* fall through */
+        case INSTR_LOAD_VOID:
+            emit_mov_imm64(e, X86_RAX, OBJ_ADDR(instr == INSTR_LOAD_TRUE  ? KOS_TRUE  :
+                                                instr == INSTR_LOAD_FALSE ? KOS_FALSE : KOS_VOID));
+            emit_store_reg(e, bytecode[1], X86_RAX);
+            break;
+
+        case INSTR_LOAD_CONST:
+            emit_load_const(e, ctx, module_obj, bytecode, offs);
+            break;
+
+        case INSTR_ADD:
+            /* fall through */
+        case INSTR_SUB:
+            /* fall through */
+        case INSTR_MUL:
+            /* fall through */
+        case INSTR_DIV:
+            /* fall through */
+        case INSTR_MOD:
+            emit_arith(e, instr, bytecode, decoded, offs);
+            break;
+
+        case INSTR_CMP_EQ:
+            /* fall through */
+        case INSTR_CMP_NE:
+            /* fall through */
+        case INSTR_CMP_LE:
+            /* fall through */
+        case INSTR_CMP_LT:
+            emit_compare(e, instr, bytecode, decoded);
+            break;
+
+        case INSTR_JUMP:
+            /* fall through */
+        case INSTR_JUMP_COND:
+            /* fall through */
+        case INSTR_JUMP_NOT_COND: {
+            const uint32_t target = get_jump_target(instr, bytecode, offs);
+
+            /* Unreachable jumps after tail calls can point past the end of the function */
+            if (target >= size) {
+                emit_exit(e, offs);
+                return 0;
+            }
+
+            *error = emit_jump(e, instr, bytecode, offs, target);
+            break;
+        }
+
+        case INSTR_AND:
+            /* fall through */
+        case INSTR_OR:
+            /* fall through */
+        case INSTR_XOR:
+            emit_bitwise(e, instr, bytecode, decoded, offs);
+            break;
+
+        default: {
+            const KOS_VM_EXEC exec = kos_vm_get_exec(instr);
+
+            if ( ! exec) {
+                emit_exit(e, offs);
+                return 0;
+            }
+
+            emit_exec(e, exec, decoded, offs);
+            break;
+        }
+    }
+
+    return 1;
+}
+
+static int is_back_edge(const uint8_t *bytecode, uint32_t offs, uint32_t size)
+{
+    const KOS_BYTECODE_INSTR instr = (KOS_BYTECODE_INSTR)*bytecode;
+
+    if (instr != INSTR_JUMP && instr != INSTR_JUMP_COND && instr != INSTR_JUMP_NOT_COND)
+        return 0;
+
+    return get_jump_target(instr, bytecode, offs) <= offs && offs < size;
+}
+
+/* Finds instructions from which native code runs long enough to be worth entering */
+static void find_entries(KOS_JIT_CODE *jit, const KOS_BYTECODE *bytecode)
+{
+    const uint32_t size = bytecode->bytecode_size;
+    uint32_t       next = KOS_JIT_NO_ENTRY;
+    uint32_t       run  = 0;
+    uint32_t       offs = size;
+
+    while (offs) {
+        uint32_t native;
+
+        --offs;
+        native = jit->entries[offs];
+
+        if (native) {
+            if (native & KOS_JIT_EXIT_ONLY)
+                run = 0;
+            else if (is_back_edge(&bytecode->bytecode[offs], offs, size))
+                run = KOS_JIT_MIN_RUN;
+            else if (run < KOS_JIT_MIN_RUN)
+                ++run;
+
+            if (run >= KOS_JIT_MIN_RUN)
+                next = offs;
+        }
+
+        jit->next_entry[offs] = next;
+    }
+}
+
+static void free_code(KOS_JIT_CODE *jit)
+{
+    if (jit->code)
+        munmap(jit->code, jit->code_size);
+
+    KOS_free(jit);
+}
+
+static int finalize_code(KOS_JIT_EMITTER *e, KOS_JIT_CODE *jit)
+{
+    const size_t        page_size = KOS_PAGE_SIZE;
+    const KOS_JIT_JUMP *jump      = (const KOS_JIT_JUMP *)e->jumps.buffer;
+    const KOS_JIT_JUMP *end       = (const KOS_JIT_JUMP *)(e->jumps.buffer + e->jumps.size);
+    void               *code;
+
+    for ( ; jump < end; ++jump) {
+        const uint32_t target = jit->entries[jump->target] & ~KOS_JIT_EXIT_ONLY;
+        const uint32_t rel    = target - (jump->code_offs + 4U);
+
+        assert(target);
+        memcpy(e->code.buffer + jump->code_offs, &rel, sizeof(rel));
+    }
+
+    jit->code_size = (e->code.size + page_size - 1U) & ~(page_size - 1U);
+
+    code = mmap(KOS_NULL, jit->code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED)
+        return KOS_ERROR_OUT_OF_MEMORY;
+
+    jit->code = (uint8_t *)code;
+
+    memcpy(code, e->code.buffer, e->code.size);
+
+    if (mprotect(code, jit->code_size, PROT_READ | PROT_EXEC))
+        return KOS_ERROR_OUT_OF_MEMORY;
+
+    return KOS_SUCCESS;
+}
+
+static void publish_code(KOS_CONTEXT ctx, KOS_BYTECODE *bytecode, KOS_JIT_CODE *jit)
+{
+    /* Another thread may have compiled the same function in the meantime */
+    if ( ! KOS_atomic_cas_strong_ptr(bytecode->jit_code, (void *)KOS_NULL, (void *)jit)) {
+        free_code(jit);
+        return;
+    }
+
+    KOS_atomic_add_u32(ctx->inst->jit.num_compiled, 1U);
+}
+
+int kos_jit_compile(KOS_CONTEXT   ctx,
+                    KOS_BYTECODE *bytecode,
+                    KOS_OBJ_ID    module_obj)
+{
+    const uint32_t   size    = bytecode->bytecode_size;
+    const KOS_INSTR *decoded = KOS_DECODED_INSTRS(bytecode);
+    KOS_JIT_CODE    *jit;
+    KOS_JIT_EMITTER  e;
+    uint32_t         offs    = 0;
+    int              error   = KOS_SUCCESS;
+
+    jit = (KOS_JIT_CODE *)KOS_malloc(sizeof(KOS_JIT_CODE) + (size_t)(size * 2U - 1U) * sizeof(uint32_t));
+    if ( ! jit)
+        return KOS_ERROR_OUT_OF_MEMORY;
+
+    jit->code       = KOS_NULL;
+    jit->code_size  = 0;
+    jit->next_entry = &jit->entries[size];
+    memset(&jit->entries[0], 0, (size_t)size * sizeof(uint32_t));
+
+    KOS_vector_init(&e.code);
+    KOS_vector_init(&e.jumps);
+    e.epilogue = 0;
+
+    TRY(KOS_vector_reserve(&e.code, KOS_JIT_MAX_TEMPLATE));
+
+    emit_prologue(&e);
+
+    while (offs < size) {
+        const uint8_t *const instr_ptr  = &bytecode->bytecode[offs];
+        const uint32_t       instr_size = kos_get_instr_size(instr_ptr);
+        const uint32_t       native     = get_pos(&e);
+
+        assert(instr_size);
+        assert(decoded->offs == offs);
+
+        TRY(KOS_vector_reserve(&e.code, e.code.size + KOS_JIT_MAX_TEMPLATE));
+
+        /* Slow paths receive the decoded instruction, which the interpreter
+         * executes and quickens, the native code itself follows bytecode */
+        if (emit_instr(&e, ctx, module_obj, instr_ptr, decoded, offs, size, &error))
+            jit->entries[offs] = native;
+        else
+            jit->entries[offs] = native | KOS_JIT_EXIT_ONLY;
+
+        if (error)
+            goto cleanup;
+
+        assert(get_pos(&e) - native <= KOS_JIT_MAX_TEMPLATE);
+
+        offs += instr_size;
+        ++decoded;
+    }
+
+    assert(offs == size);
+
+    find_entries(jit, bytecode);
+
+    TRY(finalize_code(&e, jit));
+
+    publish_code(ctx, bytecode, jit);
+    jit = KOS_NULL;
+
+cleanup:
+    if (jit)
+        free_code(jit);
+
+    KOS_vector_destroy(&e.jumps);
+    KOS_vector_destroy(&e.code);
+
+    return error;
+}
+
+uint32_t kos_jit_run(KOS_CONTEXT             ctx,
+                     const KOS_BYTECODE     *bytecode,
+                     KOS_ATOMIC(KOS_OBJ_ID) *regs,
+                     uint32_t                offs)
+{
+    const KOS_JIT_CODE *const jit = (const KOS_JIT_CODE *)KOS_atomic_read_acquire_ptr(bytecode->jit_code);
+    KOS_JIT_ENTRY             entry;
+    uint32_t                  native;
+
+    if ( ! jit)
+        return offs;
+
+    assert(offs < bytecode->bytecode_size);
+    native = jit->entries[offs];
+
+    if ( ! native || (native & KOS_JIT_EXIT_ONLY))
+        return offs;
+
+    memcpy(&entry, &jit->code, sizeof(entry));
+
+    offs = entry(ctx, regs, jit->code + native);
+
+    assert(offs < bytecode->bytecode_size);
+    return offs;
+}
+
+uint32_t kos_jit_get_entry(const KOS_BYTECODE *bytecode,
+                           uint32_t            offs)
+{
+    const KOS_JIT_CODE *const jit = (const KOS_JIT_CODE *)KOS_atomic_read_acquire_ptr(bytecode->jit_code);
+
+    if ( ! jit || offs >= bytecode->bytecode_size)
+        return KOS_JIT_NO_ENTRY;
+
+    return jit->next_entry[offs];
+}
+
+void kos_jit_free(KOS_BYTECODE *bytecode)
+{
+    KOS_JIT_CODE *const jit = (KOS_JIT_CODE *)KOS_atomic_read_relaxed_ptr(bytecode->jit_code);
+
+    if (jit) {
+        KOS_atomic_write_relaxed_ptr(bytecode->jit_code, (void *)KOS_NULL);
+
+        free_code(jit);
+    }
+}
+
+#endif
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 Chris Dragan
+ */
+
+#ifndef KOS_JIT_H_INCLUDED
+#define KOS_JIT_H_INCLUDED
+
+#include "../inc/kos_bytecode.h"
+#include "../inc/kos_entity.h"
+#include "kos_config.h"
+#include "kos_object_internal.h"
+
+#ifdef KOS_JIT
+
+/* Compiles function's bytecode to native code and publishes it in bytecode->jit_code.
+ * Returns KOS_SUCCESS if native code is available after the call. */
+int kos_jit_compile(KOS_CONTEXT   ctx,
+                    KOS_BYTECODE *bytecode,
+                    KOS_OBJ_ID    module_obj);
+
+/* Runs native code of a function starting at the specified bytecode offset.
+ * Returns offset of the instruction at which the interpreter must continue,
+ * either because the instruction is not supported by the JIT or because it
+ * raised an exception. */
+uint32_t kos_jit_run(KOS_CONTEXT             ctx,
+                     const KOS_BYTECODE     *bytecode,
+                     KOS_ATOMIC(KOS_OBJ_ID) *regs,
+                     uint32_t                offs);
+
+/* Returns offset of the first instruction at or after the specified offset
+ * at which it is worth entering native code or KOS_JIT_NO_ENTRY. */
+uint32_t kos_jit_get_entry(const KOS_BYTECODE *bytecode,
+                           uint32_t            offs);
+
+#define KOS_JIT_NO_ENTRY 0xFFFFFFFFU
+
+/* Frees native code of a function, called by the GC when the bytecode is freed. */
+void kos_jit_free(KOS_BYTECODE *bytecode);
+
+/* Slow paths for native code, implemented in kos_vm.c.  They execute the
+ * specified decoded instruction exactly like the interpreter, including
+ * quickening and deoptimization of the instruction. */
+KOS_OBJ_ID kos_vm_arith(KOS_CONTEXT      ctx,
+                        const KOS_INSTR *instr,
+                        KOS_OBJ_ID       src1,
+                        KOS_OBJ_ID       src2);
+
+KOS_OBJ_ID kos_vm_compare(KOS_CONTEXT      ctx,
+                          const KOS_INSTR *instr,
+                          KOS_OBJ_ID       src1,
+                          KOS_OBJ_ID       src2);
+
+/* Executes a decoded instruction which does not affect control flow, implemented
+ * in kos_vm.c and shared with the interpreter.  Returns KOS_ERROR_EXCEPTION on failure. */
+typedef int (*KOS_VM_EXEC)(KOS_CONTEXT      ctx,
+                           KOS_STACK_FRAME *stack_frame,
+                           const KOS_INSTR *instr);
+
+/* Returns function which executes the specified instruction or KOS_NULL
+ * if the instruction is handled only by the interpreter. */
+KOS_VM_EXEC kos_vm_get_exec(KOS_BYTECODE_INSTR instr);
+
+#endif
+
+#endif
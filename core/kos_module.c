@@ -20,11 +20,13 @@
 #include "kos_heap.h"
 #include "kos_math.h"
 #include "kos_misc.h"
+#include "kos_module_cache.h"
 #include "kos_object_internal.h"
 #include "kos_parser.h"
 #include "kos_perf.h"
 #include "kos_try.h"
 #include "kos_utf8_internal.h"
+#include "kos_vm.h"
 #include <assert.h>
 #include <errno.h>
 #include <stdio.h>
@@ -396,8 +398,9 @@ static KOS_OBJ_ID alloc_module(KOS_CONTEXT ctx,
     OBJPTR(MODULE, module.o)->inst         = ctx->inst;
     OBJPTR(MODULE, module.o)->constants    = KOS_BADPTR;
     OBJPTR(MODULE, module.o)->global_names = KOS_BADPTR;
-    OBJPTR(MODULE, module.o)->globals      = KOS_BADPTR;
-    OBJPTR(MODULE, module.o)->module_names = KOS_BADPTR;
+    OBJPTR(MODULE, module.o)->globals       = KOS_BADPTR;
+    OBJPTR(MODULE, module.o)->const_globals = KOS_BADPTR;
+    OBJPTR(MODULE, module.o)->module_names  = KOS_BADPTR;
     OBJPTR(MODULE, module.o)->priv         = KOS_BADPTR;
 
     obj.o = KOS_new_object(ctx);
@@ -408,6 +411,10 @@ static KOS_OBJ_ID alloc_module(KOS_CONTEXT ctx,
     TRY_OBJID(obj.o);
     OBJPTR(MODULE, module.o)->globals = obj.o;
 
+    obj.o = KOS_new_object(ctx);
+    TRY_OBJID(obj.o);
+    OBJPTR(MODULE, module.o)->const_globals = obj.o;
+
     obj.o = KOS_new_object(ctx);
     TRY_OBJID(obj.o);
     OBJPTR(MODULE, module.o)->module_names = obj.o;
@@ -531,6 +538,41 @@ cleanup:
     return error;
 }
 
+static int add_global_name(KOS_CONTEXT ctx,
+                           KOS_OBJ_ID  module_obj,
+                           const char *name_str,
+                           unsigned    name_len,
+                           int         global_idx)
+{
+    KOS_OBJ_ID name;
+
+    name = KOS_new_string(ctx, name_str, name_len);
+    if (IS_BAD_PTR(name))
+        return KOS_ERROR_EXCEPTION;
+
+    return KOS_set_property(ctx,
+                            OBJPTR(MODULE, module_obj)->global_names,
+                            name,
+                            TO_SMALL_INT(global_idx));
+}
+
+static int add_const_global(KOS_CONTEXT ctx,
+                            KOS_OBJ_ID  module_obj,
+                            const char *name_str,
+                            unsigned    name_len)
+{
+    KOS_OBJ_ID name;
+
+    name = KOS_new_string(ctx, name_str, name_len);
+    if (IS_BAD_PTR(name))
+        return KOS_ERROR_EXCEPTION;
+
+    return KOS_set_property(ctx,
+                            OBJPTR(MODULE, module_obj)->const_globals,
+                            name,
+                            KOS_TRUE);
+}
+
 static int alloc_globals(KOS_CONTEXT    ctx,
                          KOS_COMP_UNIT *program,
                          KOS_OBJ_ID     module_obj)
@@ -549,16 +591,11 @@ static int alloc_globals(KOS_CONTEXT    ctx,
 
         if (var->type == VAR_GLOBAL) {
 
-            KOS_OBJ_ID name;
-
-            name = KOS_new_string(ctx, var->token->begin, var->token->length);
-            TRY_OBJID(name);
-
             assert(var->array_idx < program->num_globals);
-            TRY(KOS_set_property(ctx,
-                                 OBJPTR(MODULE, module.o)->global_names,
-                                 name,
-                                 TO_SMALL_INT(var->array_idx)));
+            TRY(add_global_name(ctx, module.o, var->token->begin, var->token->length, var->array_idx));
+
+            if (var->is_const)
+                TRY(add_const_global(ctx, module.o, var->token->begin, var->token->length));
         }
     }
 
@@ -567,32 +604,45 @@ cleanup:
     return error;
 }
 
-static int save_direct_modules(KOS_CONTEXT    ctx,
-                               KOS_COMP_UNIT *program,
-                               KOS_OBJ_ID     module_obj)
+static int add_direct_module(KOS_CONTEXT ctx,
+                             KOS_OBJ_ID  module_obj,
+                             const char *name_str,
+                             unsigned    name_len)
 {
-    int                 error  = KOS_SUCCESS;
-    KOS_VAR            *var;
-    KOS_INSTANCE *const inst   = ctx->inst;
-    KOS_LOCAL           module;
+    KOS_OBJ_ID name;
+    KOS_OBJ_ID module_idx_obj;
+    KOS_LOCAL  module;
+    int        error;
 
     KOS_init_local_with(ctx, &module, module_obj);
 
-    for (var = program->modules; var; var = var->next) {
+    name = KOS_new_string(ctx, name_str, name_len);
+    TRY_OBJID(name);
 
-        KOS_OBJ_ID name;
-        KOS_OBJ_ID module_idx_obj;
+    module_idx_obj = KOS_get_property_shallow(ctx, ctx->inst->modules.module_names, name);
+    TRY_OBJID(module_idx_obj);
 
-        name = KOS_new_string(ctx, var->token->begin, var->token->length);
-        TRY_OBJID(name);
+    assert(IS_SMALL_INT(module_idx_obj));
 
-        module_idx_obj = KOS_get_property_shallow(ctx, inst->modules.module_names, name);
-        TRY_OBJID(module_idx_obj);
+    TRY(KOS_set_property(ctx, OBJPTR(MODULE, module.o)->module_names, name, module_idx_obj));
 
-        assert(IS_SMALL_INT(module_idx_obj));
+cleanup:
+    KOS_destroy_top_local(ctx, &module);
+    return error;
+}
 
-        TRY(KOS_set_property(ctx, OBJPTR(MODULE, module.o)->module_names, name, module_idx_obj));
-    }
+static int save_direct_modules(KOS_CONTEXT    ctx,
+                               KOS_COMP_UNIT *program,
+                               KOS_OBJ_ID     module_obj)
+{
+    int       error = KOS_SUCCESS;
+    KOS_VAR  *var;
+    KOS_LOCAL module;
+
+    KOS_init_local_with(ctx, &module, module_obj);
+
+    for (var = program->modules; var; var = var->next)
+        TRY(add_direct_module(ctx, module.o, var->token->begin, var->token->length));
 
 cleanup:
     KOS_destroy_top_local(ctx, &module);
@@ -601,7 +651,7 @@ cleanup:
 
 typedef struct KOS_PRINT_CONST_COOKIE_S {
     KOS_CONTEXT ctx;
-    KOS_OBJ_ID  constants;
+    KOS_LOCAL   constants; /* Converting constants to strings can trigger GC */
 } KOS_PRINT_CONST_COOKIE;
 
 static int print_const(void       *cookie,
@@ -612,7 +662,7 @@ static int print_const(void       *cookie,
     KOS_OBJ_ID              constant;
     int                     error;
 
-    constant = KOS_array_read(data->ctx, data->constants, const_index);
+    constant = KOS_array_read(data->ctx, data->constants.o, const_index);
 
     if (IS_BAD_PTR(constant)) {
         KOS_clear_exception(data->ctx);
@@ -675,6 +725,7 @@ static int disassemble_func(KOS_CONTEXT ctx, KOS_OBJ_ID func_obj)
                 "==============================================================================";
 
     KOS_init_local_with(ctx, &func, func_obj);
+    KOS_init_local(ctx, &print_cookie.constants);
     KOS_vector_init(&module_path_cstr);
     KOS_vector_init(&module_name_cstr);
     KOS_vector_init(&func_name_cstr);
@@ -737,8 +788,8 @@ static int disassemble_func(KOS_CONTEXT ctx, KOS_OBJ_ID func_obj)
     print_regs(OBJPTR(FUNCTION, func.o)->opts.this_reg, 1, "this reg");
     print_regs(OBJPTR(FUNCTION, func.o)->opts.bind_reg, OBJPTR(FUNCTION, func.o)->opts.num_binds, "binds regs");
 
-    print_cookie.ctx       = ctx;
-    print_cookie.constants = OBJPTR(MODULE, module)->constants;
+    print_cookie.ctx         = ctx;
+    print_cookie.constants.o = OBJPTR(MODULE, module)->constants;
 
     TRY(kos_disassemble(filename,
                         bytecode->bytecode,
@@ -753,11 +804,46 @@ cleanup:
     KOS_vector_destroy(&func_name_cstr);
     KOS_vector_destroy(&module_name_cstr);
     KOS_vector_destroy(&module_path_cstr);
-    KOS_destroy_top_local(ctx, &func);
+    KOS_destroy_top_locals(ctx, &print_cookie.constants, &func);
 
     return error;
 }
 
+/* Returns number of instructions to decode and sets number of property caches */
+static uint32_t count_instrs(const uint8_t *bytecode,
+                             uint32_t       bytecode_size,
+                             uint32_t      *num_caches)
+{
+    const uint8_t *const end       = bytecode + bytecode_size;
+    uint32_t             num_instr = 0;
+    uint32_t             num_sites = 0;
+    uint32_t             num;
+
+    while (bytecode < end) {
+        const KOS_BYTECODE_INSTR instr = (KOS_BYTECODE_INSTR)*bytecode;
+
+        /* Decoding stops at invalid instruction, the end marker takes its place
+         * and it is detected when executed */
+        if ((instr < INSTR_BREAKPOINT) || (instr >= INSTR_LAST_OPCODE))
+            break;
+
+        if ((instr == INSTR_GET_PROP8) || (instr == INSTR_GET_PROP8_OPT) || (instr == INSTR_SET_PROP8))
+            ++num_sites;
+
+        ++num_instr;
+
+        bytecode += kos_get_instr_size(bytecode);
+    }
+
+    /* Caches are assigned to instructions sequentially by the decoder.
+     * There is always at least one cache, so the interpreter never has to check. */
+    for (num = 1; num < num_sites; num <<= 1);
+
+    *num_caches = KOS_min(num, (uint32_t)KOS_MAX_PROP_CACHES);
+
+    return num_instr;
+}
+
 KOS_OBJ_ID kos_alloc_bytecode(KOS_CONTEXT ctx,
                               const void *bytecode,
                               uint32_t    bytecode_size,
@@ -766,11 +852,16 @@ KOS_OBJ_ID kos_alloc_bytecode(KOS_CONTEXT ctx,
 {
     const uint32_t aligned_bytecode_size = KOS_align_up(bytecode_size,
                                                         (uint32_t)sizeof(struct KOS_COMP_ADDR_TO_LINE_S));
-    const uint32_t total_size = aligned_bytecode_size + addr2line_size;
+    uint32_t       num_caches;
+    const uint32_t num_instr = count_instrs((const uint8_t *)bytecode, bytecode_size, &num_caches);
+    const uint32_t caches_size = num_caches * (uint32_t)sizeof(KOS_PROP_CACHE);
+    const uint32_t decoded_offs = aligned_bytecode_size + addr2line_size + caches_size;
+    const uint32_t decoded_size = (num_instr + 1U) * (uint32_t)sizeof(KOS_INSTR);
+    const uint32_t total_size = decoded_offs + decoded_size;
     const uint32_t alloc_size = (uint32_t)sizeof(KOS_BYTECODE) + total_size - 1;
 
     KOS_BYTECODE *const bytecode_obj = (KOS_BYTECODE *)
-        kos_alloc_object(ctx, KOS_ALLOC_IMMOVABLE, OBJ_OPAQUE, alloc_size);
+        kos_alloc_object(ctx, KOS_ALLOC_BYTECODE, OBJ_OPAQUE, alloc_size);
 
     if (bytecode_obj) {
         bytecode_obj->bytecode_size    = bytecode_size;
@@ -778,51 +869,84 @@ KOS_OBJ_ID kos_alloc_bytecode(KOS_CONTEXT ctx,
         bytecode_obj->addr2line_size   = addr2line_size;
         bytecode_obj->def_line         = 0;
         bytecode_obj->num_instr        = 0;
+        bytecode_obj->prop_cache_offs  = aligned_bytecode_size + addr2line_size;
+        bytecode_obj->prop_cache_mask  = num_caches - 1U;
+        bytecode_obj->decoded_offs     = decoded_offs;
+        bytecode_obj->num_decoded      = num_instr;
+
+        assert( ! ((uintptr_t)&bytecode_obj->bytecode[bytecode_obj->prop_cache_offs] & (sizeof(KOS_OBJ_ID) - 1U)));
+        assert( ! ((uintptr_t)&bytecode_obj->bytecode[decoded_offs] & (sizeof(KOS_OBJ_ID) - 1U)));
+
+        KOS_atomic_write_relaxed_u32(bytecode_obj->num_deopts, 0U);
+        KOS_atomic_write_relaxed_u32(bytecode_obj->jit_counter, 0U);
+        KOS_atomic_write_relaxed_ptr(bytecode_obj->jit_code, (void *)KOS_NULL);
 
         memcpy(bytecode_obj->bytecode, bytecode, bytecode_size);
 
         if (addr2line_size)
             memcpy(&bytecode_obj->bytecode[aligned_bytecode_size], addr2line, addr2line_size);
+
+        memset(&bytecode_obj->bytecode[bytecode_obj->prop_cache_offs], 0, caches_size);
+
+        kos_vm_decode(bytecode_obj);
     }
 
     return OBJID(OPAQUE, (KOS_OPAQUE *)bytecode_obj);
 }
 
-static KOS_OBJ_ID alloc_bytecode(KOS_CONTEXT        ctx,
-                                 KOS_COMP_UNIT     *program,
-                                 KOS_COMP_FUNCTION *func_const)
+static KOS_OBJ_ID alloc_bytecode(KOS_CONTEXT              ctx,
+                                 const uint8_t           *code,
+                                 const uint8_t           *addr2line,
+                                 const KOS_COMP_FUNCTION *func_const)
 {
-    assert(func_const->bytecode_offset + func_const->bytecode_size <= program->code_buf.size);
-    if (func_const->addr2line_size) {
-        assert(func_const->addr2line_offset + func_const->addr2line_size <= program->addr2line_buf.size);
-    }
-
     return kos_alloc_bytecode(ctx,
-                              &program->code_buf.buffer[func_const->bytecode_offset],
+                              &code[func_const->bytecode_offset],
                               func_const->bytecode_size,
-                              &program->addr2line_buf.buffer[func_const->addr2line_offset],
+                              &addr2line[func_const->addr2line_offset],
                               func_const->addr2line_size);
 }
 
-static uint32_t count_constants(KOS_COMP_UNIT *program)
+static uint32_t count_constants(const KOS_COMP_CONST *constant)
 {
     uint32_t i;
 
-    KOS_COMP_CONST *str = program->first_constant;
-
-    for (i = 0; str; str = str->next, ++i);
+    for (i = 0; constant; constant = constant->next, ++i);
 
     return i;
 }
 
-static int alloc_constants(KOS_CONTEXT    ctx,
-                           KOS_COMP_UNIT *program,
-                           KOS_OBJ_ID     module_obj)
+static KOS_OBJ_ID get_template_value(KOS_CONTEXT ctx,
+                                     KOS_OBJ_ID  module_obj,
+                                     uint32_t    value)
+{
+    switch (value) {
+
+        case KOS_COMP_TEMPLATE_VOID:
+            return KOS_VOID;
+
+        case KOS_COMP_TEMPLATE_FALSE:
+            return KOS_FALSE;
+
+        case KOS_COMP_TEMPLATE_TRUE:
+            return KOS_TRUE;
+
+        default:
+            return KOS_array_read(ctx, OBJPTR(MODULE, module_obj)->constants, (int)value);
+    }
+}
+
+/* Creates constant objects, code and addr2line point to buffers at which
+ * bytecode_offset and addr2line_offset of function constants are based. */
+static int alloc_constants(KOS_CONTEXT     ctx,
+                           KOS_COMP_CONST *first_constant,
+                           const uint8_t  *code,
+                           const uint8_t  *addr2line,
+                           KOS_OBJ_ID      module_obj)
 {
     int             error         = KOS_SUCCESS;
-    const uint32_t  num_constants = count_constants(program);
+    const uint32_t  num_constants = count_constants(first_constant);
     uint32_t        base_idx      = 0;
-    KOS_COMP_CONST *constant      = program->first_constant;
+    KOS_COMP_CONST *constant      = first_constant;
     KOS_LOCAL       module;
     KOS_LOCAL       obj;
     int             i;
@@ -873,6 +997,69 @@ static int alloc_constants(KOS_CONTEXT    ctx,
             case KOS_COMP_CONST_PROTOTYPE:
                 obj.o = KOS_new_object(ctx);
                 break;
+
+            case KOS_COMP_CONST_SWITCH: {
+                const KOS_COMP_SWITCH *const switch_const = (const KOS_COMP_SWITCH *)constant;
+                uint32_t                     i_case       = switch_const->num_cases;
+
+                obj.o = KOS_new_object_with_prototype(ctx, KOS_VOID);
+                TRY_OBJID(obj.o);
+
+                /* Process cases backwards, so that the first of duplicate cases wins */
+                while (i_case--) {
+                    const uint32_t   str_idx = switch_const->case_str_idx[i_case];
+                    const KOS_OBJ_ID key     = KOS_array_read(ctx,
+                                                              OBJPTR(MODULE, module.o)->constants,
+                                                              (int)str_idx);
+                    TRY_OBJID(key);
+                    assert(GET_OBJ_TYPE(key) == OBJ_STRING);
+
+                    TRY(KOS_set_property(ctx, obj.o, key, TO_SMALL_INT((int)i_case + 1)));
+                }
+                break;
+            }
+
+            case KOS_COMP_CONST_OBJ_TEMPLATE: {
+                const KOS_COMP_TEMPLATE *const templ = (const KOS_COMP_TEMPLATE *)constant;
+                uint32_t                       i_item;
+
+                obj.o = KOS_new_object(ctx);
+                TRY_OBJID(obj.o);
+
+                /* Properties are added in the order of the object literal,
+                 * so the template has the same shape as an object created without it */
+                for (i_item = 0; i_item < templ->num_items; i_item += 2) {
+                    const KOS_OBJ_ID key = KOS_array_read(ctx,
+                                                          OBJPTR(MODULE, module.o)->constants,
+                                                          (int)templ->items[i_item]);
+                    KOS_OBJ_ID       value;
+
+                    TRY_OBJID(key);
+                    assert(GET_OBJ_TYPE(key) == OBJ_STRING);
+
+                    value = get_template_value(ctx, module.o, templ->items[i_item + 1]);
+                    TRY_OBJID(value);
+
+                    TRY(KOS_set_property(ctx, obj.o, key, value));
+                }
+                break;
+            }
+
+            case KOS_COMP_CONST_ARRAY_TEMPLATE: {
+                const KOS_COMP_TEMPLATE *const templ = (const KOS_COMP_TEMPLATE *)constant;
+                uint32_t                       i_item;
+
+                obj.o = KOS_new_array(ctx, templ->num_items);
+                TRY_OBJID(obj.o);
+
+                for (i_item = 0; i_item < templ->num_items; i_item++) {
+                    const KOS_OBJ_ID value = get_template_value(ctx, module.o, templ->items[i_item]);
+                    TRY_OBJID(value);
+
+                    TRY(KOS_array_write(ctx, obj.o, (int)i_item, value));
+                }
+                break;
+            }
         }
 
         TRY_OBJID(obj.o);
@@ -880,7 +1067,7 @@ static int alloc_constants(KOS_CONTEXT    ctx,
         TRY(KOS_array_write(ctx, OBJPTR(MODULE, module.o)->constants, base_idx + i, obj.o));
     }
 
-    for (i = 0, constant = program->first_constant; constant; constant = constant->next, ++i) {
+    for (i = 0, constant = first_constant; constant; constant = constant->next, ++i) {
 
         KOS_COMP_FUNCTION *func_const;
         KOS_OBJ_ID         name;
@@ -923,7 +1110,7 @@ static int alloc_constants(KOS_CONTEXT    ctx,
         OBJPTR(FUNCTION, obj.o)->module            = module.o;
 
         {
-            const KOS_OBJ_ID bytecode = alloc_bytecode(ctx, program, func_const);
+            const KOS_OBJ_ID bytecode = alloc_bytecode(ctx, code, addr2line, func_const);
             TRY_OBJID(bytecode);
             OBJPTR(FUNCTION, obj.o)->bytecode = bytecode;
 
@@ -964,8 +1151,26 @@ static int alloc_constants(KOS_CONTEXT    ctx,
         TRY(KOS_array_write(ctx, OBJPTR(MODULE, module.o)->constants, base_idx + i, obj.o));
     }
 
+    /* Functions are referenced by constant operands, so constant operands
+     * of decoded instructions are resolved only after all constants exist */
+    for (i = 0, constant = first_constant; constant; constant = constant->next, ++i) {
+
+        KOS_OBJ_ID bytecode;
+
+        if (constant->type != KOS_COMP_CONST_FUNCTION)
+            continue;
+
+        obj.o = KOS_array_read(ctx, OBJPTR(MODULE, module.o)->constants, base_idx + i);
+        TRY_OBJID(obj.o);
+
+        bytecode = OBJPTR(FUNCTION, obj.o)->bytecode;
+
+        kos_vm_resolve_constants((KOS_BYTECODE *)OBJPTR(OPAQUE, bytecode),
+                                 OBJPTR(MODULE, module.o)->constants);
+    }
+
     if (ctx->inst->flags & KOS_INST_DISASM) {
-        for (i = 0, constant = program->first_constant; constant; constant = constant->next, ++i) {
+        for (i = 0, constant = first_constant; constant; constant = constant->next, ++i) {
 
             if (constant->type != KOS_COMP_CONST_FUNCTION)
                 continue;
@@ -1067,8 +1272,17 @@ struct KOS_COMP_CTX {
     KOS_LOCAL   module;
     const char *data;
     unsigned    data_size;
+    KOS_VECTOR *imports;     /* Imported modules recorded for module cache or NULL */
+    uint32_t    num_imports;
 };
 
+/* Location and key of compiled module in module cache */
+typedef struct KOS_CACHE_ENTRY_S {
+    KOS_MODULE_CACHE_KEY key;
+    KOS_VECTOR           module_path; /* Absolute path to module source file */
+    KOS_VECTOR           cache_path;  /* Path to cache file                  */
+} KOS_CACHE_ENTRY;
+
 enum KOS_ERROR_OR_WARNING {
     KOS_WARNING,
     KOS_ERROR
@@ -1142,6 +1356,81 @@ cleanup:
     return ret;
 }
 
+/* Retrieves value of a global, which the compiler can fold into modules which
+ * import it.  Returns KOS_ERROR_NOT_FOUND if the global can change or if its
+ * value cannot be represented as a literal. */
+static int get_global_const(KOS_CONTEXT            ctx,
+                            KOS_OBJ_ID             module_obj,
+                            KOS_OBJ_ID             name_obj,
+                            int                    global_idx,
+                            KOS_VECTOR            *str_buf,
+                            KOS_COMP_GLOBAL_CONST *value)
+{
+    KOS_MODULE *const module = OBJPTR(MODULE, module_obj);
+    KOS_OBJ_ID        obj_id;
+
+    if (IS_BAD_PTR(module->const_globals))
+        return KOS_ERROR_NOT_FOUND;
+
+    obj_id = KOS_get_property_shallow(ctx, module->const_globals, name_obj);
+    if (IS_BAD_PTR(obj_id)) {
+        KOS_clear_exception(ctx);
+        return KOS_ERROR_NOT_FOUND;
+    }
+
+    obj_id = KOS_array_read(ctx, module->globals, global_idx);
+    if (IS_BAD_PTR(obj_id))
+        return KOS_ERROR_EXCEPTION;
+
+    memset(value, 0, sizeof(*value));
+
+    switch (GET_OBJ_TYPE(obj_id)) {
+
+        case OBJ_SMALL_INTEGER:
+            value->type      = NT_NUMERIC_LITERAL;
+            value->int_value = GET_SMALL_INT(obj_id);
+            break;
+
+        case OBJ_INTEGER:
+            value->type      = NT_NUMERIC_LITERAL;
+            value->int_value = OBJPTR(INTEGER, obj_id)->value;
+            break;
+
+        case OBJ_FLOAT:
+            value->type        = NT_NUMERIC_LITERAL;
+            value->is_float    = 1;
+            value->float_value = KOS_get_float(obj_id);
+            break;
+
+        case OBJ_BOOLEAN:
+            value->type      = NT_BOOL_LITERAL;
+            value->int_value = KOS_get_bool(obj_id);
+            break;
+
+        case OBJ_VOID:
+            value->type = NT_VOID_LITERAL;
+            break;
+
+        case OBJ_STRING:
+            if (KOS_string_to_cstr_vec(ctx, obj_id, str_buf))
+                return KOS_ERROR_EXCEPTION;
+
+            /* The compiler would interpret backslashes as escape sequences */
+            if (str_buf->size - 1U > 0xFFFDU || memchr(str_buf->buffer, '\\', str_buf->size - 1U))
+                return KOS_ERROR_NOT_FOUND;
+
+            value->type    = NT_STRING_LITERAL;
+            value->str     = str_buf->buffer;
+            value->str_len = (uint16_t)(str_buf->size - 1U);
+            break;
+
+        default:
+            return KOS_ERROR_NOT_FOUND;
+    }
+
+    return KOS_SUCCESS;
+}
+
 int kos_comp_resolve_global(void                          *vframe,
                             int                            module_idx,
                             const char                    *name,
@@ -1149,16 +1438,19 @@ int kos_comp_resolve_global(void                          *vframe,
                             KOS_COMP_WALK_GLOBALS_CALLBACK callback,
                             void                          *cookie)
 {
-    KOS_LOCAL            str;
-    struct KOS_COMP_CTX *comp_ctx = (struct KOS_COMP_CTX *)vframe;
-    KOS_CONTEXT          ctx      = comp_ctx->ctx;
-    KOS_INSTANCE        *inst     = ctx->inst;
-    KOS_OBJ_ID           module_obj;
-    KOS_OBJ_ID           glob_idx_obj;
-    int                  error    = KOS_SUCCESS;
+    KOS_LOCAL             str;
+    struct KOS_COMP_CTX  *comp_ctx = (struct KOS_COMP_CTX *)vframe;
+    KOS_CONTEXT           ctx      = comp_ctx->ctx;
+    KOS_INSTANCE         *inst     = ctx->inst;
+    KOS_OBJ_ID            module_obj;
+    KOS_OBJ_ID            glob_idx_obj;
+    KOS_VECTOR            str_buf;
+    KOS_COMP_GLOBAL_CONST value;
+    int                   error    = KOS_SUCCESS;
 
     assert(module_idx >= 0);
 
+    KOS_vector_init(&str_buf);
     KOS_init_local(ctx, &str);
 
     str.o = KOS_new_const_ascii_string(ctx, name, length);
@@ -1174,14 +1466,20 @@ int kos_comp_resolve_global(void                          *vframe,
 
     assert(IS_SMALL_INT(glob_idx_obj));
 
+    error = get_global_const(ctx, module_obj, str.o, (int)GET_SMALL_INT(glob_idx_obj), &str_buf, &value);
+    if (error && (error != KOS_ERROR_NOT_FOUND))
+        goto cleanup;
+
     TRY(callback(name,
                  length,
                  module_idx,
                  (int)GET_SMALL_INT(glob_idx_obj),
+                 error ? KOS_NULL : &value,
                  cookie));
 
 cleanup:
     KOS_destroy_top_local(ctx, &str);
+    KOS_vector_destroy(&str_buf);
 
     if (error == KOS_ERROR_EXCEPTION) {
         error = (KOS_get_exception(ctx) == KOS_STR_OUT_OF_MEMORY) ? KOS_ERROR_OUT_OF_MEMORY : KOS_ERROR_NOT_FOUND;
@@ -1196,15 +1494,18 @@ int kos_comp_walk_globals(void                          *vframe,
                           KOS_COMP_WALK_GLOBALS_CALLBACK callback,
                           void                          *cookie)
 {
-    struct KOS_COMP_CTX *comp_ctx = (struct KOS_COMP_CTX *)vframe;
-    KOS_CONTEXT          ctx      = comp_ctx->ctx;
-    KOS_INSTANCE *const  inst     = ctx->inst;
-    KOS_VECTOR           name;
-    KOS_LOCAL            walk;
-    KOS_OBJ_ID           module_obj;
-    int                  error    = KOS_SUCCESS;
+    struct KOS_COMP_CTX  *comp_ctx = (struct KOS_COMP_CTX *)vframe;
+    KOS_CONTEXT           ctx      = comp_ctx->ctx;
+    KOS_INSTANCE *const   inst     = ctx->inst;
+    KOS_VECTOR            name;
+    KOS_VECTOR            str_buf;
+    KOS_LOCAL             walk;
+    KOS_OBJ_ID            module_obj;
+    KOS_COMP_GLOBAL_CONST value;
+    int                   error    = KOS_SUCCESS;
 
     KOS_vector_init(&name);
+    KOS_vector_init(&str_buf);
 
     KOS_init_local(ctx, &walk);
 
@@ -1218,19 +1519,28 @@ int kos_comp_walk_globals(void                          *vframe,
 
     while ( ! kos_object_walk(ctx, walk.o)) {
 
+        int global_idx;
+
         assert(IS_SMALL_INT(KOS_get_walk_value(walk.o)));
+        global_idx = (int)GET_SMALL_INT(KOS_get_walk_value(walk.o));
 
         TRY(KOS_string_to_cstr_vec(ctx, KOS_get_walk_key(walk.o), &name));
 
+        error = get_global_const(ctx, module_obj, KOS_get_walk_key(walk.o), global_idx, &str_buf, &value);
+        if (error && (error != KOS_ERROR_NOT_FOUND))
+            goto cleanup;
+
         TRY(callback(name.buffer,
                      (uint16_t)name.size - 1U,
                      module_idx,
-                     (int)GET_SMALL_INT(KOS_get_walk_value(walk.o)),
+                     global_idx,
+                     error ? KOS_NULL : &value,
                      cookie));
     }
 
 cleanup:
     KOS_destroy_top_local(ctx, &walk);
+    KOS_vector_destroy(&str_buf);
     KOS_vector_destroy(&name);
 
     if (error == KOS_ERROR_EXCEPTION) {
@@ -1361,12 +1671,13 @@ cleanup:
     KOS_vector_destroy(&cstr);
 }
 
-static int compile_module(KOS_CONTEXT ctx,
-                          KOS_OBJ_ID  module_obj,
-                          uint16_t    module_idx,
-                          const char *data,
-                          unsigned    data_size,
-                          unsigned    flags)
+static int compile_module(KOS_CONTEXT            ctx,
+                          KOS_OBJ_ID             module_obj,
+                          uint16_t               module_idx,
+                          const char            *data,
+                          unsigned               data_size,
+                          unsigned               flags,
+                          const KOS_CACHE_ENTRY *cache)
 {
     PROF_ZONE(MODULE)
 
@@ -1378,16 +1689,21 @@ static int compile_module(KOS_CONTEXT ctx,
     KOS_PARSER          parser;
     KOS_COMP_UNIT       program;
     struct KOS_COMP_CTX comp_ctx;
+    KOS_VECTOR          imports;
     int                 error             = KOS_SUCCESS;
     unsigned            num_opt_passes    = 0;
 
     time_0 = KOS_get_time_us();
 
+    KOS_vector_init(&imports);
+
     KOS_init_local_with(ctx, &comp_ctx.module, module_obj);
 
-    comp_ctx.ctx       = ctx;
-    comp_ctx.data      = data;
-    comp_ctx.data_size = data_size;
+    comp_ctx.ctx         = ctx;
+    comp_ctx.data        = data;
+    comp_ctx.data_size   = data_size;
+    comp_ctx.imports     = cache ? &imports : KOS_NULL;
+    comp_ctx.num_imports = 0;
 
     /* Initialize parser and compiler */
     kos_compiler_init(&program, module_idx);
@@ -1433,6 +1749,7 @@ static int compile_module(KOS_CONTEXT ctx,
     /* Prepare compiler */
     program.ctx            = &comp_ctx;
     program.is_interactive = (flags & KOS_RUN_INTERACTIVE) ? 1 : 0;
+    program.inline_funcs   = (inst->flags & KOS_INST_NO_INLINE) ? 0 : 1;
     TRY(predefine_globals(ctx,
                           &program,
                           OBJPTR(MODULE, comp_ctx.module.o)->global_names,
@@ -1475,7 +1792,11 @@ static int compile_module(KOS_CONTEXT ctx,
     }
 
     TRY(alloc_globals(ctx, &program, comp_ctx.module.o));
-    TRY(alloc_constants(ctx, &program, comp_ctx.module.o));
+    TRY(alloc_constants(ctx,
+                        program.first_constant,
+                        (const uint8_t *)program.code_buf.buffer,
+                        (const uint8_t *)program.addr2line_buf.buffer,
+                        comp_ctx.module.o));
     TRY(save_direct_modules(ctx, &program, comp_ctx.module.o));
 
     {
@@ -1489,9 +1810,23 @@ static int compile_module(KOS_CONTEXT ctx,
         OBJPTR(MODULE, comp_ctx.module.o)->main_idx = frame->constant->header.index;
     }
 
+    /* Store compiled module in cache, failure to write the cache is not an error */
+    if (cache) {
+        const int cache_error = kos_module_cache_write(cache->cache_path.buffer,
+                                                       &cache->key,
+                                                       &imports,
+                                                       comp_ctx.num_imports,
+                                                       &program,
+                                                       OBJPTR(MODULE, comp_ctx.module.o)->main_idx);
+
+        if (cache_error && (inst->flags & KOS_INST_VERBOSE))
+            printf("Kos failed to write module cache %s\n", cache->cache_path.buffer);
+    }
+
 cleanup:
     kos_parser_destroy(&parser);
     kos_compiler_destroy(&program);
+    KOS_vector_destroy(&imports);
     KOS_destroy_top_local(ctx, &comp_ctx.module);
     return error;
 }
@@ -1571,6 +1906,277 @@ static void handle_interpreter_error(KOS_CONTEXT ctx, int error)
     }
 }
 
+static int import_and_run_module(KOS_CONTEXT ctx,
+                                 const char *name,
+                                 uint16_t    name_len,
+                                 int        *module_idx)
+{
+    KOS_OBJ_ID module_obj;
+    int        already_loaded = 0;
+
+    assert(module_idx);
+
+    module_obj = import_module(ctx, name, name_len, 0, KOS_NULL, 0, &already_loaded, module_idx);
+
+    if (IS_BAD_PTR(module_obj)) {
+        assert(KOS_is_exception_pending(ctx));
+        return KOS_ERROR_EXCEPTION;
+    }
+
+    if ( ! already_loaded) {
+        const KOS_OBJ_ID ret = KOS_run_module(ctx, module_obj);
+
+        if (IS_BAD_PTR(ret)) {
+            assert(KOS_is_exception_pending(ctx));
+            return KOS_ERROR_EXCEPTION;
+        }
+    }
+
+    return KOS_SUCCESS;
+}
+
+/* Hashes names and indices of globals or modules, independent of their order */
+static int hash_names(KOS_CONTEXT ctx,
+                      KOS_OBJ_ID  names_obj,
+                      uint64_t   *out_hash)
+{
+    KOS_VECTOR name;
+    KOS_LOCAL  walk;
+    uint64_t   hash  = 0;
+    int        error = KOS_SUCCESS;
+
+    KOS_vector_init(&name);
+
+    KOS_init_local(ctx, &walk);
+
+    walk.o = kos_new_object_walk(ctx, names_obj, KOS_SHALLOW);
+    TRY_OBJID(walk.o);
+
+    while ( ! kos_object_walk(ctx, walk.o)) {
+
+        uint32_t idx;
+
+        assert(IS_SMALL_INT(KOS_get_walk_value(walk.o)));
+        idx = (uint32_t)GET_SMALL_INT(KOS_get_walk_value(walk.o));
+
+        TRY(KOS_string_to_cstr_vec(ctx, KOS_get_walk_key(walk.o), &name));
+
+        hash += kos_module_cache_hash(kos_module_cache_hash(KOS_MODULE_CACHE_HASH_INIT, name.buffer, name.size),
+                                      &idx, sizeof(idx));
+    }
+
+    *out_hash = hash;
+
+cleanup:
+    KOS_destroy_top_local(ctx, &walk);
+    KOS_vector_destroy(&name);
+
+    return error;
+}
+
+static int hash_module_globals(KOS_CONTEXT ctx,
+                               int         module_idx,
+                               uint64_t   *out_hash)
+{
+    const KOS_OBJ_ID module_obj = KOS_array_read(ctx, ctx->inst->modules.modules, module_idx);
+    KOS_VECTOR       str_buf;
+    KOS_LOCAL        walk;
+    int              error;
+
+    if (IS_BAD_PTR(module_obj))
+        return KOS_ERROR_EXCEPTION;
+
+    KOS_vector_init(&str_buf);
+    KOS_init_local(ctx, &walk);
+
+    assert(GET_OBJ_TYPE(module_obj) == OBJ_MODULE);
+
+    TRY(hash_names(ctx, OBJPTR(MODULE, module_obj)->global_names, out_hash));
+
+    /* Values of constants are folded into modules which import them */
+    if ( ! IS_BAD_PTR(OBJPTR(MODULE, module_obj)->const_globals)) {
+
+        walk.o = kos_new_object_walk(ctx, OBJPTR(MODULE, module_obj)->const_globals, KOS_SHALLOW);
+        TRY_OBJID(walk.o);
+
+        while ( ! kos_object_walk(ctx, walk.o)) {
+
+            KOS_COMP_GLOBAL_CONST value;
+            KOS_OBJ_ID            idx_obj;
+            uint64_t              hash;
+
+            idx_obj = KOS_get_property_shallow(ctx, OBJPTR(MODULE, module_obj)->global_names,
+                                               KOS_get_walk_key(walk.o));
+            TRY_OBJID(idx_obj);
+            assert(IS_SMALL_INT(idx_obj));
+
+            error = get_global_const(ctx, module_obj, KOS_get_walk_key(walk.o),
+                                     (int)GET_SMALL_INT(idx_obj), &str_buf, &value);
+            if (error == KOS_ERROR_NOT_FOUND) {
+                error = KOS_SUCCESS;
+                continue;
+            }
+            if (error)
+                goto cleanup;
+
+            hash = kos_module_cache_hash(KOS_MODULE_CACHE_HASH_INIT, &value.type, sizeof(value.type));
+            hash = kos_module_cache_hash(hash, &idx_obj, sizeof(idx_obj));
+            if (value.type == NT_STRING_LITERAL)
+                hash = kos_module_cache_hash(hash, value.str, value.str_len);
+            else {
+                hash = kos_module_cache_hash(hash, &value.int_value,   sizeof(value.int_value));
+                hash = kos_module_cache_hash(hash, &value.float_value, sizeof(value.float_value));
+            }
+
+            *out_hash += hash;
+        }
+    }
+
+cleanup:
+    KOS_destroy_top_local(ctx, &walk);
+    KOS_vector_destroy(&str_buf);
+
+    return error;
+}
+
+/* Determines location of module in module cache and the key which the cached
+ * module must match.  Returns KOS_ERROR_NOT_FOUND if the cache cannot be used. */
+static int get_cache_entry(KOS_CONTEXT      ctx,
+                           KOS_OBJ_ID       module_obj,
+                           int              module_idx,
+                           KOS_OBJ_ID       module_path,
+                           const char      *data,
+                           unsigned         data_size,
+                           KOS_CACHE_ENTRY *cache)
+{
+    const char *const cache_dir = ctx->inst->modules.cache_dir;
+    KOS_LOCAL         module;
+    KOS_VECTOR        name;
+    uint64_t          path_hash;
+    uint64_t          modules_hash = 0;
+    const uint8_t     is_base      = module_idx == KOS_BASE_MODULE_IDX;
+    const uint8_t     no_inline    = (ctx->inst->flags & KOS_INST_NO_INLINE) ? 1 : 0;
+    int               error;
+
+    assert(cache_dir);
+
+    KOS_vector_init(&name);
+    KOS_init_local_with(ctx, &module, module_obj);
+
+    TRY(KOS_string_to_cstr_vec(ctx, module_path, &cache->module_path));
+
+    if (KOS_get_absolute_path(&cache->module_path))
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    TRY(KOS_string_to_cstr_vec(ctx, OBJPTR(MODULE, module.o)->name, &name));
+
+    path_hash = kos_module_cache_hash(KOS_MODULE_CACHE_HASH_INIT,
+                                      cache->module_path.buffer,
+                                      cache->module_path.size - 1);
+
+    TRY(KOS_vector_resize(&cache->cache_path, strlen(cache_dir) + name.size + 32));
+    snprintf(cache->cache_path.buffer, cache->cache_path.size,
+             "%s" KOS_PATH_SEPARATOR_STR "%s-%08x%08x" KOS_MODULE_CACHE_EXT,
+             cache_dir, name.buffer, (unsigned)(uint32_t)(path_hash >> 32), (unsigned)(uint32_t)path_hash);
+
+    cache->key.module_path     = cache->module_path.buffer;
+    cache->key.module_path_len = (uint32_t)cache->module_path.size - 1U;
+    cache->key.source_size     = data_size;
+    cache->key.source_hash     = kos_module_cache_hash(KOS_MODULE_CACHE_HASH_INIT, data, data_size);
+
+    /* Compiled code depends on globals and modules predefined by built-in module initialization */
+    TRY(hash_names(ctx, OBJPTR(MODULE, module.o)->global_names, &cache->key.env_hash));
+    TRY(hash_names(ctx, OBJPTR(MODULE, module.o)->module_names, &modules_hash));
+    cache->key.env_hash = kos_module_cache_hash(cache->key.env_hash, &modules_hash, sizeof(modules_hash));
+    cache->key.env_hash = kos_module_cache_hash(cache->key.env_hash, &is_base, sizeof(is_base));
+
+    /* Compiled code also depends on compiler options */
+    cache->key.env_hash = kos_module_cache_hash(cache->key.env_hash, &no_inline, sizeof(no_inline));
+
+cleanup:
+    KOS_destroy_top_local(ctx, &module);
+    KOS_vector_destroy(&name);
+
+    return error;
+}
+
+/* Loads compiled module from module cache.  Returns KOS_ERROR_NOT_FOUND
+ * if the module is not in the cache or if the cached module is stale. */
+static int load_cached_module(KOS_CONTEXT            ctx,
+                              KOS_OBJ_ID             module_obj,
+                              const KOS_CACHE_ENTRY *cache)
+{
+    PROF_ZONE(MODULE)
+
+    KOS_FILEBUF       file_buf;
+    KOS_MEMPOOL       allocator;
+    KOS_CACHED_MODULE cached;
+    KOS_LOCAL         module;
+    uint32_t          i;
+    int               error;
+
+    KOS_filebuf_init(&file_buf);
+    KOS_mempool_init(&allocator);
+    KOS_init_local_with(ctx, &module, module_obj);
+
+    if ( ! KOS_does_file_exist(cache->cache_path.buffer))
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    if (KOS_load_file(cache->cache_path.buffer, &file_buf))
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    TRY(kos_module_cache_read(&file_buf, &cache->key, &allocator, &cached));
+
+    /* Import modules in the same order as the compiler did, the bytecode refers
+     * to them and to their globals by index, so these must not have changed. */
+    for (i = 0; i < cached.num_imports; i++) {
+
+        const KOS_CACHED_NAME *const import = &cached.imports[i];
+        int                          module_idx;
+        uint64_t                     globals_hash = 0;
+
+        TRY(import_and_run_module(ctx, import->name, (uint16_t)import->length, &module_idx));
+
+        if ((uint32_t)module_idx != import->idx)
+            RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+        TRY(hash_module_globals(ctx, module_idx, &globals_hash));
+
+        if (globals_hash != import->globals_hash)
+            RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+    }
+
+    TRY(KOS_array_resize(ctx, OBJPTR(MODULE, module.o)->globals, cached.num_globals));
+
+    for (i = 0; i < cached.num_names; i++) {
+
+        const KOS_CACHED_NAME *const global     = &cached.globals[i];
+        const uint32_t               global_idx = global->idx & ~KOS_CACHED_CONST_GLOBAL;
+
+        TRY(add_global_name(ctx, module.o, global->name, global->length, (int)global_idx));
+
+        if (global->idx & KOS_CACHED_CONST_GLOBAL)
+            TRY(add_const_global(ctx, module.o, global->name, global->length));
+    }
+
+    TRY(alloc_constants(ctx, cached.first_constant, cached.base, cached.base, module.o));
+
+    for (i = 0; i < cached.num_modules; i++)
+        TRY(add_direct_module(ctx, module.o, cached.modules[i].name, cached.modules[i].length));
+
+    OBJPTR(MODULE, module.o)->main_idx = cached.main_idx;
+
+    if (ctx->inst->flags & KOS_INST_VERBOSE)
+        printf("Kos using module cache %s\n", cache->cache_path.buffer);
+
+cleanup:
+    KOS_destroy_top_local(ctx, &module);
+    KOS_mempool_destroy(&allocator);
+    KOS_unload_file(&file_buf);
+
+    return error;
+}
+
 static KOS_OBJ_ID import_module(KOS_CONTEXT ctx,
                                 const char *module_name, /* Module name or path, ASCII or UTF-8    */
                                 unsigned    name_len,    /* Length of module name or path in bytes */
@@ -1594,8 +2200,12 @@ static KOS_OBJ_ID import_module(KOS_CONTEXT ctx,
     KOS_INSTANCE   *const inst               = ctx->inst;
     KOS_MODULE_LOAD_CHAIN loading            = { KOS_NULL, KOS_NULL, 0 };
     KOS_FILEBUF           file_buf;
+    KOS_CACHE_ENTRY       cache;
+    int                   use_cache          = 0;
 
     KOS_filebuf_init(&file_buf);
+    KOS_vector_init(&cache.module_path);
+    KOS_vector_init(&cache.cache_path);
 
     get_module_name(module_name, name_len, &loading);
     PROF_ZONE_NAME(loading.module_name, loading.length)
@@ -1710,6 +2320,8 @@ static KOS_OBJ_ID import_module(KOS_CONTEXT ctx,
     if ( ! data) {
         unsigned flags = KOS_MODULE_NEEDS_KOS_SOURCE;
 
+        use_cache = inst->modules.cache_dir != KOS_NULL;
+
         if ( ! IS_BAD_PTR(mod_init.o))
             flags = ((struct KOS_MODULE_INIT_S *)OBJPTR(OPAQUE, mod_init.o))->flags;
 
@@ -1742,8 +2354,24 @@ static KOS_OBJ_ID import_module(KOS_CONTEXT ctx,
         }
     }
 
-    /* Compile module source to bytecode */
-    TRY(compile_module(ctx, module.o, (uint16_t)module_idx, data, data_size, KOS_RUN_NO_FLAGS));
+    /* Load compiled module from cache or compile module source to bytecode */
+    if (use_cache) {
+        error = get_cache_entry(ctx, module.o, module_idx, module_path.o, data, data_size, &cache);
+
+        if (error == KOS_ERROR_NOT_FOUND) {
+            use_cache = 0;
+            error     = KOS_SUCCESS;
+        }
+        else {
+            TRY(error);
+            error = load_cached_module(ctx, module.o, &cache);
+        }
+    }
+
+    if ( ! use_cache || (error == KOS_ERROR_NOT_FOUND))
+        error = compile_module(ctx, module.o, (uint16_t)module_idx, data, data_size, KOS_RUN_NO_FLAGS,
+                               use_cache ? &cache : KOS_NULL);
+    TRY(error);
 
     /* Free file buffer */
     KOS_unload_file(&file_buf);
@@ -1759,6 +2387,8 @@ cleanup:
     module.o = KOS_destroy_top_locals(ctx, &actual_module_name, &module);
 
     KOS_unload_file(&file_buf);
+    KOS_vector_destroy(&cache.cache_path);
+    KOS_vector_destroy(&cache.module_path);
 
     if (error) {
         handle_interpreter_error(ctx, error);
@@ -1797,28 +2427,26 @@ int kos_comp_import_module(void       *vframe,
 {
     struct KOS_COMP_CTX *comp_ctx = (struct KOS_COMP_CTX *)vframe;
     KOS_CONTEXT          ctx      = comp_ctx->ctx;
-    KOS_OBJ_ID           module_obj;
-    int                  already_loaded = 0;
-
-    assert(module_idx);
-
-    module_obj = import_module(ctx, name, name_len, 0, KOS_NULL, 0, &already_loaded, module_idx);
+    uint64_t             globals_hash;
+    int                  error;
 
-    if (IS_BAD_PTR(module_obj)) {
-        assert(KOS_is_exception_pending(ctx));
-        return KOS_ERROR_EXCEPTION;
-    }
+    TRY(import_and_run_module(ctx, name, name_len, module_idx));
 
-    if ( ! already_loaded) {
-        const KOS_OBJ_ID ret = KOS_run_module(ctx, module_obj);
+    /* Record the import for module cache, as the compiled code depends on it */
+    if (comp_ctx->imports) {
+        TRY(hash_module_globals(ctx, *module_idx, &globals_hash));
 
-        if (IS_BAD_PTR(ret)) {
-            assert(KOS_is_exception_pending(ctx));
-            return KOS_ERROR_EXCEPTION;
+        error = kos_module_cache_add_import(comp_ctx->imports, name, name_len, *module_idx, globals_hash);
+        if (error) {
+            KOS_raise_exception(ctx, KOS_STR_OUT_OF_MEMORY);
+            RAISE_ERROR(KOS_ERROR_EXCEPTION);
         }
+
+        ++comp_ctx->num_imports;
     }
 
-    return KOS_SUCCESS;
+cleanup:
+    return error;
 }
 
 static int append_stdin(KOS_CONTEXT ctx, KOS_VECTOR *buf)
@@ -1959,7 +2587,7 @@ KOS_OBJ_ID KOS_repl(KOS_CONTEXT ctx,
     assert(module_idx <= 0xFFFF);
 
     /* Compile evaluated source to bytecode */
-    TRY(compile_module(ctx, module.o, (uint16_t)module_idx, buf, buf_size, flags));
+    TRY(compile_module(ctx, module.o, (uint16_t)module_idx, buf, buf_size, flags, KOS_NULL));
 
     /* Put module on the list */
     if ( ! (flags & (KOS_RUN_CONTINUE | KOS_RUN_TEMPORARY))) {
@@ -2105,6 +2733,28 @@ cleanup:
     return error;
 }
 
+int KOS_module_add_constant(KOS_CONTEXT ctx,
+                            KOS_OBJ_ID  module_obj,
+                            KOS_OBJ_ID  name_obj,
+                            KOS_OBJ_ID  value_obj,
+                            unsigned   *idx)
+{
+    int       error;
+    KOS_LOCAL module;
+    KOS_LOCAL name;
+
+    KOS_init_local_with(ctx, &module, module_obj);
+    KOS_init_local_with(ctx, &name,   name_obj);
+
+    TRY(KOS_module_add_global(ctx, module.o, name.o, value_obj, idx));
+
+    TRY(KOS_set_property(ctx, OBJPTR(MODULE, module.o)->const_globals, name.o, KOS_TRUE));
+
+cleanup:
+    KOS_destroy_top_locals(ctx, &name, &module);
+    return error;
+}
+
 int KOS_module_get_global(KOS_CONTEXT ctx,
                           KOS_OBJ_ID  module_obj,
                           KOS_OBJ_ID  name,
@@ -2171,6 +2821,38 @@ cleanup:
     return error;
 }
 
+int KOS_module_add_fast_function(KOS_CONTEXT               ctx,
+                                 KOS_OBJ_ID                module_obj,
+                                 KOS_OBJ_ID                name_obj,
+                                 KOS_FAST_FUNCTION_HANDLER handler,
+                                 const KOS_CONVERT        *args)
+{
+    int        error  = KOS_SUCCESS;
+    KOS_OBJ_ID func_obj;
+    KOS_LOCAL  module;
+    KOS_LOCAL  name;
+
+    assert(GET_OBJ_TYPE(module_obj) == OBJ_MODULE);
+
+    KOS_init_local_with(ctx, &module, module_obj);
+    KOS_init_local_with(ctx, &name,   name_obj);
+
+    func_obj = KOS_new_fast_builtin_function(ctx, name_obj, handler, args);
+    TRY_OBJID(func_obj);
+
+    OBJPTR(FUNCTION, func_obj)->module = module.o;
+
+    TRY(KOS_module_add_global(ctx,
+                              module.o,
+                              name.o,
+                              func_obj,
+                              KOS_NULL));
+
+cleanup:
+    KOS_destroy_top_locals(ctx, &name, &module);
+    return error;
+}
+
 int KOS_module_add_constructor(KOS_CONTEXT          ctx,
                                KOS_OBJ_ID           module_obj,
                                KOS_OBJ_ID           name_obj,
@@ -2241,6 +2923,37 @@ cleanup:
     return error;
 }
 
+int KOS_module_add_fast_member_function(KOS_CONTEXT               ctx,
+                                        KOS_OBJ_ID                module_obj,
+                                        KOS_OBJ_ID                proto_obj,
+                                        KOS_OBJ_ID                name_obj,
+                                        KOS_FAST_FUNCTION_HANDLER handler,
+                                        const KOS_CONVERT        *args)
+{
+    int        error = KOS_SUCCESS;
+    KOS_OBJ_ID func_obj;
+    KOS_LOCAL  module;
+    KOS_LOCAL  proto;
+    KOS_LOCAL  name;
+
+    assert(GET_OBJ_TYPE(module_obj) == OBJ_MODULE);
+
+    KOS_init_local_with(ctx, &module, module_obj);
+    KOS_init_local_with(ctx, &proto,  proto_obj);
+    KOS_init_local_with(ctx, &name,   name_obj);
+
+    func_obj = KOS_new_fast_builtin_function(ctx, name.o, handler, args);
+    TRY_OBJID(func_obj);
+
+    OBJPTR(FUNCTION, func_obj)->module = module.o;
+
+    TRY(KOS_set_property(ctx, proto.o, name.o, func_obj));
+
+cleanup:
+    KOS_destroy_top_locals(ctx, &name, &module);
+    return error;
+}
+
 int KOS_module_add_static_function(KOS_CONTEXT          ctx,
                                    KOS_OBJ_ID           module_obj,
                                    KOS_OBJ_ID           class_name_obj,
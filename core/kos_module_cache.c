@@ -0,0 +1,835 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 Chris Dragan
+ */
+
+#include "kos_module_cache.h"
+#include "../inc/kos_error.h"
+#include "../inc/kos_memory.h"
+#include "../inc/kos_system.h"
+#include "../inc/kos_version.h"
+#include "kos_compiler.h"
+#include "kos_try.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Cache file layout, all fields are 32-bit words in native byte order:
+ *
+ *     header     magic, cache version, Kos version, number of opcodes,
+ *                source size, source hash, env hash, module path
+ *     imports    count, { name, module index, hash of global names }
+ *     globals    size of globals array, count, { name, global index | const flag }
+ *     modules    count, { name }
+ *     constants  count, { type, value }
+ *     main       index of constant with module's global scope function
+ *     checksum   64-bit hash of all preceding bytes
+ *     trailer    magic
+ *
+ * Strings are stored as length followed by bytes padded to 4 bytes.
+ * 64-bit values are stored as two 32-bit words.
+ */
+
+#define KOS_CACHE_MAGIC   0x43534F4BU /* "KOSC" */
+#define KOS_CACHE_TRAILER 0x444E454BU /* "KEND" */
+
+#define KOS_CACHE_KOS_VERSION ((KOS_VERSION_MAJOR << 16) | (KOS_VERSION_MINOR << 8) | KOS_VERSION_REVISION)
+
+uint64_t kos_module_cache_hash(uint64_t    hash,
+                               const void *data,
+                               size_t      size)
+{
+    /* FNV-1a */
+    const uint64_t       prime = ((uint64_t)0x100U << 32) | (uint64_t)0x1B3U;
+    const uint8_t       *ptr   = (const uint8_t *)data;
+    const uint8_t *const end   = ptr + size;
+
+    for ( ; ptr < end; ++ptr)
+        hash = (hash ^ *ptr) * prime;
+
+    return hash;
+}
+
+static int put_u32(KOS_VECTOR *buf, uint32_t value)
+{
+    const size_t pos   = buf->size;
+    const int    error = KOS_vector_resize(buf, pos + sizeof(value));
+
+    if ( ! error)
+        memcpy(&buf->buffer[pos], &value, sizeof(value));
+
+    return error;
+}
+
+static int put_u64(KOS_VECTOR *buf, uint64_t value)
+{
+    int error = put_u32(buf, (uint32_t)value);
+
+    if ( ! error)
+        error = put_u32(buf, (uint32_t)(value >> 32));
+
+    return error;
+}
+
+static int put_bytes(KOS_VECTOR *buf, const void *data, uint32_t size)
+{
+    const size_t pos         = buf->size;
+    const size_t padded_size = (size + 3U) & ~(size_t)3U;
+    const int    error       = KOS_vector_resize(buf, pos + padded_size);
+
+    if ( ! error) {
+        if (size)
+            memcpy(&buf->buffer[pos], data, size);
+        memset(&buf->buffer[pos + size], 0, padded_size - size);
+    }
+
+    return error;
+}
+
+static int put_str(KOS_VECTOR *buf, const char *str, uint32_t length)
+{
+    int error = put_u32(buf, length);
+
+    if ( ! error)
+        error = put_bytes(buf, str, length);
+
+    return error;
+}
+
+int kos_module_cache_add_import(KOS_VECTOR *imports,
+                                const char *name,
+                                uint16_t    name_len,
+                                int         module_idx,
+                                uint64_t    globals_hash)
+{
+    int error;
+
+    assert(module_idx >= 0);
+
+    TRY(put_str(imports, name, name_len));
+    TRY(put_u32(imports, (uint32_t)module_idx));
+    TRY(put_u64(imports, globals_hash));
+
+cleanup:
+    return error;
+}
+
+static uint32_t count_constants(const KOS_COMP_CONST *constant)
+{
+    uint32_t num = 0;
+
+    for ( ; constant; constant = constant->next, ++num);
+
+    return num;
+}
+
+static int put_function(KOS_VECTOR              *buf,
+                        const KOS_COMP_UNIT     *program,
+                        const KOS_COMP_FUNCTION *func_const)
+{
+    int     error;
+    uint8_t arg_idx;
+
+    assert(func_const->bytecode_offset + func_const->bytecode_size <= program->code_buf.size);
+    if (func_const->addr2line_size) {
+        assert(func_const->addr2line_offset + func_const->addr2line_size <= program->addr2line_buf.size);
+    }
+
+    TRY(put_u32(buf, func_const->flags));
+    TRY(put_u32(buf, func_const->num_regs));
+    TRY(put_u32(buf, func_const->closure_size));
+    TRY(put_u32(buf, func_const->min_args));
+    TRY(put_u32(buf, func_const->num_used_def_args));
+    TRY(put_u32(buf, func_const->num_binds));
+    TRY(put_u32(buf, func_const->args_reg));
+    TRY(put_u32(buf, func_const->rest_reg));
+    TRY(put_u32(buf, func_const->ellipsis_reg));
+    TRY(put_u32(buf, func_const->this_reg));
+    TRY(put_u32(buf, func_const->bind_reg));
+    TRY(put_u32(buf, func_const->name_str_idx));
+    TRY(put_u32(buf, func_const->def_line));
+    TRY(put_u32(buf, func_const->num_instr));
+    TRY(put_u32(buf, func_const->num_named_args));
+
+    for (arg_idx = 0; arg_idx < func_const->num_named_args; arg_idx++)
+        TRY(put_u32(buf, func_const->arg_name_str_idx[arg_idx]));
+
+    TRY(put_u32(buf, func_const->bytecode_size));
+    TRY(put_bytes(buf,
+                  &program->code_buf.buffer[func_const->bytecode_offset],
+                  func_const->bytecode_size));
+
+    TRY(put_u32(buf, func_const->addr2line_size));
+    TRY(put_bytes(buf,
+                  &program->addr2line_buf.buffer[func_const->addr2line_offset],
+                  func_const->addr2line_size));
+
+cleanup:
+    return error;
+}
+
+static int put_module(KOS_VECTOR                 *buf,
+                      const KOS_MODULE_CACHE_KEY *key,
+                      const KOS_VECTOR           *imports,
+                      uint32_t                    num_imports,
+                      const KOS_COMP_UNIT        *program,
+                      uint32_t                    main_idx)
+{
+    const KOS_COMP_CONST *constant;
+    const KOS_VAR        *var;
+    uint32_t              num;
+    int                   error;
+
+    TRY(put_u32(buf, KOS_CACHE_MAGIC));
+    TRY(put_u32(buf, KOS_MODULE_CACHE_VERSION));
+    TRY(put_u32(buf, KOS_CACHE_KOS_VERSION));
+    TRY(put_u32(buf, INSTR_LAST_OPCODE));
+    TRY(put_u32(buf, key->source_size));
+    TRY(put_u64(buf, key->source_hash));
+    TRY(put_u64(buf, key->env_hash));
+    TRY(put_str(buf, key->module_path, key->module_path_len));
+
+    TRY(put_u32(buf, num_imports));
+    TRY(put_bytes(buf, imports->buffer, (uint32_t)imports->size));
+
+    for (num = 0, var = program->globals; var; var = var->next)
+        if (var->type == VAR_GLOBAL)
+            ++num;
+
+    TRY(put_u32(buf, (uint32_t)program->num_globals));
+    TRY(put_u32(buf, num));
+
+    for (var = program->globals; var; var = var->next) {
+        if (var->type == VAR_GLOBAL) {
+            assert(var->array_idx < program->num_globals);
+            TRY(put_str(buf, var->token->begin, var->token->length));
+            TRY(put_u32(buf, (uint32_t)var->array_idx | (var->is_const ? KOS_CACHED_CONST_GLOBAL : 0U)));
+        }
+    }
+
+    for (num = 0, var = program->modules; var; var = var->next, ++num);
+
+    TRY(put_u32(buf, num));
+
+    for (var = program->modules; var; var = var->next)
+        TRY(put_str(buf, var->token->begin, var->token->length));
+
+    TRY(put_u32(buf, count_constants(program->first_constant)));
+
+    for (constant = program->first_constant; constant; constant = constant->next) {
+
+        TRY(put_u32(buf, (uint32_t)constant->type));
+
+        switch (constant->type) {
+
+            default:
+                assert(constant->type == KOS_COMP_CONST_INTEGER);
+                TRY(put_u64(buf, (uint64_t)((const KOS_COMP_INTEGER *)constant)->value));
+                break;
+
+            case KOS_COMP_CONST_FLOAT: {
+                uint64_t value;
+
+                memcpy(&value, &((const KOS_COMP_FLOAT *)constant)->value, sizeof(value));
+                TRY(put_u64(buf, value));
+                break;
+            }
+
+            case KOS_COMP_CONST_STRING: {
+                const KOS_COMP_STRING *const str = (const KOS_COMP_STRING *)constant;
+
+                TRY(put_u32(buf, (uint32_t)str->escape));
+                TRY(put_str(buf, str->str, str->length));
+                break;
+            }
+
+            case KOS_COMP_CONST_FUNCTION:
+                TRY(put_function(buf, program, (const KOS_COMP_FUNCTION *)constant));
+                break;
+
+            case KOS_COMP_CONST_PROTOTYPE:
+                break;
+
+            case KOS_COMP_CONST_SWITCH: {
+                const KOS_COMP_SWITCH *const switch_const = (const KOS_COMP_SWITCH *)constant;
+                uint32_t                     i;
+
+                TRY(put_u32(buf, switch_const->num_cases));
+
+                for (i = 0; i < switch_const->num_cases; i++)
+                    TRY(put_u32(buf, switch_const->case_str_idx[i]));
+                break;
+            }
+
+            case KOS_COMP_CONST_OBJ_TEMPLATE:
+                /* fall through */
+            case KOS_COMP_CONST_ARRAY_TEMPLATE: {
+                const KOS_COMP_TEMPLATE *const templ = (const KOS_COMP_TEMPLATE *)constant;
+                uint32_t                       i;
+
+                TRY(put_u32(buf, templ->num_items));
+
+                for (i = 0; i < templ->num_items; i++)
+                    TRY(put_u32(buf, templ->items[i]));
+                break;
+            }
+        }
+    }
+
+    TRY(put_u32(buf, main_idx));
+    TRY(put_u64(buf, kos_module_cache_hash(KOS_MODULE_CACHE_HASH_INIT, buf->buffer, buf->size)));
+    TRY(put_u32(buf, KOS_CACHE_TRAILER));
+
+cleanup:
+    return error;
+}
+
+int kos_module_cache_write(const char                 *cache_path,
+                           const KOS_MODULE_CACHE_KEY *key,
+                           const KOS_VECTOR           *imports,
+                           uint32_t                    num_imports,
+                           const KOS_COMP_UNIT        *program,
+                           uint32_t                    main_idx)
+{
+    KOS_VECTOR buf;
+    KOS_VECTOR tmp_path;
+    FILE      *file  = KOS_NULL;
+    int        error = KOS_SUCCESS;
+
+    KOS_vector_init(&buf);
+    KOS_vector_init(&tmp_path);
+
+    TRY(KOS_vector_reserve(&buf, 4096U + program->code_buf.size + program->addr2line_buf.size));
+    TRY(put_module(&buf, key, imports, num_imports, program, main_idx));
+
+    /* Write to a temporary file first, so that other instances loading
+     * the same module never observe a partially written cache file. */
+    {
+        const size_t   path_len = strlen(cache_path);
+        const uint64_t unique   = (uint64_t)KOS_get_time_us() ^ (uint64_t)(uintptr_t)&buf;
+
+        TRY(KOS_vector_resize(&tmp_path, path_len + 32));
+        snprintf(tmp_path.buffer, tmp_path.size, "%s.%08x.tmp", cache_path,
+                 (unsigned)(uint32_t)(unique ^ (unique >> 32)));
+    }
+
+    file = fopen(tmp_path.buffer, "wb");
+    if ( ! file)
+        RAISE_ERROR(KOS_ERROR_ERRNO);
+
+    if (fwrite(buf.buffer, 1, buf.size, file) != buf.size) {
+        fclose(file);
+        remove(tmp_path.buffer);
+        RAISE_ERROR(KOS_ERROR_ERRNO);
+    }
+
+    if (fclose(file)) {
+        remove(tmp_path.buffer);
+        RAISE_ERROR(KOS_ERROR_ERRNO);
+    }
+
+#ifdef _WIN32
+    remove(cache_path);
+#endif
+
+    if (rename(tmp_path.buffer, cache_path)) {
+        remove(tmp_path.buffer);
+        RAISE_ERROR(KOS_ERROR_ERRNO);
+    }
+
+cleanup:
+    KOS_vector_destroy(&tmp_path);
+    KOS_vector_destroy(&buf);
+
+    return error;
+}
+
+typedef struct KOS_CACHE_READER_S {
+    const uint8_t *begin;
+    const uint8_t *cur;
+    const uint8_t *end;
+} KOS_CACHE_READER;
+
+static int get_u32(KOS_CACHE_READER *reader, uint32_t *value)
+{
+    if ((size_t)(reader->end - reader->cur) < sizeof(*value))
+        return KOS_ERROR_NOT_FOUND;
+
+    memcpy(value, reader->cur, sizeof(*value));
+    reader->cur += sizeof(*value);
+
+    return KOS_SUCCESS;
+}
+
+static int get_u64(KOS_CACHE_READER *reader, uint64_t *value)
+{
+    uint32_t low  = 0;
+    uint32_t high = 0;
+    int      error;
+
+    TRY(get_u32(reader, &low));
+    TRY(get_u32(reader, &high));
+
+    *value = ((uint64_t)high << 32) | low;
+
+cleanup:
+    return error;
+}
+
+static int get_bytes(KOS_CACHE_READER *reader, uint32_t size, const uint8_t **data)
+{
+    const size_t padded_size = (size + 3U) & ~(size_t)3U;
+
+    if ((size_t)(reader->end - reader->cur) < padded_size)
+        return KOS_ERROR_NOT_FOUND;
+
+    *data = reader->cur;
+    reader->cur += padded_size;
+
+    return KOS_SUCCESS;
+}
+
+static int get_str(KOS_CACHE_READER *reader, const char **str, uint32_t *length)
+{
+    const uint8_t *data = KOS_NULL;
+    int            error;
+
+    TRY(get_u32(reader, length));
+    TRY(get_bytes(reader, *length, &data));
+
+    *str = (const char *)data;
+
+cleanup:
+    return error;
+}
+
+static int expect_u32(KOS_CACHE_READER *reader, uint32_t expected)
+{
+    uint32_t value = ~expected;
+    int      error;
+
+    TRY(get_u32(reader, &value));
+
+    if (value != expected)
+        error = KOS_ERROR_NOT_FOUND;
+
+cleanup:
+    return error;
+}
+
+/* Detects corruption anywhere in the file before any of it is used, bytecode
+ * read from the file is executed without any further validation */
+static int verify_checksum(const KOS_CACHE_READER *reader)
+{
+    const size_t     tail_size = sizeof(uint64_t) + sizeof(uint32_t);
+    const size_t     size      = (size_t)(reader->end - reader->begin);
+    KOS_CACHE_READER tail;
+    uint64_t         checksum  = 0;
+    int              error;
+
+    if (size < tail_size)
+        return KOS_ERROR_NOT_FOUND;
+
+    tail.begin = reader->begin;
+    tail.cur   = reader->end - tail_size;
+    tail.end   = reader->end;
+
+    TRY(get_u64(&tail, &checksum));
+
+    if (checksum != kos_module_cache_hash(KOS_MODULE_CACHE_HASH_INIT, reader->begin, size - tail_size))
+        error = KOS_ERROR_NOT_FOUND;
+
+cleanup:
+    return error;
+}
+
+static int get_names(KOS_CACHE_READER *reader,
+                     KOS_MEMPOOL      *allocator,
+                     int               with_idx,
+                     int               with_hash,
+                     KOS_CACHED_NAME **names,
+                     uint32_t         *num_names)
+{
+    KOS_CACHED_NAME *name;
+    uint32_t         i;
+    int              error;
+
+    TRY(get_u32(reader, num_names));
+
+    /* Each name takes at least one word in the file */
+    if (*num_names > (uint32_t)(reader->end - reader->cur) / 4U)
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    name = (KOS_CACHED_NAME *)KOS_mempool_alloc(allocator, sizeof(KOS_CACHED_NAME) * (*num_names + 1U));
+    if ( ! name)
+        RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+    *names = name;
+
+    for (i = 0; i < *num_names; i++, name++) {
+        name->idx          = 0;
+        name->globals_hash = 0;
+
+        TRY(get_str(reader, &name->name, &name->length));
+        if (name->length > 0xFFFFU)
+            RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+        if (with_idx)
+            TRY(get_u32(reader, &name->idx));
+        if (with_hash)
+            TRY(get_u64(reader, &name->globals_hash));
+    }
+
+cleanup:
+    return error;
+}
+
+static int get_function(KOS_CACHE_READER   *reader,
+                        KOS_MEMPOOL        *allocator,
+                        uint32_t            num_constants,
+                        KOS_COMP_FUNCTION **out_func)
+{
+    KOS_COMP_FUNCTION *func_const;
+    const uint8_t     *data  = KOS_NULL;
+    uint32_t           fields[15];
+    uint32_t           i;
+    int                error = KOS_SUCCESS;
+
+    for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        TRY(get_u32(reader, &fields[i]));
+
+    /* Number of named args */
+    if (fields[14] > 255U)
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    func_const = (KOS_COMP_FUNCTION *)KOS_mempool_alloc(allocator,
+            sizeof(KOS_COMP_FUNCTION) + sizeof(uint32_t) * (fields[14] ? fields[14] - 1U : 0U));
+    if ( ! func_const)
+        RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+    memset(func_const, 0, sizeof(*func_const));
+
+    func_const->flags             = (uint8_t)fields[0];
+    func_const->num_regs          = (uint8_t)fields[1];
+    func_const->closure_size      = (uint8_t)fields[2];
+    func_const->min_args          = (uint8_t)fields[3];
+    func_const->num_used_def_args = (uint8_t)fields[4];
+    func_const->num_binds         = (uint8_t)fields[5];
+    func_const->args_reg          = (uint8_t)fields[6];
+    func_const->rest_reg          = (uint8_t)fields[7];
+    func_const->ellipsis_reg      = (uint8_t)fields[8];
+    func_const->this_reg          = (uint8_t)fields[9];
+    func_const->bind_reg          = (uint8_t)fields[10];
+    func_const->name_str_idx      = fields[11];
+    func_const->def_line          = fields[12];
+    func_const->num_instr         = fields[13];
+    func_const->num_named_args    = (uint8_t)fields[14];
+
+    if (func_const->name_str_idx >= num_constants)
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    for (i = 0; i < func_const->num_named_args; i++) {
+        TRY(get_u32(reader, &func_const->arg_name_str_idx[i]));
+
+        if (func_const->arg_name_str_idx[i] >= num_constants)
+            RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+    }
+
+    TRY(get_u32(reader, &func_const->bytecode_size));
+    TRY(get_bytes(reader, func_const->bytecode_size, &data));
+    func_const->bytecode_offset = (uint32_t)(data - reader->begin);
+
+    TRY(get_u32(reader, &func_const->addr2line_size));
+    TRY(get_bytes(reader, func_const->addr2line_size, &data));
+    func_const->addr2line_offset = (uint32_t)(data - reader->begin);
+
+    if (func_const->addr2line_size % sizeof(struct KOS_COMP_ADDR_TO_LINE_S))
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    *out_func = func_const;
+
+cleanup:
+    return error;
+}
+
+static int get_constants(KOS_CACHE_READER  *reader,
+                         KOS_MEMPOOL       *allocator,
+                         KOS_CACHED_MODULE *cached)
+{
+    KOS_COMP_CONST **next_ptr      = &cached->first_constant;
+    uint8_t         *types;
+    uint32_t         num_constants = 0;
+    uint32_t         i;
+    int              error;
+
+    TRY(get_u32(reader, &num_constants));
+
+    if (num_constants > (uint32_t)(reader->end - reader->cur) / 4U)
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    types = (uint8_t *)KOS_mempool_alloc(allocator, num_constants + 1U);
+    if ( ! types)
+        RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+    for (i = 0; i < num_constants; i++) {
+
+        KOS_COMP_CONST *constant = KOS_NULL;
+        uint32_t        type     = 0;
+
+        TRY(get_u32(reader, &type));
+
+        switch (type) {
+
+            case KOS_COMP_CONST_INTEGER: {
+                KOS_COMP_INTEGER *const int_const = (KOS_COMP_INTEGER *)
+                    KOS_mempool_alloc(allocator, sizeof(KOS_COMP_INTEGER));
+                uint64_t value = 0;
+
+                if ( ! int_const)
+                    RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+                TRY(get_u64(reader, &value));
+                int_const->value = (int64_t)value;
+                constant         = &int_const->header;
+                break;
+            }
+
+            case KOS_COMP_CONST_FLOAT: {
+                KOS_COMP_FLOAT *const float_const = (KOS_COMP_FLOAT *)
+                    KOS_mempool_alloc(allocator, sizeof(KOS_COMP_FLOAT));
+                uint64_t value = 0;
+
+                if ( ! float_const)
+                    RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+                TRY(get_u64(reader, &value));
+                memcpy(&float_const->value, &value, sizeof(value));
+                constant = &float_const->header;
+                break;
+            }
+
+            case KOS_COMP_CONST_STRING: {
+                KOS_COMP_STRING *const str_const = (KOS_COMP_STRING *)
+                    KOS_mempool_alloc(allocator, sizeof(KOS_COMP_STRING));
+                uint32_t escape = 0;
+                uint32_t length = 0;
+
+                if ( ! str_const)
+                    RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+                TRY(get_u32(reader, &escape));
+                TRY(get_str(reader, &str_const->str, &length));
+
+                if ((escape > KOS_UTF8_WITH_ESCAPE) || (length > 0xFFFFU))
+                    RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+                str_const->length = (uint16_t)length;
+                str_const->escape = (KOS_UTF8_ESCAPE)escape;
+                constant          = &str_const->header;
+                break;
+            }
+
+            case KOS_COMP_CONST_FUNCTION: {
+                KOS_COMP_FUNCTION *func_const = KOS_NULL;
+
+                TRY(get_function(reader, allocator, num_constants, &func_const));
+                constant = &func_const->header;
+                break;
+            }
+
+            case KOS_COMP_CONST_PROTOTYPE:
+                constant = (KOS_COMP_CONST *)KOS_mempool_alloc(allocator, sizeof(KOS_COMP_CONST));
+                if ( ! constant)
+                    RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+                break;
+
+            case KOS_COMP_CONST_SWITCH: {
+                KOS_COMP_SWITCH *switch_const;
+                uint32_t         num_cases = 0;
+                uint32_t         i_case;
+
+                TRY(get_u32(reader, &num_cases));
+
+                if ( ! num_cases || (num_cases > (uint32_t)(reader->end - reader->cur) / 4U))
+                    RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+                switch_const = (KOS_COMP_SWITCH *)KOS_mempool_alloc(
+                        allocator, sizeof(KOS_COMP_SWITCH) + sizeof(uint32_t) * (num_cases - 1U));
+                if ( ! switch_const)
+                    RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+                switch_const->num_cases = num_cases;
+
+                /* Case strings must precede the switch table */
+                for (i_case = 0; i_case < num_cases; i_case++) {
+                    uint32_t str_idx = 0;
+
+                    TRY(get_u32(reader, &str_idx));
+
+                    if ((str_idx >= i) || (types[str_idx] != KOS_COMP_CONST_STRING))
+                        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+                    switch_const->case_str_idx[i_case] = str_idx;
+                }
+
+                constant = &switch_const->header;
+                break;
+            }
+
+            case KOS_COMP_CONST_OBJ_TEMPLATE:
+                /* fall through */
+            case KOS_COMP_CONST_ARRAY_TEMPLATE: {
+                KOS_COMP_TEMPLATE *templ;
+                uint32_t           num_items = 0;
+                uint32_t           i_item;
+
+                TRY(get_u32(reader, &num_items));
+
+                if ( ! num_items || (num_items > (uint32_t)(reader->end - reader->cur) / 4U))
+                    RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+                /* Object templates consist of key-value pairs */
+                if ((type == KOS_COMP_CONST_OBJ_TEMPLATE) && (num_items & 1U))
+                    RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+                templ = (KOS_COMP_TEMPLATE *)KOS_mempool_alloc(
+                        allocator, sizeof(KOS_COMP_TEMPLATE) + sizeof(uint32_t) * (num_items - 1U));
+                if ( ! templ)
+                    RAISE_ERROR(KOS_ERROR_OUT_OF_MEMORY);
+
+                templ->num_items = num_items;
+
+                /* Keys and values must precede the template */
+                for (i_item = 0; i_item < num_items; i_item++) {
+                    const int is_key = (type == KOS_COMP_CONST_OBJ_TEMPLATE) && ! (i_item & 1U);
+                    uint32_t  idx     = 0;
+
+                    TRY(get_u32(reader, &idx));
+
+                    if (is_key) {
+                        if ((idx >= i) || (types[idx] != KOS_COMP_CONST_STRING))
+                            RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+                    }
+                    else if ((idx != KOS_COMP_TEMPLATE_VOID)  &&
+                             (idx != KOS_COMP_TEMPLATE_FALSE) &&
+                             (idx != KOS_COMP_TEMPLATE_TRUE)) {
+                        if ((idx >= i) ||
+                            ((types[idx] != KOS_COMP_CONST_INTEGER) &&
+                             (types[idx] != KOS_COMP_CONST_FLOAT)   &&
+                             (types[idx] != KOS_COMP_CONST_STRING)))
+                            RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+                    }
+
+                    templ->items[i_item] = idx;
+                }
+
+                constant = &templ->header;
+                break;
+            }
+
+            default:
+                RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+        }
+
+        memset(&constant->rb_tree_node, 0, sizeof(constant->rb_tree_node));
+        constant->type  = (enum KOS_COMP_CONST_TYPE_E)type;
+        constant->index = i;
+        constant->next  = KOS_NULL;
+
+        types[i]  = (uint8_t)type;
+        *next_ptr = constant;
+        next_ptr  = &constant->next;
+    }
+
+    /* Function names and argument names must refer to strings */
+    {
+        const KOS_COMP_CONST *constant = cached->first_constant;
+
+        for ( ; constant; constant = constant->next) {
+
+            const KOS_COMP_FUNCTION *func_const;
+
+            if (constant->type != KOS_COMP_CONST_FUNCTION)
+                continue;
+
+            func_const = (const KOS_COMP_FUNCTION *)constant;
+
+            if (types[func_const->name_str_idx] != KOS_COMP_CONST_STRING)
+                RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+            for (i = 0; i < func_const->num_named_args; i++)
+                if (types[func_const->arg_name_str_idx[i]] != KOS_COMP_CONST_STRING)
+                    RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+        }
+    }
+
+    TRY(get_u32(reader, &cached->main_idx));
+
+    if ((cached->main_idx >= num_constants) || (types[cached->main_idx] != KOS_COMP_CONST_FUNCTION))
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+cleanup:
+    return error;
+}
+
+int kos_module_cache_read(const KOS_FILEBUF          *file_buf,
+                          const KOS_MODULE_CACHE_KEY *key,
+                          KOS_MEMPOOL                *allocator,
+                          KOS_CACHED_MODULE          *cached)
+{
+    KOS_CACHE_READER reader;
+    const char      *path     = KOS_NULL;
+    uint32_t         path_len = 0;
+    uint64_t         hash     = 0;
+    uint32_t         i;
+    int              error;
+
+    reader.begin = (const uint8_t *)file_buf->buffer;
+    reader.cur   = reader.begin;
+    reader.end   = reader.begin + file_buf->size;
+
+    memset(cached, 0, sizeof(*cached));
+    cached->base = reader.begin;
+
+    TRY(expect_u32(&reader, KOS_CACHE_MAGIC));
+    TRY(expect_u32(&reader, KOS_MODULE_CACHE_VERSION));
+    TRY(expect_u32(&reader, KOS_CACHE_KOS_VERSION));
+    TRY(expect_u32(&reader, INSTR_LAST_OPCODE));
+    TRY(expect_u32(&reader, key->source_size));
+
+    TRY(verify_checksum(&reader));
+
+    TRY(get_u64(&reader, &hash));
+    if (hash != key->source_hash)
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    TRY(get_u64(&reader, &hash));
+    if (hash != key->env_hash)
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    /* Guard against hash collisions in cache file names */
+    TRY(get_str(&reader, &path, &path_len));
+    if ((path_len != key->module_path_len) || memcmp(path, key->module_path, path_len))
+        RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    TRY(get_names(&reader, allocator, 1, 1, &cached->imports, &cached->num_imports));
+
+    TRY(get_u32(&reader, &cached->num_globals));
+    TRY(get_names(&reader, allocator, 1, 0, &cached->globals, &cached->num_names));
+
+    for (i = 0; i < cached->num_names; i++)
+        if ((cached->globals[i].idx & ~KOS_CACHED_CONST_GLOBAL) >= cached->num_globals)
+            RAISE_ERROR(KOS_ERROR_NOT_FOUND);
+
+    TRY(get_names(&reader, allocator, 0, 0, &cached->modules, &cached->num_modules));
+
+    TRY(get_constants(&reader, allocator, cached));
+
+    TRY(get_u64(&reader, &hash));
+    TRY(expect_u32(&reader, KOS_CACHE_TRAILER));
+
+    if (reader.cur != reader.end)
+        error = KOS_ERROR_NOT_FOUND;
+
+cleanup:
+    return error;
+}
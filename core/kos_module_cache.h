@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 Chris Dragan
+ */
+
+#ifndef KOS_MODULE_CACHE_H_INCLUDED
+#define KOS_MODULE_CACHE_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct KOS_COMP_CONST_S;
+struct KOS_COMP_UNIT_S;
+struct KOS_FILEBUF_S;
+struct KOS_MEMPOOL_S;
+struct KOS_VECTOR_S;
+
+/* Increment whenever the layout of cache files or the code generated
+ * by the compiler changes, so that stale cache files are recompiled. */
+#define KOS_MODULE_CACHE_VERSION 7U
+
+#define KOS_MODULE_CACHE_EXT ".kosc"
+
+/* Identifies compiled module, cache file is only used if all fields match */
+typedef struct KOS_MODULE_CACHE_KEY_S {
+    const char *module_path;     /* Absolute path to module source file                  */
+    uint32_t    module_path_len;
+    uint32_t    source_size;     /* Size of module source code                           */
+    uint64_t    source_hash;     /* Hash of module source code                           */
+    uint64_t    env_hash;        /* Hash of globals and modules defined before compiling */
+} KOS_MODULE_CACHE_KEY;
+
+/* Flag in index of a global, which never changes after the module is initialized */
+#define KOS_CACHED_CONST_GLOBAL 0x80000000U
+
+typedef struct KOS_CACHED_NAME_S {
+    const char *name;
+    uint32_t    length;
+    uint32_t    idx;             /* Index of global or index of imported module   */
+    uint64_t    globals_hash;    /* Hash of global names of an imported module    */
+} KOS_CACHED_NAME;
+
+/* Compiled module read from cache file, strings and bytecode point into the file */
+typedef struct KOS_CACHED_MODULE_S {
+    const uint8_t           *base;           /* Base for bytecode and addr2line offsets */
+    KOS_CACHED_NAME         *imports;        /* Modules imported during compilation     */
+    KOS_CACHED_NAME         *globals;
+    KOS_CACHED_NAME         *modules;        /* Directly referenced modules             */
+    struct KOS_COMP_CONST_S *first_constant;
+    uint32_t                 num_imports;
+    uint32_t                 num_globals;    /* Number of entries in module's globals   */
+    uint32_t                 num_names;      /* Number of named globals                 */
+    uint32_t                 num_modules;
+    uint32_t                 main_idx;
+} KOS_CACHED_MODULE;
+
+#define KOS_MODULE_CACHE_HASH_INIT ((((uint64_t)0xCBF29CE4U) << 32) | (uint64_t)0x84222325U)
+
+uint64_t kos_module_cache_hash(uint64_t    hash,
+                               const void *data,
+                               size_t      size);
+
+/* Records module imported by the compiler, in the order of imports */
+int kos_module_cache_add_import(struct KOS_VECTOR_S *imports,
+                                const char          *name,
+                                uint16_t             name_len,
+                                int                  module_idx,
+                                uint64_t             globals_hash);
+
+/* Writes compiled module to cache file, replaces the file atomically */
+int kos_module_cache_write(const char                   *cache_path,
+                           const KOS_MODULE_CACHE_KEY   *key,
+                           const struct KOS_VECTOR_S    *imports,
+                           uint32_t                      num_imports,
+                           const struct KOS_COMP_UNIT_S *program,
+                           uint32_t                      main_idx);
+
+/* Parses cache file loaded into memory.  Returns KOS_ERROR_NOT_FOUND
+ * if the file is stale, corrupted or was created for a different key. */
+int kos_module_cache_read(const struct KOS_FILEBUF_S *file_buf,
+                          const KOS_MODULE_CACHE_KEY *key,
+                          struct KOS_MEMPOOL_S       *allocator,
+                          KOS_CACHED_MODULE          *cached);
+
+#endif
@@ -44,6 +44,17 @@
  *      this table forever, it never changes.
  *  V - Some value.  Values can change over time.  When a property is deleted,
  *      TOMBSTONE is written as a value.
+ *
+ * Plain objects with few properties use shaped storage instead of a hash
+ * table.  The keys are held in a shape, which is shared by all objects,
+ * which had the same properties added in the same order, and the storage
+ * only holds the values, in the same order as the keys in the shape.
+ * A property is added by first replacing the storage's shape with a child
+ * shape, which has the new key appended, and then writing the value into
+ * the next slot.  Values in shaped storage go through the same states as
+ * values in the hash table.  Once an object has too many properties or the
+ * limit of shapes has been reached, the object's shaped storage is converted
+ * to a hash table.
  */
 
 KOS_DECLARE_STATIC_CONST_STRING(str_err_no_own_properties, "object has no own properties");
@@ -131,6 +142,10 @@ static KOS_ATOMIC(KOS_OBJ_ID) *get_properties(KOS_OBJ_ID obj_id)
             props = &OBJPTR(CLASS, obj_id)->props;
             break;
 
+        case OBJ_SHAPE:
+            props = &OBJPTR(SHAPE, obj_id)->transitions;
+            break;
+
         default:
             props = KOS_NULL;
             break;
@@ -143,7 +158,7 @@ static int has_properties(KOS_OBJ_ID obj_id)
 {
     const KOS_TYPE type = GET_OBJ_TYPE(obj_id);
 
-    return type == OBJ_OBJECT || type == OBJ_CLASS;
+    return type == OBJ_OBJECT || type == OBJ_CLASS || type == OBJ_SHAPE;
 }
 
 static KOS_OBJ_ID alloc_buffer(KOS_CONTEXT ctx, unsigned capacity)
@@ -156,12 +171,186 @@ static KOS_OBJ_ID alloc_buffer(KOS_CONTEXT ctx, unsigned capacity)
                                    (capacity - 1) * sizeof(KOS_PITEM));
 
     if (storage) {
+        unsigned i;
+
         assert(kos_get_object_type(storage->header) == OBJ_OBJECT_STORAGE);
+
+        KOS_atomic_write_relaxed_u32(storage->capacity,       capacity);
+        KOS_atomic_write_relaxed_u32(storage->num_slots_used, 0);
+        KOS_atomic_write_relaxed_u32(storage->num_slots_open, capacity);
+        KOS_atomic_write_relaxed_u32(storage->active_copies,  0);
+        KOS_atomic_write_relaxed_u32(storage->watched,        0);
+        KOS_atomic_write_relaxed_ptr(storage->new_prop_table, KOS_BADPTR);
+
+        for (i = 0; i < capacity; i++) {
+            KOS_atomic_write_relaxed_ptr(storage->items[i].key,       KOS_BADPTR);
+            KOS_atomic_write_relaxed_u32(storage->items[i].hash.hash, 0);
+            KOS_atomic_write_relaxed_ptr(storage->items[i].value,     TOMBSTONE);
+        }
     }
 
     return OBJID(OBJECT_STORAGE, storage);
 }
 
+static KOS_OBJ_ID alloc_shaped_storage(KOS_CONTEXT ctx, unsigned capacity)
+{
+    KOS_SHAPED_STORAGE *const storage = (KOS_SHAPED_STORAGE *)
+            kos_alloc_object(ctx,
+                             KOS_ALLOC_MOVABLE,
+                             OBJ_SHAPED_STORAGE,
+                             sizeof(KOS_SHAPED_STORAGE) +
+                                   (capacity - 1) * sizeof(KOS_OBJ_ID));
+
+    if (storage) {
+        unsigned i;
+
+        assert(kos_get_object_type(storage->header) == OBJ_SHAPED_STORAGE);
+
+        KOS_atomic_write_relaxed_u32(storage->capacity,       capacity);
+        KOS_atomic_write_relaxed_u32(storage->num_slots_open, capacity);
+        KOS_atomic_write_relaxed_u32(storage->active_copies,  0);
+        KOS_atomic_write_relaxed_u32(storage->watched,        0);
+        KOS_atomic_write_relaxed_ptr(storage->shape,          KOS_BADPTR);
+        KOS_atomic_write_relaxed_ptr(storage->new_prop_table, KOS_BADPTR);
+
+        for (i = 0; i < capacity; i++)
+            KOS_atomic_write_relaxed_ptr(storage->values[i], TOMBSTONE);
+    }
+
+    return OBJID(SHAPED_STORAGE, storage);
+}
+
+static KOS_OBJ_ID alloc_shape(KOS_CONTEXT ctx, uint32_t num_props)
+{
+    KOS_SHAPE *const shape = (KOS_SHAPE *)
+            kos_alloc_object(ctx,
+                             KOS_ALLOC_MOVABLE,
+                             OBJ_SHAPE,
+                             (uint32_t)(sizeof(KOS_SHAPE) +
+                                        (num_props ? num_props - 1 : 0) * sizeof(KOS_OBJ_ID) +
+                                        num_props * sizeof(uint32_t)));
+
+    if (shape) {
+        assert(kos_get_object_type(shape->header) == OBJ_SHAPE);
+
+        shape->num_props = num_props;
+        KOS_atomic_write_relaxed_ptr(shape->transitions, KOS_BADPTR);
+    }
+
+    return OBJID(SHAPE, shape);
+}
+
+int kos_init_shapes(KOS_CONTEXT ctx)
+{
+    const KOS_OBJ_ID root = alloc_shape(ctx, 0U);
+
+    if (IS_BAD_PTR(root))
+        return KOS_ERROR_EXCEPTION;
+
+    ctx->inst->shapes.root = root;
+
+    return KOS_SUCCESS;
+}
+
+/* Returns index of the key in the shape or -1 if the shape does not have the key */
+static int find_shape_key(KOS_OBJ_ID shape_obj,
+                          KOS_OBJ_ID prop,
+                          uint32_t   hash)
+{
+    const KOS_SHAPE *const shape     = OBJPTR(SHAPE, shape_obj);
+    const uint32_t  *const hashes    = KOS_SHAPE_HASHES(shape);
+    const uint32_t         num_props = shape->num_props;
+    uint32_t               i;
+
+    for (i = 0; i < num_props; i++) {
+        const KOS_OBJ_ID key = shape->keys[i];
+
+        if (key == prop)
+            return (int)i;
+
+        if ((hashes[i] == hash) && ! KOS_string_compare(key, prop))
+            return (int)i;
+    }
+
+    return -1;
+}
+
+static uint32_t get_table_capacity(KOS_OBJ_ID prop_table)
+{
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE)
+        return KOS_atomic_read_relaxed_u32(OBJPTR(SHAPED_STORAGE, prop_table)->capacity);
+
+    return KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, prop_table)->capacity);
+}
+
+static KOS_ATOMIC(uint32_t) *get_num_slots_open(KOS_OBJ_ID prop_table)
+{
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE)
+        return &OBJPTR(SHAPED_STORAGE, prop_table)->num_slots_open;
+
+    return &OBJPTR(OBJECT_STORAGE, prop_table)->num_slots_open;
+}
+
+static KOS_ATOMIC(uint32_t) *get_active_copies(KOS_OBJ_ID prop_table)
+{
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE)
+        return &OBJPTR(SHAPED_STORAGE, prop_table)->active_copies;
+
+    return &OBJPTR(OBJECT_STORAGE, prop_table)->active_copies;
+}
+
+static KOS_ATOMIC(uint32_t) *get_watched(KOS_OBJ_ID prop_table)
+{
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE)
+        return &OBJPTR(SHAPED_STORAGE, prop_table)->watched;
+
+    return &OBJPTR(OBJECT_STORAGE, prop_table)->watched;
+}
+
+void kos_invalidate_prop_caches(KOS_INSTANCE *inst)
+{
+    KOS_atomic_add_u32(inst->shapes.proto_epoch, 1U);
+}
+
+/* Called after a key has been added to a property table or a deleted key
+ * has been restored.  If any property cache relies on the key not being
+ * in this table, all cached prototype holders are invalidated.  The CAS
+ * which published the key is a full barrier, see also watch_prototypes(). */
+static void notify_key_added(KOS_CONTEXT ctx, KOS_OBJ_ID prop_table)
+{
+    if (KOS_atomic_read_acquire_u32(*get_watched(prop_table)))
+        kos_invalidate_prop_caches(ctx->inst);
+}
+
+static KOS_ATOMIC(KOS_OBJ_ID) *get_new_prop_table(KOS_OBJ_ID prop_table)
+{
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE)
+        return &OBJPTR(SHAPED_STORAGE, prop_table)->new_prop_table;
+
+    return &OBJPTR(OBJECT_STORAGE, prop_table)->new_prop_table;
+}
+
+static KOS_ATOMIC(KOS_OBJ_ID) *get_table_value(KOS_OBJ_ID prop_table, uint32_t idx)
+{
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE)
+        return &OBJPTR(SHAPED_STORAGE, prop_table)->values[idx];
+
+    return &OBJPTR(OBJECT_STORAGE, prop_table)->items[idx].value;
+}
+
+static KOS_OBJ_ID get_table_key(KOS_OBJ_ID prop_table, uint32_t idx)
+{
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE) {
+        const KOS_OBJ_ID shape_obj = KOS_atomic_read_acquire_obj(
+                                        OBJPTR(SHAPED_STORAGE, prop_table)->shape);
+
+        return (idx < OBJPTR(SHAPE, shape_obj)->num_props) ? OBJPTR(SHAPE, shape_obj)->keys[idx]
+                                                          : KOS_BADPTR;
+    }
+
+    return KOS_atomic_read_relaxed_obj(OBJPTR(OBJECT_STORAGE, prop_table)->items[idx].key);
+}
+
 void kos_init_object(KOS_OBJECT *obj, KOS_OBJ_ID prototype)
 {
     obj->prototype = prototype;
@@ -200,43 +389,24 @@ static KOS_OBJ_ID read_props(KOS_ATOMIC(KOS_OBJ_ID) *ptr)
     return KOS_atomic_read_acquire_obj(*ptr);
 }
 
-static int salvage_item(KOS_CONTEXT ctx,
-                        KOS_PITEM  *old_item,
-                        KOS_OBJ_ID  new_table,
-                        uint32_t    new_capacity)
+/* Claims a slot for the key in the new hash table */
+static KOS_PITEM *claim_new_item(KOS_OBJ_ID new_table,
+                                 uint32_t   new_capacity,
+                                 KOS_OBJ_ID key,
+                                 uint32_t   hash)
 {
-    KOS_OBJ_ID     key;
-    KOS_OBJ_ID     value;
-    KOS_PITEM     *new_item;
     const uint32_t mask = new_capacity - 1;
-    uint32_t       hash;
-    uint32_t       idx;
-    int            ret;
-
-    /* Attempt to close an empty or deleted slot early */
-    if (KOS_atomic_cas_strong_ptr(old_item->value, TOMBSTONE, CLOSED))
-        return 1;
-
-    value = KOS_atomic_read_relaxed_obj(old_item->value);
-    if (value == CLOSED)
-        return 0;
-
-    key  = KOS_atomic_read_relaxed_obj(old_item->key);
-    assert( ! IS_BAD_PTR(key));
-    hash = KOS_atomic_read_relaxed_u32(old_item->hash.hash);
-    idx  = hash & mask;
+    uint32_t       idx  = hash & mask;
 
-    /* Claim a slot in the new table */
     for (;;) {
 
         KOS_OBJ_ID dest_key;
-
-        new_item = OBJPTR(OBJECT_STORAGE, new_table)->items + idx;
+        KOS_PITEM *new_item = OBJPTR(OBJECT_STORAGE, new_table)->items + idx;
 
         if (KOS_atomic_cas_strong_ptr(new_item->key, KOS_BADPTR, key)) {
             KOS_atomic_write_relaxed_u32(new_item->hash.hash, hash);
             KOS_atomic_add_i32(OBJPTR(OBJECT_STORAGE, new_table)->num_slots_used, 1);
-            break;
+            return new_item;
         }
 
         /* This slot in the new table is already taken */
@@ -244,21 +414,29 @@ static int salvage_item(KOS_CONTEXT ctx,
         assert( ! IS_BAD_PTR(dest_key));
         if (is_key_equal(key, hash, dest_key, new_item))
             /* Someone already wrote this key to the new table */
-            break;
+            return new_item;
 
         idx = (idx + 1) & mask;
     }
+}
+
+/* Moves value from the old table to the new table */
+static int move_value(KOS_ATOMIC(KOS_OBJ_ID) *old_value,
+                      KOS_ATOMIC(KOS_OBJ_ID) *new_value)
+{
+    KOS_OBJ_ID value;
+    int        ret;
 
     /* Mark the value as reserved */
-    if ( ! KOS_atomic_cas_strong_ptr(new_item->value, TOMBSTONE, RESERVED))
+    if ( ! KOS_atomic_cas_strong_ptr(*new_value, TOMBSTONE, RESERVED))
         /* Another thread salvaged this slot */
         return 0;
 
     /* Get the value from the old table and close the slot */
-    value = (KOS_OBJ_ID)KOS_atomic_swap_ptr(old_item->value, CLOSED);
+    value = (KOS_OBJ_ID)KOS_atomic_swap_ptr(*old_value, CLOSED);
     if (value == CLOSED) {
         /* While this thread has reserved a slot in the new table,
-         * another thread went the fast path at the top of this function
+         * another thread went the fast path at the top of salvage function
          * and closed the slot quickly.  Now we will attempt to mark
          * the slot as deleted in the new table. */
         value = TOMBSTONE;
@@ -269,44 +447,117 @@ static int salvage_item(KOS_CONTEXT ctx,
 
     /* Store the value in the new table, unless another thread already
      * wrote something newer */
-    if (KOS_atomic_cas_strong_ptr(new_item->value, RESERVED, value))
+    if (KOS_atomic_cas_strong_ptr(*new_value, RESERVED, value))
         return ret;
 
     return ret;
 }
 
+static int salvage_item(KOS_CONTEXT ctx,
+                        KOS_PITEM  *old_item,
+                        KOS_OBJ_ID  new_table,
+                        uint32_t    new_capacity)
+{
+    KOS_OBJ_ID key;
+    KOS_OBJ_ID value;
+    KOS_PITEM *new_item;
+
+    /* Attempt to close an empty or deleted slot early */
+    if (KOS_atomic_cas_strong_ptr(old_item->value, TOMBSTONE, CLOSED))
+        return 1;
+
+    value = KOS_atomic_read_relaxed_obj(old_item->value);
+    if (value == CLOSED)
+        return 0;
+
+    key = KOS_atomic_read_relaxed_obj(old_item->key);
+    assert( ! IS_BAD_PTR(key));
+
+    /* Claim a slot in the new table */
+    new_item = claim_new_item(new_table,
+                              new_capacity,
+                              key,
+                              KOS_atomic_read_relaxed_u32(old_item->hash.hash));
+
+    return move_value(&old_item->value, &new_item->value);
+}
+
+static int salvage_shaped_item(KOS_CONTEXT ctx,
+                               KOS_OBJ_ID  old_table,
+                               uint32_t    idx,
+                               KOS_OBJ_ID  new_table,
+                               uint32_t    new_capacity)
+{
+    KOS_ATOMIC(KOS_OBJ_ID) *const old_value = &OBJPTR(SHAPED_STORAGE, old_table)->values[idx];
+    KOS_ATOMIC(KOS_OBJ_ID)       *new_value;
+    KOS_OBJ_ID                    value;
+
+    /* Attempt to close an empty or deleted slot early */
+    if (KOS_atomic_cas_strong_ptr(*old_value, TOMBSTONE, CLOSED))
+        return 1;
+
+    value = KOS_atomic_read_acquire_obj(*old_value);
+    if (value == CLOSED)
+        return 0;
+
+    if (GET_OBJ_TYPE(new_table) == OBJ_SHAPED_STORAGE)
+        new_value = &OBJPTR(SHAPED_STORAGE, new_table)->values[idx];
+    else {
+        /* The key is always added to the shape before the value is written */
+        const KOS_OBJ_ID shape_obj = KOS_atomic_read_acquire_obj(
+                                        OBJPTR(SHAPED_STORAGE, old_table)->shape);
+        KOS_SHAPE *const shape     = OBJPTR(SHAPE, shape_obj);
+
+        assert(idx < shape->num_props);
+
+        new_value = &claim_new_item(new_table,
+                                    new_capacity,
+                                    shape->keys[idx],
+                                    KOS_SHAPE_HASHES(shape)[idx])->value;
+    }
+
+    return move_value(old_value, new_value);
+}
+
 static void copy_table(KOS_CONTEXT ctx,
                        KOS_OBJ_ID  src_obj_id,
                        KOS_OBJ_ID  old_table,
                        KOS_OBJ_ID  new_table)
 {
-    const uint32_t old_capacity = KOS_atomic_read_relaxed_u32(
-                                    OBJPTR(OBJECT_STORAGE, old_table)->capacity);
-    const uint32_t new_capacity = KOS_atomic_read_relaxed_u32(
-                                    OBJPTR(OBJECT_STORAGE, new_table)->capacity);
-    const uint32_t mask         = old_capacity - 1;
-    const uint32_t fuzz         = 64U * (old_capacity - KOS_atomic_read_relaxed_u32(
-                                    OBJPTR(OBJECT_STORAGE, old_table)->num_slots_open));
-    uint32_t       i            = fuzz & mask;
+    KOS_ATOMIC(uint32_t) *const num_slots_open = get_num_slots_open(old_table);
+    KOS_ATOMIC(uint32_t) *const active_copies  = get_active_copies(old_table);
+    const int                   shaped         = GET_OBJ_TYPE(old_table) == OBJ_SHAPED_STORAGE;
+    const uint32_t              old_capacity   = get_table_capacity(old_table);
+    const uint32_t              new_capacity   = get_table_capacity(new_table);
+    const uint32_t              mask           = old_capacity - 1;
+    const uint32_t              fuzz           = 64U * (old_capacity -
+                                                        KOS_atomic_read_relaxed_u32(*num_slots_open));
+    uint32_t                    i              = fuzz & mask;
+    int                         completed      = 0;
 
     KOS_ATOMIC(KOS_OBJ_ID) *props;
 
-    KOS_atomic_add_i32(OBJPTR(OBJECT_STORAGE, old_table)->active_copies, 1);
+    KOS_atomic_add_i32(*active_copies, 1);
 
     for (;;) {
-        if (salvage_item(ctx,
-                         OBJPTR(OBJECT_STORAGE, old_table)->items + i,
-                         new_table,
-                         new_capacity)) {
+        const int salvaged = shaped
+            ? salvage_shaped_item(ctx, old_table, i, new_table, new_capacity)
+            : salvage_item(ctx,
+                           OBJPTR(OBJECT_STORAGE, old_table)->items + i,
+                           new_table,
+                           new_capacity);
+
+        if (salvaged) {
             KOS_PERF_CNT(object_salvage_success);
-            if (KOS_atomic_add_i32(OBJPTR(OBJECT_STORAGE, old_table)->num_slots_open,
-                                   -1) == 1)
+            if (KOS_atomic_add_i32(*num_slots_open, -1) == 1) {
+                completed = 1;
                 break;
+            }
         }
         /* Early exit if another thread has finished salvaging */
         else {
             KOS_PERF_CNT(object_salvage_fail);
-            if ( ! KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, old_table)->num_slots_open))
+            if ( ! KOS_atomic_read_relaxed_u32(*num_slots_open))
                 break;
         }
 
@@ -314,20 +565,29 @@ static void copy_table(KOS_CONTEXT ctx,
         i = (i + 1) & mask;
     }
 
+    /* Once all slots are closed, no more values can be written to the old
+     * shaped storage, so the thread which closed the last slot publishes
+     * the final shape in the new storage. */
+    if (completed && (GET_OBJ_TYPE(new_table) == OBJ_SHAPED_STORAGE))
+        KOS_atomic_write_release_ptr(OBJPTR(SHAPED_STORAGE, new_table)->shape,
+                                     KOS_atomic_read_acquire_obj(OBJPTR(SHAPED_STORAGE, old_table)->shape));
+
     /* Avoid race when one thread marks a slot as reserved in the new
      * table while another thread deletes the original item and
      * closes the source slot. */
-    if (KOS_atomic_add_i32(OBJPTR(OBJECT_STORAGE, old_table)->active_copies, -1) > 1) {
-        while (KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, old_table)->active_copies))
+    if (KOS_atomic_add_i32(*active_copies, -1) > 1) {
+        while (KOS_atomic_read_relaxed_u32(*active_copies))
             kos_yield();
     }
 
+    kos_write_barrier(new_table);
+
     props = get_properties(src_obj_id);
     if (KOS_atomic_cas_strong_ptr(*props, old_table, new_table)) {
+        kos_write_barrier(src_obj_id);
 #ifndef NDEBUG
         for (i = 0; i < old_capacity; i++) {
-            KOS_PITEM *item  = OBJPTR(OBJECT_STORAGE, old_table)->items + i;
-            KOS_OBJ_ID value = KOS_atomic_read_relaxed_obj(item->value);
+            KOS_OBJ_ID value = KOS_atomic_read_relaxed_obj(*get_table_value(old_table, i));
             assert(value == CLOSED);
         }
 #endif
@@ -338,11 +598,10 @@ static KOS_OBJ_ID help_copy_table(KOS_CONTEXT ctx,
                                   KOS_OBJ_ID  src_obj_id,
                                   KOS_OBJ_ID  old_table)
 {
-    const KOS_OBJ_ID new_table = KOS_atomic_read_relaxed_obj(
-                                    OBJPTR(OBJECT_STORAGE, old_table)->new_prop_table);
+    const KOS_OBJ_ID new_table = KOS_atomic_read_relaxed_obj(*get_new_prop_table(old_table));
     assert( ! IS_BAD_PTR(new_table));
 
-    if (KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, old_table)->active_copies))
+    if (KOS_atomic_read_relaxed_u32(*get_active_copies(old_table)))
         copy_table(ctx, src_obj_id, old_table, new_table);
 
     return new_table;
@@ -373,20 +632,17 @@ static int need_resize(KOS_OBJ_ID table, unsigned num_reprobes)
     return 1;
 }
 
-static int resize_prop_table(KOS_CONTEXT ctx,
-                             KOS_OBJ_ID  obj_id,
-                             KOS_OBJ_ID  old_table_obj,
-                             uint32_t    grow_factor)
+static int replace_prop_table(KOS_CONTEXT ctx,
+                              KOS_OBJ_ID  obj_id,
+                              KOS_OBJ_ID  old_table_obj,
+                              KOS_TYPE    new_type,
+                              uint32_t    new_capacity)
 {
-    int            error        = KOS_SUCCESS;
-    const uint32_t old_capacity = IS_BAD_PTR(old_table_obj) ? 0U :
-        KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, old_table_obj)->capacity);
-    const uint32_t new_capacity = old_capacity ? old_capacity * grow_factor
-                                               : KOS_MIN_PROPS_CAPACITY;
-    KOS_OBJ_ID     new_table    = KOS_BADPTR;
+    int        error     = KOS_SUCCESS;
+    KOS_OBJ_ID new_table = KOS_BADPTR;
 
     if ( ! IS_BAD_PTR(old_table_obj))
-        new_table = KOS_atomic_read_relaxed_obj(OBJPTR(OBJECT_STORAGE, old_table_obj)->new_prop_table);
+        new_table = KOS_atomic_read_relaxed_obj(*get_new_prop_table(old_table_obj));
 
     if ( ! IS_BAD_PTR(new_table)) {
         /* Another thread is already resizing the property table, help it */
@@ -402,28 +658,26 @@ static int resize_prop_table(KOS_CONTEXT ctx,
         KOS_init_local_with(ctx, &obj, obj_id);
         KOS_init_local_with(ctx, &old_table, old_table_obj);
 
-        new_table = alloc_buffer(ctx, new_capacity);
+        if (new_type == OBJ_SHAPED_STORAGE)
+            new_table = alloc_shaped_storage(ctx, new_capacity);
+        else
+            new_table = alloc_buffer(ctx, new_capacity);
 
         if ( ! IS_BAD_PTR(new_table)) {
-            unsigned i;
-
-            KOS_atomic_write_relaxed_u32(OBJPTR(OBJECT_STORAGE, new_table)->capacity,       new_capacity);
-            KOS_atomic_write_relaxed_u32(OBJPTR(OBJECT_STORAGE, new_table)->num_slots_used, 0);
-            KOS_atomic_write_relaxed_u32(OBJPTR(OBJECT_STORAGE, new_table)->num_slots_open, new_capacity);
-            KOS_atomic_write_relaxed_u32(OBJPTR(OBJECT_STORAGE, new_table)->active_copies,  0);
-            KOS_atomic_write_relaxed_ptr(OBJPTR(OBJECT_STORAGE, new_table)->new_prop_table, KOS_BADPTR);
-
-            for (i = 0; i < new_capacity; i++) {
-                KOS_atomic_write_relaxed_ptr(OBJPTR(OBJECT_STORAGE, new_table)->items[i].key,       KOS_BADPTR);
-                KOS_atomic_write_relaxed_u32(OBJPTR(OBJECT_STORAGE, new_table)->items[i].hash.hash, 0);
-                KOS_atomic_write_relaxed_ptr(OBJPTR(OBJECT_STORAGE, new_table)->items[i].value,     TOMBSTONE);
-            }
 
             if ( ! IS_BAD_PTR(old_table.o)) {
-                if (KOS_atomic_cas_strong_ptr(OBJPTR(OBJECT_STORAGE, old_table.o)->new_prop_table,
+                if (KOS_atomic_cas_strong_ptr(*get_new_prop_table(old_table.o),
                                               KOS_BADPTR,
                                               new_table)) {
 
+                    kos_write_barrier(old_table.o);
+
+                    /* Keys can be added to the new table as soon as it is published */
+                    if (KOS_atomic_read_acquire_u32(*get_watched(old_table.o))) {
+                        KOS_atomic_write_relaxed_u32(*get_watched(new_table), 1U);
+                        kos_invalidate_prop_caches(ctx->inst);
+                    }
+
                     copy_table(ctx, obj.o, old_table.o, new_table);
 
                     KOS_PERF_CNT(object_resize_success);
@@ -439,9 +693,16 @@ static int resize_prop_table(KOS_CONTEXT ctx,
             else {
                 KOS_ATOMIC(KOS_OBJ_ID) *props = get_properties(obj.o);
 
-                if ( ! KOS_atomic_cas_strong_ptr(*props,
-                                                 KOS_BADPTR,
-                                                 new_table)) {
+                /* New object starts with an empty shape */
+                if (new_type == OBJ_SHAPED_STORAGE)
+                    KOS_atomic_write_relaxed_ptr(OBJPTR(SHAPED_STORAGE, new_table)->shape,
+                                                 ctx->inst->shapes.root);
+
+                if (KOS_atomic_cas_strong_ptr(*props,
+                                              KOS_BADPTR,
+                                              new_table))
+                    kos_write_barrier(obj.o);
+                else {
                     /* Somebody already resized it */
                     KOS_PERF_CNT(object_resize_fail);
                 }
@@ -456,6 +717,30 @@ static int resize_prop_table(KOS_CONTEXT ctx,
     return error;
 }
 
+static int resize_prop_table(KOS_CONTEXT ctx,
+                             KOS_OBJ_ID  obj_id,
+                             KOS_OBJ_ID  old_table_obj,
+                             uint32_t    grow_factor)
+{
+    KOS_TYPE new_type     = OBJ_OBJECT_STORAGE;
+    uint32_t new_capacity = KOS_MIN_PROPS_CAPACITY;
+
+    if (IS_BAD_PTR(old_table_obj)) {
+        /* Only plain objects use shapes */
+        if ((GET_OBJ_TYPE(obj_id) == OBJ_OBJECT) && ! IS_BAD_PTR(ctx->inst->shapes.root))
+            new_type = OBJ_SHAPED_STORAGE;
+    }
+    else {
+        new_capacity = get_table_capacity(old_table_obj) * grow_factor;
+
+        if ((GET_OBJ_TYPE(old_table_obj) == OBJ_SHAPED_STORAGE) &&
+            (new_capacity <= KOS_MAX_SHAPE_PROPS))
+            new_type = OBJ_SHAPED_STORAGE;
+    }
+
+    return replace_prop_table(ctx, obj_id, old_table_obj, new_type, new_capacity);
+}
+
 static void raise_no_property(KOS_CONTEXT ctx, KOS_OBJ_ID prop)
 {
     KOS_VECTOR prop_cstr;
@@ -470,12 +755,14 @@ static void raise_no_property(KOS_CONTEXT ctx, KOS_OBJ_ID prop)
 
 static KOS_ATOMIC(KOS_OBJ_ID) *find_valid_prototype(KOS_CONTEXT             ctx,
                                                     KOS_OBJ_ID             *obj_id,
-                                                    KOS_ATOMIC(KOS_OBJ_ID) *props)
+                                                    KOS_ATOMIC(KOS_OBJ_ID) *props,
+                                                    uint32_t               *depth)
 {
     while ( ! props || IS_BAD_PTR(read_props(props))) {
         const KOS_OBJ_ID next_obj_id = KOS_get_prototype(ctx, *obj_id);
 
         *obj_id = next_obj_id;
+        ++*depth;
 
         if (IS_BAD_PTR(next_obj_id)) {
             props = KOS_NULL;
@@ -494,16 +781,59 @@ enum GET_STATUS {
     GET_FOUND
 };
 
+static enum GET_STATUS find_shaped_property(KOS_OBJ_ID  prop_table,
+                                            KOS_OBJ_ID  prop,
+                                            uint32_t    hash,
+                                            KOS_OBJ_ID *retval,
+                                            uint32_t   *slot)
+{
+    KOS_SHAPED_STORAGE *const storage   = OBJPTR(SHAPED_STORAGE, prop_table);
+    const KOS_OBJ_ID          shape_obj = KOS_atomic_read_acquire_obj(storage->shape);
+    const int                 idx       = find_shape_key(shape_obj, prop, hash);
+    KOS_OBJ_ID                value;
+
+    if (idx < 0) {
+        /* All values have been moved to the new storage, which can have new keys */
+        if ( ! KOS_atomic_read_relaxed_u32(storage->num_slots_open))
+            return GET_TRY_NEW_TABLE;
+
+        return GET_TRY_PROTOTYPE;
+    }
+
+    value = KOS_atomic_read_acquire_obj(storage->values[idx]);
+
+    /* Object property storage is being resized, so read value from the new storage */
+    if (value == CLOSED)
+        return GET_TRY_NEW_TABLE;
+
+    /* Key deleted or write incomplete, will look in prototype */
+    if (value == TOMBSTONE)
+        return GET_TRY_PROTOTYPE;
+
+    assert(value != RESERVED);
+    *retval = value;
+    *slot   = (uint32_t)idx;
+    return GET_FOUND;
+}
+
 static enum GET_STATUS find_property(KOS_OBJ_ID  prop_table,
                                      KOS_OBJ_ID  prop,
                                      uint32_t    hash,
-                                     KOS_OBJ_ID *retval)
+                                     KOS_OBJ_ID *retval,
+                                     uint32_t   *slot)
 {
-    KOS_PITEM *items        = OBJPTR(OBJECT_STORAGE, prop_table)->items;
-    uint32_t   num_reprobes = KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, prop_table)->capacity);
-    uint32_t   mask         = num_reprobes - 1;
+    KOS_PITEM *items;
+    uint32_t   num_reprobes;
+    uint32_t   mask;
     uint32_t   idx          = hash;
 
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE)
+        return find_shaped_property(prop_table, prop, hash, retval, slot);
+
+    items        = OBJPTR(OBJECT_STORAGE, prop_table)->items;
+    num_reprobes = KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, prop_table)->capacity);
+    mask         = num_reprobes - 1;
+
     for (;;) {
         KOS_PITEM *const cur_item  = items + (idx &= mask);
         KOS_OBJ_ID       cur_key   = KOS_atomic_read_relaxed_obj(cur_item->key);
@@ -523,6 +853,7 @@ static enum GET_STATUS find_property(KOS_OBJ_ID  prop_table,
             if (cur_value != TOMBSTONE) {
                 assert(cur_value != RESERVED);
                 *retval = cur_value;
+                *slot   = idx;
                 return GET_FOUND;
             }
 
@@ -542,15 +873,121 @@ static enum GET_STATUS find_property(KOS_OBJ_ID  prop_table,
     return GET_TRY_PROTOTYPE;
 }
 
-KOS_OBJ_ID KOS_get_property_with_depth(KOS_CONTEXT      ctx,
-                                       KOS_OBJ_ID       obj_id,
-                                       KOS_OBJ_ID       prop,
-                                       enum KOS_DEPTH_E shallow)
+/* Returns shape with the key appended to the keys of the specified shape.
+ * Returns KOS_BADPTR without raising an exception if the object cannot have
+ * a shape with the key, because the limit of properties or shapes has been
+ * reached. */
+static int get_child_shape(KOS_CONTEXT ctx,
+                           KOS_OBJ_ID  shape_obj,
+                           KOS_OBJ_ID  prop_obj,
+                           uint32_t    hash,
+                           KOS_OBJ_ID *child_shape)
+{
+    KOS_INSTANCE *const inst        = ctx->inst;
+    const KOS_OBJ_ID    transitions = read_props(&OBJPTR(SHAPE, shape_obj)->transitions);
+    const uint32_t      num_props   = OBJPTR(SHAPE, shape_obj)->num_props;
+    KOS_LOCAL           shape;
+    KOS_LOCAL           prop;
+    KOS_LOCAL           child;
+    int                 error       = KOS_SUCCESS;
+
+    *child_shape = KOS_BADPTR;
+
+    if ( ! IS_BAD_PTR(transitions)) {
+        uint32_t slot;
+
+        if (find_property(transitions, prop_obj, hash, child_shape, &slot) == GET_FOUND)
+            return KOS_SUCCESS;
+    }
+
+    if ((num_props >= KOS_MAX_SHAPE_PROPS) ||
+        (KOS_atomic_read_relaxed_u32(inst->shapes.num_shapes) >= KOS_MAX_SHAPES))
+        return KOS_SUCCESS;
+
+    KOS_atomic_add_u32(inst->shapes.num_shapes, 1U);
+
+    KOS_init_locals(ctx, &shape, &prop, &child, kos_end_locals);
+    shape.o = shape_obj;
+    prop.o  = prop_obj;
+
+    child.o = alloc_shape(ctx, num_props + 1U);
+
+    if ( ! IS_BAD_PTR(child.o)) {
+        KOS_SHAPE *const src        = OBJPTR(SHAPE, shape.o);
+        KOS_SHAPE *const dst        = OBJPTR(SHAPE, child.o);
+        uint32_t  *const src_hashes = KOS_SHAPE_HASHES(src);
+        uint32_t  *const dst_hashes = KOS_SHAPE_HASHES(dst);
+        uint32_t         i;
+
+        for (i = 0; i < num_props; i++) {
+            dst->keys[i]  = src->keys[i];
+            dst_hashes[i] = src_hashes[i];
+        }
+
+        dst->keys[num_props]  = prop.o;
+        dst_hashes[num_props] = hash;
+
+        error = KOS_set_property(ctx, shape.o, prop.o, child.o);
+    }
+    else
+        error = KOS_ERROR_EXCEPTION;
+
+    if (error)
+        child.o = KOS_BADPTR;
+
+    *child_shape = KOS_destroy_top_locals(ctx, &shape, &child);
+
+    return error;
+}
+
+#define PROP_CACHE_CAP_BITS    5
+#define PROP_CACHE_DEPTH_BITS  3
+#define PROP_CACHE_SLOT_SHIFT  (PROP_CACHE_CAP_BITS + PROP_CACHE_DEPTH_BITS)
+#define PROP_CACHE_CAP_MASK    ((1U << PROP_CACHE_CAP_BITS) - 1U)
+#define PROP_CACHE_DEPTH_MASK  ((1U << PROP_CACHE_DEPTH_BITS) - 1U)
+#define PROP_CACHE_SHAPED      PROP_CACHE_CAP_MASK
+
+/* Cache entry layout, from least significant bits:
+ * - log2 of property table capacity or all ones for shaped storage,
+ *   zero indicates an empty entry,
+ * - number of prototype hops from the accessed object to the property table,
+ * - slot index in the property table. */
+static uint32_t make_prop_cache_entry(uint32_t   depth,
+                                      KOS_OBJ_ID prop_table,
+                                      uint32_t   slot)
+{
+    uint32_t cap_bits = 0;
+
+    if ((depth > PROP_CACHE_DEPTH_MASK) || (slot >= (1U << (32 - PROP_CACHE_SLOT_SHIFT))))
+        return 0;
+
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE)
+        cap_bits = PROP_CACHE_SHAPED;
+    else {
+        const uint32_t capacity = KOS_atomic_read_relaxed_u32(
+                                    OBJPTR(OBJECT_STORAGE, prop_table)->capacity);
+
+        while ((1U << cap_bits) < capacity)
+            ++cap_bits;
+    }
+
+    assert(cap_bits > 0);
+
+    return cap_bits | (depth << PROP_CACHE_CAP_BITS) | (slot << PROP_CACHE_SLOT_SHIFT);
+}
+
+static KOS_OBJ_ID get_property(KOS_CONTEXT      ctx,
+                               KOS_OBJ_ID       obj_id,
+                               KOS_OBJ_ID       prop,
+                               enum KOS_DEPTH_E shallow,
+                               uint32_t        *cache_entry)
 {
     KOS_ATOMIC(KOS_OBJ_ID) *props;
     KOS_OBJ_ID              retval = KOS_BADPTR;
     KOS_OBJ_ID              prop_table;
     uint32_t                hash;
+    uint32_t                depth  = 0;
+    uint32_t                slot   = 0;
 
     assert( ! IS_BAD_PTR(obj_id));
     assert( ! IS_BAD_PTR(prop));
@@ -565,7 +1002,7 @@ KOS_OBJ_ID KOS_get_property_with_depth(KOS_CONTEXT      ctx,
 
     /* Find non-empty property table in this object or in a prototype */
     if ( ! shallow)
-        props = find_valid_prototype(ctx, &obj_id, props);
+        props = find_valid_prototype(ctx, &obj_id, props, &depth);
     else if (props && IS_BAD_PTR(read_props(props)))
         props = KOS_NULL;
 
@@ -581,14 +1018,14 @@ KOS_OBJ_ID KOS_get_property_with_depth(KOS_CONTEXT      ctx,
     for (;;) {
 
         /* Find property */
-        const enum GET_STATUS status = find_property(prop_table, prop, hash, &retval);
+        const enum GET_STATUS status = find_property(prop_table, prop, hash, &retval, &slot);
 
         if (status == GET_FOUND)
             break;
         else if (status == GET_TRY_PROTOTYPE) {
 
             /* Find non-empty property table in a prototype */
-            props = shallow ? KOS_NULL : find_valid_prototype(ctx, &obj_id, KOS_NULL);
+            props = shallow ? KOS_NULL : find_valid_prototype(ctx, &obj_id, KOS_NULL, &depth);
 
             if ( ! props) {
                 raise_no_property(ctx, prop);
@@ -605,14 +1042,402 @@ KOS_OBJ_ID KOS_get_property_with_depth(KOS_CONTEXT      ctx,
         }
     }
 
-    if ( ! IS_BAD_PTR(retval))
+    if ( ! IS_BAD_PTR(retval)) {
         KOS_PERF_CNT(object_get_success);
+
+        *cache_entry = make_prop_cache_entry(depth, prop_table, slot);
+    }
     else
         KOS_PERF_CNT(object_get_fail);
 
     return retval;
 }
 
+KOS_OBJ_ID kos_find_own_property(KOS_CONTEXT ctx,
+                                 KOS_OBJ_ID  obj_id,
+                                 KOS_OBJ_ID  prop)
+{
+    KOS_ATOMIC(KOS_OBJ_ID) *props;
+    KOS_OBJ_ID              retval = KOS_BADPTR;
+    KOS_OBJ_ID              prop_table;
+    uint32_t                hash;
+    uint32_t                slot;
+
+    assert(GET_OBJ_TYPE(prop) == OBJ_STRING);
+
+    props = get_properties(obj_id);
+
+    if ( ! props)
+        return KOS_BADPTR;
+
+    prop_table = read_props(props);
+
+    if (IS_BAD_PTR(prop_table))
+        return KOS_BADPTR;
+
+    hash = KOS_string_get_hash(prop);
+
+    for (;;) {
+
+        const enum GET_STATUS status = find_property(prop_table, prop, hash, &retval, &slot);
+
+        if (status != GET_TRY_NEW_TABLE)
+            break;
+
+        prop_table = help_copy_table(ctx, obj_id, prop_table);
+    }
+
+    return retval;
+}
+
+KOS_OBJ_ID KOS_get_property_with_depth(KOS_CONTEXT      ctx,
+                                       KOS_OBJ_ID       obj_id,
+                                       KOS_OBJ_ID       prop,
+                                       enum KOS_DEPTH_E shallow)
+{
+    uint32_t cache_entry = 0;
+
+    return get_property(ctx, obj_id, prop, shallow, &cache_entry);
+}
+
+/* Returns pointer to the property value at the cached slot, if the object's
+ * current property table has the cached capacity or the object's shape has
+ * the property at the cached slot. */
+static KOS_ATOMIC(KOS_OBJ_ID) *get_cached_value(KOS_OBJ_ID obj_id,
+                                                KOS_OBJ_ID prop,
+                                                uint32_t   entry)
+{
+    KOS_ATOMIC(KOS_OBJ_ID) *props      = get_properties(obj_id);
+    const uint32_t          slot       = entry >> PROP_CACHE_SLOT_SHIFT;
+    const uint32_t          cap_bits   = entry & PROP_CACHE_CAP_MASK;
+    KOS_OBJ_ID              prop_table;
+    KOS_PITEM              *item;
+    KOS_OBJ_ID              key;
+
+    if ( ! props)
+        return KOS_NULL;
+
+    prop_table = read_props(props);
+
+    if (IS_BAD_PTR(prop_table))
+        return KOS_NULL;
+
+    if (GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE) {
+        const KOS_OBJ_ID shape_obj = KOS_atomic_read_acquire_obj(
+                                        OBJPTR(SHAPED_STORAGE, prop_table)->shape);
+        KOS_SHAPE *const shape     = OBJPTR(SHAPE, shape_obj);
+
+        if ((cap_bits != PROP_CACHE_SHAPED) || (slot >= shape->num_props))
+            return KOS_NULL;
+
+        key = shape->keys[slot];
+
+        if ((key != prop) &&
+            ((KOS_SHAPE_HASHES(shape)[slot] != KOS_string_get_hash(prop)) ||
+             KOS_string_compare(key, prop)))
+            return KOS_NULL;
+
+        return &OBJPTR(SHAPED_STORAGE, prop_table)->values[slot];
+    }
+
+    if ((cap_bits == PROP_CACHE_SHAPED) ||
+        (KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, prop_table)->capacity)
+            != (1U << cap_bits)))
+        return KOS_NULL;
+
+    item = &OBJPTR(OBJECT_STORAGE, prop_table)->items[slot];
+    key  = KOS_atomic_read_relaxed_obj(item->key);
+
+    if (key != prop) {
+        if (IS_BAD_PTR(key) || ! is_key_equal(prop, KOS_string_get_hash(prop), key, item))
+            return KOS_NULL;
+    }
+
+    return &item->value;
+}
+
+static KOS_OBJ_ID get_cached_property(KOS_CONTEXT ctx,
+                                      KOS_OBJ_ID  obj_id,
+                                      KOS_OBJ_ID  prop,
+                                      uint32_t    entry)
+{
+    uint32_t                depth = (entry >> PROP_CACHE_CAP_BITS) & PROP_CACHE_DEPTH_MASK;
+    KOS_ATOMIC(KOS_OBJ_ID) *item;
+    KOS_OBJ_ID              value;
+
+    /* The property must not exist in any object before the cached one */
+    for ( ; depth; --depth) {
+        KOS_ATOMIC(KOS_OBJ_ID) *props = get_properties(obj_id);
+
+        if (props) {
+            const KOS_OBJ_ID prop_table = read_props(props);
+            uint32_t         slot;
+
+            if ( ! IS_BAD_PTR(prop_table) &&
+                (find_property(prop_table, prop, KOS_string_get_hash(prop), &value, &slot) != GET_TRY_PROTOTYPE))
+                return KOS_BADPTR;
+        }
+
+        obj_id = KOS_get_prototype(ctx, obj_id);
+
+        if (IS_BAD_PTR(obj_id))
+            return KOS_BADPTR;
+    }
+
+    item = get_cached_value(obj_id, prop, entry);
+
+    if ( ! item)
+        return KOS_BADPTR;
+
+    value = KOS_atomic_read_acquire_obj(*item);
+
+    if (IS_BAD_PTR(value) || (value == TOMBSTONE) || (value == CLOSED) || (value == RESERVED))
+        return KOS_BADPTR;
+
+    return value;
+}
+
+/* Returns value of a property found in a prototype, which is cached together
+ * with the object holding the property.  Keys are never added to any watched
+ * prototype between the accessed object and the holder without changing the
+ * epoch, so only the accessed object itself needs to be checked. */
+static KOS_OBJ_ID get_holder_property(KOS_CONTEXT ctx,
+                                      KOS_OBJ_ID  obj_id,
+                                      KOS_OBJ_ID  prop,
+                                      uint32_t    entry,
+                                      KOS_OBJ_ID  proto,
+                                      KOS_OBJ_ID  holder,
+                                      KOS_OBJ_ID  shape)
+{
+    KOS_ATOMIC(KOS_OBJ_ID) *props;
+    KOS_ATOMIC(KOS_OBJ_ID) *item;
+    KOS_OBJ_ID              value;
+
+    if (KOS_get_prototype(ctx, obj_id) != proto)
+        return KOS_BADPTR;
+
+    props = get_properties(obj_id);
+
+    if (props) {
+        const KOS_OBJ_ID prop_table = read_props(props);
+
+        /* The shape was cached only if it does not have the key */
+        if ( ! IS_BAD_PTR(prop_table) &&
+            ! ((GET_OBJ_TYPE(prop_table) == OBJ_SHAPED_STORAGE) &&
+               (KOS_atomic_read_acquire_obj(OBJPTR(SHAPED_STORAGE, prop_table)->shape) == shape) &&
+               IS_BAD_PTR(KOS_atomic_read_relaxed_obj(OBJPTR(SHAPED_STORAGE, prop_table)->new_prop_table)))) {
+
+            uint32_t slot;
+
+            if (find_property(prop_table, prop, KOS_string_get_hash(prop), &value, &slot) != GET_TRY_PROTOTYPE)
+                return KOS_BADPTR;
+        }
+    }
+
+    item = get_cached_value(holder, prop, entry);
+
+    if ( ! item)
+        return KOS_BADPTR;
+
+    value = KOS_atomic_read_acquire_obj(*item);
+
+    if (IS_BAD_PTR(value) || (value == TOMBSTONE) || (value == CLOSED) || (value == RESERVED))
+        return KOS_BADPTR;
+
+    return value;
+}
+
+/* Marks property tables of prototypes between the accessed object and the holder
+ * as watched, so that adding a key to any of them changes the epoch.
+ * Returns the holder or KOS_BADPTR if any prototype has no property table yet. */
+static KOS_OBJ_ID watch_prototypes(KOS_CONTEXT ctx,
+                                   KOS_OBJ_ID  proto,
+                                   uint32_t    num_protos)
+{
+    for ( ; num_protos; --num_protos) {
+        KOS_ATOMIC(KOS_OBJ_ID) *props = get_properties(proto);
+
+        if (props) {
+            const KOS_OBJ_ID prop_table = read_props(props);
+
+            if (IS_BAD_PTR(prop_table))
+                return KOS_BADPTR;
+
+            KOS_atomic_write_relaxed_u32(*get_watched(prop_table), 1U);
+        }
+
+        proto = KOS_get_prototype(ctx, proto);
+
+        if (IS_BAD_PTR(proto))
+            break;
+    }
+
+    return proto;
+}
+
+/* Checks that none of the prototypes between the accessed object and the holder
+ * has the key, after their property tables have been marked as watched. */
+static int is_key_absent(KOS_CONTEXT ctx,
+                         KOS_OBJ_ID  proto,
+                         KOS_OBJ_ID  prop,
+                         uint32_t    num_protos)
+{
+    const uint32_t hash = KOS_string_get_hash(prop);
+
+    for ( ; num_protos; --num_protos) {
+        KOS_ATOMIC(KOS_OBJ_ID) *props;
+
+        if (IS_BAD_PTR(proto))
+            return 0;
+
+        props = get_properties(proto);
+
+        if (props) {
+            const KOS_OBJ_ID prop_table = read_props(props);
+            KOS_OBJ_ID       value;
+            uint32_t         slot;
+
+            /* The table could have been replaced before it was marked */
+            if ( ! KOS_atomic_read_relaxed_u32(*get_watched(prop_table)) ||
+                ! IS_BAD_PTR(KOS_atomic_read_relaxed_obj(*get_new_prop_table(prop_table))))
+                return 0;
+
+            if (find_property(prop_table, prop, hash, &value, &slot) != GET_TRY_PROTOTYPE)
+                return 0;
+        }
+
+        proto = KOS_get_prototype(ctx, proto);
+    }
+
+    return 1;
+}
+
+/* Returns shape of the accessed object if the shape does not have the key */
+static KOS_OBJ_ID get_shape_without_key(KOS_OBJ_ID obj_id,
+                                        KOS_OBJ_ID prop)
+{
+    KOS_ATOMIC(KOS_OBJ_ID) *props = get_properties(obj_id);
+    KOS_OBJ_ID              prop_table;
+    KOS_OBJ_ID              shape;
+
+    if ( ! props)
+        return KOS_BADPTR;
+
+    prop_table = read_props(props);
+
+    if (IS_BAD_PTR(prop_table) || (GET_OBJ_TYPE(prop_table) != OBJ_SHAPED_STORAGE))
+        return KOS_BADPTR;
+
+    shape = KOS_atomic_read_acquire_obj(OBJPTR(SHAPED_STORAGE, prop_table)->shape);
+
+    if (find_shape_key(shape, prop, KOS_string_get_hash(prop)) >= 0)
+        return KOS_BADPTR;
+
+    return shape;
+}
+
+static void write_prop_cache(KOS_PROP_CACHE *cache,
+                             uint32_t        entry,
+                             uint32_t        epoch,
+                             KOS_OBJ_ID      proto,
+                             KOS_OBJ_ID      holder,
+                             KOS_OBJ_ID      shape)
+{
+    const uint32_t seq = KOS_atomic_read_relaxed_u32(cache->seq);
+
+    /* Leave the cache alone if another thread is updating it */
+    if ((seq & 1U) || ! KOS_atomic_cas_strong_u32(cache->seq, seq, seq + 1U))
+        return;
+
+    KOS_atomic_write_relaxed_u32(cache->entry,  entry);
+    KOS_atomic_write_relaxed_u32(cache->epoch,  epoch);
+    KOS_atomic_write_relaxed_ptr(cache->proto,  proto);
+    KOS_atomic_write_relaxed_ptr(cache->holder, holder);
+    KOS_atomic_write_relaxed_ptr(cache->shape,  shape);
+
+    KOS_atomic_write_release_u32(cache->seq, seq + 2U);
+}
+
+static void update_prop_cache(KOS_CONTEXT     ctx,
+                              KOS_OBJ_ID      obj_id,
+                              KOS_OBJ_ID      prop,
+                              uint32_t        entry,
+                              KOS_PROP_CACHE *cache)
+{
+    const uint32_t depth  = (entry >> PROP_CACHE_CAP_BITS) & PROP_CACHE_DEPTH_MASK;
+    KOS_OBJ_ID     proto  = KOS_BADPTR;
+    KOS_OBJ_ID     holder = KOS_BADPTR;
+    KOS_OBJ_ID     shape  = KOS_BADPTR;
+    uint32_t       epoch  = 0;
+
+    if (depth) {
+        proto  = KOS_get_prototype(ctx, obj_id);
+        holder = watch_prototypes(ctx, proto, depth - 1U);
+
+        if ( ! IS_BAD_PTR(holder)) {
+
+            /* Pairs with the CAS which adds a key in set_property() or set_shaped_property():
+             * either the key is found below or the epoch is changed after it is read. */
+            KOS_atomic_full_barrier();
+
+            epoch = KOS_atomic_read_acquire_u32(ctx->inst->shapes.proto_epoch);
+
+            if (is_key_absent(ctx, proto, prop, depth - 1U) && get_cached_value(holder, prop, entry))
+                shape = get_shape_without_key(obj_id, prop);
+            else
+                holder = KOS_BADPTR;
+        }
+    }
+
+    write_prop_cache(cache, entry, epoch, proto, holder, shape);
+}
+
+KOS_OBJ_ID kos_get_property_cached(KOS_CONTEXT     ctx,
+                                   KOS_OBJ_ID      obj_id,
+                                   KOS_OBJ_ID      prop,
+                                   KOS_PROP_CACHE *cache)
+{
+    const uint32_t seq   = KOS_atomic_read_acquire_u32(cache->seq);
+    uint32_t       entry = KOS_atomic_read_relaxed_u32(cache->entry);
+    KOS_OBJ_ID     value;
+
+    assert( ! IS_BAD_PTR(obj_id));
+    assert( ! IS_BAD_PTR(prop));
+
+    if (entry && ! (seq & 1U) && (GET_OBJ_TYPE(prop) == OBJ_STRING)) {
+        const uint32_t   epoch  = KOS_atomic_read_relaxed_u32(cache->epoch);
+        const KOS_OBJ_ID proto  = KOS_atomic_read_relaxed_obj(cache->proto);
+        const KOS_OBJ_ID holder = KOS_atomic_read_relaxed_obj(cache->holder);
+        const KOS_OBJ_ID shape  = KOS_atomic_read_relaxed_obj(cache->shape);
+
+        KOS_atomic_acquire_barrier();
+
+        if (KOS_atomic_read_relaxed_u32(cache->seq) == seq) {
+
+            if ( ! IS_BAD_PTR(holder) &&
+                (epoch == KOS_atomic_read_acquire_u32(ctx->inst->shapes.proto_epoch)))
+                value = get_holder_property(ctx, obj_id, prop, entry, proto, holder, shape);
+            else
+                value = get_cached_property(ctx, obj_id, prop, entry);
+
+            if ( ! IS_BAD_PTR(value)) {
+                KOS_PERF_CNT(prop_cache_hit);
+                return value;
+            }
+        }
+    }
+
+    KOS_PERF_CNT(prop_cache_miss);
+
+    entry = 0;
+    value = get_property(ctx, obj_id, prop, KOS_DEEP, &entry);
+
+    if (entry)
+        update_prop_cache(ctx, obj_id, prop, entry, cache);
+
+    return value;
+}
+
 int kos_object_copy_prop_table(KOS_CONTEXT ctx,
                                KOS_OBJ_ID  obj_id)
 {
@@ -626,6 +1451,84 @@ int kos_object_copy_prop_table(KOS_CONTEXT ctx,
     return resize_prop_table(ctx, obj_id, props ? read_props(props) : KOS_BADPTR, 1U);
 }
 
+KOS_OBJ_ID kos_object_clone(KOS_CONTEXT ctx,
+                            KOS_OBJ_ID  obj_id)
+{
+    KOS_LOCAL  src;
+    KOS_LOCAL  dest;
+    KOS_OBJ_ID src_table;
+
+    assert( ! IS_BAD_PTR(obj_id));
+    assert(GET_OBJ_TYPE(obj_id) == OBJ_OBJECT);
+
+    KOS_init_local_with(ctx, &src, obj_id);
+    KOS_init_local(     ctx, &dest);
+
+    dest.o = KOS_new_object_with_prototype(ctx, OBJPTR(OBJECT, src.o)->prototype);
+
+    src_table = IS_BAD_PTR(dest.o) ? KOS_BADPTR : read_props(&OBJPTR(OBJECT, src.o)->props);
+
+    if ( ! IS_BAD_PTR(src_table)) {
+
+        const KOS_TYPE   type     = GET_OBJ_TYPE(src_table);
+        const uint32_t   capacity = get_table_capacity(src_table);
+        const KOS_OBJ_ID table    = (type == OBJ_SHAPED_STORAGE)
+                                    ? alloc_shaped_storage(ctx, capacity)
+                                    : alloc_buffer(ctx, capacity);
+        uint32_t         i;
+
+        if (IS_BAD_PTR(table))
+            dest.o = KOS_BADPTR;
+        else {
+            /* The table could have been moved by the GC */
+            src_table = read_props(&OBJPTR(OBJECT, src.o)->props);
+
+            assert(GET_OBJ_TYPE(src_table) == type);
+            assert(IS_BAD_PTR(KOS_atomic_read_relaxed_obj(*get_new_prop_table(src_table))));
+
+            KOS_atomic_write_relaxed_u32(*get_num_slots_open(table),
+                                         KOS_atomic_read_relaxed_u32(*get_num_slots_open(src_table)));
+
+            if (type == OBJ_SHAPED_STORAGE) {
+                KOS_SHAPED_STORAGE *const src_storage = OBJPTR(SHAPED_STORAGE, src_table);
+                KOS_SHAPED_STORAGE *const storage     = OBJPTR(SHAPED_STORAGE, table);
+
+                KOS_atomic_write_relaxed_ptr(storage->shape,
+                                             KOS_atomic_read_acquire_obj(src_storage->shape));
+
+                for (i = 0; i < capacity; i++)
+                    KOS_atomic_write_relaxed_ptr(storage->values[i],
+                                                 KOS_atomic_read_relaxed_obj(src_storage->values[i]));
+            }
+            else {
+                KOS_OBJECT_STORAGE *const src_storage = OBJPTR(OBJECT_STORAGE, src_table);
+                KOS_OBJECT_STORAGE *const storage     = OBJPTR(OBJECT_STORAGE, table);
+
+                KOS_atomic_write_relaxed_u32(storage->num_slots_used,
+                                             KOS_atomic_read_relaxed_u32(src_storage->num_slots_used));
+
+                for (i = 0; i < capacity; i++) {
+                    KOS_PITEM *const src_item = &src_storage->items[i];
+                    KOS_PITEM *const item     = &storage->items[i];
+
+                    KOS_atomic_write_relaxed_ptr(item->key,       KOS_atomic_read_relaxed_obj(src_item->key));
+                    KOS_atomic_write_relaxed_u32(item->hash.hash, KOS_atomic_read_relaxed_u32(src_item->hash.hash));
+                    KOS_atomic_write_relaxed_ptr(item->value,     KOS_atomic_read_relaxed_obj(src_item->value));
+                }
+            }
+
+            KOS_atomic_write_release_ptr(OBJPTR(OBJECT, dest.o)->props, table);
+            kos_write_barrier(dest.o);
+        }
+    }
+
+    obj_id = dest.o;
+
+    KOS_destroy_top_locals(ctx, &dest, &src);
+
+    return obj_id;
+}
+
 enum SET_STATUS {
     SET_FAILED,
     SET_TRY_AGAIN,
@@ -673,6 +1576,8 @@ static enum SET_STATUS set_property(KOS_CONTEXT ctx,
 
             KOS_PERF_CNT_ARRAY(object_collision, KOS_min(collis_depth, 3));
 
+            kos_write_barrier(*prop_table);
+
             KOS_atomic_write_relaxed_u32(cur_item->hash.hash, hash);
             KOS_atomic_add_i32(OBJPTR(OBJECT_STORAGE, *prop_table)->num_slots_used, 1);
         }
@@ -712,7 +1617,13 @@ static enum SET_STATUS set_property(KOS_CONTEXT ctx,
             }
 
             /* It's OK if someone else wrote in the mean time */
-            if ( ! KOS_atomic_cas_strong_ptr(cur_item->value, oldval, value->o))
+            if (KOS_atomic_cas_strong_ptr(cur_item->value, oldval, value->o)) {
+                kos_write_barrier(*prop_table);
+
+                if ((oldval == TOMBSTONE) && (value->o != TOMBSTONE))
+                    notify_key_added(ctx, *prop_table);
+            }
+            else
                 /* Re-read in case it was moved to the new table */
                 oldval = KOS_atomic_read_acquire_obj(cur_item->value);
         }
@@ -730,6 +1641,118 @@ static enum SET_STATUS set_property(KOS_CONTEXT ctx,
     return SET_SUCCESS;
 }
 
+static enum SET_STATUS set_shaped_property(KOS_CONTEXT ctx,
+                                           KOS_LOCAL  *obj,
+                                           KOS_OBJ_ID *prop_table,
+                                           KOS_LOCAL  *prop,
+                                           uint32_t    hash,
+                                           KOS_LOCAL  *value)
+{
+    KOS_SHAPED_STORAGE *storage   = OBJPTR(SHAPED_STORAGE, *prop_table);
+    KOS_OBJ_ID          shape_obj = KOS_atomic_read_acquire_obj(storage->shape);
+    const int           idx       = find_shape_key(shape_obj, prop->o, hash);
+    uint32_t            num_props;
+    KOS_OBJ_ID          child_shape;
+    KOS_OBJ_ID          oldval;
+
+    /* Existing key, write the value */
+    if (idx >= 0) {
+
+        KOS_ATOMIC(KOS_OBJ_ID) *const slot = &storage->values[idx];
+
+        oldval = KOS_atomic_read_acquire_obj(*slot);
+
+        /* We will use the new storage if it was copied */
+        if (oldval != CLOSED) {
+
+            /* If this is a dynamic property, throw it */
+            if (GET_OBJ_TYPE(oldval) == OBJ_DYNAMIC_PROP && value->o != TOMBSTONE) {
+
+                KOS_raise_exception(ctx, oldval);
+                return SET_CALL_SETTER;
+            }
+
+            /* It's OK if someone else wrote in the mean time */
+            if (KOS_atomic_cas_strong_ptr(*slot, oldval, value->o)) {
+                kos_write_barrier(*prop_table);
+
+                if ((oldval == TOMBSTONE) && (value->o != TOMBSTONE))
+                    notify_key_added(ctx, *prop_table);
+            }
+            else
+                /* Re-read in case it was moved to the new storage */
+                oldval = KOS_atomic_read_acquire_obj(*slot);
+        }
+
+        /* Another thread is resizing the storage - use new property storage */
+        if (oldval == CLOSED) {
+            *prop_table = help_copy_table(ctx, obj->o, *prop_table);
+            return SET_TRY_AGAIN;
+        }
+
+        return SET_SUCCESS;
+    }
+
+    /* All values have been moved to the new storage, which can have new keys */
+    if ( ! KOS_atomic_read_relaxed_u32(storage->num_slots_open)) {
+        *prop_table = help_copy_table(ctx, obj->o, *prop_table);
+        return SET_TRY_AGAIN;
+    }
+
+    /* If we are deleting a non-existent property, just bail */
+    if (value->o == TOMBSTONE)
+        return SET_SUCCESS;
+
+    num_props = OBJPTR(SHAPE, shape_obj)->num_props;
+
+    /* Resize if property storage is full */
+    if (num_props >= KOS_atomic_read_relaxed_u32(storage->capacity)) {
+        if (resize_prop_table(ctx, obj->o, *prop_table, 2U))
+            return SET_FAILED;
+
+        *prop_table = read_props(get_properties(obj->o));
+        return SET_TRY_AGAIN;
+    }
+
+    if (get_child_shape(ctx, shape_obj, prop->o, hash, &child_shape))
+        return SET_FAILED;
+
+    /* Objects could have been moved by the garbage collector */
+    storage = OBJPTR(SHAPED_STORAGE, *prop_table);
+
+    /* Convert to hash table if the new shape is not available */
+    if (IS_BAD_PTR(child_shape)) {
+        if (replace_prop_table(ctx, obj->o, *prop_table, OBJ_OBJECT_STORAGE,
+                               KOS_atomic_read_relaxed_u32(storage->capacity) * 2U))
+            return SET_FAILED;
+
+        *prop_table = read_props(get_properties(obj->o));
+        return SET_TRY_AGAIN;
+    }
+
+    shape_obj = KOS_atomic_read_acquire_obj(storage->shape);
+
+    /* Add the key to the shape, unless another thread added another key in the mean time */
+    if ((OBJPTR(SHAPE, shape_obj)->num_props != num_props) ||
+        ! KOS_atomic_cas_strong_ptr(storage->shape, shape_obj, child_shape))
+        return SET_TRY_AGAIN;
+
+    kos_write_barrier(*prop_table);
+
+    /* Write the value, it's OK if someone else wrote in the mean time */
+    if (KOS_atomic_cas_strong_ptr(storage->values[num_props], TOMBSTONE, value->o))
+        notify_key_added(ctx, *prop_table);
+    else {
+        /* Another thread is resizing the storage - use new property storage */
+        if (KOS_atomic_read_acquire_obj(storage->values[num_props]) == CLOSED) {
+            *prop_table = help_copy_table(ctx, obj->o, *prop_table);
+            return SET_TRY_AGAIN;
+        }
+    }
+
+    return SET_SUCCESS;
+}
+
 int KOS_set_property(KOS_CONTEXT ctx,
                      KOS_OBJ_ID  obj_id,
                      KOS_OBJ_ID  prop_obj,
@@ -793,7 +1816,10 @@ int KOS_set_property(KOS_CONTEXT ctx,
         KOS_init_local_with(ctx, &prop_table, read_props(props));
 
         do {
-            status = set_property(ctx, &obj, &prop_table.o, &prop, hash, &value, &num_reprobes);
+            if (GET_OBJ_TYPE(prop_table.o) == OBJ_SHAPED_STORAGE)
+                status = set_shaped_property(ctx, &obj, &prop_table.o, &prop, hash, &value);
+            else
+                status = set_property(ctx, &obj, &prop_table.o, &prop, hash, &value, &num_reprobes);
 
             switch (status) {
                 case SET_CALL_SETTER: error = KOS_ERROR_SETTER;    break;
@@ -803,7 +1829,9 @@ int KOS_set_property(KOS_CONTEXT ctx,
         } while (status == SET_TRY_AGAIN);
 
         /* Check if we need to resize the table */
-        if ( ! error && need_resize(prop_table.o, num_reprobes))
+        if ( ! error &&
+            (GET_OBJ_TYPE(prop_table.o) == OBJ_OBJECT_STORAGE) &&
+            need_resize(prop_table.o, num_reprobes))
             error = resize_prop_table(ctx, obj.o, prop_table.o, 2U);
 
         KOS_destroy_top_local(ctx, &prop_table);
@@ -830,6 +1858,77 @@ cleanup:
     return error;
 }
 
+int kos_set_property_cached(KOS_CONTEXT     ctx,
+                            KOS_OBJ_ID      obj_id,
+                            KOS_OBJ_ID      prop_obj,
+                            KOS_OBJ_ID      value,
+                            KOS_PROP_CACHE *cache)
+{
+    const uint32_t entry = KOS_atomic_read_relaxed_u32(cache->entry);
+    KOS_LOCAL      obj;
+    KOS_LOCAL      prop;
+    int            error;
+
+    assert( ! IS_BAD_PTR(obj_id));
+    assert( ! IS_BAD_PTR(prop_obj));
+    assert( ! IS_BAD_PTR(value));
+
+    /* Only own properties can be cached, the property is never set in a prototype */
+    if (entry &&
+        ! ((entry >> PROP_CACHE_CAP_BITS) & PROP_CACHE_DEPTH_MASK) &&
+        (GET_OBJ_TYPE(prop_obj) == OBJ_STRING)) {
+
+        KOS_ATOMIC(KOS_OBJ_ID) *const item = get_cached_value(obj_id, prop_obj, entry);
+
+        if (item) {
+            const KOS_OBJ_ID oldval = KOS_atomic_read_acquire_obj(*item);
+
+            /* Setters, deleted properties and tables being resized go through the slow path */
+            if ( ! IS_BAD_PTR(oldval) &&
+                (oldval != TOMBSTONE) &&
+                (oldval != CLOSED) &&
+                (oldval != RESERVED) &&
+                (GET_OBJ_TYPE(oldval) != OBJ_DYNAMIC_PROP) &&
+                KOS_atomic_cas_strong_ptr(*item, oldval, value)) {
+
+                kos_write_barrier(read_props(get_properties(obj_id)));
+
+                KOS_PERF_CNT(prop_cache_hit);
+                return KOS_SUCCESS;
+            }
+        }
+    }
+
+    KOS_PERF_CNT(prop_cache_miss);
+
+    KOS_init_local_with(ctx, &obj,  obj_id);
+    KOS_init_local_with(ctx, &prop, prop_obj);
+
+    error = KOS_set_property(ctx, obj.o, prop.o, value);
+
+    if ( ! error) {
+        KOS_ATOMIC(KOS_OBJ_ID) *const props = get_properties(obj.o);
+        const KOS_OBJ_ID              prop_table = props ? read_props(props) : KOS_BADPTR;
+
+        if ( ! IS_BAD_PTR(prop_table)) {
+            KOS_OBJ_ID found;
+            uint32_t   slot;
+
+            if (find_property(prop_table, prop.o, KOS_string_get_hash(prop.o), &found, &slot) == GET_FOUND) {
+
+                const uint32_t new_entry = make_prop_cache_entry(0U, prop_table, slot);
+
+                if (new_entry)
+                    write_prop_cache(cache, new_entry, 0U, KOS_BADPTR, KOS_BADPTR, KOS_BADPTR);
+            }
+        }
+    }
+
+    KOS_destroy_top_locals(ctx, &prop, &obj);
+
+    return error;
+}
+
 int KOS_delete_property(KOS_CONTEXT ctx,
                         KOS_OBJ_ID  obj_id,
                         KOS_OBJ_ID  prop)
@@ -1116,7 +2215,7 @@ int kos_object_walk(KOS_CONTEXT ctx,
 
     table.o = KOS_atomic_read_relaxed_obj(OBJPTR(ITERATOR, walk.o)->key_table);
     if ( ! IS_BAD_PTR(table.o))
-        capacity = KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, table.o)->capacity);
+        capacity = get_table_capacity(table.o);
 
     for (;;) {
 
@@ -1150,7 +2249,7 @@ int kos_object_walk(KOS_CONTEXT ctx,
                     if (IS_BAD_PTR(table.o))
                         continue;
 
-                    capacity = KOS_atomic_read_relaxed_u32(OBJPTR(OBJECT_STORAGE, table.o)->capacity);
+                    capacity = get_table_capacity(table.o);
 
                     KOS_atomic_write_relaxed_u32(OBJPTR(ITERATOR, walk.o)->index, 0U);
                     KOS_atomic_write_release_ptr(OBJPTR(ITERATOR, walk.o)->key_table, table.o);
@@ -1167,7 +2266,7 @@ int kos_object_walk(KOS_CONTEXT ctx,
             break;
         }
 
-        key.o = KOS_atomic_read_relaxed_obj(OBJPTR(OBJECT_STORAGE, table.o)->items[index].key);
+        key.o = get_table_key(table.o, index);
 
         if (IS_BAD_PTR(key.o))
             continue;
@@ -1184,7 +2283,7 @@ int kos_object_walk(KOS_CONTEXT ctx,
                 break;
         }
 
-        value = KOS_atomic_read_acquire_obj(OBJPTR(OBJECT_STORAGE, table.o)->items[index].value);
+        value = KOS_atomic_read_acquire_obj(*get_table_value(table.o, index));
 
         assert( ! IS_BAD_PTR(value));
 
@@ -157,6 +157,7 @@ typedef struct KOS_OBJECT_STORAGE_S {
     KOS_ATOMIC(uint32_t)   num_slots_used;
     KOS_ATOMIC(uint32_t)   num_slots_open;
     KOS_ATOMIC(uint32_t)   active_copies;
+    KOS_ATOMIC(uint32_t)   watched; /* Non-zero if prop caches rely on keys missing here */
     KOS_ATOMIC(KOS_OBJ_ID) new_prop_table;
     KOS_PITEM              items[1];
 } KOS_OBJECT_STORAGE;
@@ -165,11 +166,46 @@ typedef struct KOS_OBJECT_STORAGE_S {
 #define KOS_MAX_PROP_REPROBES  8U
 #define KOS_SPEED_GROW_BELOW   64U
 
+/* Shape describes layout of properties of objects, which had the same
+ * properties added in the same order.  Shapes are immutable, except for
+ * the table of transitions, which maps keys to child shapes, i.e. shapes
+ * with one more property appended.  Shapes form a tree with the root
+ * being an empty shape held by the instance. */
+typedef struct KOS_SHAPE_S {
+    KOS_OBJ_HEADER         header;
+    uint32_t               num_props;   /* Number of properties described by this shape */
+    KOS_ATOMIC(KOS_OBJ_ID) transitions; /* Property table mapping keys to child shapes  */
+    KOS_OBJ_ID             keys[1];     /* Keys followed by their hashes                */
+} KOS_SHAPE;
+
+/* Property storage of an object with a shape.  Values are stored in the
+ * same order in which the keys occur in the shape. */
+typedef struct KOS_SHAPED_STORAGE_S {
+    KOS_OBJ_HEADER         header;
+    KOS_ATOMIC(uint32_t)   capacity;
+    KOS_ATOMIC(uint32_t)   num_slots_open;
+    KOS_ATOMIC(uint32_t)   active_copies;
+    KOS_ATOMIC(uint32_t)   watched; /* Non-zero if prop caches rely on keys missing here */
+    KOS_ATOMIC(KOS_OBJ_ID) shape;
+    KOS_ATOMIC(KOS_OBJ_ID) new_prop_table;
+    KOS_ATOMIC(KOS_OBJ_ID) values[1];
+} KOS_SHAPED_STORAGE;
+
+#define KOS_SHAPE_HASHES(shape) ((uint32_t *)((uint8_t *)(shape)->keys + (shape)->num_props * sizeof(KOS_OBJ_ID)))
+
+int kos_init_shapes(KOS_CONTEXT ctx);
+
 void kos_init_object(KOS_OBJECT *obj, KOS_OBJ_ID prototype);
 
 int kos_object_copy_prop_table(KOS_CONTEXT ctx,
                                KOS_OBJ_ID  obj_id);
 
+/* Creates a new object with the same prototype and a copy of the property table
+ * of the source object.  The source object must not be modified concurrently,
+ * which holds for templates in module constants. */
+KOS_OBJ_ID kos_object_clone(KOS_CONTEXT ctx,
+                            KOS_OBJ_ID  obj_id);
+
 int kos_is_truthy(KOS_OBJ_ID obj_id);
 
 KOS_OBJ_ID kos_new_object_walk(KOS_CONTEXT      ctx,
@@ -179,6 +215,49 @@ KOS_OBJ_ID kos_new_object_walk(KOS_CONTEXT      ctx,
 int kos_object_walk(KOS_CONTEXT ctx,
                     KOS_OBJ_ID  iterator_id);
 
+/* Looks up a property in the object itself, without checking prototypes.
+ * Returns KOS_BADPTR without raising an exception if the property is not found. */
+KOS_OBJ_ID kos_find_own_property(KOS_CONTEXT ctx,
+                                 KOS_OBJ_ID  obj_id,
+                                 KOS_OBJ_ID  prop);
+
+/* Inline cache for property access instructions.  Caches only where
+ * the property was last found: the number of prototype hops, the capacity
+ * of the property table and the slot index in that table.  No object
+ * pointers are stored, so the cache does not need to be updated by the GC.
+ * A cached entry is validated against the current property table on every
+ * access, so a resized or replaced table results in a cache miss. */
+/* Property access cache, one per property access instruction.  The cache is
+ * written by any thread under a sequence lock: seq is odd while an update is
+ * in progress and readers discard the cache if seq changes while they read it.
+ *
+ * For properties found in a prototype, holder is the object which has the
+ * property.  The cached holder is only valid as long as proto_epoch in the
+ * instance is unchanged, i.e. no key was added to any watched object in the
+ * prototype chain and no objects were moved by the garbage collector. */
+typedef struct KOS_PROP_CACHE_S {
+    KOS_ATOMIC(uint32_t)   seq;    /* Sequence lock, odd while being updated       */
+    KOS_ATOMIC(uint32_t)   entry;  /* Table capacity, prototype depth and slot     */
+    KOS_ATOMIC(uint32_t)   epoch;  /* Value of proto_epoch when holder was cached  */
+    KOS_ATOMIC(KOS_OBJ_ID) proto;  /* Prototype of the accessed object             */
+    KOS_ATOMIC(KOS_OBJ_ID) holder; /* Prototype which has the property or badptr   */
+    KOS_ATOMIC(KOS_OBJ_ID) shape;  /* Shape of the accessed object or badptr       */
+} KOS_PROP_CACHE;
+
+/* Invalidates prototype holders in all property caches */
+void kos_invalidate_prop_caches(KOS_INSTANCE *inst);
+
+KOS_OBJ_ID kos_get_property_cached(KOS_CONTEXT     ctx,
+                                   KOS_OBJ_ID      obj_id,
+                                   KOS_OBJ_ID      prop,
+                                   KOS_PROP_CACHE *cache);
+
+int kos_set_property_cached(KOS_CONTEXT     ctx,
+                            KOS_OBJ_ID      obj_id,
+                            KOS_OBJ_ID      prop,
+                            KOS_OBJ_ID      value,
+                            KOS_PROP_CACHE *cache);
+
 /*==========================================================================*/
 /* KOS_ARRAY                                                                */
 /*==========================================================================*/
@@ -216,6 +295,11 @@ static inline KOS_OBJ_ID kos_get_array_storage(KOS_OBJ_ID obj_id)
 int kos_array_copy_storage(KOS_CONTEXT ctx,
                            KOS_OBJ_ID  obj_id);
 
+/* Creates a new array with a copy of the elements of the source array.
+ * The source array must not be modified concurrently. */
+KOS_OBJ_ID kos_array_clone(KOS_CONTEXT ctx,
+                           KOS_OBJ_ID  obj_id);
+
 /*==========================================================================*/
 /* KOS_BUFFER                                                               */
 /*==========================================================================*/
@@ -291,6 +375,21 @@ void kos_stack_pop(KOS_CONTEXT ctx);
 
 void kos_wrap_exception(KOS_CONTEXT ctx);
 
+/* Returns exception's backtrace, materializes it on first use from the raw
+ * backtrace recorded by kos_wrap_exception */
+KOS_OBJ_ID kos_get_backtrace(KOS_CONTEXT ctx,
+                             KOS_OBJ_ID  exception);
+
+/* Getter of the backtrace dynamic property of exception prototype */
+KOS_OBJ_ID kos_get_backtrace_prop(KOS_CONTEXT ctx,
+                                  KOS_OBJ_ID  this_obj,
+                                  KOS_OBJ_ID  args_obj);
+
+/* Setter of the backtrace dynamic property, replaces it with a plain property */
+KOS_OBJ_ID kos_set_backtrace_prop(KOS_CONTEXT ctx,
+                                  KOS_OBJ_ID  this_obj,
+                                  KOS_OBJ_ID  args_obj);
+
 /*==========================================================================*/
 /* KOS_FUNCTION                                                             */
 /*==========================================================================*/
@@ -298,12 +397,32 @@ void kos_wrap_exception(KOS_CONTEXT ctx);
 KOS_OBJ_ID kos_copy_function(KOS_CONTEXT ctx,
                              KOS_OBJ_ID  obj_id);
 
+/* Handler of functions created with KOS_new_fast_builtin_function(), invoked
+ * when args are passed in an array.  Moves the args to a location which is
+ * not moved by the GC and invokes fast_handler of the current function. */
+KOS_OBJ_ID kos_call_fast_handler(KOS_CONTEXT ctx,
+                                 KOS_OBJ_ID  this_obj,
+                                 KOS_OBJ_ID  args_obj);
+
+/* Handler of base.range() generator.  Iterating over an instantiated range
+ * generator advances the range directly, without calling the handler. */
+KOS_OBJ_ID kos_range_generator(KOS_CONTEXT ctx,
+                               KOS_OBJ_ID  regs_obj,
+                               KOS_OBJ_ID  args_obj);
+
+/* Returns registers of an instantiated generator implemented by a handler */
+KOS_OBJ_ID kos_get_generator_regs(KOS_OBJ_ID func_obj);
+
 KOS_OBJ_ID kos_alloc_bytecode(KOS_CONTEXT ctx,
                               const void *bytecode,
                               uint32_t    bytecode_size,
                               const void *addr2line,
                               uint32_t    addr2line_size);
 
+/* Returns pre-decoded instructions of a function, the last one being the end marker */
+#define KOS_DECODED_INSTRS(bytecode_ptr) \
+    ((KOS_INSTR *)&(bytecode_ptr)->bytecode[(bytecode_ptr)->decoded_offs])
+
 /*==========================================================================*/
 /* KOS_MODULE                                                               */
 /*==========================================================================*/
@@ -351,14 +470,22 @@ struct KOS_PAGE_HEADER_S {
     KOS_PAGE            *next;
     KOS_ATOMIC(uint32_t) num_allocated;   /* Number of slots allocated */
     KOS_ATOMIC(uint32_t) flags;           /* Flags for GC              */
+};
 
-    /* TODO
-     * - Distinguish between old pages and new page.  New objects should never
-     *   be allocated in old pages, objects can only be moved from new pages
-     *   to old pages.  Old pages can just be put on full_pages list.  is_page_full()
-     *   will need to be adjusted to detect an old page and treat it as full,
-     *   except for when allocating space for evacuated objects during GC.
-     */
+/* Page flags
+ * - New objects are only allocated in young pages.  Objects which survive GC
+ *   are moved to old pages, or the page in which they reside becomes old.
+ * - Old pages which contain stacks, functions, classes and other objects
+ *   written without the write barrier are scanned during every minor GC.
+ * - The write barrier marks old pages which had objects, arrays or their
+ *   storage modified as dirty, these are scanned during the next minor GC.
+ */
+enum KOS_PAGE_FLAGS_E {
+    KOS_PAGE_EVACUATED = 1U, /* Page was already processed during evacuation */
+    KOS_PAGE_OLD       = 2U, /* Page contains only objects which survived GC */
+    KOS_PAGE_SCAN      = 4U, /* Old page is always scanned during minor GC   */
+    KOS_PAGE_DIRTY     = 8U, /* Old page was modified since last GC          */
+    KOS_PAGE_SKIP      = 16U /* Old page skipped during minor GC             */
 };
 
 #define KOS_PAGE_HDR_SIZE  (sizeof(KOS_PAGE))
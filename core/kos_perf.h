@@ -61,11 +61,13 @@ struct KOS_PERF_S {
     KOS_ATOMIC(uint64_t) object_salvage_success;
     KOS_ATOMIC(uint64_t) object_salvage_fail;
     KOS_ATOMIC(uint64_t) object_collision[4];
+    KOS_ATOMIC(uint64_t) prop_cache_hit;
+    KOS_ATOMIC(uint64_t) prop_cache_miss;
 
     KOS_ATOMIC(uint64_t) array_salvage_success;
     KOS_ATOMIC(uint64_t) array_salvage_fail;
 
-    KOS_ATOMIC(uint64_t) new_object[19];
+    KOS_ATOMIC(uint64_t) new_object[21];
 
     KOS_ATOMIC(uint64_t) alloc_object;
     KOS_ATOMIC(uint64_t) alloc_huge_object;
@@ -12,10 +12,12 @@
 #include "../inc/kos_object.h"
 #include "kos_config.h"
 #include "kos_heap.h"
+#include "kos_math.h"
 #include "kos_object_internal.h"
 #include "kos_try.h"
 
 KOS_DECLARE_STATIC_CONST_STRING(str_err_not_callable,   "object is not callable");
+KOS_DECLARE_STATIC_CONST_STRING(str_err_not_exception,  "object is not an exception");
 KOS_DECLARE_STATIC_CONST_STRING(str_err_stack_overflow, "stack overflow");
 KOS_DECLARE_STATIC_CONST_STRING(str_module,             "module");
 KOS_DECLARE_STATIC_CONST_STRING(str_xbuiltinx,          "<builtin>");
@@ -184,8 +186,13 @@ int kos_stack_push(KOS_CONTEXT ctx,
 
     assert((state > KOS_GEN_INIT) || (instr > INSTR_NEXT));
 
-    num_regs = OBJPTR(FUNCTION, func.o)->handler
-               ? 1 : OBJPTR(FUNCTION, func.o)->opts.num_regs;
+    /* Handlers taking args in place get registers for filling in default args */
+    if (OBJPTR(FUNCTION, func.o)->fast_handler)
+        num_regs = KOS_max(1U, (unsigned)OBJPTR(FUNCTION, func.o)->opts.min_args +
+                               OBJPTR(FUNCTION, func.o)->opts.num_def_args);
+    else
+        num_regs = OBJPTR(FUNCTION, func.o)->handler
+                   ? 1 : OBJPTR(FUNCTION, func.o)->opts.num_regs;
     room = num_regs + KOS_STACK_EXTRA;
 
     reg_init = ((int32_t)instr << 16) | ((int32_t)ret_reg << 8) | (int32_t)num_regs;
@@ -504,63 +511,93 @@ static int get_depth(KOS_OBJ_ID stack,
 }
 
 typedef struct KOS_DUMP_CONTEXT_S {
-    KOS_CONTEXT ctx;
-    uint32_t    idx;
-    KOS_LOCAL   backtrace;
+    KOS_ATOMIC(KOS_OBJ_ID) *buf;
+    uint32_t                idx;
+    uint32_t                size;
 } KOS_DUMP_CONTEXT;
 
-static uint32_t get_instr_offs(KOS_STACK_FRAME *stack_frame)
+/* The stack frame holds index of the current decoded instruction,
+ * returns offset of that instruction in the original bytecode */
+static uint32_t get_instr_offs(KOS_STACK_FRAME *stack_frame, KOS_OBJ_ID func)
 {
-    KOS_OBJ_ID offs_obj = KOS_atomic_read_relaxed_obj(stack_frame->instr_offs);
-    int64_t    offs;
+    KOS_OBJ_ID                idx_obj      = KOS_atomic_read_relaxed_obj(stack_frame->instr_offs);
+    const KOS_BYTECODE *const bytecode_ptr = (const KOS_BYTECODE *)OBJPTR(OPAQUE, OBJPTR(FUNCTION, func)->bytecode);
+    int64_t                   idx;
 
-    assert(IS_SMALL_INT(offs_obj));
-    offs = GET_SMALL_INT(offs_obj);
+    assert(IS_SMALL_INT(idx_obj));
+    idx = GET_SMALL_INT(idx_obj);
 
-    return (uint32_t)offs;
+    assert(idx >= 0 && idx <= (int64_t)bytecode_ptr->num_decoded);
+
+    return KOS_DECODED_INSTRS(bytecode_ptr)[idx].offs;
 }
 
+/* Records function and instruction offset of each frame in the raw backtrace,
+ * which is an array of function/offset pairs.  Module and line are obtained
+ * from the function when the backtrace is materialized. */
 static int dump_stack(KOS_OBJ_ID stack,
                       uint32_t   frame_idx,
                       uint32_t   frame_size,
                       void      *cookie)
 {
     KOS_DUMP_CONTEXT *dump_ctx    = (KOS_DUMP_CONTEXT *)cookie;
-    KOS_CONTEXT       ctx         = dump_ctx->ctx;
     KOS_STACK_FRAME  *stack_frame = (KOS_STACK_FRAME *)&OBJPTR(STACK, stack)->buf[frame_idx];
     KOS_OBJ_ID        func        = KOS_atomic_read_relaxed_obj(stack_frame->func_obj);
-    KOS_OBJ_ID        offs_id;
-    intptr_t          instr_offs;
-    unsigned          line;
-    int               error       = KOS_SUCCESS;
-    KOS_LOCAL         module;
-    KOS_LOCAL         func_name;
-    KOS_LOCAL         module_name;
-    KOS_LOCAL         module_path;
-    KOS_LOCAL         frame_desc;
-
-    if (OBJPTR(FUNCTION, func)->handler) {
+    uint32_t          instr_offs  = 0;
+
+    assert(dump_ctx->idx + 2U <= dump_ctx->size);
+
+    if ( ! OBJPTR(FUNCTION, func)->fast_handler && ! OBJPTR(FUNCTION, func)->handler)
+        instr_offs = get_instr_offs(stack_frame, func);
+
+    KOS_atomic_write_relaxed_ptr(dump_ctx->buf[dump_ctx->idx],      func);
+    KOS_atomic_write_relaxed_ptr(dump_ctx->buf[dump_ctx->idx + 1U], TO_SMALL_INT((int)instr_offs));
+
+    dump_ctx->idx += 2U;
+
+    return KOS_SUCCESS;
+}
+
+static KOS_OBJ_ID new_frame_desc(KOS_CONTEXT ctx,
+                                 KOS_OBJ_ID  func_obj,
+                                 uint32_t    frame_offs)
+{
+    KOS_OBJ_ID offs_id;
+    intptr_t   instr_offs;
+    unsigned   line;
+    int        error       = KOS_SUCCESS;
+    KOS_LOCAL  func;
+    KOS_LOCAL  module_name;
+    KOS_LOCAL  module_path;
+    KOS_LOCAL  frame_desc;
+
+    assert(GET_OBJ_TYPE(func_obj) == OBJ_FUNCTION ||
+           GET_OBJ_TYPE(func_obj) == OBJ_CLASS);
+
+    if (OBJPTR(FUNCTION, func_obj)->fast_handler) {
         line       = 0;
-        instr_offs = (intptr_t)OBJPTR(FUNCTION, func)->handler;
+        instr_offs = (intptr_t)OBJPTR(FUNCTION, func_obj)->fast_handler;
+    }
+    else if (OBJPTR(FUNCTION, func_obj)->handler) {
+        line       = 0;
+        instr_offs = (intptr_t)OBJPTR(FUNCTION, func_obj)->handler;
     }
     else {
-        instr_offs = get_instr_offs(stack_frame);
-        line       = KOS_function_addr_to_line(func, (uint32_t)instr_offs);
+        instr_offs = (intptr_t)frame_offs;
+        line       = KOS_function_addr_to_line(func_obj, frame_offs);
     }
 
-    KOS_init_local_with(ctx, &module,      OBJPTR(FUNCTION, func)->module);
-    KOS_init_local_with(ctx, &func_name,   OBJPTR(FUNCTION, func)->name);
+    KOS_init_local(     ctx, &frame_desc);
+    KOS_init_local_with(ctx, &func,        func_obj);
     KOS_init_local_with(ctx, &module_name, KOS_CONST_ID(str_xbuiltinx));
     KOS_init_local_with(ctx, &module_path, KOS_CONST_ID(str_xbuiltinx));
-    KOS_init_local_with(ctx, &frame_desc,  KOS_new_object(ctx));
-    TRY_OBJID(frame_desc.o);
 
-    assert(dump_ctx->idx < KOS_get_array_size(dump_ctx->backtrace.o));
-    TRY(KOS_array_write(ctx, dump_ctx->backtrace.o, (int)dump_ctx->idx, frame_desc.o));
+    frame_desc.o = KOS_new_object(ctx);
+    TRY_OBJID(frame_desc.o);
 
-    if ( ! IS_BAD_PTR(module.o)) {
-        module_name.o = OBJPTR(MODULE, module.o)->name;
-        module_path.o = OBJPTR(MODULE, module.o)->path;
+    if ( ! IS_BAD_PTR(OBJPTR(FUNCTION, func.o)->module)) {
+        module_name.o = OBJPTR(MODULE, OBJPTR(FUNCTION, func.o)->module)->name;
+        module_path.o = OBJPTR(MODULE, OBJPTR(FUNCTION, func.o)->module)->path;
     }
 
     TRY(KOS_set_property(ctx, frame_desc.o, KOS_CONST_ID(str_module), module_name.o));
@@ -569,14 +606,195 @@ static int dump_stack(KOS_OBJ_ID stack,
     offs_id = KOS_new_int(ctx, (int64_t)instr_offs);
     TRY_OBJID(offs_id);
     TRY(KOS_set_property(ctx, frame_desc.o, KOS_STR_OFFSET,           offs_id));
-    TRY(KOS_set_property(ctx, frame_desc.o, KOS_STR_FUNCTION,         func_name.o));
+    TRY(KOS_set_property(ctx, frame_desc.o, KOS_STR_FUNCTION,         OBJPTR(FUNCTION, func.o)->name));
+
+cleanup:
+    frame_desc.o = KOS_destroy_top_locals(ctx, &module_path, &frame_desc);
+
+    return error ? KOS_BADPTR : frame_desc.o;
+}
+
+static KOS_OBJ_ID materialize_backtrace(KOS_CONTEXT ctx,
+                                        KOS_OBJ_ID  raw_backtrace)
+{
+    uint32_t  depth;
+    uint32_t  i;
+    int       error = KOS_SUCCESS;
+    KOS_LOCAL raw;
+    KOS_LOCAL backtrace;
+
+    assert(GET_OBJ_TYPE(raw_backtrace) == OBJ_ARRAY);
+
+    depth = KOS_get_array_size(raw_backtrace) / 2U;
 
-    ++dump_ctx->idx;
+    KOS_init_local(     ctx, &backtrace);
+    KOS_init_local_with(ctx, &raw, raw_backtrace);
+
+    backtrace.o = KOS_new_array(ctx, depth);
+    TRY_OBJID(backtrace.o);
+
+    for (i = 0; i < depth; i++) {
+
+        const KOS_OBJ_ID func = KOS_array_read(ctx, raw.o, (int)(i * 2U));
+        const KOS_OBJ_ID offs = KOS_array_read(ctx, raw.o, (int)(i * 2U + 1U));
+        KOS_OBJ_ID       frame_desc;
+
+        assert(IS_SMALL_INT(offs));
+
+        frame_desc = new_frame_desc(ctx, func, (uint32_t)GET_SMALL_INT(offs));
+        TRY_OBJID(frame_desc);
+
+        TRY(KOS_array_write(ctx, backtrace.o, (int)i, frame_desc));
+    }
 
 cleanup:
-    KOS_destroy_top_locals(ctx, &frame_desc, &module);
+    backtrace.o = KOS_destroy_top_locals(ctx, &raw, &backtrace);
 
-    return error;
+    return error ? KOS_BADPTR : backtrace.o;
+}
+
+static int is_lazy_backtrace(KOS_OBJ_ID value);
+
+KOS_OBJ_ID kos_get_backtrace(KOS_CONTEXT ctx,
+                             KOS_OBJ_ID  exception_obj)
+{
+    int        error = KOS_SUCCESS;
+    KOS_OBJ_ID raw_backtrace;
+    KOS_LOCAL  exception;
+    KOS_LOCAL  backtrace;
+
+    KOS_init_local(     ctx, &backtrace);
+    KOS_init_local_with(ctx, &exception, exception_obj);
+
+    backtrace.o = KOS_get_property_shallow(ctx, exception.o, KOS_STR_BACKTRACE);
+    TRY_OBJID(backtrace.o);
+
+    /* Backtrace was already materialized or was overwritten */
+    if ( ! is_lazy_backtrace(backtrace.o))
+        goto cleanup;
+
+    raw_backtrace = OBJPTR(DYNAMIC_PROP, backtrace.o)->getter;
+    raw_backtrace = OBJPTR(FUNCTION, raw_backtrace)->closures;
+
+    backtrace.o = materialize_backtrace(ctx, raw_backtrace);
+    TRY_OBJID(backtrace.o);
+
+    TRY(KOS_delete_property(ctx, exception.o, KOS_STR_BACKTRACE));
+    TRY(KOS_set_property(ctx, exception.o, KOS_STR_BACKTRACE, backtrace.o));
+
+cleanup:
+    backtrace.o = KOS_destroy_top_locals(ctx, &exception, &backtrace);
+
+    return error ? KOS_BADPTR : backtrace.o;
+}
+
+static KOS_OBJ_ID get_lazy_backtrace(KOS_CONTEXT ctx,
+                                     KOS_OBJ_ID  this_obj,
+                                     KOS_OBJ_ID  args_obj)
+{
+    return kos_get_backtrace(ctx, this_obj);
+}
+
+/* The raw backtrace is held in the closures slot of the getter of the
+ * exception's own "backtrace" dynamic property, so it does not show up
+ * among the exception's properties. */
+static int is_lazy_backtrace(KOS_OBJ_ID value)
+{
+    KOS_OBJ_ID getter;
+
+    if (GET_OBJ_TYPE(value) != OBJ_DYNAMIC_PROP)
+        return 0;
+
+    getter = OBJPTR(DYNAMIC_PROP, value)->getter;
+
+    return GET_OBJ_TYPE(getter) == OBJ_FUNCTION &&
+           OBJPTR(FUNCTION, getter)->handler == get_lazy_backtrace;
+}
+
+static int is_exception(KOS_CONTEXT ctx, KOS_OBJ_ID obj_id)
+{
+    return GET_OBJ_TYPE(obj_id) == OBJ_OBJECT &&
+           KOS_get_prototype(ctx, obj_id) == ctx->inst->prototypes.exception_proto;
+}
+
+KOS_OBJ_ID kos_get_backtrace_prop(KOS_CONTEXT ctx,
+                                  KOS_OBJ_ID  this_obj,
+                                  KOS_OBJ_ID  args_obj)
+{
+    if ( ! is_exception(ctx, this_obj)) {
+        KOS_raise_exception(ctx, KOS_CONST_ID(str_err_not_exception));
+        return KOS_BADPTR;
+    }
+
+    return kos_get_backtrace(ctx, this_obj);
+}
+
+KOS_OBJ_ID kos_set_backtrace_prop(KOS_CONTEXT ctx,
+                                  KOS_OBJ_ID  this_obj,
+                                  KOS_OBJ_ID  args_obj)
+{
+    int       error = KOS_SUCCESS;
+    KOS_LOCAL exception;
+    KOS_LOCAL value;
+
+    if ( ! is_exception(ctx, this_obj)) {
+        KOS_raise_exception(ctx, KOS_CONST_ID(str_err_not_exception));
+        return KOS_BADPTR;
+    }
+
+    KOS_init_local(     ctx, &value);
+    KOS_init_local_with(ctx, &exception, this_obj);
+
+    value.o = KOS_array_read(ctx, args_obj, 0);
+    TRY_OBJID(value.o);
+
+    /* Replace the dynamic property with a plain one */
+    TRY(KOS_delete_property(ctx, exception.o, KOS_STR_BACKTRACE));
+    TRY(KOS_set_property(ctx, exception.o, KOS_STR_BACKTRACE, value.o));
+
+cleanup:
+    KOS_destroy_top_locals(ctx, &exception, &value);
+
+    return error ? KOS_BADPTR : KOS_VOID;
+}
+
+static KOS_OBJ_ID new_lazy_backtrace(KOS_CONTEXT ctx,
+                                     KOS_OBJ_ID  raw_backtrace)
+{
+    KOS_INSTANCE *const inst  = ctx->inst;
+    int                 error = KOS_SUCCESS;
+    KOS_OBJ_ID          func_obj;
+    KOS_OBJ_ID          proto_prop;
+    KOS_LOCAL           raw;
+    KOS_LOCAL           dyn_prop;
+
+    KOS_init_local(     ctx, &dyn_prop);
+    KOS_init_local_with(ctx, &raw, raw_backtrace);
+
+    dyn_prop.o = KOS_new_dynamic_prop(ctx);
+    TRY_OBJID(dyn_prop.o);
+
+    func_obj = KOS_new_function(ctx);
+    TRY_OBJID(func_obj);
+
+    OBJPTR(FUNCTION, func_obj)->module        = inst->modules.init_module;
+    OBJPTR(FUNCTION, func_obj)->opts.min_args = 0;
+    OBJPTR(FUNCTION, func_obj)->handler       = get_lazy_backtrace;
+    OBJPTR(FUNCTION, func_obj)->name          = KOS_STR_BACKTRACE;
+    OBJPTR(FUNCTION, func_obj)->closures      = raw.o;
+    OBJPTR(DYNAMIC_PROP, dyn_prop.o)->getter  = func_obj;
+
+    /* The setter is shared with the dynamic property of exception prototype */
+    proto_prop = KOS_get_property_shallow(ctx, inst->prototypes.exception_proto, KOS_STR_BACKTRACE);
+    TRY_OBJID(proto_prop);
+    assert(GET_OBJ_TYPE(proto_prop) == OBJ_DYNAMIC_PROP);
+
+    OBJPTR(DYNAMIC_PROP, dyn_prop.o)->setter = OBJPTR(DYNAMIC_PROP, proto_prop)->setter;
+
+cleanup:
+    dyn_prop.o = KOS_destroy_top_locals(ctx, &raw, &dyn_prop);
+
+    return error ? KOS_BADPTR : dyn_prop.o;
 }
 
 void kos_wrap_exception(KOS_CONTEXT ctx)
@@ -601,7 +819,7 @@ void kos_wrap_exception(KOS_CONTEXT ctx)
             return;
     }
 
-    KOS_init_locals(ctx, &exception, &backtrace, &thrown_object, &dump_ctx.backtrace, kos_end_locals);
+    KOS_init_locals(ctx, &exception, &backtrace, &thrown_object, kos_end_locals);
 
     thrown_object.o = ctx->exception;
 
@@ -617,19 +835,26 @@ void kos_wrap_exception(KOS_CONTEXT ctx)
     depth = 0;
     TRY(walk_stack(ctx, get_depth, &depth));
 
-    backtrace.o = KOS_new_array(ctx, depth);
+    backtrace.o = KOS_new_array(ctx, depth * 2U);
     TRY_OBJID(backtrace.o);
 
-    TRY(KOS_set_property(ctx, exception.o, KOS_STR_BACKTRACE, backtrace.o));
-
-    dump_ctx.ctx         = ctx;
-    dump_ctx.idx         = 0;
-    dump_ctx.backtrace.o = backtrace.o;
+    /* The array is not visible to other threads yet and no allocations
+     * occur while walking the stack, so the storage is written directly. */
+    dump_ctx.buf  = kos_get_array_buffer(OBJPTR(ARRAY, backtrace.o));
+    dump_ctx.idx  = 0;
+    dump_ctx.size = depth * 2U;
 
     TRY(walk_stack(ctx, dump_stack, &dump_ctx));
 
+    assert(dump_ctx.idx == dump_ctx.size);
+
+    backtrace.o = new_lazy_backtrace(ctx, backtrace.o);
+    TRY_OBJID(backtrace.o);
+
+    TRY(KOS_set_property(ctx, exception.o, KOS_STR_BACKTRACE, backtrace.o));
+
 cleanup:
     ctx->exception = partial_wrap ? exception.o : thrown_object.o;
 
-    KOS_destroy_top_locals(ctx, &exception, &dump_ctx.backtrace);
+    KOS_destroy_top_locals(ctx, &exception, &thrown_object);
 }
@@ -336,7 +336,13 @@ int kos_join_finished_threads(KOS_CONTEXT                      ctx,
 
             KOS_suspend_context(ctx);
             kos_yield();
-            KOS_resume_context(ctx);
+
+            /* GC may have run out of memory, keep joining the remaining threads */
+            if (KOS_resume_context(ctx)) {
+                if (IS_BAD_PTR(exception.o))
+                    exception.o = KOS_get_exception(ctx);
+                KOS_clear_exception(ctx);
+            }
 
             if (num_finished == KOS_atomic_read_relaxed_u32(inst->threads.num_threads))
                 join_rest = 1;
@@ -596,6 +602,60 @@ void kos_wait_cond_var(KOS_COND_VAR cond_var, KOS_MUTEX mutex)
     assert(ok);
 }
 
+struct KOS_NATIVE_THREAD_S {
+    HANDLE                 handle;
+    KOS_NATIVE_THREAD_FUNC func;
+    void                  *cookie;
+};
+
+static DWORD WINAPI native_thread_proc(LPVOID thread_ptr)
+{
+    KOS_NATIVE_THREAD thread = (KOS_NATIVE_THREAD)thread_ptr;
+
+    thread->func(thread->cookie);
+
+    return 0;
+}
+
+int kos_create_native_thread(KOS_NATIVE_THREAD     *thread,
+                             KOS_NATIVE_THREAD_FUNC func,
+                             void                  *cookie)
+{
+    int error = KOS_SUCCESS;
+
+    assert(thread);
+    *thread = (KOS_NATIVE_THREAD)KOS_malloc(sizeof(struct KOS_NATIVE_THREAD_S));
+
+    if (*thread) {
+        (*thread)->func   = func;
+        (*thread)->cookie = cookie;
+        (*thread)->handle = kos_seq_fail() ? 0 :
+            CreateThread(KOS_NULL, 0, native_thread_proc, *thread, 0, KOS_NULL);
+
+        if ( ! (*thread)->handle) {
+            KOS_free(*thread);
+            *thread = KOS_NULL;
+            error = KOS_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    else
+        error = KOS_ERROR_OUT_OF_MEMORY;
+
+    return error;
+}
+
+void kos_join_native_thread(KOS_NATIVE_THREAD *thread)
+{
+    assert(thread && *thread);
+
+    WaitForSingleObject((*thread)->handle, INFINITE);
+    CloseHandle((*thread)->handle);
+
+    KOS_free(*thread);
+
+    *thread = KOS_NULL;
+}
+
 int kos_tls_create(KOS_TLS_KEY *key)
 {
     int   error   = KOS_SUCCESS;
@@ -798,6 +858,66 @@ void kos_wait_cond_var(KOS_COND_VAR cond_var, KOS_MUTEX mutex)
     assert(ret == 0);
 }
 
+struct KOS_NATIVE_THREAD_S {
+    pthread_t              handle;
+    KOS_NATIVE_THREAD_FUNC func;
+    void                  *cookie;
+};
+
+static void *native_thread_proc(void *thread_ptr)
+{
+    KOS_NATIVE_THREAD thread = (KOS_NATIVE_THREAD)thread_ptr;
+
+    thread->func(thread->cookie);
+
+    return KOS_NULL;
+}
+
+int kos_create_native_thread(KOS_NATIVE_THREAD     *thread,
+                             KOS_NATIVE_THREAD_FUNC func,
+                             void                  *cookie)
+{
+    int error = KOS_SUCCESS;
+
+    assert(thread);
+    *thread = (KOS_NATIVE_THREAD)KOS_malloc(sizeof(struct KOS_NATIVE_THREAD_S));
+
+    if (*thread) {
+        (*thread)->func   = func;
+        (*thread)->cookie = cookie;
+
+        if (kos_seq_fail() || pthread_create(&(*thread)->handle, KOS_NULL, native_thread_proc, *thread)) {
+            KOS_free(*thread);
+            *thread = KOS_NULL;
+            error = KOS_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    else
+        error = KOS_ERROR_OUT_OF_MEMORY;
+
+    return error;
+}
+
+void kos_join_native_thread(KOS_NATIVE_THREAD *thread)
+{
+#ifndef NDEBUG
+    int ret;
+#endif
+
+    assert(thread && *thread);
+
+#ifndef NDEBUG
+    ret =
+#endif
+    pthread_join((*thread)->handle, KOS_NULL);
+
+    assert(ret == 0);
+
+    KOS_free(*thread);
+
+    *thread = KOS_NULL;
+}
+
 struct KOS_TLS_OBJECT_S {
     pthread_key_t key;
 };
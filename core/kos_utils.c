@@ -13,6 +13,7 @@
 #include "../inc/kos_object.h"
 #include "../inc/kos_string.h"
 #include "../inc/kos_utf8.h"
+#include "kos_heap.h"
 #include "kos_math.h"
 #include "kos_misc.h"
 #include "kos_object_internal.h"
@@ -126,7 +127,7 @@ KOS_NUMERIC KOS_get_numeric(KOS_OBJ_ID obj_id)
 
         case OBJ_FLOAT:
             numeric.type = KOS_FLOAT_VALUE;
-            numeric.u.d  = OBJPTR(FLOAT, obj_id)->value;
+            numeric.u.d  = KOS_get_float(obj_id);
             break;
 
         default:
@@ -179,7 +180,7 @@ int KOS_get_integer(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT: {
-            const double number = OBJPTR(FLOAT, obj_id)->value;
+            const double number = KOS_get_float(obj_id);
             if (number <= -9223372036854775808.0 || number >= 9223372036854775808.0) {
                 KOS_raise_printf(ctx, "number %f is out of range for conversion to integer", number);
                 error = KOS_ERROR_EXCEPTION;
@@ -220,11 +221,23 @@ int KOS_get_index_arg(KOS_CONTEXT           ctx,
                       enum KOS_VOID_INDEX_E void_index,
                       int                  *found_pos)
 {
-    int64_t          ival;
     const KOS_OBJ_ID val_id = KOS_array_read(ctx, args_obj, arg_idx);
-    int              error  = KOS_SUCCESS;
 
-    TRY_OBJID(val_id);
+    if (IS_BAD_PTR(val_id))
+        return KOS_ERROR_EXCEPTION;
+
+    return KOS_get_index_value(ctx, val_id, begin_pos, end_pos, void_index, found_pos);
+}
+
+int KOS_get_index_value(KOS_CONTEXT           ctx,
+                        KOS_OBJ_ID            val_id,
+                        int                   begin_pos,
+                        int                   end_pos,
+                        enum KOS_VOID_INDEX_E void_index,
+                        int                  *found_pos)
+{
+    int64_t ival;
+    int     error = KOS_SUCCESS;
 
     assert(end_pos >= 0);
 
@@ -1042,7 +1055,10 @@ static int vector_append_function(KOS_CONTEXT ctx,
 
     TRY(vector_append_str(ctx, cstr_vec, func->name, KOS_DONT_QUOTE));
 
-    if (func->handler)
+    if (func->fast_handler)
+        len = (unsigned)snprintf(cstr_ptr, sizeof(cstr_ptr), " @ 0x%" PRIX64 ">",
+                                 (uint64_t)(uintptr_t)func->fast_handler);
+    else if (func->handler)
         len = (unsigned)snprintf(cstr_ptr, sizeof(cstr_ptr), " @ 0x%" PRIX64 ">",
                                  (uint64_t)(uintptr_t)func->handler);
     else
@@ -1084,7 +1100,10 @@ static KOS_OBJ_ID function_to_str(KOS_CONTEXT ctx,
 
     strings[1].o = OBJPTR(FUNCTION, func.o)->name;
 
-    if (OBJPTR(FUNCTION, func.o)->handler)
+    if (OBJPTR(FUNCTION, func.o)->fast_handler)
+        snprintf(cstr_ptr, sizeof(cstr_ptr), " @ 0x%" PRIx64 ">",
+                 (uint64_t)(uintptr_t)OBJPTR(FUNCTION, func.o)->fast_handler);
+    else if (OBJPTR(FUNCTION, func.o)->handler)
         snprintf(cstr_ptr, sizeof(cstr_ptr), " @ 0x%" PRIx64 ">",
                  (uint64_t)(uintptr_t)OBJPTR(FUNCTION, func.o)->handler);
     else
@@ -1167,7 +1186,7 @@ static int object_to_string_or_cstr_vec(KOS_CONTEXT        ctx,
             break;
 
         case OBJ_FLOAT:
-            error = float_to_str(ctx, OBJPTR(FLOAT, obj_id)->value, str, cstr_vec);
+            error = float_to_str(ctx, KOS_get_float(obj_id), str, cstr_vec);
             break;
 
         case OBJ_STRING:
@@ -1440,7 +1459,7 @@ static double get_float(KOS_OBJ_ID obj_id)
     else if (GET_OBJ_TYPE(obj_id) == OBJ_INTEGER)
         return (double)OBJPTR(INTEGER, obj_id)->value;
     else
-        return OBJPTR(FLOAT, obj_id)->value;
+        return KOS_get_float(obj_id);
 }
 
 static KOS_COMPARE_RESULT compare_float(KOS_OBJ_ID a, KOS_OBJ_ID b)
@@ -1544,7 +1563,7 @@ static KOS_COMPARE_RESULT compare(KOS_OBJ_ID                a,
 
     if (a == b) {
         if (a_type == OBJ_FLOAT) {
-            const double value = OBJPTR(FLOAT, a)->value;
+            const double value = KOS_get_float(a);
             return value == value ? KOS_EQUAL : KOS_INDETERMINATE;
         }
         else
@@ -1784,6 +1803,176 @@ KOS_OBJ_ID KOS_new_iterator_copy(KOS_CONTEXT ctx,
     return OBJID(ITERATOR, iter);
 }
 
+/* Range iterator is marked with OBJ_ITERATOR type, because iterators are never
+ * iterated over.  The current number is stored in obj, the end of the range is
+ * stored in prop_obj and the increment is stored in key_table. */
+static KOS_OBJ_ID new_range_iterator(KOS_CONTEXT ctx,
+                                     KOS_OBJ_ID  start_id,
+                                     KOS_OBJ_ID  stop_id,
+                                     KOS_OBJ_ID  step_id)
+{
+    KOS_ITERATOR *iter;
+    KOS_LOCAL     start;
+    KOS_LOCAL     stop;
+    KOS_LOCAL     step;
+
+    assert( ! IS_BAD_PTR(start_id));
+    assert( ! IS_BAD_PTR(stop_id));
+    assert( ! IS_BAD_PTR(step_id));
+
+    if ((KOS_get_numeric(start_id).type == KOS_NON_NUMERIC) ||
+        (KOS_get_numeric(stop_id).type  == KOS_NON_NUMERIC) ||
+        (KOS_get_numeric(step_id).type  == KOS_NON_NUMERIC)) {
+
+        KOS_raise_exception_cstring(ctx, str_err_not_number);
+        return KOS_BADPTR;
+    }
+
+    KOS_init_local_with(ctx, &start, start_id);
+    KOS_init_local_with(ctx, &stop,  stop_id);
+    KOS_init_local_with(ctx, &step,  step_id);
+
+    iter = (KOS_ITERATOR *)kos_alloc_object(ctx,
+                                            KOS_ALLOC_MOVABLE,
+                                            OBJ_ITERATOR,
+                                            sizeof(KOS_ITERATOR));
+
+    if (iter) {
+        iter->index         = 0;
+        iter->depth         = (uint8_t)KOS_CONTENTS;
+        iter->type          = (uint8_t)OBJ_ITERATOR;
+        iter->obj           = start.o;
+        iter->prop_obj      = stop.o;
+        iter->key_table     = step.o;
+        iter->returned_keys = KOS_BADPTR;
+        iter->last_key      = KOS_BADPTR;
+        iter->last_value    = KOS_BADPTR;
+    }
+
+    KOS_destroy_top_locals(ctx, &step, &start);
+
+    return OBJID(ITERATOR, iter);
+}
+
+/* Registers of range generator contain start, stop and step args.  The first
+ * register is replaced with the range iterator when the range is first used. */
+static KOS_OBJ_ID get_range_iterator(KOS_CONTEXT ctx,
+                                     KOS_OBJ_ID  regs_obj)
+{
+    KOS_OBJ_ID iter_id;
+    KOS_OBJ_ID stop_id;
+    KOS_OBJ_ID step_id;
+    KOS_LOCAL  regs;
+
+    assert(GET_OBJ_TYPE(regs_obj) == OBJ_ARRAY);
+    assert(KOS_get_array_size(regs_obj) > 2);
+
+    iter_id = KOS_atomic_read_relaxed_obj(kos_get_array_buffer(OBJPTR(ARRAY, regs_obj))[0]);
+
+    if (GET_OBJ_TYPE(iter_id) == OBJ_ITERATOR)
+        return iter_id;
+
+    stop_id = KOS_atomic_read_relaxed_obj(kos_get_array_buffer(OBJPTR(ARRAY, regs_obj))[1]);
+    step_id = KOS_atomic_read_relaxed_obj(kos_get_array_buffer(OBJPTR(ARRAY, regs_obj))[2]);
+
+    if (stop_id == KOS_VOID) {
+        stop_id = iter_id;
+        iter_id = TO_SMALL_INT(0);
+    }
+
+    KOS_init_local_with(ctx, &regs, regs_obj);
+
+    iter_id = new_range_iterator(ctx, iter_id, stop_id, step_id);
+
+    regs_obj = KOS_destroy_top_local(ctx, &regs);
+
+    if ( ! IS_BAD_PTR(iter_id)) {
+        KOS_atomic_write_release_ptr(kos_get_array_buffer(OBJPTR(ARRAY, regs_obj))[0], iter_id);
+        kos_write_barrier(kos_get_array_storage(regs_obj));
+    }
+
+    return iter_id;
+}
+
+KOS_OBJ_ID kos_range_generator(KOS_CONTEXT ctx,
+                               KOS_OBJ_ID  regs_obj,
+                               KOS_OBJ_ID  args_obj)
+{
+    KOS_LOCAL  iter;
+    KOS_OBJ_ID iter_id = get_range_iterator(ctx, regs_obj);
+    int        error;
+
+    if (IS_BAD_PTR(iter_id))
+        return KOS_BADPTR;
+
+    KOS_init_local_with(ctx, &iter, iter_id);
+
+    error = KOS_iterator_next(ctx, iter_id);
+
+    iter_id = KOS_destroy_top_local(ctx, &iter);
+
+    return error ? KOS_BADPTR : KOS_get_walk_value(iter_id);
+}
+
+static int range_next(KOS_CONTEXT ctx,
+                      KOS_OBJ_ID  iter_id)
+{
+    KOS_LOCAL          iter;
+    KOS_OBJ_ID         obj_id;
+    KOS_NUMERIC        value;
+    KOS_NUMERIC        step;
+    KOS_COMPARE_RESULT expected;
+
+    step = KOS_get_numeric(KOS_atomic_read_relaxed_obj(OBJPTR(ITERATOR, iter_id)->key_table));
+
+    if (step.type == KOS_INTEGER_VALUE)
+        expected = (step.u.i > 0) ? KOS_LESS_THAN :
+                   (step.u.i < 0) ? KOS_GREATER_THAN : KOS_EQUAL;
+    else {
+        assert(step.type == KOS_FLOAT_VALUE);
+        expected = (step.u.d > 0) ? KOS_LESS_THAN :
+                   (step.u.d < 0) ? KOS_GREATER_THAN : KOS_EQUAL;
+    }
+
+    obj_id = KOS_atomic_read_relaxed_obj(OBJPTR(ITERATOR, iter_id)->obj);
+
+    /* Zero or NaN step produces an empty range */
+    if ((expected == KOS_EQUAL) ||
+        (KOS_compare(obj_id, KOS_atomic_read_relaxed_obj(OBJPTR(ITERATOR, iter_id)->prop_obj)) != expected))
+        return KOS_ERROR_NOT_FOUND;
+
+    value = KOS_get_numeric(obj_id);
+
+    /* Integer addition wraps around, same as the add operator */
+    if ((value.type == KOS_INTEGER_VALUE) && (step.type == KOS_INTEGER_VALUE))
+        value.u.i = (int64_t)((uint64_t)value.u.i + (uint64_t)step.u.i);
+    else {
+        if (value.type == KOS_INTEGER_VALUE) {
+            value.type = KOS_FLOAT_VALUE;
+            value.u.d  = (double)value.u.i;
+        }
+        value.u.d += (step.type == KOS_INTEGER_VALUE) ? (double)step.u.i : step.u.d;
+    }
+
+    KOS_init_local_with(ctx, &iter, iter_id);
+
+    obj_id = (value.type == KOS_INTEGER_VALUE) ? KOS_new_int(ctx, value.u.i)
+                                               : KOS_new_float(ctx, value.u.d);
+
+    iter_id = KOS_destroy_top_local(ctx, &iter);
+
+    if (IS_BAD_PTR(obj_id))
+        return KOS_ERROR_EXCEPTION;
+
+    KOS_atomic_write_release_ptr(OBJPTR(ITERATOR, iter_id)->last_key,
+                                 TO_SMALL_INT((int64_t)KOS_atomic_add_u32(OBJPTR(ITERATOR, iter_id)->index, 1U)));
+    KOS_atomic_write_release_ptr(OBJPTR(ITERATOR, iter_id)->last_value,
+                                 KOS_atomic_read_relaxed_obj(OBJPTR(ITERATOR, iter_id)->obj));
+    KOS_atomic_write_release_ptr(OBJPTR(ITERATOR, iter_id)->obj, obj_id);
+
+    return KOS_SUCCESS;
+}
+
 KOS_OBJ_ID KOS_new_iterator(KOS_CONTEXT      ctx,
                             KOS_OBJ_ID       obj_id,
                             enum KOS_DEPTH_E depth)
@@ -1799,6 +1988,12 @@ KOS_OBJ_ID KOS_new_iterator(KOS_CONTEXT      ctx,
     if ((type == OBJ_OBJECT) || (type == OBJ_CLASS) || (depth != KOS_CONTENTS))
         return kos_new_object_walk(ctx, obj_id, depth);
 
+    /* Iterate over instantiated range generator directly, sharing its state */
+    if ((type == OBJ_FUNCTION) &&
+        (OBJPTR(FUNCTION, obj_id)->handler == kos_range_generator) &&
+        (KOS_atomic_read_relaxed_u32(OBJPTR(FUNCTION, obj_id)->state) == KOS_GEN_READY))
+        return get_range_iterator(ctx, kos_get_generator_regs(obj_id));
+
     KOS_init_local_with(ctx, &obj, obj_id);
 
     iter = (KOS_ITERATOR *)kos_alloc_object(ctx,
@@ -1836,6 +2031,14 @@ int KOS_iterator_next(KOS_CONTEXT ctx,
         case OBJ_CLASS:
             return kos_object_walk(ctx, iter_id);
 
+        case OBJ_ITERATOR: {
+            const int error = range_next(ctx, iter_id);
+
+            if (error != KOS_ERROR_NOT_FOUND)
+                return error;
+            break;
+        }
+
         case OBJ_FUNCTION: {
             KOS_FUNCTION_STATE state;
             KOS_OBJ_ID         obj_id = OBJPTR(ITERATOR, iter_id)->obj;
@@ -2213,7 +2416,7 @@ int KOS_extract_native_value(KOS_CONTEXT           ctx,
                         break;
                     default:
                         assert(READ_OBJ_TYPE(elem_id) == OBJ_FLOAT);
-                        f_value = OBJPTR(FLOAT, elem_id)->value;
+                        f_value = KOS_get_float(elem_id);
                         break;
                 }
 
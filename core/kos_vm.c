@@ -15,11 +15,15 @@
 #include "../inc/kos_utils.h"
 #include "kos_config.h"
 #include "kos_debug.h"
+#include "kos_disasm.h"
+#include "kos_heap.h"
+#include "kos_jit.h"
 #include "kos_math.h"
 #include "kos_misc.h"
 #include "kos_object_internal.h"
 #include "kos_perf.h"
 #include "kos_try.h"
+#include "kos_vm.h"
 #include <assert.h>
 #include <limits.h>
 #include <math.h>
@@ -62,7 +66,7 @@ static KOS_OBJ_ID add_integer(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            ret = KOS_new_float(ctx, (double)a + OBJPTR(FLOAT, bobj)->value);
+            ret = KOS_new_float(ctx, (double)a + KOS_get_float(bobj));
             break;
 
         default:
@@ -90,7 +94,7 @@ static KOS_OBJ_ID add_float(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            b = OBJPTR(FLOAT, bobj)->value;
+            b = KOS_get_float(bobj);
             break;
 
         default:
@@ -118,7 +122,7 @@ static KOS_OBJ_ID sub_integer(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            ret = KOS_new_float(ctx, (double)a - OBJPTR(FLOAT, bobj)->value);
+            ret = KOS_new_float(ctx, (double)a - KOS_get_float(bobj));
             break;
 
         default:
@@ -147,7 +151,7 @@ static KOS_OBJ_ID sub_float(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            b = OBJPTR(FLOAT, bobj)->value;
+            b = KOS_get_float(bobj);
             break;
 
         default:
@@ -175,7 +179,7 @@ static KOS_OBJ_ID mul_integer(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            ret = KOS_new_float(ctx, (double)a * OBJPTR(FLOAT, bobj)->value);
+            ret = KOS_new_float(ctx, (double)a * KOS_get_float(bobj));
             break;
 
         default:
@@ -204,7 +208,7 @@ static KOS_OBJ_ID mul_float(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            b = OBJPTR(FLOAT, bobj)->value;
+            b = KOS_get_float(bobj);
             break;
 
         default:
@@ -245,7 +249,7 @@ static KOS_OBJ_ID div_integer(KOS_CONTEXT ctx,
 
         case OBJ_FLOAT: {
 
-            const double b = OBJPTR(FLOAT, bobj)->value;
+            const double b = KOS_get_float(bobj);
 
             if (b != 0)
                 ret = KOS_new_float(ctx, (double)a / b);
@@ -283,7 +287,7 @@ static KOS_OBJ_ID div_float(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            b = OBJPTR(FLOAT, bobj)->value;
+            b = KOS_get_float(bobj);
             break;
 
         default:
@@ -331,7 +335,7 @@ static KOS_OBJ_ID mod_integer(KOS_CONTEXT ctx,
 
         case OBJ_FLOAT: {
 
-            const double b = OBJPTR(FLOAT, bobj)->value;
+            const double b = KOS_get_float(bobj);
 
             if (b != 0)
                 ret = KOS_new_float(ctx, fmod((double)a, b));
@@ -369,7 +373,7 @@ static KOS_OBJ_ID mod_float(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            b = OBJPTR(FLOAT, bobj)->value;
+            b = KOS_get_float(bobj);
             break;
 
         default:
@@ -418,7 +422,6 @@ static int is_generator_end_exception(KOS_CONTEXT ctx)
     return ret;
 }
 
-#ifndef NDEBUG
 static uint32_t get_num_regs(KOS_CONTEXT ctx)
 {
     uint32_t size;
@@ -436,7 +439,6 @@ static uint32_t get_num_regs(KOS_CONTEXT ctx)
 
     return num_regs;
 }
-#endif
 
 static KOS_STACK_FRAME *get_current_stack_frame(KOS_CONTEXT ctx)
 {
@@ -753,6 +755,25 @@ static KOS_OBJ_ID get_handler_reg(KOS_CONTEXT ctx)
     return KOS_atomic_read_relaxed_obj(OBJPTR(STACK, stack)->buf[size - 2]);
 }
 
+KOS_OBJ_ID kos_get_generator_regs(KOS_OBJ_ID func_obj)
+{
+    uint32_t   size;
+    KOS_OBJ_ID stack;
+
+    assert(GET_OBJ_TYPE(func_obj) == OBJ_FUNCTION);
+    assert(OBJPTR(FUNCTION, func_obj)->handler);
+
+    stack = OBJPTR(FUNCTION, func_obj)->generator_stack_frame;
+
+    assert(GET_OBJ_TYPE(stack) == OBJ_STACK);
+    assert(KOS_atomic_read_relaxed_u32(OBJPTR(STACK, stack)->flags) & KOS_REENTRANT_STACK);
+
+    size = KOS_atomic_read_relaxed_u32(OBJPTR(STACK, stack)->size);
+    assert(size > KOS_STACK_EXTRA);
+
+    return KOS_atomic_read_relaxed_obj(OBJPTR(STACK, stack)->buf[size - 2]);
+}
+
 static void write_to_yield_reg(KOS_CONTEXT ctx,
                                KOS_OBJ_ID  obj_id)
 {
@@ -812,6 +833,108 @@ static KOS_OBJ_ID set_default_args_for_handler(KOS_CONTEXT ctx,
     return args_obj;
 }
 
+static KOS_OBJ_ID call_fast_handler(KOS_CONTEXT             ctx,
+                                    KOS_OBJ_ID              func_obj,
+                                    KOS_OBJ_ID              this_obj,
+                                    KOS_ATOMIC(KOS_OBJ_ID) *args,
+                                    uint32_t                num_args)
+{
+    const uint32_t min_args = OBJPTR(FUNCTION, func_obj)->opts.min_args;
+    const uint32_t max_args = OBJPTR(FUNCTION, func_obj)->opts.num_def_args + min_args;
+
+    assert(GET_OBJ_TYPE(func_obj) == OBJ_FUNCTION);
+    assert(OBJPTR(FUNCTION, func_obj)->fast_handler);
+    assert(num_args >= min_args);
+
+    /* Fill in default args in the registers of the handler's own stack frame */
+    if (num_args < max_args) {
+
+        KOS_ATOMIC(KOS_OBJ_ID) *const regs     = &get_current_stack_frame(ctx)->regs[0];
+        KOS_ATOMIC(KOS_OBJ_ID) *const defaults = kos_get_array_buffer(OBJPTR(ARRAY, OBJPTR(FUNCTION, func_obj)->defaults));
+        uint32_t                      i;
+
+        assert(get_num_regs(ctx) >= max_args);
+
+        for (i = 0; i < num_args; i++)
+            KOS_atomic_write_relaxed_ptr(regs[i], KOS_atomic_read_relaxed_obj(args[i]));
+
+        for ( ; i < max_args; i++)
+            KOS_atomic_write_relaxed_ptr(regs[i], KOS_atomic_read_relaxed_obj(defaults[i - min_args]));
+
+        args     = regs;
+        num_args = max_args;
+    }
+
+    return OBJPTR(FUNCTION, func_obj)->fast_handler(ctx, this_obj, args, num_args);
+}
+
+KOS_OBJ_ID kos_call_fast_handler(KOS_CONTEXT ctx,
+                                 KOS_OBJ_ID  this_obj,
+                                 KOS_OBJ_ID  args_obj)
+{
+    KOS_STACK_FRAME *const  stack_frame = get_current_stack_frame(ctx);
+    const KOS_OBJ_ID        func_obj    = KOS_atomic_read_relaxed_obj(stack_frame->func_obj);
+    const uint32_t          num_args    = KOS_get_array_size(args_obj);
+    KOS_ATOMIC(KOS_OBJ_ID) *args        = &stack_frame->regs[0];
+    KOS_OBJ_ID              ret         = KOS_BADPTR;
+    uint32_t                i;
+    int                     error       = KOS_SUCCESS;
+    KOS_LOCAL               func;
+    KOS_LOCAL               this_;
+    KOS_LOCAL               args_array;
+    KOS_LOCAL               storage;
+
+    assert(GET_OBJ_TYPE(func_obj) == OBJ_FUNCTION);
+    assert(OBJPTR(FUNCTION, func_obj)->handler == kos_call_fast_handler);
+
+    KOS_init_locals(ctx, &func, &this_, &args_array, &storage, kos_end_locals);
+
+    func.o       = func_obj;
+    this_.o      = this_obj;
+    args_array.o = args_obj;
+
+    /* The args array can be moved by the GC, so the args are copied to the
+     * handler's stack frame or, if there are too many of them, to a storage
+     * object which is never moved. */
+    if (num_args > get_num_regs(ctx)) {
+
+        const uint32_t     alloc_size = (uint32_t)(sizeof(KOS_ARRAY_STORAGE) +
+                                                   (num_args - 1U) * sizeof(KOS_OBJ_ID));
+        KOS_ARRAY_STORAGE *buf;
+
+        buf = (KOS_ARRAY_STORAGE *)kos_alloc_object(ctx,
+                                                    KOS_ALLOC_IMMOVABLE,
+                                                    OBJ_ARRAY_STORAGE,
+                                                    alloc_size);
+        if ( ! buf)
+            RAISE_ERROR(KOS_ERROR_EXCEPTION);
+
+        KOS_atomic_write_relaxed_u32(buf->capacity,       num_args);
+        KOS_atomic_write_relaxed_u32(buf->num_slots_open, 0);
+        KOS_atomic_write_relaxed_ptr(buf->next,           KOS_BADPTR);
+
+        for (i = 0; i < num_args; i++)
+            KOS_atomic_write_relaxed_ptr(buf->buf[i], KOS_VOID);
+
+        storage.o = OBJID(ARRAY_STORAGE, buf);
+        args      = &buf->buf[0];
+    }
+
+    for (i = 0; i < num_args; i++) {
+        const KOS_OBJ_ID value = KOS_array_read(ctx, args_array.o, (int)i);
+        TRY_OBJID(value);
+
+        KOS_atomic_write_relaxed_ptr(args[i], value);
+    }
+
+    ret = call_fast_handler(ctx, func.o, this_.o, args, num_args);
+
+cleanup:
+    KOS_destroy_top_locals(ctx, &func, &storage);
+
+    return error ? KOS_BADPTR : ret;
+}
+
 static KOS_OBJ_ID get_named_args(KOS_CONTEXT ctx,
                                  KOS_OBJ_ID  func_obj,
                                  KOS_OBJ_ID  args_obj)
@@ -1003,6 +1126,10 @@ static int prepare_call(KOS_CONTEXT        ctx,
                                    regs_idx + rarg1,
                                    num_args,
                                    *this_obj));
+            /* Args are passed in place, see call_fast_handler() */
+            else if (IS_BAD_PTR(args.o) && OBJPTR(FUNCTION, func.o)->fast_handler) {
+                assert(state == KOS_FUN);
+            }
             else {
                 if (IS_BAD_PTR(args.o)) {
                     args.o = make_args(ctx, stack_obj, regs_idx + rarg1, num_args);
@@ -1320,6 +1447,23 @@ static KOS_OBJ_ID get_module(KOS_STACK_FRAME *stack_frame)
     return module_obj;
 }
 
+/* Module constants array is never resized, so unlike KOS_array_read() this only
+ * needs to check the index.  The index comes from bytecode, which may have been
+ * loaded from a cache file, so it is always checked. */
+static KOS_OBJ_ID read_const(KOS_CONTEXT ctx, KOS_OBJ_ID module_obj, uint32_t idx)
+{
+    const KOS_OBJ_ID constants = OBJPTR(MODULE, module_obj)->constants;
+
+    assert(GET_OBJ_TYPE(constants) == OBJ_ARRAY);
+
+    if (idx >= KOS_get_array_size(constants)) {
+        KOS_raise_exception(ctx, KOS_CONST_ID(str_err_invalid_index));
+        return KOS_BADPTR;
+    }
+
+    return KOS_atomic_read_relaxed_obj(kos_get_array_buffer(OBJPTR(ARRAY, constants))[idx]);
+}
+
 KOS_OBJ_ID KOS_get_module(KOS_CONTEXT ctx)
 {
     assert(ctx->regs_idx >= 3);
@@ -1333,295 +1477,1237 @@ const KOS_BYTECODE *get_bytecode_objptr(KOS_STACK_FRAME *stack_frame)
     return (const KOS_BYTECODE *)OBJPTR(OPAQUE, bytecode_obj);
 }
 
+/* Returns constant operand of an instruction.  Constants are resolved when
+ * the module is loaded.  Bytecode which was not loaded as part of a module
+ * has unresolved constants, these are read from the module, which also
+ * checks the index. */
+static KOS_OBJ_ID get_const_operand(KOS_CONTEXT      ctx,
+                                    KOS_OBJ_ID       module_obj,
+                                    const KOS_INSTR *ip,
+                                    uint32_t         idx)
+{
+    const KOS_OBJ_ID constant = ip->constant;
+
+    return IS_BAD_PTR(constant) ? read_const(ctx, module_obj, idx) : constant;
+}
+
+static KOS_BYTECODE_INSTR get_opcode(const KOS_INSTR *ip)
+{
+    return (KOS_BYTECODE_INSTR)KOS_atomic_read_relaxed_u32(ip->opcode);
+}
+
 #ifndef NDEBUG
-static uint32_t get_bytecode_size(KOS_STACK_FRAME *stack_frame)
+static uint32_t get_num_decoded(KOS_STACK_FRAME *stack_frame)
 {
     const KOS_BYTECODE *const bytecode_ptr = get_bytecode_objptr(stack_frame);
-    return bytecode_ptr->bytecode_size;
+    return bytecode_ptr->num_decoded;
 }
 #endif
 
-static const uint8_t *get_bytecode_at_offs(KOS_STACK_FRAME *stack_frame, uint32_t offs)
+static const KOS_INSTR *get_instr_at(KOS_STACK_FRAME *stack_frame, uint32_t idx)
 {
     const KOS_BYTECODE *const bytecode_ptr = get_bytecode_objptr(stack_frame);
-    return &bytecode_ptr->bytecode[offs];
+    return KOS_DECODED_INSTRS(bytecode_ptr) + idx;
 }
 
-static const uint8_t *get_bytecode(KOS_STACK_FRAME *stack_frame)
+static const KOS_INSTR *get_bytecode(KOS_STACK_FRAME *stack_frame)
 {
     const KOS_OBJ_ID instr_offs_id = KOS_atomic_read_relaxed_obj(stack_frame->instr_offs);
-    int64_t          instr_offs;
+    int64_t          instr_idx;
 
     assert(IS_SMALL_INT(instr_offs_id));
 
-    instr_offs = GET_SMALL_INT(instr_offs_id);
+    instr_idx = GET_SMALL_INT(instr_offs_id);
 
-    assert(instr_offs >= 0 && instr_offs < get_bytecode_size(stack_frame));
+    assert(instr_idx >= 0 && instr_idx < get_num_decoded(stack_frame));
 
-    return get_bytecode_at_offs(stack_frame, (uint32_t)instr_offs);
+    return get_instr_at(stack_frame, (uint32_t)instr_idx);
 }
 
-static uint32_t get_instr_offs(KOS_STACK_FRAME *stack_frame, const uint8_t *bytecode)
+static uint32_t get_instr_idx(KOS_STACK_FRAME *stack_frame, const KOS_INSTR *ip)
 {
-    return (uint32_t)(bytecode - get_bytecode_at_offs(stack_frame, 0));
+    return (uint32_t)(ip - get_instr_at(stack_frame, 0));
 }
 
 static void store_instr_offs(KOS_STACK_FRAME *stack_frame,
-                             const uint8_t   *bytecode)
+                             const KOS_INSTR *ip)
 {
-    const uint32_t instr_offs = get_instr_offs(stack_frame, bytecode);
-    KOS_atomic_write_relaxed_ptr(stack_frame->instr_offs, TO_SMALL_INT((int64_t)instr_offs));
+    const uint32_t instr_idx = get_instr_idx(stack_frame, ip);
+    KOS_atomic_write_relaxed_ptr(stack_frame->instr_offs, TO_SMALL_INT((int64_t)instr_idx));
 }
 
-static uint32_t get_catch(KOS_STACK_FRAME *stack_frame,
-                          uint8_t         *catch_reg)
+static KOS_PROP_CACHE *get_prop_cache(KOS_STACK_FRAME *stack_frame,
+                                      const KOS_INSTR *ip)
 {
-    const KOS_OBJ_ID catch_data_obj = KOS_atomic_read_relaxed_obj(stack_frame->catch_info);
-    uint64_t         catch_data;
-    uint32_t         catch_offs;
+    const KOS_OBJ_ID    func         = get_current_func(stack_frame);
+    KOS_BYTECODE *const bytecode_ptr = (KOS_BYTECODE *)OBJPTR(OPAQUE, OBJPTR(FUNCTION, func)->bytecode);
 
-    assert(IS_SMALL_INT(catch_data_obj));
+    /* Each property access instruction has its own cache, which was assigned
+     * by the decoder, unless the function has more of them than there are caches */
+    return (KOS_PROP_CACHE *)&bytecode_ptr->bytecode[bytecode_ptr->prop_cache_offs] + ip->op[3];
+}
 
-    catch_data = (uint64_t)GET_SMALL_INT(catch_data_obj);
+#ifdef KOS_CPP11
+static_assert(KOS_FIRST_QUICK_INSTR + KOS_NUM_QUICK_INSTRS == INSTR_LAST_OPCODE, "Unexpected number of quickened instructions");
+#endif
 
-    catch_offs = (uint32_t)(catch_data >> 8);
-    *catch_reg = (uint8_t)(catch_data & 0xFFU);
+#if KOS_DISPATCH_TABLE
+/* Addresses of instruction handlers in execute(), indexed with opcode */
+static void *const *vm_handlers;
 
-    return catch_offs;
-}
+static KOS_OBJ_ID execute(KOS_CONTEXT ctx);
+#endif
 
-static void set_catch(KOS_STACK_FRAME *stack_frame,
-                      uint32_t         catch_offs,
-                      uint8_t          catch_reg)
+/* Returns handler which the interpreter jumps to when executing the opcode */
+static void *get_handler(uint32_t opcode)
 {
-    const uint64_t catch_data = (((uint64_t)catch_offs << 8) | catch_reg);
-    assert(catch_offs < KOS_NO_CATCH);
-    KOS_atomic_write_relaxed_ptr(stack_frame->catch_info,
-                                 TO_SMALL_INT((intptr_t)(int64_t)catch_data));
+#if KOS_DISPATCH_TABLE
+    assert(vm_handlers);
+    return vm_handlers[opcode & 0xFFU];
+#else
+    (void)opcode;
+    return KOS_NULL;
+#endif
 }
 
-static void clear_catch(KOS_STACK_FRAME *stack_frame)
+/* Quickened instructions are rewritten in the decoded instructions, the original
+ * bytecode is never modified.  Multiple threads can execute the same function,
+ * but both the generic and the specialized instruction produce the same results,
+ * so it does not matter which one another thread sees. */
+static void write_opcode(const KOS_INSTR *ip, KOS_BYTECODE_INSTR instr)
 {
-    const intptr_t catch_data = KOS_NO_CATCH << 8;
-    KOS_atomic_write_relaxed_ptr(stack_frame->catch_info, TO_SMALL_INT(catch_data));
-}
+    KOS_INSTR *const dest = (KOS_INSTR *)ip;
 
-static KOS_OBJ_ID read_reg(KOS_STACK_FRAME *stack_frame, uint32_t reg)
-{
-    return KOS_atomic_read_relaxed_obj(stack_frame->regs[reg]);
+    KOS_atomic_write_relaxed_u32(dest->opcode, (uint32_t)instr);
+    KOS_atomic_write_relaxed_ptr(dest->handler, get_handler((uint32_t)instr));
 }
 
-static void write_reg(KOS_STACK_FRAME *stack_frame,
-                      uint32_t         reg,
-                      KOS_OBJ_ID       value)
+static void quicken_instr(KOS_CONTEXT        ctx,
+                          KOS_STACK_FRAME   *stack_frame,
+                          const KOS_INSTR   *ip,
+                          KOS_BYTECODE_INSTR quick_instr)
 {
-    assert(GET_OBJ_TYPE(value) <= OBJ_LAST_TYPE);
-    KOS_atomic_write_relaxed_ptr(stack_frame->regs[reg], value);
-}
+    KOS_BYTECODE *const bytecode_ptr = (KOS_BYTECODE *)get_bytecode_objptr(stack_frame);
 
-#if KOS_DISPATCH_TABLE
-#   define BEGIN_INSTRUCTION(instr)     OP_##instr
-#   define BEGIN_BREAKPOINT_INSTRUCTION OP_BREAKPOINT
-#   define NEXT_INSTRUCTION                                   \
-        do {                                                  \
-            uint32_t jump_offs;                               \
-                                                              \
-            KOS_INSTR_FUZZ_LIMIT();                           \
-            KOS_PERF_CNT(instructions);                       \
-            instr     = (KOS_BYTECODE_INSTR)*bytecode;        \
-            jump_offs = (uint32_t)(instr - INSTR_BREAKPOINT); \
-            jump_offs = (jump_offs < (INSTR_LAST_OPCODE - INSTR_BREAKPOINT)) ? jump_offs : 0; \
-            goto *dispatch_table[jump_offs];                  \
-        } while (0)
+    /* Don't keep flip-flopping instructions in functions with polymorphic operands */
+    if (KOS_atomic_read_relaxed_u32(bytecode_ptr->num_deopts) >= KOS_MAX_DEOPTS)
+        return;
 
-#else
-#   define BEGIN_INSTRUCTION(instr)     case INSTR_##instr
-#   define BEGIN_BREAKPOINT_INSTRUCTION default
-#   define NEXT_INSTRUCTION             KOS_INSTR_FUZZ_LIMIT(); break
-#endif
+    assert(quick_instr >= KOS_FIRST_QUICK_INSTR && quick_instr < INSTR_LAST_OPCODE);
+    assert(quick_instr - KOS_FIRST_QUICK_INSTR < KOS_NUM_QUICK_INSTRS);
 
-#if defined(__cplusplus) && defined(TRACY_ENABLE)
-/* This works correctly only for KOS_STRING_ELEM_8 and ASCII function names */
-#   define PROF_ZONE_NAME_FUN(func_obj_expr)                             \
-    {                                                                    \
-        const KOS_OBJ_ID func_obj = (func_obj_expr);                     \
-        const KOS_OBJ_ID name = OBJPTR(FUNCTION, func_obj)->name;        \
-        assert(GET_OBJ_TYPE(name) == OBJ_STRING);                        \
-        PROF_ZONE_NAME(                                                  \
-                (OBJPTR(STRING, name)->header.flags & KOS_STRING_LOCAL)  \
-                    ? (const char *)&OBJPTR(STRING, name)->local.data[0] \
-                    : (const char *)OBJPTR(STRING, name)->ptr.data_ptr,  \
-                OBJPTR(STRING, name)->header.length);                    \
-    }
-#else
-#   define PROF_ZONE_NAME_FUN(func_obj_expr)
-#endif
+    write_opcode(ip, quick_instr);
 
-static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
-{
-    PROF_ZONE(VM)
+    KOS_atomic_add_u32(ctx->inst->quicken.num_quickened[quick_instr - KOS_FIRST_QUICK_INSTR], 1U);
+}
 
-    const uint8_t     *bytecode;
-    KOS_BYTECODE_INSTR instr;
-    KOS_OBJ_ID         out      = KOS_BADPTR;
-    KOS_OBJ_ID         module;
-    KOS_OBJ_ID         stack    = ctx->stack;
-    KOS_STACK_FRAME   *stack_frame;
-    int                error    = KOS_SUCCESS;
-    int                depth    = 0; /* Number of calls inside execute() without affecting native stack */
-    unsigned           rdest;
-#ifndef NDEBUG
-    uint32_t           regs_idx = ctx->regs_idx;
-    uint32_t           num_regs = get_num_regs(ctx);
-#endif
+static void deoptimize_instr(KOS_CONTEXT        ctx,
+                             KOS_STACK_FRAME   *stack_frame,
+                             const KOS_INSTR   *ip,
+                             KOS_BYTECODE_INSTR generic_instr)
+{
+    KOS_BYTECODE *const      bytecode_ptr = (KOS_BYTECODE *)get_bytecode_objptr(stack_frame);
+    const KOS_BYTECODE_INSTR quick_instr  = get_opcode(ip);
 
-#if KOS_DISPATCH_TABLE
-    static void *const dispatch_table[] = {
-#   define DEFINE_INSTRUCTION(name, value) &&OP_##name,
-#   include "../inc/kos_opcodes.h"
-#   undef DEFINE_INSTRUCTION
-    };
-#endif
+    assert(quick_instr >= KOS_FIRST_QUICK_INSTR && quick_instr < INSTR_LAST_OPCODE);
 
-    stack_frame = get_current_stack_frame(ctx);
+    write_opcode(ip, generic_instr);
 
-    PROF_ZONE_NAME_FUN(get_current_func(stack_frame));
+    KOS_atomic_add_u32(bytecode_ptr->num_deopts, 1U);
+    KOS_atomic_add_u32(ctx->inst->quicken.num_deoptimized[quick_instr - KOS_FIRST_QUICK_INSTR], 1U);
+}
 
-    module = get_module(stack_frame);
-    assert( ! IS_BAD_PTR(module));
-    assert(OBJPTR(MODULE, module)->inst);
+/* Returns decoded instruction which starts at the specified bytecode offset,
+ * or the end marker if there is no such instruction */
+static const KOS_INSTR *find_instr(const KOS_BYTECODE *bytecode_ptr, uint32_t offs)
+{
+    const KOS_INSTR *const instrs = KOS_DECODED_INSTRS(bytecode_ptr);
+    uint32_t               begin  = 0;
+    uint32_t               end    = bytecode_ptr->num_decoded;
 
-    bytecode = get_bytecode(stack_frame);
+    while (begin < end) {
+        const uint32_t mid = (begin + end) / 2U;
 
-    assert( ! kos_is_heap_object(module));
-    assert( ! kos_is_heap_object(stack));
+        if (instrs[mid].offs == offs)
+            return &instrs[mid];
 
-#if KOS_DISPATCH_TABLE
-    NEXT_INSTRUCTION;
-#else
-    for (;;) {
-        assert( ! KOS_is_exception_pending(ctx));
-        assert(get_instr_offs(stack_frame, bytecode) < get_bytecode_size(stack_frame));
+        if (instrs[mid].offs < offs)
+            begin = mid + 1U;
+        else
+            end = mid;
+    }
 
-        KOS_PERF_CNT(instructions);
+    return &instrs[bytecode_ptr->num_decoded];
+}
 
-        instr = (KOS_BYTECODE_INSTR)*bytecode;
+void kos_vm_decode(KOS_BYTECODE *bytecode_ptr)
+{
+    KOS_INSTR *const     instrs    = KOS_DECODED_INSTRS(bytecode_ptr);
+    const uint8_t *const bytecode  = &bytecode_ptr->bytecode[0];
+    const uint32_t       num_instr = bytecode_ptr->num_decoded;
+    uint32_t             offs      = 0;
+    uint32_t             num_sites = 0;
+    uint32_t             i;
 
-        switch (instr) {
+#if KOS_DISPATCH_TABLE
+    if ( ! vm_handlers)
+        (void)execute(KOS_NULL);
 #endif
 
-            BEGIN_INSTRUCTION(LOAD_CONST): { /* <r.dest>, <uimm> */
-                PROF_ZONE_N(INSTR, "LOAD.CONST")
-                const KOS_IMM imm = kos_load_uimm(bytecode + 2);
-
-                rdest = bytecode[1];
+    for (i = 0; i <= num_instr; i++) {
+        KOS_INSTR *const ip = &instrs[i];
+        int              iop;
 
-                out = KOS_array_read(ctx, OBJPTR(MODULE, module)->constants, imm.value.sv);
-                TRY_OBJID(out);
+        ip->constant = KOS_BADPTR;
+        ip->offs     = offs;
 
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, out);
+        for (iop = 0; iop < (int)(sizeof(ip->op) / sizeof(ip->op[0])); iop++)
+            ip->op[iop] = 0;
 
-                bytecode += 2 + imm.size;
-                NEXT_INSTRUCTION;
-            }
+        /* End marker has an invalid opcode, so executing it raises a panic */
+        if (i == num_instr) {
+            write_opcode(ip, (KOS_BYTECODE_INSTR)0);
+            break;
+        }
 
-            BEGIN_INSTRUCTION(LOAD_FUN): { /* <r.dest>, <uimm> */
-                PROF_ZONE_N(INSTR, "LOAD.FUN")
-                const KOS_IMM imm = kos_load_uimm(bytecode + 2);
+        {
+            const KOS_BYTECODE_INSTR opcode       = (KOS_BYTECODE_INSTR)bytecode[offs];
+            const int                num_operands = kos_get_num_operands(opcode);
 
-                rdest = bytecode[1];
+            write_opcode(ip, opcode);
 
-                out = KOS_array_read(ctx, OBJPTR(MODULE, module)->constants, imm.value.sv);
-                TRY_OBJID(out);
+            ++offs;
 
-                out = kos_copy_function(ctx, out);
-                TRY_OBJID(out);
+            for (iop = 0; iop < num_operands; iop++) {
 
-                if (GET_OBJ_TYPE(out) == OBJ_CLASS) {
-                    const KOS_OBJ_ID proto_obj = KOS_array_read(ctx,
-                                                                OBJPTR(MODULE, module)->constants,
-                                                                imm.value.sv + 1);
-                    TRY_OBJID(proto_obj);
+                if (kos_get_operand_size(opcode, iop) == -1) {
+                    const KOS_IMM imm = kos_is_signed_op(opcode, iop)
+                                      ? kos_load_simm(&bytecode[offs])
+                                      : kos_load_uimm(&bytecode[offs]);
 
-                    KOS_atomic_write_relaxed_ptr(OBJPTR(CLASS, out)->prototype, proto_obj);
+                    ip->op[iop] = imm.value.sv;
+                    offs       += (uint32_t)imm.size;
                 }
+                else {
+                    assert(kos_get_operand_size(opcode, iop) == 1);
 
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, out);
-
-                bytecode += 2 + imm.size;
-                NEXT_INSTRUCTION;
+                    if ( ! kos_is_register(opcode, iop) && kos_is_signed_op(opcode, iop))
+                        ip->op[iop] = (int8_t)bytecode[offs];
+                    else
+                        ip->op[iop] = bytecode[offs];
+                    ++offs;
+                }
             }
 
-            BEGIN_INSTRUCTION(LOAD_INT8): { /* <r.dest>, <int8> */
-                PROF_ZONE_N(INSTR, "LOAD.INT8")
-                const int8_t value = (int8_t)bytecode[2];
+            /* Each property access instruction has its own cache,
+             * unless the function has more of them than there are caches */
+            if ((opcode == INSTR_GET_PROP8) || (opcode == INSTR_GET_PROP8_OPT) || (opcode == INSTR_SET_PROP8))
+                ip->op[3] = (int32_t)(num_sites++ & bytecode_ptr->prop_cache_mask);
+        }
+    }
 
-                rdest = bytecode[1];
+    /* Jump offsets are relative to the end of the instruction in bytecode,
+     * convert them to distances between decoded instructions */
+    for (i = 0; i < num_instr; i++) {
+        KOS_INSTR *const         ip           = &instrs[i];
+        const KOS_BYTECODE_INSTR opcode       = get_opcode(ip);
+        const int                num_operands = kos_get_num_operands(opcode);
+        int                      iop;
 
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, TO_SMALL_INT(value));
+        for (iop = 0; iop < num_operands; iop++) {
+            if (kos_get_offset_operand_tail(opcode, iop) >= 0) {
+                const uint32_t target = ip[1].offs + (uint32_t)ip->op[iop];
 
-                bytecode += 3;
-                NEXT_INSTRUCTION;
+                ip->op[iop] = (int32_t)(find_instr(bytecode_ptr, target) - ip);
             }
+        }
+    }
+}
 
-            BEGIN_INSTRUCTION(LOAD_TRUE): { /* <r.dest> */
-                PROF_ZONE_N(INSTR, "LOAD.TRUE")
-                rdest = bytecode[1];
+void kos_vm_resolve_constants(KOS_BYTECODE *bytecode_ptr, KOS_OBJ_ID constants)
+{
+    KOS_INSTR       *ip            = KOS_DECODED_INSTRS(bytecode_ptr);
+    KOS_INSTR *const end           = ip + bytecode_ptr->num_decoded;
+    const uint32_t   num_constants = KOS_get_array_size(constants);
 
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, KOS_TRUE);
+    assert(GET_OBJ_TYPE(constants) == OBJ_ARRAY);
 
-                bytecode += 2;
-                NEXT_INSTRUCTION;
-            }
+    for ( ; ip < end; ++ip) {
+        const KOS_BYTECODE_INSTR opcode       = get_opcode(ip);
+        const int                num_operands = kos_get_num_operands(opcode);
+        int                      iop;
 
-            BEGIN_INSTRUCTION(LOAD_FALSE): { /* <r.dest> */
-                PROF_ZONE_N(INSTR, "LOAD.FALSE")
-                rdest = bytecode[1];
+        for (iop = 0; iop < num_operands; iop++) {
 
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, KOS_FALSE);
+            if (kos_is_constant_op(opcode, iop)) {
+                const uint32_t idx = (uint32_t)ip->op[iop];
 
-                bytecode += 2;
-                NEXT_INSTRUCTION;
+                /* Invalid indexes are left unresolved and are reported when executed */
+                if (idx < num_constants)
+                    ip->constant = KOS_atomic_read_relaxed_obj(
+                            kos_get_array_buffer(OBJPTR(ARRAY, constants))[idx]);
+                break;
             }
+        }
+    }
+}
 
-            BEGIN_INSTRUCTION(LOAD_VOID): { /* <r.dest> */
-                PROF_ZONE_N(INSTR, "LOAD.VOID")
-                rdest = bytecode[1];
+static int is_string_pair(KOS_OBJ_ID a, KOS_OBJ_ID b)
+{
+    return ! IS_SMALL_INT(a) && ! IS_SMALL_INT(b) &&
+           READ_OBJ_TYPE(a) == OBJ_STRING && READ_OBJ_TYPE(b) == OBJ_STRING;
+}
 
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, KOS_VOID);
+static int is_string_equal(KOS_OBJ_ID a, KOS_OBJ_ID b)
+{
+    return a == b ||
+           (KOS_get_string_length(a) == KOS_get_string_length(b) && ! KOS_string_compare(a, b));
+}
 
-                bytecode += 2;
-                NEXT_INSTRUCTION;
-            }
+#ifdef KOS_JIT
+KOS_OBJ_ID kos_vm_arith(KOS_CONTEXT      ctx,
+                        const KOS_INSTR *ip,
+                        KOS_OBJ_ID       src1,
+                        KOS_OBJ_ID       src2)
+{
+    KOS_STACK_FRAME *const stack_frame = get_current_stack_frame(ctx);
+    KOS_BYTECODE_INSTR     instr       = get_opcode(ip);
+    const int              small_ints  = IS_SMALL_INT(src1) && IS_SMALL_INT(src2);
+    const int              floats      = (GET_OBJ_TYPE(src1) == OBJ_FLOAT) && (GET_OBJ_TYPE(src2) == OBJ_FLOAT);
+    int64_t                a;
+
+    switch (instr) {
+
+        case INSTR_ADD:
+            if (small_ints)
+                quicken_instr(ctx, stack_frame, ip, INSTR_ADD_SMALLINT);
+            else if (floats)
+                quicken_instr(ctx, stack_frame, ip, INSTR_ADD_FLOAT);
+            break;
 
-            BEGIN_INSTRUCTION(NEW_ARRAY8): { /* <r.dest>, <uint8.size> */
-                PROF_ZONE_N(INSTR, "NEW.ARRAY8")
-                const uint8_t size = bytecode[2];
+        case INSTR_SUB:
+            if (small_ints)
+                quicken_instr(ctx, stack_frame, ip, INSTR_SUB_SMALLINT);
+            else if (floats)
+                quicken_instr(ctx, stack_frame, ip, INSTR_SUB_FLOAT);
+            break;
 
-                rdest = bytecode[1];
+        case INSTR_MUL:
+            if (floats)
+                quicken_instr(ctx, stack_frame, ip, INSTR_MUL_FLOAT);
+            break;
 
-                out = KOS_new_array(ctx, size);
-                TRY_OBJID(out);
+        case INSTR_ADD_SMALLINT:
+            instr = INSTR_ADD;
+            if ( ! small_ints)
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
 
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, out);
+        case INSTR_SUB_SMALLINT:
+            instr = INSTR_SUB;
+            if ( ! small_ints)
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
 
-                bytecode += 3;
-                NEXT_INSTRUCTION;
-            }
+        case INSTR_ADD_FLOAT:
+            instr = INSTR_ADD;
+            if ( ! floats)
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
 
-            BEGIN_INSTRUCTION(NEW_OBJ): { /* <r.dest>, <r.src> */
-                PROF_ZONE_N(INSTR, "NEW.OBJ")
-                const unsigned rsrc = bytecode[2];
+        case INSTR_SUB_FLOAT:
+            instr = INSTR_SUB;
+            if ( ! floats)
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
 
-                if (rsrc == KOS_NO_REG)
-                    out = KOS_new_object(ctx);
+        case INSTR_MUL_FLOAT:
+            instr = INSTR_MUL;
+            if ( ! floats)
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
+
+        default:
+            assert((instr == INSTR_DIV) || (instr == INSTR_MOD));
+            break;
+    }
+
+    switch (GET_OBJ_TYPE(src1)) {
+
+        case OBJ_SMALL_INTEGER:
+            a = GET_SMALL_INT(src1);
+            break;
+
+        case OBJ_INTEGER:
+            a = OBJPTR(INTEGER, src1)->value;
+            break;
+
+        case OBJ_FLOAT: {
+            const double f = KOS_get_float(src1);
+
+            switch (instr) {
+                case INSTR_ADD: return add_float(ctx, f, src2);
+                case INSTR_SUB: return sub_float(ctx, f, src2);
+                case INSTR_MUL: return mul_float(ctx, f, src2);
+                case INSTR_DIV: return div_float(ctx, f, src2);
+                default:        return mod_float(ctx, f, src2);
+            }
+        }
+
+        default:
+            KOS_raise_exception(ctx, KOS_CONST_ID(str_err_unsup_operand_types));
+            return KOS_BADPTR;
+    }
+
+    switch (instr) {
+        case INSTR_ADD: return add_integer(ctx, a, src2);
+        case INSTR_SUB: return sub_integer(ctx, a, src2);
+        case INSTR_MUL: return mul_integer(ctx, a, src2);
+        case INSTR_DIV: return div_integer(ctx, a, src2);
+        default:        return mod_integer(ctx, a, src2);
+    }
+}
+
+KOS_OBJ_ID kos_vm_compare(KOS_CONTEXT      ctx,
+                          const KOS_INSTR *ip,
+                          KOS_OBJ_ID       src1,
+                          KOS_OBJ_ID       src2)
+{
+    KOS_STACK_FRAME *const stack_frame = get_current_stack_frame(ctx);
+    KOS_BYTECODE_INSTR     instr       = get_opcode(ip);
+    const int              small_ints  = IS_SMALL_INT(src1) && IS_SMALL_INT(src2);
+    KOS_COMPARE_RESULT     cmp;
+
+    switch (instr) {
+
+        case INSTR_CMP_EQ:
+            if (small_ints)
+                quicken_instr(ctx, stack_frame, ip, INSTR_CMP_EQ_SMALLINT);
+            else if (is_string_pair(src1, src2))
+                quicken_instr(ctx, stack_frame, ip, INSTR_CMP_EQ_STR);
+            break;
+
+        case INSTR_CMP_NE:
+            if (small_ints)
+                quicken_instr(ctx, stack_frame, ip, INSTR_CMP_NE_SMALLINT);
+            else if (is_string_pair(src1, src2))
+                quicken_instr(ctx, stack_frame, ip, INSTR_CMP_NE_STR);
+            break;
+
+        case INSTR_CMP_LE:
+            if (small_ints)
+                quicken_instr(ctx, stack_frame, ip, INSTR_CMP_LE_SMALLINT);
+            break;
+
+        case INSTR_CMP_LT:
+            if (small_ints)
+                quicken_instr(ctx, stack_frame, ip, INSTR_CMP_LT_SMALLINT);
+            break;
+
+        case INSTR_CMP_EQ_SMALLINT:
+            instr = INSTR_CMP_EQ;
+            if ( ! small_ints)
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
+
+        case INSTR_CMP_NE_SMALLINT:
+            instr = INSTR_CMP_NE;
+            if ( ! small_ints)
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
+
+        case INSTR_CMP_LE_SMALLINT:
+            instr = INSTR_CMP_LE;
+            if ( ! small_ints)
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
+
+        case INSTR_CMP_LT_SMALLINT:
+            instr = INSTR_CMP_LT;
+            if ( ! small_ints)
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
+
+        case INSTR_CMP_EQ_STR:
+            instr = INSTR_CMP_EQ;
+            if ( ! is_string_pair(src1, src2))
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
+
+        default:
+            assert(instr == INSTR_CMP_NE_STR);
+            instr = INSTR_CMP_NE;
+            if ( ! is_string_pair(src1, src2))
+                deoptimize_instr(ctx, stack_frame, ip, instr);
+            break;
+    }
+
+    cmp = KOS_compare(src1, src2);
+
+    switch (instr) {
+        case INSTR_CMP_EQ: return KOS_BOOL(cmp == KOS_EQUAL);
+        case INSTR_CMP_NE: return KOS_BOOL(cmp);
+        case INSTR_CMP_LE: return KOS_BOOL(cmp <= KOS_LESS_THAN);
+        default:           return KOS_BOOL(cmp == KOS_LESS_THAN);
+    }
+}
+
+/* Returns the first instruction at or after the specified one at which native
+ * code of the function is worth entering, or KOS_NULL if there is none */
+static const KOS_INSTR *find_jit_entry(const KOS_BYTECODE *bytecode_ptr,
+                                       const KOS_INSTR    *ip)
+{
+    const uint32_t offs = kos_jit_get_entry(bytecode_ptr, ip->offs);
+
+    return (offs == KOS_JIT_NO_ENTRY) ? KOS_NULL : find_instr(bytecode_ptr, offs);
+}
+
+/* Returns the instruction at which native code of the current function will be
+ * entered, or KOS_NULL if the function has not been compiled.  Called on function
+ * entry and on loop back-edges, which drives the function's hotness counter. */
+static const KOS_INSTR *get_jit_entry(KOS_CONTEXT      ctx,
+                                      KOS_STACK_FRAME *stack_frame,
+                                      const KOS_INSTR *ip)
+{
+    KOS_BYTECODE *bytecode_ptr;
+    uint32_t      counter;
+
+    if ( ! (ctx->inst->flags & KOS_INST_JIT))
+        return KOS_NULL;
+
+    bytecode_ptr = (KOS_BYTECODE *)get_bytecode_objptr(stack_frame);
+
+    if (KOS_atomic_read_relaxed_ptr(bytecode_ptr->jit_code))
+        return find_jit_entry(bytecode_ptr, ip);
+
+    /* Races between threads only make the counter less accurate */
+    counter = KOS_atomic_read_relaxed_u32(bytecode_ptr->jit_counter) + 1U;
+    KOS_atomic_write_relaxed_u32(bytecode_ptr->jit_counter, counter);
+
+    if (counter != KOS_JIT_THRESHOLD)
+        return KOS_NULL;
+
+    if (kos_jit_compile(ctx, bytecode_ptr, get_module(stack_frame)))
+        return KOS_NULL;
+
+    return find_jit_entry(bytecode_ptr, ip);
+}
+
+/* Runs native code of the current function, returns the instruction at which
+ * the interpreter continues */
+static const KOS_INSTR *run_jit(KOS_CONTEXT      ctx,
+                                KOS_STACK_FRAME *stack_frame,
+                                const KOS_INSTR *ip)
+{
+    const KOS_BYTECODE *const bytecode_ptr = get_bytecode_objptr(stack_frame);
+
+    /* Native code is compiled from the original bytecode and uses its offsets */
+    return find_instr(bytecode_ptr, kos_jit_run(ctx, bytecode_ptr, &stack_frame->regs[0], ip->offs));
+}
+
+#   define UPDATE_JIT_ENTRY() (jit_entry = get_jit_entry(ctx, stack_frame, ip))
+#   define ENTER_JIT()        do { if (ip == jit_entry) goto enter_jit; } while (0)
+#else
+#   define UPDATE_JIT_ENTRY() ((void)0)
+#   define ENTER_JIT()        ((void)0)
+#endif
+
+static uint32_t get_catch(KOS_STACK_FRAME *stack_frame,
+                          uint8_t         *catch_reg)
+{
+    const KOS_OBJ_ID catch_data_obj = KOS_atomic_read_relaxed_obj(stack_frame->catch_info);
+    uint64_t         catch_data;
+    uint32_t         catch_offs;
+
+    assert(IS_SMALL_INT(catch_data_obj));
+
+    catch_data = (uint64_t)GET_SMALL_INT(catch_data_obj);
+
+    catch_offs = (uint32_t)(catch_data >> 8);
+    *catch_reg = (uint8_t)(catch_data & 0xFFU);
+
+    return catch_offs;
+}
+
+static void set_catch(KOS_STACK_FRAME *stack_frame,
+                      uint32_t         catch_offs,
+                      uint8_t          catch_reg)
+{
+    const uint64_t catch_data = (((uint64_t)catch_offs << 8) | catch_reg);
+    assert(catch_offs < KOS_NO_CATCH);
+    KOS_atomic_write_relaxed_ptr(stack_frame->catch_info,
+                                 TO_SMALL_INT((intptr_t)(int64_t)catch_data));
+}
+
+static void clear_catch(KOS_STACK_FRAME *stack_frame)
+{
+    const intptr_t catch_data = KOS_NO_CATCH << 8;
+    KOS_atomic_write_relaxed_ptr(stack_frame->catch_info, TO_SMALL_INT(catch_data));
+}
+
+static KOS_OBJ_ID read_reg(KOS_STACK_FRAME *stack_frame, uint32_t reg)
+{
+    return KOS_atomic_read_relaxed_obj(stack_frame->regs[reg]);
+}
+
+static void write_reg(KOS_STACK_FRAME *stack_frame,
+                      uint32_t         reg,
+                      KOS_OBJ_ID       value)
+{
+    assert(GET_OBJ_TYPE(value) <= OBJ_LAST_TYPE);
+    KOS_atomic_write_relaxed_ptr(stack_frame->regs[reg], value);
+}
+
+/* Instructions which don't affect control flow are executed by the functions
+ * below, which are shared between the interpreter and native code produced
+ * by the JIT.  They return KOS_ERROR_EXCEPTION if an exception was raised. */
+
+static int exec_get(KOS_CONTEXT      ctx,
+                    KOS_STACK_FRAME *stack_frame,
+                    const KOS_INSTR *ip)
+{
+    const unsigned rdest = ip->op[0];
+    const unsigned rsrc  = ip->op[1];
+    const unsigned rprop = ip->op[2];
+    const int      opt   = get_opcode(ip) == INSTR_GET_OPT;
+    KOS_OBJ_ID     src;
+    KOS_OBJ_ID     prop;
+    KOS_OBJ_ID     out;
+    int            error = KOS_SUCCESS;
+
+    assert(rdest < get_num_regs(ctx));
+    assert(rsrc  < get_num_regs(ctx));
+    assert(rprop < get_num_regs(ctx));
+
+    src  = read_reg(stack_frame, rsrc);
+    prop = read_reg(stack_frame, rprop);
+
+    if (IS_NUMERIC_OBJ(prop)) {
+        KOS_TYPE type;
+        int64_t  idx;
+
+        TRY(KOS_get_integer(ctx, prop, &idx));
+
+        if (idx > INT_MAX || idx < INT_MIN)
+            RAISE_EXCEPTION_STR(str_err_invalid_index);
+
+        type = GET_OBJ_TYPE(src);
+        if (type == OBJ_STRING)
+            out = KOS_string_get_char(ctx, src, (int)idx);
+        else if (type == OBJ_BUFFER)
+            out = read_buffer(ctx, src, (int)idx);
+        else
+            out = KOS_array_read(ctx, src, (int)idx);
+
+        if (IS_BAD_PTR(out) && opt) {
+            KOS_clear_exception(ctx);
+            out = KOS_VOID;
+        }
+    }
+    else {
+        out = KOS_get_property(ctx, src, prop);
+
+        if (IS_BAD_PTR(out)) {
+            if (opt && GET_OBJ_TYPE(read_reg(stack_frame, rprop)) == OBJ_STRING) {
+
+                KOS_clear_exception(ctx);
+                out = KOS_VOID;
+            }
+        }
+
+        if ( ! IS_BAD_PTR(out) && GET_OBJ_TYPE(out) == OBJ_DYNAMIC_PROP) {
+            store_instr_offs(stack_frame, ip);
+
+            out = OBJPTR(DYNAMIC_PROP, out)->getter;
+            out = KOS_call_function(ctx, out, src, KOS_EMPTY_ARRAY);
+        }
+    }
+
+    TRY_OBJID(out);
+
+    write_reg(stack_frame, rdest, out);
+
+cleanup:
+    return error;
+}
+
+static int exec_get_elem8(KOS_CONTEXT      ctx,
+                          KOS_STACK_FRAME *stack_frame,
+                          const KOS_INSTR *ip)
+{
+    const unsigned rdest = ip->op[0];
+    const unsigned rsrc  = ip->op[1];
+    const int32_t  idx   = ip->op[2];
+    KOS_OBJ_ID     src;
+    KOS_OBJ_ID     out;
+    KOS_TYPE       type;
+    int            error = KOS_SUCCESS;
+
+    assert(rdest < get_num_regs(ctx));
+    assert(rsrc  < get_num_regs(ctx));
+
+    src  = read_reg(stack_frame, rsrc);
+    type = GET_OBJ_TYPE(src);
+
+    if (type == OBJ_ARRAY)
+        out = KOS_array_read(ctx, src, idx);
+    else if (type == OBJ_STRING)
+        out = KOS_string_get_char(ctx, src, idx);
+    else if (type == OBJ_BUFFER)
+        out = read_buffer(ctx, src, idx);
+    else if (type == OBJ_STACK)
+        out = read_stack(ctx, src, idx);
+    else
+        RAISE_EXCEPTION_STR(str_err_not_indexable);
+
+    if (IS_BAD_PTR(out)) {
+        if (get_opcode(ip) == INSTR_GET_ELEM8_OPT) {
+            KOS_clear_exception(ctx);
+            out = KOS_VOID;
+        }
+        else
+            RAISE_ERROR(KOS_ERROR_EXCEPTION);
+    }
+
+    write_reg(stack_frame, rdest, out);
+
+cleanup:
+    return error;
+}
+
+static int exec_get_prop8(KOS_CONTEXT      ctx,
+                          KOS_STACK_FRAME *stack_frame,
+                          const KOS_INSTR *ip,
+                          KOS_OBJ_ID       module_obj)
+{
+    const unsigned rdest = ip->op[0];
+    const unsigned rsrc  = ip->op[1];
+    const uint8_t  idx   = ip->op[2];
+    KOS_OBJ_ID     prop;
+    KOS_OBJ_ID     obj;
+    KOS_OBJ_ID     out;
+    int            error = KOS_SUCCESS;
+
+    assert(rdest < get_num_regs(ctx));
+    assert(rsrc  < get_num_regs(ctx));
+
+    prop = read_const(ctx, module_obj, idx);
+    TRY_OBJID(prop);
+
+    obj = read_reg(stack_frame, rsrc);
+    out = kos_get_property_cached(ctx, obj, prop, get_prop_cache(stack_frame, ip));
+
+    if (IS_BAD_PTR(out)) {
+        if (get_opcode(ip) == INSTR_GET_PROP8_OPT) {
+            KOS_clear_exception(ctx);
+            out = KOS_VOID;
+        }
+        else
+            RAISE_ERROR(KOS_ERROR_EXCEPTION);
+    }
+
+    if (GET_OBJ_TYPE(out) == OBJ_DYNAMIC_PROP) {
+        store_instr_offs(stack_frame, ip);
+
+        out = OBJPTR(DYNAMIC_PROP, out)->getter;
+        out = KOS_call_function(ctx, out, obj, KOS_EMPTY_ARRAY);
+        TRY_OBJID(out);
+    }
+
+    write_reg(stack_frame, rdest, out);
+
+cleanup:
+    return error;
+}
+
+static int call_setter(KOS_CONTEXT      ctx,
+                       KOS_STACK_FRAME *stack_frame,
+                       const KOS_INSTR *ip,
+                       unsigned         rdest,
+                       unsigned         rsrc)
+{
+    KOS_OBJ_ID              args;
+    KOS_OBJ_ID              retval;
+    KOS_LOCAL               setter;
+    KOS_ATOMIC(KOS_OBJ_ID) *buf;
+    int                     error = KOS_SUCCESS;
+
+    assert(KOS_is_exception_pending(ctx));
+    setter.o = KOS_get_exception(ctx);
+    KOS_clear_exception(ctx);
+
+    assert( ! IS_BAD_PTR(setter.o) && GET_OBJ_TYPE(setter.o) == OBJ_DYNAMIC_PROP);
+    store_instr_offs(stack_frame, ip);
+
+    setter.o = OBJPTR(DYNAMIC_PROP, setter.o)->setter;
+    if (IS_BAD_PTR(setter.o))
+        /* TODO print property name */
+        RAISE_EXCEPTION_STR(str_err_no_setter);
+
+    KOS_init_local_with(ctx, &setter, setter.o);
+
+    args = KOS_new_array(ctx, 1);
+
+    setter.o = KOS_destroy_top_local(ctx, &setter);
+
+    TRY_OBJID(args);
+
+    buf = kos_get_array_buffer(OBJPTR(ARRAY, args));
+
+    buf[0] = read_reg(stack_frame, rsrc);
+
+    retval = KOS_call_function(ctx, setter.o, read_reg(stack_frame, rdest), args);
+    TRY_OBJID(retval);
+
+cleanup:
+    return error;
+}
+
+static int exec_set(KOS_CONTEXT      ctx,
+                    KOS_STACK_FRAME *stack_frame,
+                    const KOS_INSTR *ip)
+{
+    const unsigned rdest = ip->op[0];
+    const unsigned rprop = ip->op[1];
+    const unsigned rsrc  = ip->op[2];
+    KOS_OBJ_ID     prop;
+    int            error = KOS_SUCCESS;
+
+    assert(rdest < get_num_regs(ctx));
+    assert(rprop < get_num_regs(ctx));
+    assert(rsrc  < get_num_regs(ctx));
+
+    prop = read_reg(stack_frame, rprop);
+
+    if (IS_NUMERIC_OBJ(prop)) {
+        KOS_OBJ_ID obj;
+        int64_t    idx;
+
+        TRY(KOS_get_integer(ctx, prop, &idx));
+
+        if (idx > INT_MAX || idx < INT_MIN)
+            RAISE_EXCEPTION_STR(str_err_invalid_index);
+
+        obj = read_reg(stack_frame, rdest);
+        if (GET_OBJ_TYPE(obj) == OBJ_BUFFER)
+            TRY(write_buffer(ctx, obj, (int)idx, read_reg(stack_frame, rsrc)));
+        else
+            TRY(KOS_array_write(ctx, obj, (int)idx, read_reg(stack_frame, rsrc)));
+    }
+    else {
+        error = KOS_set_property(ctx, read_reg(stack_frame, rdest), prop, read_reg(stack_frame, rsrc));
+
+        if (error == KOS_ERROR_SETTER)
+            error = call_setter(ctx, stack_frame, ip, rdest, rsrc);
+    }
+
+cleanup:
+    return error;
+}
+
+static int exec_set_elem8(KOS_CONTEXT      ctx,
+                          KOS_STACK_FRAME *stack_frame,
+                          const KOS_INSTR *ip)
+{
+    const unsigned rdest = ip->op[0];
+    const int32_t  idx   = ip->op[1];
+    const unsigned rsrc  = ip->op[2];
+    KOS_OBJ_ID     dest;
+    KOS_TYPE       type;
+    int            error = KOS_SUCCESS;
+
+    assert(rdest < get_num_regs(ctx));
+    assert(rsrc  < get_num_regs(ctx));
+
+    dest = read_reg(stack_frame, rdest);
+    type = GET_OBJ_TYPE(dest);
+
+    if (type == OBJ_ARRAY)
+        error = KOS_array_write(ctx, dest, idx, read_reg(stack_frame, rsrc));
+    else if (type == OBJ_BUFFER)
+        error = write_buffer(ctx, dest, idx, read_reg(stack_frame, rsrc));
+    else if (type == OBJ_STACK)
+        error = write_stack(ctx, dest, idx, read_reg(stack_frame, rsrc));
+    else
+        RAISE_EXCEPTION_STR(str_err_not_indexable);
+
+cleanup:
+    return error;
+}
+
+static int exec_set_prop8(KOS_CONTEXT      ctx,
+                          KOS_STACK_FRAME *stack_frame,
+                          const KOS_INSTR *ip,
+                          KOS_OBJ_ID       module_obj)
+{
+    const unsigned rdest = ip->op[0];
+    const uint8_t  idx   = ip->op[1];
+    const unsigned rsrc  = ip->op[2];
+    KOS_OBJ_ID     prop;
+    int            error = KOS_SUCCESS;
+
+    assert(rdest < get_num_regs(ctx));
+    assert(rsrc  < get_num_regs(ctx));
+
+    prop = read_const(ctx, module_obj, idx);
+    TRY_OBJID(prop);
+
+    error = kos_set_property_cached(ctx,
+                                    read_reg(stack_frame, rdest),
+                                    prop,
+                                    read_reg(stack_frame, rsrc),
+                                    get_prop_cache(stack_frame, ip));
+
+    if (error == KOS_ERROR_SETTER)
+        error = call_setter(ctx, stack_frame, ip, rdest, rsrc);
+
+cleanup:
+    return error;
+}
+
+static int exec_bitwise(KOS_CONTEXT      ctx,
+                        KOS_STACK_FRAME *stack_frame,
+                        const KOS_INSTR *ip)
+{
+    const unsigned rdest = ip->op[0];
+    const unsigned rsrc1 = ip->op[1];
+    const unsigned rsrc2 = ip->op[2];
+    KOS_OBJ_ID     out;
+    int64_t        a;
+    int64_t        b;
+    int            error = KOS_SUCCESS;
+
+    assert(rdest < get_num_regs(ctx));
+    assert(rsrc1 < get_num_regs(ctx));
+    assert(rsrc2 < get_num_regs(ctx));
+
+    TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc1), &a));
+    TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc2), &b));
+
+    switch (get_opcode(ip)) {
+
+        case INSTR_SHL:
+            if (b > 63 || b < -62)
+                out = TO_SMALL_INT((a < 0 && b < 0) ? -1 : 0);
+            else if (b < 0)
+                out = KOS_new_int(ctx, a >> -b);
+            else
+                out = KOS_new_int(ctx, (int64_t)((uint64_t)a << b));
+            break;
+
+        case INSTR_SHR:
+            if (b > 62 || b < -63)
+                out = TO_SMALL_INT((a < 0 && b > 0) ? -1 : 0);
+            else if (b < 0)
+                out = KOS_new_int(ctx, (int64_t)((uint64_t)a << -b));
+            else
+                out = KOS_new_int(ctx, a >> b);
+            break;
+
+        case INSTR_SHRU:
+            if (b > 63 || b < -63)
+                out = TO_SMALL_INT(0);
+            else if (b < 0)
+                out = KOS_new_int(ctx, (int64_t)((uint64_t)a << -b));
+            else
+                out = KOS_new_int(ctx, (int64_t)((uint64_t)a >> b));
+            break;
+
+        case INSTR_AND:
+            out = KOS_new_int(ctx, a & b);
+            break;
+
+        case INSTR_OR:
+            out = KOS_new_int(ctx, a | b);
+            break;
+
+        default:
+            assert(get_opcode(ip) == INSTR_XOR);
+            out = KOS_new_int(ctx, a ^ b);
+            break;
+    }
+
+    TRY_OBJID(out);
+
+    write_reg(stack_frame, rdest, out);
+
+cleanup:
+    return error;
+}
+
+#ifdef KOS_JIT
+static int jit_get_prop8(KOS_CONTEXT      ctx,
+                         KOS_STACK_FRAME *stack_frame,
+                         const KOS_INSTR *ip)
+{
+    return exec_get_prop8(ctx, stack_frame, ip, get_module(stack_frame));
+}
+
+static int jit_set_prop8(KOS_CONTEXT      ctx,
+                         KOS_STACK_FRAME *stack_frame,
+                         const KOS_INSTR *ip)
+{
+    return exec_set_prop8(ctx, stack_frame, ip, get_module(stack_frame));
+}
+
+KOS_VM_EXEC kos_vm_get_exec(KOS_BYTECODE_INSTR instr)
+{
+    switch (instr) {
+        case INSTR_GET:           /* fall through */
+        case INSTR_GET_OPT:       return exec_get;
+        case INSTR_GET_ELEM8:     /* fall through */
+        case INSTR_GET_ELEM8_OPT: return exec_get_elem8;
+        case INSTR_GET_PROP8:     /* fall through */
+        case INSTR_GET_PROP8_OPT: return jit_get_prop8;
+        case INSTR_SET:           return exec_set;
+        case INSTR_SET_ELEM8:     return exec_set_elem8;
+        case INSTR_SET_PROP8:     return jit_set_prop8;
+        case INSTR_SHL:           /* fall through */
+        case INSTR_SHR:           /* fall through */
+        case INSTR_SHRU:          /* fall through */
+        case INSTR_AND:           /* fall through */
+        case INSTR_OR:            /* fall through */
+        case INSTR_XOR:           return exec_bitwise;
+        default:                  return KOS_NULL;
+    }
+}
+#endif
+
+#if KOS_DISPATCH_TABLE
+#   define BEGIN_INSTRUCTION(instr)     OP_##instr
+#   define BEGIN_BREAKPOINT_INSTRUCTION OP_BREAKPOINT
+#   define NEXT_INSTRUCTION                                   \
+        do {                                                  \
+            KOS_INSTR_FUZZ_LIMIT();                           \
+            ENTER_JIT();                                      \
+            KOS_PERF_CNT(instructions);                       \
+            goto *KOS_atomic_read_relaxed_ptr(ip->handler);   \
+        } while (0)
+
+/* Dispatch table is indexed directly with the opcode byte, invalid opcodes
+ * go to the breakpoint handler, which raises a panic.  The table is used when
+ * instructions are decoded, which store the handler address in each instruction,
+ * so the interpreter jumps directly to the next handler (direct threading). */
+#   define INVALID_OPCODES_16                                 \
+        &&OP_BREAKPOINT, &&OP_BREAKPOINT, &&OP_BREAKPOINT, &&OP_BREAKPOINT, \
+        &&OP_BREAKPOINT, &&OP_BREAKPOINT, &&OP_BREAKPOINT, &&OP_BREAKPOINT, \
+        &&OP_BREAKPOINT, &&OP_BREAKPOINT, &&OP_BREAKPOINT, &&OP_BREAKPOINT, \
+        &&OP_BREAKPOINT, &&OP_BREAKPOINT, &&OP_BREAKPOINT, &&OP_BREAKPOINT,
+#   define INVALID_OPCODES_128                                \
+        INVALID_OPCODES_16 INVALID_OPCODES_16 INVALID_OPCODES_16 INVALID_OPCODES_16 \
+        INVALID_OPCODES_16 INVALID_OPCODES_16 INVALID_OPCODES_16 INVALID_OPCODES_16
+
+#   ifdef KOS_CPP11
+static_assert(INSTR_BREAKPOINT == 128, "Opcodes must start at 128 for the dispatch table");
+static_assert(INSTR_LAST_OPCODE <= 256, "Opcodes must fit in a byte");
+#   endif
+
+#else
+#   define BEGIN_INSTRUCTION(instr)     case INSTR_##instr
+#   define BEGIN_BREAKPOINT_INSTRUCTION default
+#   define NEXT_INSTRUCTION             KOS_INSTR_FUZZ_LIMIT(); break
+#endif
+
+#if defined(__cplusplus) && defined(TRACY_ENABLE)
+/* This works correctly only for KOS_STRING_ELEM_8 and ASCII function names */
+#   define PROF_ZONE_NAME_FUN(func_obj_expr)                             \
+    {                                                                    \
+        const KOS_OBJ_ID func_obj = (func_obj_expr);                     \
+        const KOS_OBJ_ID name = OBJPTR(FUNCTION, func_obj)->name;        \
+        assert(GET_OBJ_TYPE(name) == OBJ_STRING);                        \
+        PROF_ZONE_NAME(                                                  \
+                (OBJPTR(STRING, name)->header.flags & KOS_STRING_LOCAL)  \
+                    ? (const char *)&OBJPTR(STRING, name)->local.data[0] \
+                    : (const char *)OBJPTR(STRING, name)->ptr.data_ptr,  \
+                OBJPTR(STRING, name)->header.length);                    \
+    }
+#else
+#   define PROF_ZONE_NAME_FUN(func_obj_expr)
+#endif
+
+static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
+{
+    PROF_ZONE(VM)
+
+    const KOS_INSTR   *ip;
+    KOS_BYTECODE_INSTR instr;
+    KOS_OBJ_ID         out      = KOS_BADPTR;
+    KOS_OBJ_ID         module;
+    KOS_OBJ_ID         stack;
+    KOS_STACK_FRAME   *stack_frame;
+    int                error    = KOS_SUCCESS;
+    int                depth    = 0; /* Number of calls inside execute() without affecting native stack */
+    unsigned           rdest;
+#ifdef KOS_JIT
+    const KOS_INSTR   *jit_entry;   /* Instruction at which native code will be entered */
+#endif
+#ifndef NDEBUG
+    uint32_t           regs_idx;
+    uint32_t           num_regs;
+#endif
+
+#if KOS_DISPATCH_TABLE
+    static void *const dispatch_table[] = {
+        INVALID_OPCODES_128
+#   define DEFINE_INSTRUCTION(name, value) &&OP_##name,
+#   include "../inc/kos_opcodes.h"
+#   undef DEFINE_INSTRUCTION
+        INVALID_OPCODES_128
+    };
+
+    /* Handler addresses are only available in this function, they are
+     * published when called without context, before any code is decoded */
+    if ( ! ctx) {
+        vm_handlers = dispatch_table;
+        return KOS_BADPTR;
+    }
+#endif
+
+    stack = ctx->stack;
+#ifndef NDEBUG
+    regs_idx = ctx->regs_idx;
+    num_regs = get_num_regs(ctx);
+#endif
+
+    stack_frame = get_current_stack_frame(ctx);
+
+    PROF_ZONE_NAME_FUN(get_current_func(stack_frame));
+
+    module = get_module(stack_frame);
+    assert( ! IS_BAD_PTR(module));
+    assert(OBJPTR(MODULE, module)->inst);
+
+    ip = get_bytecode(stack_frame);
+
+    UPDATE_JIT_ENTRY();
+
+    assert( ! kos_is_heap_object(module));
+    assert( ! kos_is_heap_object(stack));
+
+#if KOS_DISPATCH_TABLE
+    NEXT_INSTRUCTION;
+#else
+    for (;;) {
+        assert( ! KOS_is_exception_pending(ctx));
+        assert(get_instr_idx(stack_frame, ip) < get_num_decoded(stack_frame));
+
+        ENTER_JIT();
+
+        KOS_PERF_CNT(instructions);
+
+        instr = get_opcode(ip);
+
+        switch (instr) {
+#endif
+
+            BEGIN_INSTRUCTION(LOAD_CONST): { /* <r.dest>, <uimm> */
+                PROF_ZONE_N(INSTR, "LOAD.CONST")
+                rdest = ip->op[0];
+
+                out = get_const_operand(ctx, module, ip, (uint32_t)ip->op[1]);
+                TRY_OBJID(out);
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(LOAD_FUN): { /* <r.dest>, <uimm> */
+                PROF_ZONE_N(INSTR, "LOAD.FUN")
+                rdest = ip->op[0];
+
+                out = get_const_operand(ctx, module, ip, (uint32_t)ip->op[1]);
+                TRY_OBJID(out);
+
+                out = kos_copy_function(ctx, out);
+                TRY_OBJID(out);
+
+                if (GET_OBJ_TYPE(out) == OBJ_CLASS) {
+                    const KOS_OBJ_ID proto_obj = KOS_array_read(ctx,
+                                                                OBJPTR(MODULE, module)->constants,
+                                                                ip->op[1] + 1);
+                    TRY_OBJID(proto_obj);
+
+                    KOS_atomic_write_relaxed_ptr(OBJPTR(CLASS, out)->prototype, proto_obj);
+                }
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(LOAD_INT8): { /* <r.dest>, <int8> */
+                PROF_ZONE_N(INSTR, "LOAD.INT8")
+                const int8_t value = ip->op[1];
+
+                rdest = ip->op[0];
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, TO_SMALL_INT(value));
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(LOAD_TRUE): { /* <r.dest> */
+                PROF_ZONE_N(INSTR, "LOAD.TRUE")
+                rdest = ip->op[0];
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, KOS_TRUE);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(LOAD_FALSE): { /* <r.dest> */
+                PROF_ZONE_N(INSTR, "LOAD.FALSE")
+                rdest = ip->op[0];
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, KOS_FALSE);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(LOAD_VOID): { /* <r.dest> */
+                PROF_ZONE_N(INSTR, "LOAD.VOID")
+                rdest = ip->op[0];
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, KOS_VOID);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(NEW_ARRAY8): { /* <r.dest>, <uint8.size> */
+                PROF_ZONE_N(INSTR, "NEW.ARRAY8")
+                const uint8_t size = ip->op[1];
+
+                rdest = ip->op[0];
+
+                out = KOS_new_array(ctx, size);
+                TRY_OBJID(out);
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(NEW_OBJ): { /* <r.dest>, <r.src> */
+                PROF_ZONE_N(INSTR, "NEW.OBJ")
+                const unsigned rsrc = ip->op[1];
+
+                if (rsrc == KOS_NO_REG)
+                    out = KOS_new_object(ctx);
                 else {
                     assert(rsrc < num_regs);
 
@@ -1629,53 +2715,87 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 }
                 TRY_OBJID(out);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(NEW_OBJ_TEMPLATE): { /* <r.dest>, <uimm> */
+                PROF_ZONE_N(INSTR, "NEW.OBJ.TEMPLATE")
+                out = get_const_operand(ctx, module, ip, (uint32_t)ip->op[1]);
+                TRY_OBJID(out);
+
+                out = kos_object_clone(ctx, out);
+                TRY_OBJID(out);
+
+                rdest = ip->op[0];
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(NEW_ARRAY_TEMPLATE): { /* <r.dest>, <uimm> */
+                PROF_ZONE_N(INSTR, "NEW.ARRAY.TEMPLATE")
+                out = get_const_operand(ctx, module, ip, (uint32_t)ip->op[1]);
+                TRY_OBJID(out);
+
+                out = kos_array_clone(ctx, out);
+                TRY_OBJID(out);
+
+                rdest = ip->op[0];
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(NEW_ITER): { /* <r.dest>, <r.src> */
                 PROF_ZONE_N(INSTR, "NEW.ITER")
-                const unsigned rsrc = bytecode[2];
+                const unsigned rsrc = ip->op[1];
 
                 assert(rsrc < num_regs);
 
                 out = KOS_new_iterator(ctx, read_reg(stack_frame, rsrc), KOS_CONTENTS);
                 TRY_OBJID(out);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 assert(rdest < num_regs);
                 KOS_atomic_write_relaxed_ptr(stack_frame->regs[rdest], out);
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(MOVE): { /* <r.dest>, <r.src> */
                 PROF_ZONE_N(INSTR, "MOVE")
-                const unsigned rsrc = bytecode[2];
+                const unsigned rsrc = ip->op[1];
 
                 assert(rsrc < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 out = read_reg(stack_frame, rsrc);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(GET_PROTO): { /* <r.dest>, <r.src> */
                 PROF_ZONE_N(INSTR, "GET.PROTO")
-                const unsigned rsrc = bytecode[2];
+                const unsigned rsrc = ip->op[1];
                 KOS_OBJ_ID     constr_obj;
 
                 assert(rsrc < num_regs);
@@ -1694,44 +2814,41 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 else
                     RAISE_EXCEPTION_STR(str_err_not_class);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(GET_GLOBAL): { /* <r.dest>, <uimm.glob.idx> */
                 PROF_ZONE_N(INSTR, "GET.GLOBAL")
-                const KOS_IMM imm = kos_load_uimm(bytecode + 2);
-
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
-                out = KOS_array_read(ctx, OBJPTR(MODULE, module)->globals, imm.value.sv);
+                out = KOS_array_read(ctx, OBJPTR(MODULE, module)->globals, ip->op[1]);
                 TRY_OBJID(out);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 2 + imm.size;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(SET_GLOBAL): { /* <uimm.glob.idx>, <r.src> */
                 PROF_ZONE_N(INSTR, "SET.GLOBAL")
-                const KOS_IMM  imm  = kos_load_uimm(bytecode + 1);
-                const unsigned rsrc = bytecode[1 + imm.size];
+                const unsigned rsrc = ip->op[1];
 
                 assert(rsrc < num_regs);
 
                 TRY(KOS_array_write(ctx,
                                     OBJPTR(MODULE, module)->globals,
-                                    imm.value.sv,
+                                    ip->op[0],
                                     read_reg(stack_frame, rsrc)));
 
-                bytecode += 2 + imm.size;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
@@ -1739,17 +2856,16 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 /* fall through */
             BEGIN_INSTRUCTION(GET_MOD_GLOBAL_OPT): { /* <r.dest>, <uimm.mod.idx>, <r.glob> */
                 PROF_ZONE_N(INSTR, "GET.MOD.GLOBAL")
-                const KOS_IMM  mod_idx    = kos_load_uimm(bytecode + 2);
-                const unsigned rglob      = bytecode[2 + mod_idx.size];
+                const unsigned rglob      = ip->op[2];
                 KOS_OBJ_ID     glob_idx;
                 KOS_OBJ_ID     module_obj = KOS_array_read(ctx,
                                                            OBJPTR(MODULE, module)->inst->modules.modules,
-                                                           mod_idx.value.uv);
+                                                           ip->op[1]);
                 TRY_OBJID(module_obj);
 
                 assert(rglob < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 assert( ! IS_SMALL_INT(module_obj));
                 assert(GET_OBJ_TYPE(module_obj) == OBJ_MODULE);
@@ -1760,7 +2876,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
                 if (IS_BAD_PTR(glob_idx)) {
 
-                    if (instr == INSTR_GET_MOD_GLOBAL ||
+                    if (get_opcode(ip) == INSTR_GET_MOD_GLOBAL ||
                         GET_OBJ_TYPE(read_reg(stack_frame, rglob)) != OBJ_STRING)
 
                         goto cleanup;
@@ -1779,43 +2895,40 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 3 + mod_idx.size;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(GET_MOD_ELEM): { /* <r.dest>, <uimm.mod.idx>, <uimm.glob.idx> */
                 PROF_ZONE_N(INSTR, "GET.MOD.ELEM")
-                const KOS_IMM mod_idx    = kos_load_uimm(bytecode + 2);
-                const KOS_IMM glob_idx   = kos_load_uimm(bytecode + 2 + mod_idx.size);
-                KOS_OBJ_ID    module_obj = KOS_array_read(ctx,
-                                                          OBJPTR(MODULE, module)->inst->modules.modules,
-                                                          mod_idx.value.uv);
+                KOS_OBJ_ID module_obj = KOS_array_read(ctx,
+                                                       OBJPTR(MODULE, module)->inst->modules.modules,
+                                                       ip->op[1]);
                 TRY_OBJID(module_obj);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 assert( ! IS_SMALL_INT(module_obj));
                 assert(GET_OBJ_TYPE(module_obj) == OBJ_MODULE);
 
-                out = KOS_array_read(ctx, OBJPTR(MODULE, module_obj)->globals, glob_idx.value.uv);
+                out = KOS_array_read(ctx, OBJPTR(MODULE, module_obj)->globals, ip->op[2]);
                 TRY_OBJID(out);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 2 + mod_idx.size + glob_idx.size;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(GET_MOD): { /* <r.dest>, <uimm.mod.idx> */
                 PROF_ZONE_N(INSTR, "GET.MOD")
-                const KOS_IMM mod_idx    = kos_load_uimm(bytecode + 2);
-                KOS_OBJ_ID    module_obj = KOS_array_read(ctx,
-                                                          OBJPTR(MODULE, module)->inst->modules.modules,
-                                                          mod_idx.value.uv);
+                KOS_OBJ_ID module_obj = KOS_array_read(ctx,
+                                                       OBJPTR(MODULE, module)->inst->modules.modules,
+                                                       ip->op[1]);
                 TRY_OBJID(module_obj);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 assert( ! IS_SMALL_INT(module_obj));
                 assert(GET_OBJ_TYPE(module_obj) == OBJ_MODULE);
@@ -1825,7 +2938,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 2 + mod_idx.size;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
@@ -1833,68 +2946,10 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 /* fall through */
             BEGIN_INSTRUCTION(GET_OPT): { /* <r.dest>, <r.src>, <r.prop> */
                 PROF_ZONE_N(INSTR, "GET")
-                const unsigned rsrc  = bytecode[2];
-                const unsigned rprop = bytecode[3];
-                KOS_OBJ_ID     src;
-                KOS_OBJ_ID     prop;
-
-                assert(rsrc  < num_regs);
-                assert(rprop < num_regs);
-
-                rdest = bytecode[1];
-                src   = read_reg(stack_frame, rsrc);
-                prop  = read_reg(stack_frame, rprop);
-
-                if (IS_NUMERIC_OBJ(prop)) {
-                    KOS_TYPE type;
-                    int64_t  idx;
-
-                    TRY(KOS_get_integer(ctx, prop, &idx));
-
-                    if (idx > INT_MAX || idx < INT_MIN)
-                        RAISE_EXCEPTION_STR(str_err_invalid_index);
-
-                    type = GET_OBJ_TYPE(src);
-                    if (type == OBJ_STRING)
-                        out = KOS_string_get_char(ctx, src, (int)idx);
-                    else if (type == OBJ_BUFFER)
-                        out = read_buffer(ctx, src, (int)idx);
-                    else
-                        out = KOS_array_read(ctx, src, (int)idx);
-
-                    if (IS_BAD_PTR(out) && instr == INSTR_GET_OPT) {
-                        KOS_clear_exception(ctx);
-                        out = KOS_VOID;
-                    }
-                }
-                else {
-                    out = KOS_get_property(ctx, src, prop);
 
-                    if (IS_BAD_PTR(out)) {
-                        if (instr == INSTR_GET_OPT &&
-                            GET_OBJ_TYPE(read_reg(stack_frame, rprop)) == OBJ_STRING) {
+                TRY(exec_get(ctx, stack_frame, ip));
 
-                            KOS_clear_exception(ctx);
-                            out = KOS_VOID;
-                        }
-                    }
-
-                    if ( ! IS_BAD_PTR(out) && GET_OBJ_TYPE(out) == OBJ_DYNAMIC_PROP) {
-                        store_instr_offs(stack_frame, bytecode);
-
-                        out = OBJPTR(DYNAMIC_PROP, out)->getter;
-                        out = KOS_call_function(ctx, out, src, KOS_EMPTY_ARRAY);
-
-                        assert(ctx->regs_idx == regs_idx);
-                    }
-                }
-
-                TRY_OBJID(out);
-
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, out);
-
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
@@ -1902,50 +2957,18 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 /* fall through */
             BEGIN_INSTRUCTION(GET_ELEM8_OPT): { /* <r.dest>, <r.src>, <int8> */
                 PROF_ZONE_N(INSTR, "GET.ELEM8")
-                const unsigned rsrc = bytecode[2];
-                const int32_t  idx  = (int8_t)bytecode[3];
-                KOS_OBJ_ID     src;
-                KOS_TYPE       type;
 
-                assert(rsrc < num_regs);
-
-                rdest = bytecode[1];
-                src   = read_reg(stack_frame, rsrc);
-
-                type = GET_OBJ_TYPE(src);
-
-                if (type == OBJ_ARRAY)
-                    out = KOS_array_read(ctx, src, idx);
-                else if (type == OBJ_STRING)
-                    out = KOS_string_get_char(ctx, src, idx);
-                else if (type == OBJ_BUFFER)
-                    out = read_buffer(ctx, src, idx);
-                else if (type == OBJ_STACK)
-                    out = read_stack(ctx, src, idx);
-                else
-                    RAISE_EXCEPTION_STR(str_err_not_indexable);
-
-                if (IS_BAD_PTR(out)) {
-                    if (instr == INSTR_GET_ELEM8_OPT) {
-                        KOS_clear_exception(ctx);
-                        out = KOS_VOID;
-                    }
-                    else
-                        goto cleanup;
-                }
-
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, out);
+                TRY(exec_get_elem8(ctx, stack_frame, ip));
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(GET_RANGE): { /* <r.dest>, <r.src>, <r.begin>, <r.end> */
                 PROF_ZONE_N(INSTR, "GET.RANGE")
-                const unsigned rsrc   = bytecode[2];
-                const unsigned rbegin = bytecode[3];
-                const unsigned rend   = bytecode[4];
+                const unsigned rsrc   = ip->op[1];
+                const unsigned rbegin = ip->op[2];
+                const unsigned rend   = ip->op[3];
                 KOS_OBJ_ID     src;
                 KOS_OBJ_ID     begin;
                 KOS_OBJ_ID     end;
@@ -1958,7 +2981,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rbegin < num_regs);
                 assert(rend   < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
                 src   = read_reg(stack_frame, rsrc);
                 begin = read_reg(stack_frame, rbegin);
                 end   = read_reg(stack_frame, rend);
@@ -1999,294 +3022,121 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                     src = KOS_destroy_top_local(ctx, &saved_src);
                     out = KOS_destroy_top_local(ctx, &saved_out);
 
-                    TRY_OBJID(args);
-
-                    buf = kos_get_array_buffer(OBJPTR(ARRAY, args));
-
-                    buf[0] = read_reg(stack_frame, rbegin);
-                    buf[1] = read_reg(stack_frame, rend);
-
-                    out = KOS_call_function(ctx, out, src, args);
-
-                    assert(ctx->regs_idx == regs_idx);
-                }
-
-                TRY_OBJID(out);
-
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, out);
-
-                bytecode += 5;
-                NEXT_INSTRUCTION;
-            }
-
-            BEGIN_INSTRUCTION(GET_PROP8):       /* <r.dest>, <r.src>, <uint8.str.idx> */
-                /* fall through */
-            BEGIN_INSTRUCTION(GET_PROP8_OPT): { /* <r.dest>, <r.src>, <uint8.str.idx> */
-                PROF_ZONE_N(INSTR, "GET.PROP8")
-                const unsigned rsrc = bytecode[2];
-                const uint8_t  idx  = bytecode[3];
-                KOS_OBJ_ID     prop;
-                KOS_OBJ_ID     obj;
-
-                assert(rsrc < num_regs);
-
-                rdest = bytecode[1];
-
-                prop = KOS_array_read(ctx, OBJPTR(MODULE, module)->constants, idx);
-                TRY_OBJID(prop);
-
-                obj = read_reg(stack_frame, rsrc);
-                out = KOS_get_property(ctx, obj, prop);
-
-                if (IS_BAD_PTR(out)) {
-                    if (instr == INSTR_GET_PROP8_OPT) {
-                        KOS_clear_exception(ctx);
-                        out = KOS_VOID;
-                    }
-                    else
-                        goto cleanup;
-                }
-
-                if (GET_OBJ_TYPE(out) == OBJ_DYNAMIC_PROP) {
-                    store_instr_offs(stack_frame, bytecode);
-
-                    out = OBJPTR(DYNAMIC_PROP, out)->getter;
-                    out = KOS_call_function(ctx, out, obj, KOS_EMPTY_ARRAY);
-                    TRY_OBJID(out);
-
-                    assert(ctx->regs_idx == regs_idx);
-                }
-
-                assert(rdest < num_regs);
-                write_reg(stack_frame, rdest, out);
-
-                bytecode += 4;
-                NEXT_INSTRUCTION;
-            }
-
-            BEGIN_INSTRUCTION(SET): { /* <r.dest>, <r.prop>, <r.src> */
-                PROF_ZONE_N(INSTR, "SET")
-                const unsigned rprop = bytecode[2];
-                const unsigned rsrc  = bytecode[3];
-                KOS_OBJ_ID     prop;
-
-                rdest = bytecode[1];
-
-                assert(rdest < num_regs);
-                assert(rprop < num_regs);
-                assert(rsrc  < num_regs);
-
-                prop = read_reg(stack_frame, rprop);
-
-                if (IS_NUMERIC_OBJ(prop)) {
-                    KOS_OBJ_ID obj;
-                    int64_t    idx;
-
-                    TRY(KOS_get_integer(ctx, prop, &idx));
-
-                    if (idx > INT_MAX || idx < INT_MIN)
-                        RAISE_EXCEPTION_STR(str_err_invalid_index);
-
-                    obj = read_reg(stack_frame, rdest);
-                    if (GET_OBJ_TYPE(obj) == OBJ_BUFFER)
-                        TRY(write_buffer(ctx, obj, (int)idx, read_reg(stack_frame, rsrc)));
-                    else
-                        TRY(KOS_array_write(ctx, obj, (int)idx, read_reg(stack_frame, rsrc)));
-                }
-                else {
-                    error = KOS_set_property(ctx, read_reg(stack_frame, rdest), prop, read_reg(stack_frame, rsrc));
-
-                    if (error == KOS_ERROR_SETTER) {
-                        KOS_OBJ_ID              args;
-                        KOS_OBJ_ID              retval;
-                        KOS_LOCAL               setter;
-                        KOS_ATOMIC(KOS_OBJ_ID) *buf;
+                    TRY_OBJID(args);
+
+                    buf = kos_get_array_buffer(OBJPTR(ARRAY, args));
 
-                        assert(KOS_is_exception_pending(ctx));
-                        setter.o = KOS_get_exception(ctx);
-                        KOS_clear_exception(ctx);
+                    buf[0] = read_reg(stack_frame, rbegin);
+                    buf[1] = read_reg(stack_frame, rend);
 
-                        assert( ! IS_BAD_PTR(setter.o) && GET_OBJ_TYPE(setter.o) == OBJ_DYNAMIC_PROP);
-                        store_instr_offs(stack_frame, bytecode);
+                    out = KOS_call_function(ctx, out, src, args);
 
-                        setter.o = OBJPTR(DYNAMIC_PROP, setter.o)->setter;
-                        if (IS_BAD_PTR(setter.o))
-                            /* TODO print property name */
-                            RAISE_EXCEPTION_STR(str_err_no_setter);
+                    assert(ctx->regs_idx == regs_idx);
+                }
 
-                        KOS_init_local_with(ctx, &setter, setter.o);
+                TRY_OBJID(out);
 
-                        args = KOS_new_array(ctx, 1);
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
 
-                        setter.o = KOS_destroy_top_local(ctx, &setter);
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
 
-                        TRY_OBJID(args);
+            BEGIN_INSTRUCTION(GET_PROP8):       /* <r.dest>, <r.src>, <uint8.str.idx> */
+                /* fall through */
+            BEGIN_INSTRUCTION(GET_PROP8_OPT): { /* <r.dest>, <r.src>, <uint8.str.idx> */
+                PROF_ZONE_N(INSTR, "GET.PROP8")
 
-                        buf = kos_get_array_buffer(OBJPTR(ARRAY, args));
+                TRY(exec_get_prop8(ctx, stack_frame, ip, module));
 
-                        buf[0] = read_reg(stack_frame, rsrc);
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
 
-                        retval = KOS_call_function(ctx, setter.o, read_reg(stack_frame, rdest), args);
-                        TRY_OBJID(retval);
+            BEGIN_INSTRUCTION(SET): { /* <r.dest>, <r.prop>, <r.src> */
+                PROF_ZONE_N(INSTR, "SET")
 
-                        assert(ctx->regs_idx == regs_idx);
-                    }
-                    else if (error)
-                        goto cleanup;
-                }
+                TRY(exec_set(ctx, stack_frame, ip));
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(SET_ELEM8): { /* <r.dest>, <int8>, <r.src> */
                 PROF_ZONE_N(INSTR, "SET.ELEM8")
-                const int32_t  idx  = (int8_t)bytecode[2];
-                const unsigned rsrc = bytecode[3];
-                KOS_OBJ_ID     dest;
-                KOS_TYPE       type;
-
-                rdest = bytecode[1];
-
-                assert(rdest < num_regs);
-                assert(rsrc  < num_regs);
-
-                dest = read_reg(stack_frame, rdest);
 
-                type = GET_OBJ_TYPE(dest);
-
-                if (type == OBJ_ARRAY)
-                    TRY(KOS_array_write(ctx, dest, idx, read_reg(stack_frame, rsrc)));
-                else if (type == OBJ_BUFFER)
-                    TRY(write_buffer(ctx, dest, idx, read_reg(stack_frame, rsrc)));
-                else if (type == OBJ_STACK)
-                    TRY(write_stack(ctx, dest, idx, read_reg(stack_frame, rsrc)));
-                else
-                    RAISE_EXCEPTION_STR(str_err_not_indexable);
+                TRY(exec_set_elem8(ctx, stack_frame, ip));
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(SET_PROP8): { /* <r.dest>, <uint8.str.idx>, <r.src> */
                 PROF_ZONE_N(INSTR, "SET.PROP8")
-                const uint8_t  idx  = bytecode[2];
-                const unsigned rsrc = bytecode[3];
-                KOS_OBJ_ID     prop;
-                KOS_OBJ_ID     obj;
-                KOS_OBJ_ID     value;
-
-                rdest = bytecode[1];
-
-                assert(rdest < num_regs);
-                assert(rsrc  < num_regs);
-
-                prop = KOS_array_read(ctx, OBJPTR(MODULE, module)->constants, idx);
-                TRY_OBJID(prop);
-
-                obj   = read_reg(stack_frame, rdest);
-                value = read_reg(stack_frame, rsrc);
-
-                error = KOS_set_property(ctx, obj, prop, value);
-
-                if (error == KOS_ERROR_SETTER) {
-                    KOS_LOCAL               setter;
-                    KOS_OBJ_ID              args;
-                    KOS_ATOMIC(KOS_OBJ_ID) *buf;
-
-                    assert(KOS_is_exception_pending(ctx));
-                    setter.o = KOS_get_exception(ctx);
-                    KOS_clear_exception(ctx);
-
-                    assert( ! IS_BAD_PTR(setter.o) && GET_OBJ_TYPE(setter.o) == OBJ_DYNAMIC_PROP);
-                    store_instr_offs(stack_frame, bytecode);
-
-                    setter.o = OBJPTR(DYNAMIC_PROP, setter.o)->setter;
-                    if (IS_BAD_PTR(setter.o))
-                        /* TODO print property name */
-                        RAISE_EXCEPTION_STR(str_err_no_setter);
-
-                    KOS_init_local_with(ctx, &setter, setter.o);
-
-                    args = KOS_new_array(ctx, 1);
-
-                    setter.o = KOS_destroy_top_local(ctx, &setter);
-
-                    TRY_OBJID(args);
-
-                    buf = kos_get_array_buffer(OBJPTR(ARRAY, args));
-
-                    buf[0] = read_reg(stack_frame, rsrc);
 
-                    value = KOS_call_function(ctx, setter.o, read_reg(stack_frame, rdest), args);
-                    TRY_OBJID(value);
-
-                    assert(ctx->regs_idx == regs_idx);
-                }
-                else if (error)
-                    goto cleanup;
+                TRY(exec_set_prop8(ctx, stack_frame, ip, module));
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(PUSH): { /* <r.dest>, <r.src> */
                 PROF_ZONE_N(INSTR, "PUSH")
-                const unsigned rsrc = bytecode[2];
+                const unsigned rsrc = ip->op[1];
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 assert(rdest < num_regs);
                 assert(rsrc  < num_regs);
 
                 TRY(KOS_array_push(ctx, read_reg(stack_frame, rdest), read_reg(stack_frame, rsrc), KOS_NULL));
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(PUSH_EX): { /* <r.dest>, <r.src> */
                 PROF_ZONE_N(INSTR, "PUSH.EX")
-                const unsigned rsrc = bytecode[2];
+                const unsigned rsrc = ip->op[1];
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 assert(rdest < num_regs);
                 assert(rsrc  < num_regs);
 
                 TRY(KOS_array_push_expand(ctx, read_reg(stack_frame, rdest), read_reg(stack_frame, rsrc)));
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(DEL): { /* <r.dest>, <r.prop> */
                 PROF_ZONE_N(INSTR, "DEL")
-                const unsigned rprop = bytecode[2];
+                const unsigned rprop = ip->op[1];
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 assert(rdest < num_regs);
                 assert(rprop < num_regs);
 
                 TRY(KOS_delete_property(ctx, read_reg(stack_frame, rdest), read_reg(stack_frame, rprop)));
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(ADD): { /* <r.dest>, <r.src1>, <r.src2> */
                 PROF_ZONE_N(INSTR, "ADD")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
 
                 KOS_LOCAL src[2];
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest    = bytecode[1];
+                rdest    = ip->op[0];
                 src[0].o = read_reg(stack_frame, rsrc1);
                 src[1].o = read_reg(stack_frame, rsrc2);
 
@@ -2294,6 +3144,8 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
                     case OBJ_SMALL_INTEGER: {
                         const int64_t a = GET_SMALL_INT(src[0].o);
+                        if (IS_SMALL_INT(src[1].o))
+                            quicken_instr(ctx, stack_frame, ip, INSTR_ADD_SMALLINT);
                         out             = add_integer(ctx, a, src[1].o);
                         break;
                     }
@@ -2303,7 +3155,9 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                         break;
 
                     case OBJ_FLOAT:
-                        out = add_float(ctx, OBJPTR(FLOAT, src[0].o)->value, src[1].o);
+                        if (GET_OBJ_TYPE(src[1].o) == OBJ_FLOAT)
+                            quicken_instr(ctx, stack_frame, ip, INSTR_ADD_FLOAT);
+                        out = add_float(ctx, KOS_get_float(src[0].o), src[1].o);
                         break;
 
                     default:
@@ -2316,14 +3170,14 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(SUB): { /* <r.dest>, <r.src1>, <r.src2> */
                 PROF_ZONE_N(INSTR, "SUB")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
 
                 KOS_OBJ_ID src1;
                 KOS_OBJ_ID src2;
@@ -2331,13 +3185,15 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
                 src1  = read_reg(stack_frame, rsrc1);
                 src2  = read_reg(stack_frame, rsrc2);
 
                 switch (GET_OBJ_TYPE(src1)) {
 
                     case OBJ_SMALL_INTEGER:
+                        if (IS_SMALL_INT(src2))
+                            quicken_instr(ctx, stack_frame, ip, INSTR_SUB_SMALLINT);
                         out = sub_integer(ctx, GET_SMALL_INT(src1), src2);
                         break;
 
@@ -2346,7 +3202,9 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                         break;
 
                     case OBJ_FLOAT:
-                        out = sub_float(ctx, OBJPTR(FLOAT, src1)->value, src2);
+                        if (GET_OBJ_TYPE(src2) == OBJ_FLOAT)
+                            quicken_instr(ctx, stack_frame, ip, INSTR_SUB_FLOAT);
+                        out = sub_float(ctx, KOS_get_float(src1), src2);
                         break;
 
                     default:
@@ -2359,14 +3217,14 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(MUL): { /* <r.dest>, <r.src1>, <r.src2> */
                 PROF_ZONE_N(INSTR, "MUL")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
 
                 KOS_OBJ_ID src1;
                 KOS_OBJ_ID src2;
@@ -2374,7 +3232,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
                 src1  = read_reg(stack_frame, rsrc1);
                 src2  = read_reg(stack_frame, rsrc2);
 
@@ -2389,7 +3247,9 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                         break;
 
                     case OBJ_FLOAT:
-                        out = mul_float(ctx, OBJPTR(FLOAT, src1)->value, src2);
+                        if (GET_OBJ_TYPE(src2) == OBJ_FLOAT)
+                            quicken_instr(ctx, stack_frame, ip, INSTR_MUL_FLOAT);
+                        out = mul_float(ctx, KOS_get_float(src1), src2);
                         break;
 
                     default:
@@ -2402,14 +3262,14 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(DIV): { /* <r.dest>, <r.src1>, <r.src2> */
                 PROF_ZONE_N(INSTR, "DIV")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
 
                 KOS_OBJ_ID src1;
                 KOS_OBJ_ID src2;
@@ -2417,7 +3277,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
                 src1  = read_reg(stack_frame, rsrc1);
                 src2  = read_reg(stack_frame, rsrc2);
 
@@ -2432,410 +3292,636 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                         break;
 
                     case OBJ_FLOAT:
-                        out = div_float(ctx, OBJPTR(FLOAT, src1)->value, src2);
+                        out = div_float(ctx, KOS_get_float(src1), src2);
                         break;
 
-                    default:
-                        RAISE_EXCEPTION_STR(str_err_unsup_operand_types);
-                        break;
-                }
+                    default:
+                        RAISE_EXCEPTION_STR(str_err_unsup_operand_types);
+                        break;
+                }
+
+                TRY_OBJID(out);
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(MOD): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "MOD")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+
+                KOS_OBJ_ID src1;
+                KOS_OBJ_ID src2;
+
+                assert(rsrc1 < num_regs);
+                assert(rsrc2 < num_regs);
+
+                rdest = ip->op[0];
+                src1  = read_reg(stack_frame, rsrc1);
+                src2  = read_reg(stack_frame, rsrc2);
+
+                switch (GET_OBJ_TYPE(src1)) {
+
+                    case OBJ_SMALL_INTEGER:
+                        out = mod_integer(ctx, GET_SMALL_INT(src1), src2);
+                        break;
+
+                    case OBJ_INTEGER:
+                        out = mod_integer(ctx, OBJPTR(INTEGER, src1)->value, src2);
+                        break;
+
+                    case OBJ_FLOAT:
+                        out = mod_float(ctx, KOS_get_float(src1), src2);
+                        break;
+
+                    default:
+                        RAISE_EXCEPTION_STR(str_err_unsup_operand_types);
+                        break;
+                }
+
+                TRY_OBJID(out);
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(SHL): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "SHL")
+
+                TRY(exec_bitwise(ctx, stack_frame, ip));
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(SHR): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "SHR")
+
+                TRY(exec_bitwise(ctx, stack_frame, ip));
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(SHRU): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "SHRU")
+
+                TRY(exec_bitwise(ctx, stack_frame, ip));
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(NOT): { /* <r.dest>, <r.src> */
+                PROF_ZONE_N(INSTR, "NOT")
+                const unsigned rsrc = ip->op[1];
+                int64_t        a;
+
+                assert(rsrc  < num_regs);
+
+                rdest = ip->op[0];
+
+                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc), &a));
+
+                out = KOS_new_int(ctx, ~a);
+                TRY_OBJID(out);
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(AND): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "AND")
+
+                TRY(exec_bitwise(ctx, stack_frame, ip));
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(OR): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "OR")
+
+                TRY(exec_bitwise(ctx, stack_frame, ip));
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(XOR): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "XOR")
+
+                TRY(exec_bitwise(ctx, stack_frame, ip));
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(TYPE): { /* <r.dest>, <r.src> */
+                PROF_ZONE_N(INSTR, "TYPE")
+                const unsigned rsrc = ip->op[1];
+                KOS_OBJ_ID     src;
+                unsigned       type_idx;
+
+                KOS_DECLARE_STATIC_CONST_STRING(str_integer, "integer");
+                KOS_DECLARE_STATIC_CONST_STRING(str_float,   "float");
+                KOS_DECLARE_STATIC_CONST_STRING(str_boolean, "boolean");
+                KOS_DECLARE_STATIC_CONST_STRING(str_string,  "string");
+                KOS_DECLARE_STATIC_CONST_STRING(str_object,  "object");
+                KOS_DECLARE_STATIC_CONST_STRING(str_array,   "array");
+                KOS_DECLARE_STATIC_CONST_STRING(str_buffer,  "buffer");
+                KOS_DECLARE_STATIC_CONST_STRING(str_class,   "class");
+                KOS_DECLARE_STATIC_CONST_STRING(str_module,  "module");
+
+                static const KOS_OBJ_ID obj_type_map[12] = {
+                    KOS_CONST_ID(str_integer),
+                    KOS_CONST_ID(str_integer),
+                    KOS_CONST_ID(str_float),
+                    KOS_STR_VOID,
+                    KOS_CONST_ID(str_boolean),
+                    KOS_CONST_ID(str_string),
+                    KOS_CONST_ID(str_object),
+                    KOS_CONST_ID(str_array),
+                    KOS_CONST_ID(str_buffer),
+                    KOS_STR_FUNCTION,
+                    KOS_CONST_ID(str_class),
+                    KOS_CONST_ID(str_module)
+                };
+
+                assert(rsrc < num_regs);
+
+                rdest = ip->op[0];
+                src   = read_reg(stack_frame, rsrc);
+
+                assert(!IS_BAD_PTR(src));
+
+                type_idx = GET_OBJ_TYPE(src);
+                type_idx = (type_idx < 2 * (sizeof(obj_type_map) / sizeof(obj_type_map[0])))
+                           ? type_idx : (unsigned)OBJ_OBJECT;
+
+                out = obj_type_map[type_idx >> 1];
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(CMP_EQ): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.EQ")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
+
+                assert(rsrc1 < num_regs);
+                assert(rsrc2 < num_regs);
+
+                rdest = ip->op[0];
+                src1  = read_reg(stack_frame, rsrc1);
+                src2  = read_reg(stack_frame, rsrc2);
+
+                if (IS_SMALL_INT(src1) && IS_SMALL_INT(src2))
+                    quicken_instr(ctx, stack_frame, ip, INSTR_CMP_EQ_SMALLINT);
+                else if (is_string_pair(src1, src2))
+                    quicken_instr(ctx, stack_frame, ip, INSTR_CMP_EQ_STR);
+
+                out = KOS_BOOL(KOS_compare(src1, src2) == KOS_EQUAL);
+
+                assert(rdest < num_regs);
+                write_reg(stack_frame, rdest, out);
+
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(CMP_NE): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.NE")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
+
+                KOS_COMPARE_RESULT cmp;
+
+                assert(rsrc1 < num_regs);
+                assert(rsrc2 < num_regs);
+
+                rdest = ip->op[0];
+                src1  = read_reg(stack_frame, rsrc1);
+                src2  = read_reg(stack_frame, rsrc2);
+
+                if (IS_SMALL_INT(src1) && IS_SMALL_INT(src2))
+                    quicken_instr(ctx, stack_frame, ip, INSTR_CMP_NE_SMALLINT);
+                else if (is_string_pair(src1, src2))
+                    quicken_instr(ctx, stack_frame, ip, INSTR_CMP_NE_STR);
 
-                TRY_OBJID(out);
+                cmp = KOS_compare(src1, src2);
+                out = KOS_BOOL(cmp);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(MOD): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "MOD")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
-
-                KOS_OBJ_ID src1;
-                KOS_OBJ_ID src2;
+            BEGIN_INSTRUCTION(CMP_LE): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.LE")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
                 src1  = read_reg(stack_frame, rsrc1);
                 src2  = read_reg(stack_frame, rsrc2);
 
-                switch (GET_OBJ_TYPE(src1)) {
-
-                    case OBJ_SMALL_INTEGER:
-                        out = mod_integer(ctx, GET_SMALL_INT(src1), src2);
-                        break;
-
-                    case OBJ_INTEGER:
-                        out = mod_integer(ctx, OBJPTR(INTEGER, src1)->value, src2);
-                        break;
-
-                    case OBJ_FLOAT:
-                        out = mod_float(ctx, OBJPTR(FLOAT, src1)->value, src2);
-                        break;
-
-                    default:
-                        RAISE_EXCEPTION_STR(str_err_unsup_operand_types);
-                        break;
-                }
+                if (IS_SMALL_INT(src1) && IS_SMALL_INT(src2))
+                    quicken_instr(ctx, stack_frame, ip, INSTR_CMP_LE_SMALLINT);
 
-                TRY_OBJID(out);
+                out = KOS_BOOL(KOS_compare(src1, src2) <= KOS_LESS_THAN);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(SHL): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "SHL")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
-                int64_t        a;
-                int64_t        b;
+            BEGIN_INSTRUCTION(CMP_LT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.LT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
-
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc1), &a));
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc2), &b));
+                rdest = ip->op[0];
+                src1  = read_reg(stack_frame, rsrc1);
+                src2  = read_reg(stack_frame, rsrc2);
 
-                if (b > 63 || b < -62)
-                    out = TO_SMALL_INT((a < 0 && b < 0) ? -1 : 0);
-                else if (b < 0)
-                    out = KOS_new_int(ctx, a >> -b);
-                else
-                    out = KOS_new_int(ctx, (int64_t)((uint64_t)a << b));
+                if (IS_SMALL_INT(src1) && IS_SMALL_INT(src2))
+                    quicken_instr(ctx, stack_frame, ip, INSTR_CMP_LT_SMALLINT);
 
-                TRY_OBJID(out);
+                out = KOS_BOOL(KOS_compare(src1, src2) == KOS_LESS_THAN);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(SHR): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "SHR")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
-                int64_t        a;
-                int64_t        b;
+            BEGIN_INSTRUCTION(ADD_SMALLINT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "ADD.SMALLINT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
 
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc1), &a));
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc2), &b));
+                if (! IS_SMALL_INT(src1) || ! IS_SMALL_INT(src2)) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_ADD);
+                    NEXT_INSTRUCTION;
+                }
 
-                if (b > 62 || b < -63)
-                    out = TO_SMALL_INT((a < 0 && b > 0) ? -1 : 0);
-                else if (b < 0)
-                    out = KOS_new_int(ctx, (int64_t)((uint64_t)a << -b));
-                else
-                    out = KOS_new_int(ctx, a >> b);
+                rdest = ip->op[0];
 
+                out = KOS_new_int(ctx, (int64_t)GET_SMALL_INT(src1) + (int64_t)GET_SMALL_INT(src2));
                 TRY_OBJID(out);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(SHRU): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "SHRU")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
-                int64_t        a;
-                int64_t        b;
+            BEGIN_INSTRUCTION(SUB_SMALLINT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "SUB.SMALLINT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
 
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc1), &a));
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc2), &b));
+                if (! IS_SMALL_INT(src1) || ! IS_SMALL_INT(src2)) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_SUB);
+                    NEXT_INSTRUCTION;
+                }
 
-                if (b > 63 || b < -63)
-                    out = TO_SMALL_INT(0);
-                else if (b < 0)
-                    out = KOS_new_int(ctx, (int64_t)((uint64_t)a << -b));
-                else
-                    out = KOS_new_int(ctx, (int64_t)((uint64_t)a >> b));
+                rdest = ip->op[0];
 
+                out = KOS_new_int(ctx, (int64_t)GET_SMALL_INT(src1) - (int64_t)GET_SMALL_INT(src2));
                 TRY_OBJID(out);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(NOT): { /* <r.dest>, <r.src> */
-                PROF_ZONE_N(INSTR, "NOT")
-                const unsigned rsrc = bytecode[2];
-                int64_t        a;
+            BEGIN_INSTRUCTION(ADD_FLOAT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "ADD.FLOAT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
 
-                assert(rsrc  < num_regs);
+                assert(rsrc1 < num_regs);
+                assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
 
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc), &a));
+                if (GET_OBJ_TYPE(src1) != OBJ_FLOAT || GET_OBJ_TYPE(src2) != OBJ_FLOAT) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_ADD);
+                    NEXT_INSTRUCTION;
+                }
 
-                out = KOS_new_int(ctx, ~a);
+                rdest = ip->op[0];
+
+                out = KOS_new_float(ctx, KOS_get_float(src1) + KOS_get_float(src2));
                 TRY_OBJID(out);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(AND): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "AND")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
-                int64_t        a;
-                int64_t        b;
+            BEGIN_INSTRUCTION(SUB_FLOAT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "SUB.FLOAT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
+
+                if (GET_OBJ_TYPE(src1) != OBJ_FLOAT || GET_OBJ_TYPE(src2) != OBJ_FLOAT) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_SUB);
+                    NEXT_INSTRUCTION;
+                }
 
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc1), &a));
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc2), &b));
+                rdest = ip->op[0];
 
-                out = KOS_new_int(ctx, a & b);
+                out = KOS_new_float(ctx, KOS_get_float(src1) - KOS_get_float(src2));
                 TRY_OBJID(out);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(OR): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "OR")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
-                int64_t        a;
-                int64_t        b;
+            BEGIN_INSTRUCTION(MUL_FLOAT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "MUL.FLOAT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
+
+                if (GET_OBJ_TYPE(src1) != OBJ_FLOAT || GET_OBJ_TYPE(src2) != OBJ_FLOAT) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_MUL);
+                    NEXT_INSTRUCTION;
+                }
 
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc1), &a));
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc2), &b));
+                rdest = ip->op[0];
 
-                out = KOS_new_int(ctx, a | b);
+                out = KOS_new_float(ctx, KOS_get_float(src1) * KOS_get_float(src2));
                 TRY_OBJID(out);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(XOR): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "XOR")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
-                int64_t        a;
-                int64_t        b;
+            BEGIN_INSTRUCTION(CMP_EQ_SMALLINT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.EQ.SMALLINT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
+
+                if (! IS_SMALL_INT(src1) || ! IS_SMALL_INT(src2)) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_CMP_EQ);
+                    NEXT_INSTRUCTION;
+                }
 
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc1), &a));
-                TRY(KOS_get_integer(ctx, read_reg(stack_frame, rsrc2), &b));
+                rdest = ip->op[0];
 
-                out = KOS_new_int(ctx, a ^ b);
-                TRY_OBJID(out);
+                out = KOS_BOOL(src1 == src2);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(TYPE): { /* <r.dest>, <r.src> */
-                PROF_ZONE_N(INSTR, "TYPE")
-                const unsigned rsrc = bytecode[2];
-                KOS_OBJ_ID     src;
-                unsigned       type_idx;
-
-                KOS_DECLARE_STATIC_CONST_STRING(str_integer, "integer");
-                KOS_DECLARE_STATIC_CONST_STRING(str_float,   "float");
-                KOS_DECLARE_STATIC_CONST_STRING(str_boolean, "boolean");
-                KOS_DECLARE_STATIC_CONST_STRING(str_string,  "string");
-                KOS_DECLARE_STATIC_CONST_STRING(str_object,  "object");
-                KOS_DECLARE_STATIC_CONST_STRING(str_array,   "array");
-                KOS_DECLARE_STATIC_CONST_STRING(str_buffer,  "buffer");
-                KOS_DECLARE_STATIC_CONST_STRING(str_class,   "class");
-                KOS_DECLARE_STATIC_CONST_STRING(str_module,  "module");
-
-                static const KOS_OBJ_ID obj_type_map[12] = {
-                    KOS_CONST_ID(str_integer),
-                    KOS_CONST_ID(str_integer),
-                    KOS_CONST_ID(str_float),
-                    KOS_STR_VOID,
-                    KOS_CONST_ID(str_boolean),
-                    KOS_CONST_ID(str_string),
-                    KOS_CONST_ID(str_object),
-                    KOS_CONST_ID(str_array),
-                    KOS_CONST_ID(str_buffer),
-                    KOS_STR_FUNCTION,
-                    KOS_CONST_ID(str_class),
-                    KOS_CONST_ID(str_module)
-                };
+            BEGIN_INSTRUCTION(CMP_NE_SMALLINT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.NE.SMALLINT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
+                KOS_OBJ_ID     src1;
+                KOS_OBJ_ID     src2;
 
-                assert(rsrc < num_regs);
+                assert(rsrc1 < num_regs);
+                assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
-                src   = read_reg(stack_frame, rsrc);
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
 
-                assert(!IS_BAD_PTR(src));
+                if (! IS_SMALL_INT(src1) || ! IS_SMALL_INT(src2)) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_CMP_NE);
+                    NEXT_INSTRUCTION;
+                }
 
-                type_idx = GET_OBJ_TYPE(src);
-                type_idx = (type_idx < 2 * (sizeof(obj_type_map) / sizeof(obj_type_map[0])))
-                           ? type_idx : (unsigned)OBJ_OBJECT;
+                rdest = ip->op[0];
 
-                out = obj_type_map[type_idx >> 1];
+                out = KOS_BOOL(src1 != src2);
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(CMP_EQ): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "CMP.EQ")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
+            BEGIN_INSTRUCTION(CMP_LE_SMALLINT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.LE.SMALLINT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
                 KOS_OBJ_ID     src1;
                 KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
-                src1  = read_reg(stack_frame, rsrc1);
-                src2  = read_reg(stack_frame, rsrc2);
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
 
-                out = KOS_BOOL(KOS_compare(src1, src2) == KOS_EQUAL);
+                if (! IS_SMALL_INT(src1) || ! IS_SMALL_INT(src2)) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_CMP_LE);
+                    NEXT_INSTRUCTION;
+                }
+
+                rdest = ip->op[0];
+
+                out = KOS_BOOL(GET_SMALL_INT(src1) <= GET_SMALL_INT(src2));
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(CMP_NE): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "CMP.NE")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
+            BEGIN_INSTRUCTION(CMP_LT_SMALLINT): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.LT.SMALLINT")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
                 KOS_OBJ_ID     src1;
                 KOS_OBJ_ID     src2;
 
-                KOS_COMPARE_RESULT cmp;
-
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
-                src1  = read_reg(stack_frame, rsrc1);
-                src2  = read_reg(stack_frame, rsrc2);
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
 
-                cmp = KOS_compare(src1, src2);
-                out = KOS_BOOL(cmp);
+                if (! IS_SMALL_INT(src1) || ! IS_SMALL_INT(src2)) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_CMP_LT);
+                    NEXT_INSTRUCTION;
+                }
+
+                rdest = ip->op[0];
+
+                out = KOS_BOOL(GET_SMALL_INT(src1) < GET_SMALL_INT(src2));
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(CMP_LE): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "CMP.LE")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
+            BEGIN_INSTRUCTION(CMP_EQ_STR): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.EQ.STR")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
                 KOS_OBJ_ID     src1;
                 KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
-                src1  = read_reg(stack_frame, rsrc1);
-                src2  = read_reg(stack_frame, rsrc2);
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
 
-                out = KOS_BOOL(KOS_compare(src1, src2) <= KOS_LESS_THAN);
+                if (! is_string_pair(src1, src2)) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_CMP_EQ);
+                    NEXT_INSTRUCTION;
+                }
+
+                rdest = ip->op[0];
+
+                out = KOS_BOOL(is_string_equal(src1, src2));
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
-            BEGIN_INSTRUCTION(CMP_LT): { /* <r.dest>, <r.src1>, <r.src2> */
-                PROF_ZONE_N(INSTR, "CMP.LT")
-                const unsigned rsrc1 = bytecode[2];
-                const unsigned rsrc2 = bytecode[3];
+            BEGIN_INSTRUCTION(CMP_NE_STR): { /* <r.dest>, <r.src1>, <r.src2> */
+                PROF_ZONE_N(INSTR, "CMP.NE.STR")
+                const unsigned rsrc1 = ip->op[1];
+                const unsigned rsrc2 = ip->op[2];
                 KOS_OBJ_ID     src1;
                 KOS_OBJ_ID     src2;
 
                 assert(rsrc1 < num_regs);
                 assert(rsrc2 < num_regs);
 
-                rdest = bytecode[1];
-                src1  = read_reg(stack_frame, rsrc1);
-                src2  = read_reg(stack_frame, rsrc2);
+                src1 = read_reg(stack_frame, rsrc1);
+                src2 = read_reg(stack_frame, rsrc2);
 
-                out = KOS_BOOL(KOS_compare(src1, src2) == KOS_LESS_THAN);
+                if (! is_string_pair(src1, src2)) {
+                    deoptimize_instr(ctx, stack_frame, ip, INSTR_CMP_NE);
+                    NEXT_INSTRUCTION;
+                }
+
+                rdest = ip->op[0];
+
+                out = KOS_BOOL(! is_string_equal(src1, src2));
 
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(HAS_DP): { /* <r.dest>, <r.src>, <r.prop> */
                 PROF_ZONE_N(INSTR, "HAS.DP")
-                const unsigned rsrc  = bytecode[2];
-                const unsigned rprop = bytecode[3];
+                const unsigned rsrc  = ip->op[1];
+                const unsigned rprop = ip->op[2];
 
                 assert(rsrc  < num_regs);
                 assert(rprop < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 out = KOS_get_property(ctx, read_reg(stack_frame, rsrc), read_reg(stack_frame, rprop));
                 KOS_clear_exception(ctx);
@@ -2845,21 +3931,21 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(HAS_DP_PROP8): { /* <r.dest>, <r.src>, <uint8.str.idx> */
                 PROF_ZONE_N(INSTR, "HAS.DP.PROP8")
-                const unsigned rsrc  = bytecode[2];
-                const int32_t  idx   = bytecode[3];
+                const unsigned rsrc  = ip->op[1];
+                const int32_t  idx   = ip->op[2];
                 KOS_OBJ_ID     prop;
 
                 assert(rsrc  < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
-                prop = KOS_array_read(ctx, OBJPTR(MODULE, module)->constants, idx);
+                prop = read_const(ctx, module, (uint32_t)idx);
                 TRY_OBJID(prop);
 
                 out = KOS_get_property(ctx, read_reg(stack_frame, rsrc), prop);
@@ -2870,19 +3956,19 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(HAS_SH): { /* <r.dest>, <r.src>, <r.prop> */
                 PROF_ZONE_N(INSTR, "HAS.SH")
-                const unsigned rsrc  = bytecode[2];
-                const unsigned rprop = bytecode[3];
+                const unsigned rsrc  = ip->op[1];
+                const unsigned rprop = ip->op[2];
 
                 assert(rsrc  < num_regs);
                 assert(rprop < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 out = KOS_get_property_shallow(ctx, read_reg(stack_frame, rsrc), read_reg(stack_frame, rprop));
                 KOS_clear_exception(ctx);
@@ -2892,21 +3978,21 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(HAS_SH_PROP8): { /* <r.dest>, <r.src>, <uint8.str.idx> */
                 PROF_ZONE_N(INSTR, "HAS.SH.PROP8")
-                const unsigned rsrc  = bytecode[2];
-                const uint8_t  idx   = bytecode[3];
+                const unsigned rsrc  = ip->op[1];
+                const uint8_t  idx   = ip->op[2];
                 KOS_OBJ_ID     prop;
 
                 assert(rsrc  < num_regs);
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
-                prop = KOS_array_read(ctx, OBJPTR(MODULE, module)->constants, idx);
+                prop = read_const(ctx, module, (uint32_t)idx);
                 TRY_OBJID(prop);
 
                 out = KOS_get_property_shallow(ctx, read_reg(stack_frame, rsrc), prop);
@@ -2917,14 +4003,14 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(INSTANCEOF): { /* <r.dest>, <r.src>, <r.func> */
                 PROF_ZONE_N(INSTR, "INSTANCEOF")
-                const unsigned rsrc  = bytecode[2];
-                const unsigned rfunc = bytecode[3];
+                const unsigned rsrc  = ip->op[1];
+                const unsigned rfunc = ip->op[2];
                 KOS_OBJ_ID     constr_obj;
 
                 out = KOS_FALSE;
@@ -2932,7 +4018,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rsrc  < num_regs);
                 assert(rfunc < num_regs);
 
-                rdest      = bytecode[1];
+                rdest      = ip->op[0];
                 constr_obj = read_reg(stack_frame, rfunc);
 
                 if (GET_OBJ_TYPE(constr_obj) == OBJ_CLASS) {
@@ -2950,49 +4036,61 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(JUMP): { /* <simm.delta> */
                 PROF_ZONE_N(INSTR, "JUMP")
-                const KOS_IMM imm = kos_load_simm(bytecode + 1);
+                const int32_t delta = ip->op[0];
 
                 TRY(KOS_handle_global_event(ctx));
 
-                bytecode += 1 + imm.size + imm.value.sv;
+                ip += delta;
+
+                if (delta <= 0)
+                    UPDATE_JIT_ENTRY();
+
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(JUMP_COND): { /* <simm.delta>, <r.src> */
                 PROF_ZONE_N(INSTR, "JUMP.COND")
-                const KOS_IMM  imm  = kos_load_simm(bytecode + 1);
-                const unsigned rsrc = bytecode[1 + imm.size];
+                const int32_t  delta = ip->op[0];
+                const unsigned rsrc  = ip->op[1];
 
                 assert(rsrc < num_regs);
 
                 TRY(KOS_handle_global_event(ctx));
 
                 if (kos_is_truthy(read_reg(stack_frame, rsrc)))
-                    bytecode += imm.value.sv;
+                    ip += delta;
+                else
+                    ++ip;
+
+                if (delta <= 0)
+                    UPDATE_JIT_ENTRY();
 
-                bytecode += 2 + imm.size;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(JUMP_NOT_COND): { /* <simm.delta>, <r.src> */
                 PROF_ZONE_N(INSTR, "JUMP.NOT.COND")
-                const KOS_IMM  imm  = kos_load_simm(bytecode + 1);
-                const unsigned rsrc = bytecode[1 + imm.size];
+                const int32_t  delta = ip->op[0];
+                const unsigned rsrc  = ip->op[1];
 
                 assert(rsrc < num_regs);
 
                 TRY(KOS_handle_global_event(ctx));
 
                 if ( ! kos_is_truthy(read_reg(stack_frame, rsrc)))
-                    bytecode += imm.value.sv;
+                    ip += delta;
+                else
+                    ++ip;
+
+                if (delta <= 0)
+                    UPDATE_JIT_ENTRY();
 
-                bytecode += 2 + imm.size;
                 NEXT_INSTRUCTION;
             }
 
@@ -3000,13 +4098,13 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 /* fall through */
             BEGIN_INSTRUCTION(BIND): { /* <r.dest>, <uint8.slot.idx>, <r.src> */
                 PROF_ZONE_N(INSTR, "BIND")
-                const unsigned idx = bytecode[2];
+                const unsigned idx = ip->op[1];
 
                 KOS_LOCAL dest;
                 KOS_LOCAL closures;
                 KOS_LOCAL regs;
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
                 assert(rdest < num_regs);
 
                 KOS_init_local_with(ctx, &dest, read_reg(stack_frame, rdest));
@@ -3023,8 +4121,8 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 KOS_init_local_with(ctx, &closures, OBJPTR(FUNCTION, dest.o)->closures);
                 KOS_init_local(ctx, &regs);
 
-                if (instr == INSTR_BIND) {
-                    const unsigned rsrc = bytecode[3];
+                if (get_opcode(ip) == INSTR_BIND) {
+                    const unsigned rsrc = ip->op[2];
                     assert(rsrc < num_regs);
                     regs.o = read_reg(stack_frame, rsrc);
                 }
@@ -3058,7 +4156,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
                 TRY(KOS_array_write(ctx, closures.o, (int)idx, regs.o));
 
-                bytecode += (instr == INSTR_BIND_SELF) ? 3 : 4;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
@@ -3068,8 +4166,8 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 KOS_OBJ_ID     dest;
                 KOS_TYPE       type;
 
-                const unsigned rsrc = bytecode[2];
-                rdest               = bytecode[1];
+                const unsigned rsrc = ip->op[1];
+                rdest               = ip->op[0];
 
                 assert(rsrc  < num_regs);
                 assert(rdest < num_regs);
@@ -3087,7 +4185,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 else
                     RAISE_EXCEPTION_STR(str_err_not_callable);
 
-                bytecode += 3;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
@@ -3098,8 +4196,9 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 KOS_LOCAL      iter;
                 int            finished = 0;
 
-                const unsigned riter = bytecode[2];
-                rdest                = bytecode[1];
+                const unsigned riter = ip->op[1];
+                rdest                = ip->op[0];
+                instr                = get_opcode(ip);
 
                 assert(riter < num_regs);
                 assert(rdest < num_regs);
@@ -3109,10 +4208,11 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 if (GET_OBJ_TYPE(iter.o) != OBJ_ITERATOR)
                     RAISE_EXCEPTION_STR(str_err_not_callable);
 
-                store_instr_offs(stack_frame, bytecode);
+                store_instr_offs(stack_frame, ip);
 
                 KOS_init_local_with(ctx, &iter, iter.o);
 
+#ifndef CONFIG_DEEP_STACK
                 if (OBJPTR(ITERATOR, iter.o)->type == OBJ_FUNCTION) {
 
                     KOS_LOCAL          func;
@@ -3124,13 +4224,6 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
                     state = get_func_state(func.o);
 
-                    if (state == KOS_GEN_DONE) {
-                        KOS_raise_generator_end(ctx);
-                        KOS_destroy_top_local(ctx, &iter);
-                        goto cleanup;
-                    }
-
-#ifndef CONFIG_DEEP_STACK
                     KOS_init_local_with(ctx, &func, func.o);
 
                     if ((state == KOS_GEN_READY || state == KOS_GEN_ACTIVE) && ! OBJPTR(FUNCTION, func.o)->handler) {
@@ -3160,7 +4253,9 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                         assert( ! kos_is_heap_object(module));
                         assert( ! kos_is_heap_object(stack));
 
-                        bytecode    = get_bytecode(stack_frame);
+                        ip          = get_bytecode(stack_frame);
+
+                        UPDATE_JIT_ENTRY();
 
                         KOS_destroy_top_locals(ctx, &func, &iter);
 
@@ -3168,8 +4263,8 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                     }
 
                     KOS_destroy_top_local(ctx, &func);
-#endif
                 }
+#endif
 
                 error = KOS_iterator_next(ctx, iter.o);
 
@@ -3198,7 +4293,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                             KOS_init_local_with(ctx, &iter,       iter.o);
                             KOS_init_local_with(ctx, &saved_pair, pair);
 
-                            store_instr_offs(stack_frame, bytecode);
+                            store_instr_offs(stack_frame, ip);
 
                             value = OBJPTR(DYNAMIC_PROP, value)->getter;
 
@@ -3209,6 +4304,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
                             assert(ctx->regs_idx == regs_idx);
 
+                            pair   = saved_pair.o;
                             iter.o = KOS_destroy_top_locals(ctx, &saved_pair, &iter);
 
                             TRY_OBJID(value);
@@ -3243,13 +4339,10 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                         goto cleanup;
                     }
 
-                    bytecode += 3;
+                    ++ip;
                 }
                 else {
-                    const KOS_IMM imm = kos_load_simm(bytecode + 3);
-
-                    bytecode += finished ? 0 : imm.value.sv;
-                    bytecode += 3 + imm.size;
+                    ip += finished ? 1 : ip->op[2];
 
                     TRY(KOS_handle_global_event(ctx));
                 }
@@ -3275,7 +4368,6 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 unsigned           rarg1     = ~0U;
                 unsigned           num_args  = 0;
                 int                tail_call = 0;
-                int                delta;
                 KOS_FUNCTION_STATE state;
 
                 KOS_LOCAL      func;
@@ -3285,65 +4377,61 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
                 KOS_init_locals(ctx, &func, &ret, &this_, &args, kos_end_locals);
 
+                instr = get_opcode(ip);
+
                 switch (instr) {
 
                     case INSTR_TAIL_CALL:
                         rdest     = ~0U;
-                        rfunc     = bytecode[1];
-                        rthis     = bytecode[2];
-                        rargs     = bytecode[3];
+                        rfunc     = ip->op[0];
+                        rthis     = ip->op[1];
+                        rargs     = ip->op[2];
                         tail_call = 1;
-                        delta     = 4;
                         break;
 
                     case INSTR_TAIL_CALL_N:
                         rdest     = ~0U;
-                        rfunc     = bytecode[1];
-                        rthis     = bytecode[2];
-                        rarg1     = bytecode[3];
-                        num_args  = bytecode[4];
+                        rfunc     = ip->op[0];
+                        rthis     = ip->op[1];
+                        rarg1     = ip->op[2];
+                        num_args  = ip->op[3];
                         tail_call = 1;
-                        delta     = 5;
                         assert( ! num_args || rarg1 + num_args <= num_regs);
                         break;
 
                     case INSTR_TAIL_CALL_FUN:
                         rdest     = ~0U;
-                        rfunc     = bytecode[1];
-                        rarg1     = bytecode[2];
-                        num_args  = bytecode[3];
+                        rfunc     = ip->op[0];
+                        rarg1     = ip->op[1];
+                        num_args  = ip->op[2];
                         tail_call = 1;
-                        delta     = 4;
                         assert( ! num_args || rarg1 + num_args <= num_regs);
                         break;
 
                     case INSTR_CALL:
-                        rdest = bytecode[1];
-                        rfunc = bytecode[2];
-                        rthis = bytecode[3];
-                        rargs = bytecode[4];
-                        delta = 5;
+                        rdest = ip->op[0];
+                        rfunc = ip->op[1];
+                        rthis = ip->op[2];
+                        rargs = ip->op[3];
                         assert(rdest < num_regs);
                         break;
 
                     case INSTR_CALL_N:
-                        rdest    = bytecode[1];
-                        rfunc    = bytecode[2];
-                        rthis    = bytecode[3];
-                        rarg1    = bytecode[4];
-                        num_args = bytecode[5];
-                        delta    = 6;
+                        rdest    = ip->op[0];
+                        rfunc    = ip->op[1];
+                        rthis    = ip->op[2];
+                        rarg1    = ip->op[3];
+                        num_args = ip->op[4];
                         assert(rdest < num_regs);
                         assert( ! num_args || rarg1 + num_args <= num_regs);
                         break;
 
                     default:
                         assert(instr == INSTR_CALL_FUN);
-                        rdest    = bytecode[1];
-                        rfunc    = bytecode[2];
-                        rarg1    = bytecode[3];
-                        num_args = bytecode[4];
-                        delta    = 5;
+                        rdest    = ip->op[0];
+                        rfunc    = ip->op[1];
+                        rarg1    = ip->op[2];
+                        num_args = ip->op[3];
                         assert(rdest < num_regs);
                         assert( ! num_args || rarg1 + num_args <= num_regs);
                         break;
@@ -3368,7 +4456,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                     args.o = read_reg(stack_frame, rargs);
                 }
 
-                store_instr_offs(stack_frame, bytecode);
+                store_instr_offs(stack_frame, ip);
 
                 switch (GET_OBJ_TYPE(func.o)) {
 
@@ -3431,7 +4519,9 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                         assert( ! kos_is_heap_object(module));
                         assert( ! kos_is_heap_object(stack));
 
-                        bytecode    = get_bytecode(stack_frame);
+                        ip          = get_bytecode(stack_frame);
+
+                        UPDATE_JIT_ENTRY();
 
                         KOS_destroy_top_locals(ctx, &func, &args);
 
@@ -3439,7 +4529,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 #endif
                     }
                     else {
-                        if (IS_BAD_PTR(args.o)) {
+                        if (IS_BAD_PTR(args.o) && ! OBJPTR(FUNCTION, func.o)->fast_handler) {
                             assert(KOS_is_exception_pending(ctx));
                             error = KOS_ERROR_EXCEPTION;
                         }
@@ -3447,7 +4537,12 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                             PROF_ZONE(VM)
                             PROF_ZONE_NAME_FUN(func.o)
 
-                            ret.o = OBJPTR(FUNCTION, func.o)->handler(ctx, this_.o, args.o);
+                            if (IS_BAD_PTR(args.o))
+                                ret.o = call_fast_handler(ctx, func.o, this_.o,
+                                                          &stack_frame->regs[num_args ? rarg1 : 0],
+                                                          num_args);
+                            else
+                                ret.o = OBJPTR(FUNCTION, func.o)->handler(ctx, this_.o, args.o);
 
                             assert(IS_BAD_PTR(ret.o) || GET_OBJ_TYPE(ret.o) <= OBJ_LAST_TYPE);
 
@@ -3511,7 +4606,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
                 assert(rdest < num_regs);
                 write_reg(stack_frame, rdest, out);
 
-                bytecode += delta;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
@@ -3519,7 +4614,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
             BEGIN_INSTRUCTION(RETURN): { /* <r.src> */
                 PROF_ZONE_N(INSTR, "RETURN")
-                const unsigned rsrc = bytecode[1];
+                const unsigned rsrc = ip->op[0];
 
                 assert(regs_idx >= 3);
                 assert(rsrc < num_regs);
@@ -3537,9 +4632,9 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
             BEGIN_INSTRUCTION(YIELD): { /* <r.dest>, <r.src> */
                 PROF_ZONE_N(INSTR, "YIELD")
-                const uint8_t rsrc = bytecode[2];
+                const uint8_t rsrc = ip->op[1];
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
                 assert(rsrc  < num_regs);
                 assert(rdest < num_regs);
@@ -3554,7 +4649,7 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
                 clear_stack_flag(ctx, KOS_CAN_YIELD);
 
-                bytecode += 3;
+                ++ip;
 
                 error = KOS_SUCCESS;
                 assert( ! IS_BAD_PTR(out));
@@ -3563,29 +4658,108 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
             BEGIN_INSTRUCTION(CATCH): { /* <r.dest>, <simm.delta> */
                 PROF_ZONE_N(INSTR, "CATCH")
-                const KOS_IMM  imm    = kos_load_simm(bytecode + 2);
-                const uint32_t offset = get_instr_offs(stack_frame, bytecode) + 2 + imm.size + imm.value.sv;
+                const uint32_t catch_idx = get_instr_idx(stack_frame, ip) + (uint32_t)ip->op[1];
 
-                rdest = bytecode[1];
+                rdest = ip->op[0];
 
-                assert(rdest  < num_regs);
-                assert(offset < get_bytecode_size(stack_frame));
+                assert(rdest     < num_regs);
+                assert(catch_idx <= get_num_decoded(stack_frame));
 
-                set_catch(stack_frame, offset, (uint8_t)rdest);
+                set_catch(stack_frame, catch_idx, (uint8_t)rdest);
 
-                bytecode += 2 + imm.size;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(CANCEL): {
                 PROF_ZONE_N(INSTR, "CANCEL")
                 clear_catch(stack_frame);
-                bytecode += 1;
+                ++ip;
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(SWITCH_INT): { /* <r.src>, <simm.min>, <uimm.count> */
+                PROF_ZONE_N(INSTR, "SWITCH.INT")
+                const int32_t  min   = ip->op[1];
+                const uint32_t count = (uint32_t)ip->op[2];
+                const unsigned rsrc  = ip->op[0];
+                KOS_OBJ_ID     src;
+                uint64_t       idx   = 0;
+
+                assert(rsrc < num_regs);
+
+                src = read_reg(stack_frame, rsrc);
+
+                if (IS_SMALL_INT(src))
+                    idx = (uint64_t)GET_SMALL_INT(src) - (uint64_t)(int64_t)min;
+                else if (GET_OBJ_TYPE(src) == OBJ_INTEGER)
+                    idx = (uint64_t)OBJPTR(INTEGER, src)->value - (uint64_t)(int64_t)min;
+                else if (GET_OBJ_TYPE(src) == OBJ_FLOAT) {
+                    const double value = KOS_get_float(src) - (double)min;
+
+                    /* Only integral values within the table match any cases */
+                    if ((value >= 0) && (value < (double)count) && (value == floor(value)))
+                        idx = (uint64_t)value;
+                    else
+                        idx = count;
+                }
+                else
+                    idx = count;
+
+                /* Values outside of the table go to the first entry,
+                 * each entry of the jump table is a single JUMP instruction */
+                idx = (idx < count) ? (idx + 1U) : 0U;
+
+                ip += 1U + idx;
+
+                assert(get_opcode(ip) == INSTR_JUMP);
+
+                TRY(KOS_handle_global_event(ctx));
+
+                ip += ip->op[0];
+                NEXT_INSTRUCTION;
+            }
+
+            BEGIN_INSTRUCTION(SWITCH_STR): { /* <r.src>, <uimm.const.idx>, <uimm.count> */
+                PROF_ZONE_N(INSTR, "SWITCH.STR")
+                const unsigned rsrc = ip->op[0];
+                KOS_OBJ_ID     src;
+                uint32_t       idx  = 0;
+
+                assert(rsrc < num_regs);
+
+                src = read_reg(stack_frame, rsrc);
+
+                if (GET_OBJ_TYPE(src) == OBJ_STRING) {
+                    const KOS_OBJ_ID table = get_const_operand(ctx, module, ip, (uint32_t)ip->op[1]);
+                    KOS_OBJ_ID       entry;
+
+                    TRY_OBJID(table);
+
+                    assert(GET_OBJ_TYPE(table) == OBJ_OBJECT);
+
+                    entry = kos_find_own_property(ctx, table, src);
+
+                    if ( ! IS_BAD_PTR(entry)) {
+                        assert(IS_SMALL_INT(entry));
+                        idx = (uint32_t)GET_SMALL_INT(entry);
+                        assert(idx && (idx <= (uint32_t)ip->op[2]));
+                    }
+                }
+
+                ip += 1U + idx;
+
+                assert(get_opcode(ip) == INSTR_JUMP);
+
+                TRY(KOS_handle_global_event(ctx));
+
+                ip += ip->op[0];
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_BREAKPOINT_INSTRUCTION: {
                 PROF_ZONE_N(INSTR, "BREAKPOINT")
+                instr = get_opcode(ip);
                 assert(instr == INSTR_BREAKPOINT);
                 if (instr != INSTR_BREAKPOINT) {
                     kos_set_global_event(ctx, KOS_EVENT_PANIC);
@@ -3595,19 +4769,44 @@ static KOS_OBJ_ID execute(KOS_CONTEXT ctx) /* lgtm [cpp/use-of-goto] */
 
                 /* TODO simply call a debugger function from instance */
 
-                bytecode += 1;
+                ++ip;
                 NEXT_INSTRUCTION;
             }
 
             BEGIN_INSTRUCTION(THROW): { /* <r.src> */
                 PROF_ZONE_N(INSTR, "THROW")
-                const unsigned rsrc = bytecode[1];
+                const unsigned rsrc = ip->op[0];
 
                 assert(rsrc < num_regs);
 
                 KOS_raise_exception(ctx, read_reg(stack_frame, rsrc));
             }
 
+#ifdef KOS_JIT
+enter_jit:
+            {
+                PROF_ZONE_N(INSTR, "jit")
+
+                ip        = run_jit(ctx, stack_frame, ip);
+                jit_entry = KOS_NULL;
+
+                if (KOS_is_exception_pending(ctx)) {
+                    error = KOS_ERROR_EXCEPTION;
+                    goto cleanup;
+                }
+
+                /* Native code stopped at an instruction it does not support,
+                 * go back to native code after the interpreter executes it. */
+                jit_entry = find_jit_entry(get_bytecode_objptr(stack_frame), ip + 1);
+
+#if KOS_DISPATCH_TABLE
+                NEXT_INSTRUCTION;
+#else
+                continue;
+#endif
+            }
+#endif
+
 cleanup:
             {
                 PROF_ZONE_N(INSTR, "exception")
@@ -3616,7 +4815,7 @@ cleanup:
 
                 assert(KOS_is_exception_pending(ctx));
 
-                store_instr_offs(stack_frame, bytecode);
+                store_instr_offs(stack_frame, ip);
 
                 kos_wrap_exception(ctx);
 
@@ -3634,7 +4833,7 @@ cleanup:
                 assert(catch_reg < num_regs);
                 write_reg(stack_frame, catch_reg, KOS_get_exception(ctx));
 
-                bytecode = get_bytecode_at_offs(stack_frame, catch_offs);
+                ip = get_instr_at(stack_frame, catch_offs);
 
                 clear_catch(stack_frame);
                 KOS_clear_ctrl_c_event(ctx);
@@ -3643,7 +4842,7 @@ cleanup:
             }
 
 handle_return:
-            store_instr_offs(stack_frame, bytecode);
+            store_instr_offs(stack_frame, ip);
 
             if (depth) {
                 PROF_ZONE_N(INSTR, "return")
@@ -3689,7 +4888,7 @@ handle_return:
                 assert(OBJPTR(MODULE, module)->inst);
                 assert( ! kos_is_heap_object(module));
                 assert( ! kos_is_heap_object(stack));
-                bytecode    = get_bytecode(stack_frame);
+                ip          = get_bytecode(stack_frame);
 
                 if (error &&
                     (call_instr == INSTR_NEXT_JUMP) &&
@@ -3706,20 +4905,18 @@ handle_return:
                     goto cleanup;
                 }
 
-                assert((KOS_BYTECODE_INSTR)*bytecode == call_instr);
+                assert(get_opcode(ip) == call_instr);
 
                 switch (call_instr) {
 
-                    case INSTR_NEXT_JUMP: {
-                        const KOS_IMM imm = kos_load_simm(bytecode + 3);
+                    case INSTR_NEXT_JUMP:
                         if (get_func_state(func_obj) != KOS_GEN_DONE)
-                            bytecode += imm.value.sv;
-                        else
+                            ip += ip->op[2];
+                        else {
                             out = KOS_VOID;
-
-                        bytecode += 3 + imm.size;
+                            ++ip;
+                        }
                         break;
-                    }
 
                     case INSTR_NEXT:
                         if (get_func_state(func_obj) == KOS_GEN_DONE) {
@@ -3734,23 +4931,21 @@ handle_return:
                             goto cleanup;
                         }
 
-                        bytecode += 3;
+                        ++ip;
                         break;
 
                     case INSTR_CALL_N:
-                        bytecode += 6;
-                        break;
-
+                        /* fall through */
                     case INSTR_CALL:
                         /* fall through */
                     case INSTR_CALL_FUN:
-                        bytecode += 5;
+                        ++ip;
                         break;
 
                     default:
-                        assert(((KOS_BYTECODE_INSTR)*bytecode == INSTR_TAIL_CALL) ||
-                               ((KOS_BYTECODE_INSTR)*bytecode == INSTR_TAIL_CALL_FUN) ||
-                               ((KOS_BYTECODE_INSTR)*bytecode == INSTR_TAIL_CALL_N));
+                        assert((get_opcode(ip) == INSTR_TAIL_CALL) ||
+                               (get_opcode(ip) == INSTR_TAIL_CALL_FUN) ||
+                               (get_opcode(ip) == INSTR_TAIL_CALL_N));
                         goto handle_return;
                 }
 
@@ -3760,6 +4955,8 @@ handle_return:
                     write_reg(stack_frame, rdest, out);
                 }
 
+                UPDATE_JIT_ENTRY();
+
                 NEXT_INSTRUCTION;
             }
             else
@@ -3804,13 +5001,17 @@ KOS_OBJ_ID kos_call_function(KOS_CONTEXT            ctx,
         return KOS_BADPTR;
     }
 
+    state = get_func_state(func_obj);
+
+    /* Finished generator signals the end without raising an exception */
+    if (state == KOS_GEN_DONE && call_flavor == KOS_CALL_GENERATOR)
+        return KOS_BADPTR;
+
     KOS_init_local(     ctx, &ret);
     KOS_init_local_with(ctx, &args,  args_obj);
     KOS_init_local_with(ctx, &this_, this_obj);
     KOS_init_local_with(ctx, &func,  func_obj);
 
-    state = get_func_state(func.o);
-
     if (type == OBJ_CLASS && (call_flavor != KOS_APPLY_FUNCTION || this_.o == KOS_VOID)) {
         assert(state == KOS_CTOR);
         this_.o = create_this(ctx, func.o);
@@ -3836,7 +5037,11 @@ KOS_OBJ_ID kos_call_function(KOS_CONTEXT            ctx,
             PROF_ZONE(VM)
             PROF_ZONE_NAME_FUN(func.o)
 
-            ret.o = OBJPTR(FUNCTION, func.o)->handler(ctx, this_.o, args.o);
+            if (IS_BAD_PTR(args.o))
+                ret.o = call_fast_handler(ctx, func.o, this_.o,
+                                          &get_current_stack_frame(ctx)->regs[0], 0);
+            else
+                ret.o = OBJPTR(FUNCTION, func.o)->handler(ctx, this_.o, args.o);
 
             assert(ctx->local_list == &func);
 
@@ -9,4 +9,13 @@
 
 KOS_OBJ_ID kos_vm_run_module(KOS_CONTEXT ctx, KOS_OBJ_ID module_obj);
 
+/* Decodes function's bytecode into fixed-size instructions executed by the
+ * interpreter.  Invoked when the bytecode object is allocated. */
+void kos_vm_decode(KOS_BYTECODE *bytecode);
+
+/* Resolves constant operands of decoded instructions.  Invoked after all
+ * constants of the module, including functions, have been created. */
+void kos_vm_resolve_constants(KOS_BYTECODE *bytecode,
+                              KOS_OBJ_ID    constants);
+
 #endif
@@ -14,4 +14,11 @@ typedef enum KOS_BYTECODE_INSTR_U {
     INSTR_LAST_OPCODE
 } KOS_BYTECODE_INSTR;
 
+/* Quickened instructions are at the end of the opcode range */
+#define KOS_FIRST_QUICK_INSTR INSTR_ADD_SMALLINT
+
+/* Size of each JUMP instruction in the jump table following SWITCH.INT
+ * and SWITCH.STR.  The immediate delta is always encoded with 4 bytes. */
+#define KOS_JUMP_TABLE_ENTRY_SIZE 5
+
 #endif
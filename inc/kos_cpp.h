@@ -478,7 +478,7 @@ class floating: public object {
         }
 
         operator double() const {
-            return OBJPTR(FLOAT, *this)->value;
+            return KOS_get_float(*this);
         }
 };
 
@@ -2141,7 +2141,7 @@ namespace detail {
             }
 
             case OBJ_FLOAT: {
-                const double number = OBJPTR(FLOAT, obj_id)->value;
+                const double number = KOS_get_float(obj_id);
                 /* TODO check range */
                 ret = static_cast<T>(number);
                 break;
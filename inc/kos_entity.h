@@ -43,9 +43,11 @@ typedef enum KOS_ENTITY_TYPE_E {
     OBJ_DYNAMIC_PROP   = 34,
     OBJ_ITERATOR       = 36,
     OBJ_STACK          = 38,
+    OBJ_SHAPE          = 40,
+    OBJ_SHAPED_STORAGE = 42,
 
     /* Just the last valid object id, not a real object type */
-    OBJ_LAST_POSSIBLE  = OBJ_STACK
+    OBJ_LAST_POSSIBLE  = OBJ_SHAPED_STORAGE
 } KOS_TYPE;
 
 struct KOS_ENTITY_PLACEHOLDER;
@@ -59,18 +61,35 @@ struct KOS_ENTITY_PLACEHOLDER;
  * - Heap object pointer     ...pppp pppp ppp0 0001 (32 byte-aligned pointer)
  * - Off-heap object pointer ...pppp pppp ppp0 1001 (8 byte-aligned pointer)
  * - Static object pointer   ...pppp pppp ppp1 0001 (16 byte-aligned pointer)
+ * - Small float             ...ffff ffff ffff fs11 (64-bit platforms only)
  *
- * If bit 0 is a '1', the rest of KOS_OBJ_ID is treated as the pointer without
- * that bit set.  The actual pointer to the object is KOS_OBJ_ID minus 1.
+ * If bit 0 is a '1' and bit 1 is a '0', the rest of KOS_OBJ_ID is treated as
+ * the pointer without that bit set.  The actual pointer to the object is
+ * KOS_OBJ_ID minus 1.
  *
  * Heap objects are tracked by the garbage collector.  "Heap" in this context means
  * the VM's heap, managed by the garbage collector.
  *
  * Off-heap objects are allocated using malloc(), but they have a tracker object
  * (OBJ_HUGE_TRACKER) associated with them, which is allocated on the heap.
+ *
+ * Small floats are floating-point numbers stored directly in KOS_OBJ_ID,
+ * without allocating an object.  The bits of the double are rotated left by 3,
+ * which places the sign in bit 2 and the two top exponent bits in bits 1..0,
+ * which are then replaced with the tag.  Only numbers whose magnitude is
+ * roughly between 1e-77 and 1e77 can be stored this way, because for them the
+ * two dropped exponent bits can be recovered from the third exponent bit.
+ * Zero is stored using a dedicated encoding.  Other numbers, including
+ * negative zero, infinities and NaNs, are allocated on the heap as OBJ_FLOAT.
+ * READ_OBJ_TYPE returns OBJ_FLOAT for small floats and KOS_get_float() must
+ * be used to obtain the value of any float.
  */
 typedef struct KOS_ENTITY_PLACEHOLDER *KOS_OBJ_ID;
 
+#if defined(__LP64__) || defined(_WIN64)
+#   define KOS_SMALL_FLOATS 1
+#endif
+
 #define KOS_BADPTR ((KOS_OBJ_ID)(intptr_t)1)
 
 typedef struct KOS_OBJ_HEADER_S {
@@ -109,9 +128,18 @@ static inline KOS_OBJ_ID TO_SMALL_INT(intptr_t value) {
 static inline bool IS_BAD_PTR(KOS_OBJ_ID obj_id) {
     return reinterpret_cast<intptr_t>(obj_id) == 1;
 }
+static inline bool IS_SMALL_FLOAT(KOS_OBJ_ID obj_id) {
+#ifdef KOS_SMALL_FLOATS
+    return (reinterpret_cast<intptr_t>(obj_id) & 3) == 3;
+#else
+    return false;
+#endif
+}
 static inline KOS_TYPE READ_OBJ_TYPE(KOS_OBJ_ID obj_id) {
     assert( ! IS_SMALL_INT(obj_id));
     assert( ! IS_BAD_PTR(obj_id));
+    if (IS_SMALL_FLOAT(obj_id))
+        return OBJ_FLOAT;
     return static_cast<KOS_TYPE>(
                static_cast<uint8_t>(
                    reinterpret_cast<uintptr_t>(
@@ -129,6 +157,7 @@ static inline bool IS_NUMERIC_OBJ(KOS_OBJ_ID obj_id) {
 template<typename T>
 static inline T* KOS_object_ptr(KOS_OBJ_ID obj_id, KOS_TYPE type) {
     assert( ! IS_SMALL_INT(obj_id));
+    assert( ! IS_SMALL_FLOAT(obj_id));
     assert(GET_OBJ_TYPE(obj_id) == type ||
            (type == OBJ_FUNCTION && GET_OBJ_TYPE(obj_id) == OBJ_CLASS));
     return reinterpret_cast<T*>(reinterpret_cast<intptr_t>(obj_id) - 1);
@@ -155,7 +184,14 @@ static inline KOS_OBJ_ID KOS_object_id(KOS_TYPE type, T *ptr)
 #define OBJPTR(tag, obj_id)    ( (KOS_##tag *) ((intptr_t)(obj_id) - 1)            )
 #define IS_BAD_PTR(obj_id)     ( (intptr_t)(obj_id) == 1                           )
 #define OBJID(tag, ptr)        ( (KOS_OBJ_ID) ((intptr_t)(ptr) + 1)                )
+#ifdef KOS_SMALL_FLOATS
+#define IS_SMALL_FLOAT(obj_id) ( ((intptr_t)(obj_id) & 3) == 3                     )
+#define READ_OBJ_TYPE(obj_id)  ( IS_SMALL_FLOAT(obj_id) ? OBJ_FLOAT : \
+                                 (KOS_TYPE)(uint8_t)(uintptr_t)(((KOS_OBJ_HEADER *)((uint8_t *)(obj_id) - 1))->size_and_type) )
+#else
+#define IS_SMALL_FLOAT(obj_id) 0
 #define READ_OBJ_TYPE(obj_id)  ( (KOS_TYPE)(uint8_t)(uintptr_t)(((KOS_OBJ_HEADER *)((uint8_t *)(obj_id) - 1))->size_and_type) )
+#endif
 #define GET_OBJ_TYPE(obj_id)   ( IS_SMALL_INT(obj_id) ? OBJ_SMALL_INTEGER : READ_OBJ_TYPE(obj_id) )
 
 #endif
@@ -192,9 +228,10 @@ typedef struct KOS_OPAQUE_S {
 /* Huge object tracker, allocated on the heap */
 typedef struct KOS_HUGE_TRACKER_S {
     KOS_OBJ_HEADER header;
-    void          *data;   /* Pointer to the memory allocation   */
-    KOS_OBJ_ID     object; /* Id of the object in the allocation */
-    uint32_t       size;   /* Size of the memory allocation      */
+    void          *data;        /* Pointer to the memory allocation   */
+    KOS_OBJ_ID     object;      /* Id of the object in the allocation */
+    uint32_t       size;        /* Size of the memory allocation      */
+    uint32_t       is_bytecode; /* Object is function bytecode        */
 } KOS_HUGE_TRACKER;
 
 typedef enum KOS_STRING_FLAGS_E {
@@ -391,6 +428,17 @@ typedef KOS_OBJ_ID (*KOS_FUNCTION_HANDLER)(KOS_CONTEXT ctx,
                                            KOS_OBJ_ID  this_obj,
                                            KOS_OBJ_ID  args_obj);
 
+/* Handler which receives arguments in place, without an array being allocated.
+ * `args` points to `num_args` registers on the stack, which are never moved
+ * and are updated by the garbage collector, so they must be re-read after
+ * every allocation and must not be modified by the handler.
+ * `num_args` is always at least the number of declared arguments, including
+ * the ones with default values. */
+typedef KOS_OBJ_ID (*KOS_FAST_FUNCTION_HANDLER)(KOS_CONTEXT             ctx,
+                                                KOS_OBJ_ID              this_obj,
+                                                KOS_ATOMIC(KOS_OBJ_ID) *args,
+                                                uint32_t                num_args);
+
 typedef enum KOS_FUNCTION_STATE_E {
     KOS_FUN,            /* regular function                                     */
     KOS_CTOR,           /* class constructor                                    */
@@ -420,34 +468,47 @@ typedef struct KOS_FUNCTION_OPTS_S {
 } KOS_FUNCTION_OPTS;
 
 typedef struct KOS_FUNCTION_S {
-    KOS_OBJ_HEADER       header;
-    KOS_FUNCTION_OPTS    opts;
-    KOS_ATOMIC(uint32_t) state;
-    KOS_OBJ_ID           bytecode; /* Buffer storage with bytecode */
-    KOS_OBJ_ID           module;
-    KOS_OBJ_ID           name;     /* Function name */
-    KOS_OBJ_ID           closures; /* Array with bound closures */
-    KOS_OBJ_ID           defaults; /* Array with bound default values for arguments */
-    KOS_OBJ_ID           arg_map;  /* Object which maps argument names to indexes */
-    KOS_FUNCTION_HANDLER handler;  /* TODO store this in bytecode member */
-    KOS_OBJ_ID           generator_stack_frame;
+    KOS_OBJ_HEADER            header;
+    KOS_FUNCTION_OPTS         opts;
+    KOS_ATOMIC(uint32_t)      state;
+    KOS_OBJ_ID                bytecode;     /* Buffer storage with bytecode */
+    KOS_OBJ_ID                module;
+    KOS_OBJ_ID                name;         /* Function name */
+    KOS_OBJ_ID                closures;     /* Array with bound closures */
+    KOS_OBJ_ID                defaults;     /* Array with bound default values for arguments */
+    KOS_OBJ_ID                arg_map;      /* Object which maps argument names to indexes */
+    KOS_FUNCTION_HANDLER      handler;      /* TODO store this in bytecode member */
+    KOS_FAST_FUNCTION_HANDLER fast_handler; /* Handler taking args in place, if any */
+    KOS_OBJ_ID                generator_stack_frame;
 } KOS_FUNCTION;
 
 typedef struct KOS_CLASS_S {
-    KOS_OBJ_HEADER         header;
-    KOS_FUNCTION_OPTS      opts;
-    uint32_t               dummy;
-    KOS_OBJ_ID             bytecode; /* Buffer storage with bytecode */
-    KOS_OBJ_ID             module;
-    KOS_OBJ_ID             name;     /* Function name */
-    KOS_OBJ_ID             closures; /* Array with bound closures */
-    KOS_OBJ_ID             defaults; /* Array with bound default values for arguments */
-    KOS_OBJ_ID             arg_map;  /* Object which maps argument names to indexes */
-    KOS_FUNCTION_HANDLER   handler;  /* TODO store this in bytecode member */
-    KOS_ATOMIC(KOS_OBJ_ID) prototype;
-    KOS_ATOMIC(KOS_OBJ_ID) props;
+    KOS_OBJ_HEADER            header;
+    KOS_FUNCTION_OPTS         opts;
+    uint32_t                  dummy;
+    KOS_OBJ_ID                bytecode;     /* Buffer storage with bytecode */
+    KOS_OBJ_ID                module;
+    KOS_OBJ_ID                name;         /* Function name */
+    KOS_OBJ_ID                closures;     /* Array with bound closures */
+    KOS_OBJ_ID                defaults;     /* Array with bound default values for arguments */
+    KOS_OBJ_ID                arg_map;      /* Object which maps argument names to indexes */
+    KOS_FUNCTION_HANDLER      handler;      /* TODO store this in bytecode member */
+    KOS_FAST_FUNCTION_HANDLER fast_handler; /* Always null, same offset as in KOS_FUNCTION */
+    KOS_ATOMIC(KOS_OBJ_ID)    prototype;
+    KOS_ATOMIC(KOS_OBJ_ID)    props;
 } KOS_CLASS;
 
+/* Pre-decoded instruction executed by the interpreter.  Instructions are
+ * decoded from bytecode when the function is loaded, so that the interpreter
+ * does not have to decode variable-length operands on every execution. */
+typedef struct KOS_INSTR_S {
+    KOS_ATOMIC(void *)     handler;          /* Interpreter label for the opcode, if dispatch table is used */
+    KOS_OBJ_ID             constant;         /* Resolved constant operand or badptr                         */
+    uint32_t               offs;             /* Offset of the original instruction in bytecode              */
+    KOS_ATOMIC(uint32_t)   opcode;           /* Current opcode, changed when the instruction is quickened   */
+    int32_t                op[5];            /* Operands, jump offsets are distances in decoded instrs      */
+} KOS_INSTR;
+
 typedef struct KOS_BYTECODE_S {
     KOS_OBJ_HEADER         header;
     uint32_t               bytecode_size;    /* Bytecode size in bytes                                  */
@@ -455,7 +516,14 @@ typedef struct KOS_BYTECODE_S {
     uint32_t               addr2line_size;   /* Addr2line size in bytes                                 */
     uint32_t               def_line;         /* First line in source code where the function is defined */
     uint32_t               num_instr;        /* Number of instructions in the function                  */
-    uint8_t                bytecode[1];      /* Bytecode followed by KOS_LINE_ADDR structs              */
+    uint32_t               prop_cache_offs;  /* Offset to property access caches in bytecode array      */
+    uint32_t               prop_cache_mask;  /* Number of property access caches minus one              */
+    uint32_t               decoded_offs;     /* Offset to KOS_INSTR array in bytecode array             */
+    uint32_t               num_decoded;      /* Number of decoded instructions, excluding end marker    */
+    KOS_ATOMIC(uint32_t)   num_deopts;       /* Number of deoptimized quickened instructions            */
+    KOS_ATOMIC(uint32_t)   jit_counter;      /* Number of calls and loop iterations, for JIT trigger    */
+    KOS_ATOMIC(void *)     jit_code;         /* Native code produced by JIT, if any                     */
+    uint8_t                bytecode[1];      /* Bytecode, KOS_LINE_ADDR structs, caches and KOS_INSTRs  */
 } KOS_BYTECODE;
 
 typedef struct KOS_LINE_ADDR_S {
@@ -473,6 +541,7 @@ typedef struct KOS_MODULE_S {
     KOS_OBJ_ID             constants;
     KOS_OBJ_ID             global_names;
     KOS_OBJ_ID             globals;
+    KOS_OBJ_ID             const_globals; /* Names of globals which never change after module init */
     KOS_OBJ_ID             module_names; /* Map of directly referenced modules to their indices, for REPL */
     KOS_ATOMIC(KOS_OBJ_ID) priv;
     KOS_MODULE_FINALIZE    finalize;     /* Function to call when unloading the module */
@@ -532,6 +601,9 @@ KOS_API
 KOS_OBJ_ID KOS_new_float(KOS_CONTEXT ctx,
                          double      value);
 
+KOS_API
+double KOS_get_float(KOS_OBJ_ID obj_id);
+
 KOS_API
 KOS_OBJ_ID KOS_new_function(KOS_CONTEXT ctx);
 
@@ -545,6 +617,12 @@ KOS_OBJ_ID KOS_new_builtin_function(KOS_CONTEXT          ctx,
                                     KOS_FUNCTION_HANDLER handler,
                                     const KOS_CONVERT   *args);
 
+KOS_API
+KOS_OBJ_ID KOS_new_fast_builtin_function(KOS_CONTEXT               ctx,
+                                         KOS_OBJ_ID                name_obj,
+                                         KOS_FAST_FUNCTION_HANDLER handler,
+                                         const KOS_CONVERT        *args);
+
 KOS_API
 KOS_OBJ_ID KOS_new_builtin_class(KOS_CONTEXT          ctx,
                                  KOS_OBJ_ID           name_obj,
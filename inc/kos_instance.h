@@ -15,12 +15,14 @@ struct KOS_MODULE_LOAD_CHAIN_S;
 struct KOS_PAGE_HEADER_S;
 struct KOS_POOL_HEADER_S;
 struct KOS_MARK_GROUP_S;
+struct KOS_EVACUATION_S;
 
 typedef struct KOS_LIB_LIST_S          KOS_LIB_LIST;
 typedef struct KOS_MODULE_LOAD_CHAIN_S KOS_MODULE_LOAD_CHAIN;
 typedef struct KOS_PAGE_HEADER_S       KOS_PAGE;
 typedef struct KOS_POOL_HEADER_S       KOS_POOL;
 typedef struct KOS_MARK_GROUP_S        KOS_MARK_GROUP;
+typedef struct KOS_EVACUATION_S        KOS_EVACUATION;
 
 typedef struct KOS_PAGE_LIST_S {
     KOS_PAGE *head;
@@ -43,6 +45,9 @@ typedef struct KOS_MARK_GROUP_STACK_S {
     KOS_MARK_GROUP              *stack;           /* Slow-access stack when we run out of slots */
 } KOS_MARK_GROUP_STACK;
 
+/* Number of buckets in the histogram of GC pause times */
+#define KOS_GC_SLICE_BUCKETS 8
+
 typedef struct KOS_HEAP_S {
     KOS_MUTEX              mutex;
     KOS_ATOMIC(uint32_t)   gc_state;        /* Says what the GC is doing                      */
@@ -52,8 +57,13 @@ typedef struct KOS_HEAP_S {
     uint32_t               max_heap_size;   /* Maximum allowed heap size                      */
     uint32_t               max_malloc_size; /* Maximum allowed bytes allocated with malloc    */
     uint32_t               gc_threshold;    /* Next value of used_heap_size which triggers GC */
+    uint32_t               min_heap_size;   /* Lowest GC threshold set by adaptive sizing     */
+    uint32_t               soft_max_size;   /* GC threshold exceeded only by live objects     */
+    uint32_t               gc_time_target;  /* Target percentage of time spent in GC          */
+    uint32_t               num_young_pages; /* Num pages taken for new objects since last GC  */
     KOS_PAGE              *free_pages;      /* Pages which are currently unused               */
     KOS_PAGE_LIST          used_pages;      /* Pages which contain objects                    */
+    KOS_PAGE              *evac_pages[2];   /* Old pages receiving survivors of GC            */
     KOS_POOL              *pools;           /* Allocated memory for heap, in page pools       */
 
     KOS_ATOMIC(KOS_PAGE *) walk_pages;      /* Multi-threaded page updating                   */
@@ -62,11 +72,29 @@ typedef struct KOS_HEAP_S {
     uint32_t               walk_threads;    /* Number of threads helping with page walking    */
     uint32_t               threads_to_stop; /* Number of threads on which GC is waiting       */
     uint32_t               gc_cycles;       /* Number of GC cycles started                    */
+    uint32_t               minor_gc_cycles; /* Number of GC cycles which were minor           */
+    uint32_t               gc_minor;        /* Current GC cycle only collects young objects   */
     int                    mark_error;      /* Error occurred on helper thread during marking */
+    KOS_ATOMIC(uint32_t)   concurrent_mark; /* State of marking in the background             */
+    KOS_NATIVE_THREAD      mark_thread;     /* Thread marking objects in the background       */
+    uint32_t               slice_us;        /* Time budget for incremental marking slices     */
+    uint32_t               slice_bytes;     /* Size budget for incremental marking slices     */
+    uint32_t               num_slices;      /* Number of pauses in the current GC cycle       */
+    uint32_t               max_slice_us;    /* Longest pause in the current GC cycle          */
+    uint32_t               slice_hist[KOS_GC_SLICE_BUCKETS]; /* Pause times in current cycle  */
+    uint64_t               gc_time_us;      /* Time spent in GC since last heap sizing        */
+    uint64_t               sizing_time_us;  /* Time of last heap sizing decision              */
+    KOS_NATIVE_THREAD     *gc_workers;      /* Dedicated threads helping with GC walks        */
+    uint32_t               num_gc_workers;  /* Number of dedicated GC threads                 */
+    uint32_t               stop_gc_workers; /* Tells dedicated GC threads to exit             */
+    KOS_ATOMIC(uint32_t)   busy_markers;    /* Threads which have mark groups to process      */
+    KOS_ATOMIC(uint32_t)   idle_markers;    /* Threads waiting for mark groups to steal       */
+    KOS_EVACUATION        *evacuation;      /* Shared state of parallel evacuation            */
 
     KOS_COND_VAR           engagement_cond;
     KOS_COND_VAR           walk_cond;
     KOS_COND_VAR           helper_cond;
+    KOS_COND_VAR           mark_cond;
 
 #ifdef CONFIG_MAD_GC
     struct KOS_LOCKED_PAGES_S *locked_pages_first;
@@ -101,6 +129,9 @@ enum KOS_STACK_FLAGS_E {
  *      ...
  *   +N number of registers (small int)
  *
+ * For functions implemented in bytecode, catch_offs and instr_offs are
+ * indexes of pre-decoded instructions (see KOS_INSTR), not byte offsets.
+ *
  * Typical layout of the stack:
  *
  * +----------------+
@@ -224,6 +255,25 @@ struct KOS_MODULE_MGMT_S {
 
     KOS_LIB_LIST          *libs;       /* Module libraries, unloaded at destroy */
     KOS_MODULE_LOAD_CHAIN *load_chain; /* Chain of modules during loading       */
+    char                  *cache_dir;  /* Directory with compiled modules or 0  */
+};
+
+struct KOS_SHAPE_MGMT_S {
+    KOS_OBJ_ID           root;        /* Empty shape, root of the shape tree      */
+    KOS_ATOMIC(uint32_t) num_shapes;  /* Number of shapes created                 */
+    KOS_ATOMIC(uint32_t) proto_epoch; /* Changes when cached prototypes are stale */
+};
+
+#define KOS_NUM_QUICK_INSTRS 11 /* Number of quickened instructions in kos_opcodes.h */
+
+struct KOS_QUICKEN_STATS_S {
+    /* Indexed by quickened instruction minus KOS_FIRST_QUICK_INSTR */
+    KOS_ATOMIC(uint32_t) num_quickened[KOS_NUM_QUICK_INSTRS];   /* Generic -> specialized */
+    KOS_ATOMIC(uint32_t) num_deoptimized[KOS_NUM_QUICK_INSTRS]; /* Specialized -> generic */
+};
+
+struct KOS_JIT_MGMT_S {
+    KOS_ATOMIC(uint32_t) num_compiled; /* Number of functions compiled to native code */
 };
 
 struct KOS_THREAD_MGMT_S {
@@ -243,16 +293,22 @@ enum KOS_INSTANCE_FLAGS_E {
     KOS_INST_DEBUG             = 2,
     KOS_INST_DISASM            = 4,
     KOS_INST_MANUAL_GC         = 8,
-    KOS_INST_DISABLE_TAIL_CALL = 16
+    KOS_INST_DISABLE_TAIL_CALL = 16,
+    KOS_INST_JIT               = 32,
+    KOS_INST_NO_INLINE         = 64,
+    KOS_INST_CONCURRENT_GC     = 128
 };
 
 struct KOS_INSTANCE_S {
-    uint32_t                 flags;
-    KOS_HEAP                 heap;
-    KOS_OBJ_ID               args;
-    struct KOS_PROTOTYPES_S  prototypes;
-    struct KOS_MODULE_MGMT_S modules;
-    struct KOS_THREAD_MGMT_S threads;
+    uint32_t                   flags;
+    KOS_HEAP                   heap;
+    KOS_OBJ_ID                 args;
+    struct KOS_PROTOTYPES_S    prototypes;
+    struct KOS_SHAPE_MGMT_S    shapes;
+    struct KOS_QUICKEN_STATS_S quicken;
+    struct KOS_JIT_MGMT_S      jit;
+    struct KOS_MODULE_MGMT_S   modules;
+    struct KOS_THREAD_MGMT_S   threads;
 };
 
 #ifdef __cplusplus
@@ -301,6 +357,12 @@ int KOS_instance_set_args(KOS_CONTEXT  ctx,
                           int          argc,
                           const char **argv);
 
+/* Enables caching of compiled modules in an existing directory,
+ * pass KOS_NULL or an empty string to disable the cache. */
+KOS_API
+int KOS_instance_set_cache_dir(KOS_CONTEXT ctx,
+                               const char *cache_dir);
+
 typedef int (*KOS_BUILTIN_INIT)(KOS_CONTEXT ctx, KOS_OBJ_ID module);
 
 typedef enum KOS_NATIVE_MODULE_FLAGS_E {
@@ -407,17 +469,75 @@ typedef struct KOS_GC_STATS_S {
     unsigned time_update_us;
     unsigned time_finish_us;
     unsigned time_total_us;
+    unsigned num_slices;        /* Number of pauses (slices) in which the GC cycle was done */
+    unsigned time_max_slice_us; /* Longest pause during the GC cycle                        */
+    /* Histogram of pause times: <50us, <100us, <200us, <500us, <1ms, <2ms, <5ms, >=5ms     */
+    unsigned time_slice_us[KOS_GC_SLICE_BUCKETS];
+    unsigned num_minor_cycles;
+    unsigned num_major_cycles;
+    unsigned heap_sizing;       /* KOS_HEAP_SIZING_E decision made at the end of the cycle  */
+    unsigned gc_threshold;      /* Used heap size which triggers the next major GC cycle    */
+    unsigned gc_time_percent;   /* Measured percentage of time spent in GC pauses           */
 } KOS_GC_STATS;
 
 #define KOS_GC_STATS_INIT(val) \
     { (val), (val), (val), (val), (val), (val), (val), (val), (val), (val), \
       (val), (val), (val), (val), (val), (val), (val), (val), (val), (val), \
-      (val) }
+      (val), (val), (val),                                                   \
+      { (val), (val), (val), (val), (val), (val), (val), (val) },            \
+      (val), (val), (val), (val), (val) }
+
+/* Heap sizing decisions made at the end of major GC cycles */
+enum KOS_HEAP_SIZING_E {
+    KOS_HEAP_KEEP,      /* GC threshold unchanged, also after minor GC cycles  */
+    KOS_HEAP_GROW,      /* Too much time spent in GC, threshold raised         */
+    KOS_HEAP_SHRINK,    /* Little time spent in GC, threshold lowered          */
+    KOS_HEAP_OVER_LIMIT /* Live objects exceed the soft limit of the heap size */
+};
+
+/* Enables incremental GC.  Major GC cycles are started with a short pause
+ * in which roots are marked.  The rest of the heap is then marked in slices
+ * performed by threads which allocate new pages, each slice taking at most
+ * slice_us microseconds or marking at most slice_bytes bytes of objects,
+ * whichever limit is reached first.  Either limit can be 0, which means no
+ * limit.  Passing 0 for both limits disables incremental GC.
+ * Evacuation is still done in a single pause at the end of the GC cycle.
+ * This is ignored if KOS_INST_CONCURRENT_GC is set. */
+KOS_API
+void KOS_instance_set_gc_budget(KOS_INSTANCE *inst,
+                                uint32_t      slice_us,
+                                uint32_t      slice_bytes);
+
+/* Starts num_workers dedicated threads which take part in marking, evacuation
+ * and pointer update while the world is stopped.  Without them, this work is
+ * only shared with mutator threads which are waiting for the GC to finish.
+ * Previously started workers are stopped first, so passing 0 stops them.
+ * The number of workers is capped at 64. */
+KOS_API
+int KOS_instance_set_gc_workers(KOS_INSTANCE *inst,
+                                uint32_t      num_workers);
+
+/* Configures adaptive heap sizing.  At the end of each major GC cycle, the
+ * threshold at which the next major GC cycle starts is raised if more than
+ * gc_time_percent of time since the previous major GC cycle was spent in GC
+ * pauses, or lowered if much less time was spent in GC.  The threshold is
+ * kept between min_size and max_size.  max_size is a soft limit, the heap
+ * grows beyond it when live objects don't fit, but never beyond the hard
+ * limit in heap.max_heap_size. */
+KOS_API
+void KOS_instance_set_heap_size(KOS_INSTANCE *inst,
+                                uint32_t      min_size,
+                                uint32_t      max_size,
+                                uint32_t      gc_time_percent);
 
 KOS_API
 int KOS_collect_garbage(KOS_CONTEXT   ctx,
                         KOS_GC_STATS *out_stats);
 
+KOS_API
+int KOS_collect_young_garbage(KOS_CONTEXT   ctx,
+                              KOS_GC_STATS *out_stats);
+
 enum KOS_GLOBAL_EVENT_E {
     KOS_EVENT_GC       = 1,   /* GC is in progress                        */
     KOS_EVENT_CTRL_C   = 2,   /* User pressed Ctrl-C or received SIGINT   */
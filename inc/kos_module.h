@@ -68,6 +68,13 @@ int KOS_module_add_global(KOS_CONTEXT ctx,
                           KOS_OBJ_ID  value,
                           unsigned   *idx);
 
+KOS_API
+int KOS_module_add_constant(KOS_CONTEXT ctx,
+                            KOS_OBJ_ID  module_obj,
+                            KOS_OBJ_ID  name,
+                            KOS_OBJ_ID  value,
+                            unsigned   *idx);
+
 KOS_API
 int KOS_module_get_global(KOS_CONTEXT ctx,
                           KOS_OBJ_ID  module_obj,
@@ -83,6 +90,13 @@ int KOS_module_add_function(KOS_CONTEXT          ctx,
                             const KOS_CONVERT   *args,
                             KOS_FUNCTION_STATE   gen_state);
 
+KOS_API
+int KOS_module_add_fast_function(KOS_CONTEXT               ctx,
+                                 KOS_OBJ_ID                module_obj,
+                                 KOS_OBJ_ID                str_name,
+                                 KOS_FAST_FUNCTION_HANDLER handler,
+                                 const KOS_CONVERT        *args);
+
 KOS_API
 int KOS_module_add_constructor(KOS_CONTEXT          ctx,
                                KOS_OBJ_ID           module_obj,
@@ -100,6 +114,14 @@ int KOS_module_add_member_function(KOS_CONTEXT          ctx,
                                    const KOS_CONVERT   *args,
                                    KOS_FUNCTION_STATE   gen_state);
 
+KOS_API
+int KOS_module_add_fast_member_function(KOS_CONTEXT               ctx,
+                                        KOS_OBJ_ID                module_obj,
+                                        KOS_OBJ_ID                proto_obj,
+                                        KOS_OBJ_ID                str_name,
+                                        KOS_FAST_FUNCTION_HANDLER handler,
+                                        const KOS_CONVERT        *args);
+
 KOS_API
 int KOS_module_add_static_function(KOS_CONTEXT          ctx,
                                    KOS_OBJ_ID           module_obj,
@@ -126,6 +148,13 @@ do {                                                                     \
                                 (handler), (args), KOS_FUN));            \
 } while (0)
 
+#define TRY_ADD_FAST_FUNCTION(ctx, module, name, handler, args)               \
+do {                                                                          \
+    KOS_DECLARE_STATIC_CONST_STRING(XstrNAME, name);                          \
+    TRY(KOS_module_add_fast_function((ctx), (module), KOS_CONST_ID(XstrNAME), \
+                                     (handler), (args)));                     \
+} while (0)
+
 #define TRY_ADD_GENERATOR(ctx, module, name, handler, args)              \
 do {                                                                     \
     KOS_DECLARE_STATIC_CONST_STRING(XstrNAME, name);                     \
@@ -147,6 +176,13 @@ do {
                                        (handler), (args), KOS_FUN));                     \
 } while (0)
 
+#define TRY_ADD_FAST_MEMBER_FUNCTION(ctx, module, proto, name, handler, args)                 \
+do {                                                                                          \
+    KOS_DECLARE_STATIC_CONST_STRING(XstrNAME, name);                                          \
+    TRY(KOS_module_add_fast_member_function((ctx), (module), (proto), KOS_CONST_ID(XstrNAME), \
+                                            (handler), (args)));                              \
+} while (0)
+
 #define TRY_ADD_MEMBER_GENERATOR(ctx, module, proto, name, handler, args)                \
 do {                                                                                     \
     KOS_DECLARE_STATIC_CONST_STRING(XstrNAME, name);                                     \
@@ -169,19 +205,19 @@ do {
                                        KOS_CONST_ID(XstrNAME), (handler), (args), KOS_FUN));  \
 } while (0)
 
-#define TRY_ADD_INTEGER_CONSTANT(ctx, module, name, value)             \
-do {                                                                   \
-    KOS_DECLARE_STATIC_CONST_STRING(XstrNAME, name);                   \
-    TRY(KOS_module_add_global((ctx), (module), KOS_CONST_ID(XstrNAME), \
-                              TO_SMALL_INT((int)(value)), KOS_NULL));  \
+#define TRY_ADD_INTEGER_CONSTANT(ctx, module, name, value)               \
+do {                                                                     \
+    KOS_DECLARE_STATIC_CONST_STRING(XstrNAME, name);                     \
+    TRY(KOS_module_add_constant((ctx), (module), KOS_CONST_ID(XstrNAME), \
+                                TO_SMALL_INT((int)(value)), KOS_NULL));  \
 } while (0)
 
-#define TRY_ADD_STRING_CONSTANT(ctx, module, name, value)              \
-do {                                                                   \
-    KOS_DECLARE_STATIC_CONST_STRING(XstrNAME, name);                   \
-    KOS_DECLARE_STATIC_CONST_STRING(XstrVALUE, value);                 \
-    TRY(KOS_module_add_global((ctx), (module), KOS_CONST_ID(XstrNAME), \
-                              KOS_CONST_ID(XstrVALUE), KOS_NULL));     \
+#define TRY_ADD_STRING_CONSTANT(ctx, module, name, value)                \
+do {                                                                     \
+    KOS_DECLARE_STATIC_CONST_STRING(XstrNAME, name);                     \
+    KOS_DECLARE_STATIC_CONST_STRING(XstrVALUE, value);                   \
+    TRY(KOS_module_add_constant((ctx), (module), KOS_CONST_ID(XstrNAME), \
+                                KOS_CONST_ID(XstrVALUE), KOS_NULL));     \
 } while (0)
 
 #ifdef KOS_EXTERNAL_MODULES
@@ -185,3 +185,55 @@ DEFINE_INSTRUCTION(THROW, 0xC5)
 DEFINE_INSTRUCTION(CATCH, 0xC6)
 /* CANCEL */
 DEFINE_INSTRUCTION(CANCEL, 0xC7)
+
+/* SWITCH.INT <r.src>, <simm.min>, <uimm.count>
+ * Jump table for dense integer cases.  The instruction is followed by
+ * count + 1 JUMP instructions, each KOS_JUMP_TABLE_ENTRY_SIZE bytes long.
+ * If r.src is an integer from min to min + count - 1, the JUMP at index
+ * r.src - min + 1 is taken, otherwise the first JUMP is taken. */
+DEFINE_INSTRUCTION(SWITCH_INT, 0xC8)
+/* SWITCH.STR <r.src>, <uimm.const.idx>, <uimm.count>
+ * Jump table for string cases.  The constant is an object, which maps
+ * case strings to indexes of JUMP instructions following this instruction,
+ * like in SWITCH.INT.  If r.src is not found, the first JUMP is taken. */
+DEFINE_INSTRUCTION(SWITCH_STR, 0xC9)
+
+/* NEW.OBJ.TEMPLATE <r.dest>, <uimm.const.idx>
+ * Creates a new object by copying the property table of an object template
+ * from the module's constants. */
+DEFINE_INSTRUCTION(NEW_OBJ_TEMPLATE, 0xCA)
+/* NEW.ARRAY.TEMPLATE <r.dest>, <uimm.const.idx>
+ * Creates a new array by copying the elements of an array template
+ * from the module's constants. */
+DEFINE_INSTRUCTION(NEW_ARRAY_TEMPLATE, 0xCB)
+
+/* Quickened instructions.
+ *
+ * These are never emitted by the compiler.  The interpreter rewrites a generic
+ * instruction in place to one of these type-specialized variants when it finds
+ * suitable operand types.  When the operand types no longer match, the
+ * specialized instruction is rewritten back to the generic one.
+ * The operands are the same as for the generic instruction. */
+
+/* ADD.SMALLINT <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(ADD_SMALLINT, 0xCC)
+/* SUB.SMALLINT <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(SUB_SMALLINT, 0xCD)
+/* ADD.FLOAT <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(ADD_FLOAT, 0xCE)
+/* SUB.FLOAT <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(SUB_FLOAT, 0xCF)
+/* MUL.FLOAT <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(MUL_FLOAT, 0xD0)
+/* CMP.EQ.SMALLINT <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(CMP_EQ_SMALLINT, 0xD1)
+/* CMP.NE.SMALLINT <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(CMP_NE_SMALLINT, 0xD2)
+/* CMP.LE.SMALLINT <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(CMP_LE_SMALLINT, 0xD3)
+/* CMP.LT.SMALLINT <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(CMP_LT_SMALLINT, 0xD4)
+/* CMP.EQ.STR <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(CMP_EQ_STR, 0xD5)
+/* CMP.NE.STR <r.dest>, <r.src1>, <r.src2> */
+DEFINE_INSTRUCTION(CMP_NE_STR, 0xD6)
@@ -9,6 +9,9 @@
 
 typedef struct KOS_MUTEX_OBJECT_S    *KOS_MUTEX;
 typedef struct KOS_COND_VAR_OBJECT_S *KOS_COND_VAR;
+typedef struct KOS_NATIVE_THREAD_S   *KOS_NATIVE_THREAD;
+
+typedef void (*KOS_NATIVE_THREAD_FUNC)(void *cookie);
 
 #ifdef _WIN32
 typedef uint32_t KOS_TLS_KEY;
@@ -45,6 +48,12 @@ void kos_signal_cond_var(KOS_COND_VAR cond_var);
 void kos_broadcast_cond_var(KOS_COND_VAR cond_var);
 void kos_wait_cond_var(KOS_COND_VAR cond_var, KOS_MUTEX mutex);
 
+/* Native threads don't have a context and cannot run Kos code */
+int kos_create_native_thread(KOS_NATIVE_THREAD     *thread,
+                             KOS_NATIVE_THREAD_FUNC func,
+                             void                  *cookie);
+void kos_join_native_thread(KOS_NATIVE_THREAD *thread);
+
 int   kos_tls_create(KOS_TLS_KEY *key);
 void  kos_tls_destroy(KOS_TLS_KEY key);
 void *kos_tls_get(KOS_TLS_KEY key);
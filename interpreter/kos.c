@@ -68,6 +68,8 @@ static int is_option(const char *arg,
 
 static int get_exit_code(KOS_CONTEXT ctx, KOS_OBJ_ID ret);
 
+static int get_env_size_mb(const char *name, KOS_VECTOR *buf, uint32_t *size);
+
 static void print_usage(void);
 
 static int run_interactive(KOS_CONTEXT ctx, KOS_VECTOR *buf);
@@ -171,6 +173,10 @@ int main(int argc, char *argv[])
                 flags |= KOS_INST_VERBOSE | KOS_INST_DEBUG;
                 ++i_first_arg;
             }
+            else if (is_option(arg, KOS_NULL, "no-inline")) {
+                flags |= KOS_INST_NO_INLINE;
+                ++i_first_arg;
+            }
             else {
                 i_module    = i_first_arg;
                 i_first_arg = (argc - i_first_arg) > 1 ? i_first_arg + 1 : 0;
@@ -184,6 +190,16 @@ int main(int argc, char *argv[])
             buf.size == 2 && buf.buffer[0] == '1' && buf.buffer[1] == 0)
         flags |= KOS_INST_DISASM;
 
+    /* KOSJIT=1 turns on JIT compilation, if supported */
+    if (!KOS_get_env("KOSJIT", &buf) &&
+            buf.size == 2 && buf.buffer[0] == '1' && buf.buffer[1] == 0)
+        flags |= KOS_INST_JIT;
+
+    /* KOSCONCURRENTGC=1 turns on marking in the background during GC */
+    if (!KOS_get_env("KOSCONCURRENTGC", &buf) &&
+            buf.size == 2 && buf.buffer[0] == '1' && buf.buffer[1] == 0)
+        flags |= KOS_INST_CONCURRENT_GC;
+
     /* KOSINTERACTIVE=1 forces interactive prompt       */
     /* KOSINTERACTIVE=0 forces treating stdin as a file */
     if (!KOS_get_env("KOSINTERACTIVE", &buf) &&
@@ -224,6 +240,50 @@ int main(int argc, char *argv[])
         goto cleanup;
     }
 
+    /* KOSGCSLICE=us enables incremental GC with the time budget per slice */
+    if (!KOS_get_env("KOSGCSLICE", &buf) && buf.size > 1)
+        KOS_instance_set_gc_budget(&inst, (uint32_t)strtoul(buf.buffer, KOS_NULL, 10), 0U);
+
+    /* KOSGCWORKERS=n starts n dedicated threads which help with GC */
+    if (!KOS_get_env("KOSGCWORKERS", &buf) && buf.size > 1) {
+        error = KOS_instance_set_gc_workers(&inst, (uint32_t)strtoul(buf.buffer, KOS_NULL, 10));
+
+        if (error) {
+            fprintf(stderr, "Failed to start GC worker threads\n");
+            goto cleanup;
+        }
+    }
+
+    /* KOSHEAPMIN=mb and KOSHEAPMAX=mb set limits for adaptive heap sizing, */
+    /* KOSGCTIME=percent sets target fraction of time spent in GC           */
+    {
+        uint32_t min_size = inst.heap.min_heap_size;
+        uint32_t max_size = inst.heap.soft_max_size;
+        uint32_t gc_time  = inst.heap.gc_time_target;
+        int      set_size = 0;
+
+        set_size |= get_env_size_mb("KOSHEAPMIN", &buf, &min_size);
+        set_size |= get_env_size_mb("KOSHEAPMAX", &buf, &max_size);
+
+        if (!KOS_get_env("KOSGCTIME", &buf) && buf.size > 1) {
+            gc_time  = (uint32_t)strtoul(buf.buffer, KOS_NULL, 10);
+            set_size = 1;
+        }
+
+        if (set_size)
+            KOS_instance_set_heap_size(&inst, min_size, max_size, gc_time);
+    }
+
+    /* KOSCACHE=dir stores compiled modules in dir and reuses them */
+    if (!KOS_get_env("KOSCACHE", &buf) && buf.size > 1) {
+        error = KOS_instance_set_cache_dir(ctx, buf.buffer);
+
+        if (error) {
+            fprintf(stderr, "Failed to setup module cache\n");
+            goto cleanup;
+        }
+    }
+
     if (i_first_arg) {
 
         char *saved    = argv[i_first_arg - 1];
@@ -365,6 +425,20 @@ static int is_option(const char *arg,
     return 0;
 }
 
+static int get_env_size_mb(const char *name, KOS_VECTOR *buf, uint32_t *size)
+{
+    unsigned long value;
+
+    if (KOS_get_env(name, buf) || buf->size < 2)
+        return 0;
+
+    value = strtoul(buf->buffer, KOS_NULL, 10);
+
+    *size = (value < 4096U) ? ((uint32_t)value << 20) : 0xFFF00000U;
+
+    return 1;
+}
+
 static int get_exit_code(KOS_CONTEXT ctx, KOS_OBJ_ID ret)
 {
     int64_t value = 0;
@@ -387,6 +461,7 @@ static void print_usage(void)
     printf("  -m M, --memsize M   Total size of heaps in MB\n");
     printf("  -v, --verbose       Enable verbose output\n");
     printf("  -vv                 Enable more verbose output\n");
+    printf("  --no-inline         Disable inlining of function calls\n");
     printf("\n");
 }
 
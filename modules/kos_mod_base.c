@@ -12,6 +12,7 @@
 #include "../inc/kos_module.h"
 #include "../inc/kos_string.h"
 #include "../inc/kos_utils.h"
+#include "../core/kos_heap.h"
 #include "../core/kos_object_internal.h"
 #include "../core/kos_math.h"
 #include "../core/kos_misc.h"
@@ -76,6 +77,9 @@ KOS_DECLARE_STATIC_CONST_STRING(str_pos,                          "pos");
 KOS_DECLARE_STATIC_CONST_STRING(str_reverse,                      "reverse");
 KOS_DECLARE_STATIC_CONST_STRING(str_size,                         "size");
 KOS_DECLARE_STATIC_CONST_STRING(str_source,                       "source");
+KOS_DECLARE_STATIC_CONST_STRING(str_start,                        "start");
+KOS_DECLARE_STATIC_CONST_STRING(str_step,                         "step");
+KOS_DECLARE_STATIC_CONST_STRING(str_stop,                         "stop");
 KOS_DECLARE_STATIC_CONST_STRING(str_str,                          "str");
 KOS_DECLARE_STATIC_CONST_STRING(str_substr,                       "substr");
 KOS_DECLARE_STATIC_CONST_STRING(str_this_obj,                     "this_obj");
@@ -259,6 +263,52 @@ static KOS_OBJ_ID deep(KOS_CONTEXT ctx,
     return object_iterator(ctx, regs_obj, KOS_DEEP);
 }
 
+/* @item base range()
+ *
+ *     range(stop)
+ *     range(start, stop, step = 1)
+ *
+ * A generator which produces an arithmetic progression of numbers.
+ *
+ * Returns an iterator function, which yields subsequent numbers in
+ * the specified range.
+ *
+ * `start`, `stop` and `step` arguments are integers or floats.
+ *
+ * `start` specifies the first number returned by the iterator.  `start`
+ * defaults to `0`.
+ *
+ * `step` specified the increment which is added to subsequently returned
+ * numbers.  If `step` is greater than zero, the generated sequence is
+ * ascending.  If `step` is negative, the generated sequence is descending.
+ * If `step` is zero, no numbers are generated.
+ *
+ * `stop` specifies the number ending the sequence, but not included in it.
+ * The iterator terminates when it reaches or exceeds `stop`.
+ *
+ * Examples:
+ *
+ *     > range(5) -> array
+ *     [0, 1, 2, 3, 4]
+ *     > range(1, 5) -> array
+ *     [1, 2, 3, 4]
+ *     > range(0, 16, 4) -> array
+ *     [0, 4, 8, 12]
+ *     > range(0) -> array
+ *     []
+ *     > range(2, -8, -2) -> array
+ *     [2, 0, -2, -4, -6]
+ *     > for const x in range(2) { print(x) }
+ *     0
+ *     1
+ */
+static const KOS_CONVERT range_args[4] = {
+    KOS_DEFINE_MANDATORY_ARG(str_start                 ),
+    KOS_DEFINE_OPTIONAL_ARG( str_stop, KOS_VOID        ),
+    KOS_DEFINE_OPTIONAL_ARG( str_step, TO_SMALL_INT(1) ),
+    KOS_DEFINE_TAIL_ARG()
+};
+
 static int create_class(KOS_CONTEXT          ctx,
                         KOS_OBJ_ID           module_obj,
                         KOS_OBJ_ID           class_name,
@@ -2100,9 +2150,10 @@ static const KOS_CONVERT slice_args[3] = {
     KOS_DEFINE_TAIL_ARG()
 };
 
-static KOS_OBJ_ID slice(KOS_CONTEXT ctx,
-                        KOS_OBJ_ID  this_obj,
-                        KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID slice(KOS_CONTEXT             ctx,
+                        KOS_OBJ_ID              this_obj,
+                        KOS_ATOMIC(KOS_OBJ_ID) *args,
+                        uint32_t                num_args)
 {
     int        error;
     KOS_OBJ_ID ret   = KOS_BADPTR;
@@ -2111,11 +2162,10 @@ static KOS_OBJ_ID slice(KOS_CONTEXT ctx,
     int64_t    idx_a = 0;
     int64_t    idx_b = 0;
 
-    a_obj = KOS_array_read(ctx, args_obj, 0);
-    TRY_OBJID(a_obj);
+    assert(num_args >= 2);
 
-    b_obj = KOS_array_read(ctx, args_obj, 1);
-    TRY_OBJID(b_obj);
+    a_obj = KOS_atomic_read_relaxed_obj(args[0]);
+    b_obj = KOS_atomic_read_relaxed_obj(args[1]);
 
     if (IS_NUMERIC_OBJ(a_obj))
         TRY(KOS_get_integer(ctx, a_obj, &idx_a));
@@ -2201,6 +2251,9 @@ static KOS_OBJ_ID expand_for_sort(KOS_CONTEXT ctx,
             KOS_atomic_write_relaxed_ptr(OBJPTR(ARRAY_STORAGE, dest.o)->buf[i_dest],     key);
             KOS_atomic_write_relaxed_ptr(OBJPTR(ARRAY_STORAGE, dest.o)->buf[i_dest + 1], TO_SMALL_INT(i));
             KOS_atomic_write_relaxed_ptr(OBJPTR(ARRAY_STORAGE, dest.o)->buf[i_dest + 2], val.o);
+
+            /* Calling the key function could have promoted the storage */
+            kos_write_barrier(dest.o);
         }
 
         ++i;
@@ -2332,6 +2385,8 @@ static void copy_sort_results(KOS_CONTEXT ctx,
         src += step;
         ++dest;
     }
+
+    kos_write_barrier(kos_get_array_storage(ret));
 }
 
 /* @item base array.prototype.sort()
@@ -3081,7 +3136,7 @@ static int pack_format(KOS_CONTEXT               ctx,
                         break;
 
                     case OBJ_FLOAT:
-                        value = OBJPTR(FLOAT, value_obj)->value;
+                        value = KOS_get_float(value_obj);
                         break;
 
                     default:
@@ -3915,9 +3970,10 @@ static const KOS_CONVERT pop_args[2] = {
     KOS_DEFINE_TAIL_ARG()
 };
 
-static KOS_OBJ_ID pop(KOS_CONTEXT ctx,
-                      KOS_OBJ_ID  this_obj,
-                      KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID pop(KOS_CONTEXT             ctx,
+                      KOS_OBJ_ID              this_obj,
+                      KOS_ATOMIC(KOS_OBJ_ID) *args,
+                      uint32_t                num_args)
 {
     KOS_LOCAL self;
     KOS_LOCAL arg;
@@ -3927,14 +3983,12 @@ static KOS_OBJ_ID pop(KOS_CONTEXT ctx,
     int       just_one = 0;
     int       error    = KOS_SUCCESS;
 
-    assert(KOS_get_array_size(args_obj) >= 1);
+    assert(num_args >= 1);
 
     KOS_init_locals(ctx, &self, &arg, &new_array, kos_end_locals);
 
     self.o = this_obj;
-
-    arg.o = KOS_array_read(ctx, args_obj, 0);
-    TRY_OBJID(arg.o);
+    arg.o  = KOS_atomic_read_relaxed_obj(args[0]);
 
     if (arg.o == KOS_VOID)
         just_one = 1;
@@ -3982,19 +4036,17 @@ cleanup:
  *     > [1, 1, 1].push(10, 20)
  *     3
  */
-static KOS_OBJ_ID push(KOS_CONTEXT ctx,
-                       KOS_OBJ_ID  this_obj,
-                       KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID push(KOS_CONTEXT             ctx,
+                       KOS_OBJ_ID              this_obj,
+                       KOS_ATOMIC(KOS_OBJ_ID) *args,
+                       uint32_t                num_args)
 {
-    int            error    = KOS_SUCCESS;
-    const uint32_t num_args = KOS_get_array_size(args_obj);
-    uint32_t       i;
-    KOS_LOCAL      self;
-    KOS_LOCAL      args;
-    KOS_LOCAL      old_size;
+    int       error = KOS_SUCCESS;
+    uint32_t  i;
+    KOS_LOCAL self;
+    KOS_LOCAL old_size;
 
     KOS_init_local(ctx, &old_size);
-    KOS_init_local_with(ctx, &args, args_obj);
     KOS_init_local_with(ctx, &self, this_obj);
 
     if (GET_OBJ_TYPE(self.o) != OBJ_ARRAY)
@@ -4009,11 +4061,9 @@ static KOS_OBJ_ID push(KOS_CONTEXT ctx,
                               KOS_get_array_size(self.o) + num_args));
 
     for (i = 0; i < num_args; i++) {
-        uint32_t   idx      = ~0U;
-        KOS_OBJ_ID elem_obj = KOS_array_read(ctx, args.o, (int)i);
-        TRY_OBJID(elem_obj);
+        uint32_t idx = ~0U;
 
-        TRY(KOS_array_push(ctx, self.o, elem_obj, &idx));
+        TRY(KOS_array_push(ctx, self.o, KOS_atomic_read_relaxed_obj(args[i]), &idx));
 
         if (i == 0) {
             old_size.o = KOS_new_int(ctx, (int64_t)idx);
@@ -4050,9 +4100,10 @@ static const KOS_CONVERT ends_with_args[2] = {
     KOS_DEFINE_TAIL_ARG()
 };
 
-static KOS_OBJ_ID ends_with(KOS_CONTEXT ctx,
-                            KOS_OBJ_ID  this_obj,
-                            KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID ends_with(KOS_CONTEXT             ctx,
+                            KOS_OBJ_ID              this_obj,
+                            KOS_ATOMIC(KOS_OBJ_ID) *args,
+                            uint32_t                num_args)
 {
     int        error = KOS_SUCCESS;
     KOS_OBJ_ID arg;
@@ -4060,8 +4111,9 @@ static KOS_OBJ_ID ends_with(KOS_CONTEXT ctx,
     unsigned   this_len;
     unsigned   arg_len;
 
-    arg = KOS_array_read(ctx, args_obj, 0);
-    TRY_OBJID(arg);
+    assert(num_args >= 1);
+
+    arg = KOS_atomic_read_relaxed_obj(args[0]);
 
     if (GET_OBJ_TYPE(this_obj) != OBJ_STRING || GET_OBJ_TYPE(arg) != OBJ_STRING)
         RAISE_EXCEPTION_STR(str_err_not_string);
@@ -4105,17 +4157,18 @@ static const KOS_CONVERT repeats_args[2] = {
     KOS_DEFINE_TAIL_ARG()
 };
 
-static KOS_OBJ_ID repeats(KOS_CONTEXT ctx,
-                          KOS_OBJ_ID  this_obj,
-                          KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID repeats(KOS_CONTEXT             ctx,
+                          KOS_OBJ_ID              this_obj,
+                          KOS_ATOMIC(KOS_OBJ_ID) *args,
+                          uint32_t                num_args)
 {
     int        error = KOS_SUCCESS;
-    KOS_OBJ_ID arg   = KOS_array_read(ctx, args_obj, 0);
+    KOS_OBJ_ID arg   = KOS_atomic_read_relaxed_obj(args[0]);
     KOS_OBJ_ID ret   = KOS_BADPTR;
     int64_t    num;
     unsigned   text_len;
 
-    TRY_OBJID(arg);
+    assert(num_args >= 1);
 
     if (GET_OBJ_TYPE(this_obj) != OBJ_STRING)
         RAISE_EXCEPTION_STR(str_err_not_string);
@@ -4164,32 +4217,30 @@ static const KOS_CONVERT find_args[3] = {
     KOS_DEFINE_TAIL_ARG()
 };
 
-static KOS_OBJ_ID find_dir(KOS_CONTEXT         ctx,
-                           KOS_OBJ_ID          this_obj,
-                           KOS_OBJ_ID          args_obj,
-                           enum KOS_FIND_DIR_E reverse)
+static KOS_OBJ_ID find_dir(KOS_CONTEXT             ctx,
+                           KOS_OBJ_ID              this_obj,
+                           KOS_ATOMIC(KOS_OBJ_ID) *args,
+                           uint32_t                num_args,
+                           enum KOS_FIND_DIR_E     reverse)
 {
-    KOS_OBJ_ID pattern = KOS_array_read(ctx, args_obj, 0);
+    KOS_OBJ_ID pattern = KOS_atomic_read_relaxed_obj(args[0]);
     int        pos     = 0;
     int        error   = KOS_SUCCESS;
     uint32_t   this_len;
 
-    assert(KOS_get_array_size(args_obj) >= 2);
-
-    TRY_OBJID(pattern);
+    assert(num_args >= 2);
 
     if (GET_OBJ_TYPE(this_obj) != OBJ_STRING || GET_OBJ_TYPE(pattern) != OBJ_STRING)
         RAISE_EXCEPTION_STR(str_err_not_string);
 
     this_len = KOS_get_string_length(this_obj);
 
-    TRY(KOS_get_index_arg(ctx,
-                          args_obj,
-                          1,
-                          reverse ? -1 : 0,
-                          reverse ? KOS_max((int)(this_len - KOS_get_string_length(pattern)), 0) : (int)this_len,
-                          reverse ? KOS_VOID_INDEX_IS_END : KOS_VOID_INDEX_IS_BEGIN,
-                          &pos));
+    TRY(KOS_get_index_value(ctx,
+                            KOS_atomic_read_relaxed_obj(args[1]),
+                            reverse ? -1 : 0,
+                            reverse ? KOS_max((int)(this_len - KOS_get_string_length(pattern)), 0) : (int)this_len,
+                            reverse ? KOS_VOID_INDEX_IS_END : KOS_VOID_INDEX_IS_BEGIN,
+                            &pos));
 
     TRY(KOS_string_find(ctx, this_obj, pattern, reverse, &pos));
 
@@ -4197,11 +4248,12 @@ cleanup:
     return error ? KOS_BADPTR : TO_SMALL_INT(pos);
 }
 
-static KOS_OBJ_ID find(KOS_CONTEXT ctx,
-                       KOS_OBJ_ID  this_obj,
-                       KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID find(KOS_CONTEXT             ctx,
+                       KOS_OBJ_ID              this_obj,
+                       KOS_ATOMIC(KOS_OBJ_ID) *args,
+                       uint32_t                num_args)
 {
-    return find_dir(ctx, this_obj, args_obj, KOS_FIND_FORWARD);
+    return find_dir(ctx, this_obj, args, num_args, KOS_FIND_FORWARD);
 }
 
 /* @item base string.prototype.rfind()
@@ -4237,11 +4289,12 @@ static const KOS_CONVERT rfind_args[3] = {
     KOS_DEFINE_TAIL_ARG()
 };
 
-static KOS_OBJ_ID rfind(KOS_CONTEXT ctx,
-                        KOS_OBJ_ID  this_obj,
-                        KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID rfind(KOS_CONTEXT             ctx,
+                        KOS_OBJ_ID              this_obj,
+                        KOS_ATOMIC(KOS_OBJ_ID) *args,
+                        uint32_t                num_args)
 {
-    return find_dir(ctx, this_obj, args_obj, KOS_FIND_REVERSE);
+    return find_dir(ctx, this_obj, args, num_args, KOS_FIND_REVERSE);
 }
 
 /* @item base string.prototype.scan()
@@ -4281,40 +4334,37 @@ static const KOS_CONVERT scan_args[4] = {
     KOS_DEFINE_TAIL_ARG()
 };
 
-static KOS_OBJ_ID scan_dir(KOS_CONTEXT         ctx,
-                           KOS_OBJ_ID          this_obj,
-                           KOS_OBJ_ID          args_obj,
-                           enum KOS_FIND_DIR_E reverse)
+static KOS_OBJ_ID scan_dir(KOS_CONTEXT             ctx,
+                           KOS_OBJ_ID              this_obj,
+                           KOS_ATOMIC(KOS_OBJ_ID) *args,
+                           uint32_t                num_args,
+                           enum KOS_FIND_DIR_E     reverse)
 {
-    KOS_OBJ_ID              pattern = KOS_array_read(ctx, args_obj, 0);
+    KOS_OBJ_ID              pattern = KOS_atomic_read_relaxed_obj(args[0]);
     KOS_OBJ_ID              inclusive;
     int                     error   = KOS_SUCCESS;
     int                     pos     = 0;
     int                     this_len;
     enum KOS_SCAN_INCLUDE_E include;
 
-    assert(KOS_get_array_size(args_obj) >= 3);
-
-    TRY_OBJID(pattern);
+    assert(num_args >= 3);
 
     if (GET_OBJ_TYPE(this_obj) != OBJ_STRING || GET_OBJ_TYPE(pattern) != OBJ_STRING)
         RAISE_EXCEPTION_STR(str_err_not_string);
 
     this_len = (int)KOS_get_string_length(this_obj);
 
-    TRY(KOS_get_index_arg(ctx,
-                          args_obj,
-                          1,
-                          reverse ? -1 : 0,
-                          this_len,
-                          reverse ? KOS_VOID_INDEX_IS_END : KOS_VOID_INDEX_IS_BEGIN,
-                          &pos));
+    TRY(KOS_get_index_value(ctx,
+                            KOS_atomic_read_relaxed_obj(args[1]),
+                            reverse ? -1 : 0,
+                            this_len,
+                            reverse ? KOS_VOID_INDEX_IS_END : KOS_VOID_INDEX_IS_BEGIN,
+                            &pos));
 
     if (reverse && (pos == this_len))
         --pos;
 
-    inclusive = KOS_array_read(ctx, args_obj, 2);
-    TRY_OBJID(inclusive);
+    inclusive = KOS_atomic_read_relaxed_obj(args[2]);
 
     if (GET_OBJ_TYPE(inclusive) != OBJ_BOOLEAN)
         RAISE_EXCEPTION_STR(str_err_not_boolean);
@@ -4327,11 +4377,12 @@ cleanup:
     return error ? KOS_BADPTR : TO_SMALL_INT(pos);
 }
 
-static KOS_OBJ_ID scan(KOS_CONTEXT ctx,
-                       KOS_OBJ_ID  this_obj,
-                       KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID scan(KOS_CONTEXT             ctx,
+                       KOS_OBJ_ID              this_obj,
+                       KOS_ATOMIC(KOS_OBJ_ID) *args,
+                       uint32_t                num_args)
 {
-    return scan_dir(ctx, this_obj, args_obj, KOS_FIND_FORWARD);
+    return scan_dir(ctx, this_obj, args, num_args, KOS_FIND_FORWARD);
 }
 
 /* @item base string.prototype.rscan()
@@ -4372,11 +4423,12 @@ static const KOS_CONVERT rscan_args[4] = {
     KOS_DEFINE_TAIL_ARG()
 };
 
-static KOS_OBJ_ID rscan(KOS_CONTEXT ctx,
-                        KOS_OBJ_ID  this_obj,
-                        KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID rscan(KOS_CONTEXT             ctx,
+                        KOS_OBJ_ID              this_obj,
+                        KOS_ATOMIC(KOS_OBJ_ID) *args,
+                        uint32_t                num_args)
 {
-    return scan_dir(ctx, this_obj, args_obj, KOS_FIND_REVERSE);
+    return scan_dir(ctx, this_obj, args, num_args, KOS_FIND_REVERSE);
 }
 
 /* @item base string.prototype.code()
@@ -4404,17 +4456,19 @@ static const KOS_CONVERT code_args[2] = {
     KOS_DEFINE_TAIL_ARG()
 };
 
-static KOS_OBJ_ID code(KOS_CONTEXT ctx,
-                       KOS_OBJ_ID  this_obj,
-                       KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID code(KOS_CONTEXT             ctx,
+                       KOS_OBJ_ID              this_obj,
+                       KOS_ATOMIC(KOS_OBJ_ID) *args,
+                       uint32_t                num_args)
 {
     int64_t    idx       = 0;
     KOS_OBJ_ID arg;
     unsigned   char_code = 0;
     int        error     = KOS_SUCCESS;
 
-    arg = KOS_array_read(ctx, args_obj, 0);
-    TRY_OBJID(arg);
+    assert(num_args >= 1);
+
+    arg = KOS_atomic_read_relaxed_obj(args[0]);
 
     TRY(KOS_get_integer(ctx, arg, &idx));
 
@@ -4449,9 +4503,10 @@ cleanup:
  *     ["hello", "world"]
  */
 
-static KOS_OBJ_ID code_points(KOS_CONTEXT ctx,
-                              KOS_OBJ_ID  this_obj,
-                              KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID code_points(KOS_CONTEXT             ctx,
+                              KOS_OBJ_ID              this_obj,
+                              KOS_ATOMIC(KOS_OBJ_ID) *args,
+                              uint32_t                num_args)
 {
     KOS_LOCAL this_;
     KOS_LOCAL ret_array;
@@ -4508,9 +4563,10 @@ cleanup:
  *     > "foobar".starts_with("bar")
  *     false
  */
-static KOS_OBJ_ID starts_with(KOS_CONTEXT ctx,
-                              KOS_OBJ_ID  this_obj,
-                              KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID starts_with(KOS_CONTEXT             ctx,
+                              KOS_OBJ_ID              this_obj,
+                              KOS_ATOMIC(KOS_OBJ_ID) *args,
+                              uint32_t                num_args)
 {
     int        error = KOS_SUCCESS;
     KOS_OBJ_ID arg;
@@ -4518,8 +4574,9 @@ static KOS_OBJ_ID starts_with(KOS_CONTEXT ctx,
     unsigned   this_len;
     unsigned   arg_len;
 
-    arg = KOS_array_read(ctx, args_obj, 0);
-    TRY_OBJID(arg);
+    assert(num_args >= 1);
+
+    arg = KOS_atomic_read_relaxed_obj(args[0]);
 
     if (GET_OBJ_TYPE(this_obj) != OBJ_STRING || GET_OBJ_TYPE(arg) != OBJ_STRING)
         RAISE_EXCEPTION_STR(str_err_not_string);
@@ -4555,9 +4612,10 @@ cleanup:
  *     > "Text 123 stRIng".lowercase()
  *     "text 123 string"
  */
-static KOS_OBJ_ID lowercase(KOS_CONTEXT ctx,
-                            KOS_OBJ_ID  this_obj,
-                            KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID lowercase(KOS_CONTEXT             ctx,
+                            KOS_OBJ_ID              this_obj,
+                            KOS_ATOMIC(KOS_OBJ_ID) *args,
+                            uint32_t                num_args)
 {
     return KOS_string_lowercase(ctx, this_obj);
 }
@@ -4576,9 +4634,10 @@ static KOS_OBJ_ID lowercase(KOS_CONTEXT ctx,
  *     > "Text 123 stRIng".uppercase()
  *     "TEXT 123 STRING"
  */
-static KOS_OBJ_ID uppercase(KOS_CONTEXT ctx,
-                            KOS_OBJ_ID  this_obj,
-                            KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID uppercase(KOS_CONTEXT             ctx,
+                            KOS_OBJ_ID              this_obj,
+                            KOS_ATOMIC(KOS_OBJ_ID) *args,
+                            uint32_t                num_args)
 {
     return KOS_string_uppercase(ctx, this_obj);
 }
@@ -4648,9 +4707,10 @@ static KOS_OBJ_ID get_string_ascii(KOS_CONTEXT ctx,
  *     > "kos".reverse()
  *     "sok"
  */
-static KOS_OBJ_ID reverse(KOS_CONTEXT ctx,
-                          KOS_OBJ_ID  this_obj,
-                          KOS_OBJ_ID  args_obj)
+static KOS_OBJ_ID reverse(KOS_CONTEXT             ctx,
+                          KOS_OBJ_ID              this_obj,
+                          KOS_ATOMIC(KOS_OBJ_ID) *args,
+                          uint32_t                num_args)
 {
     return KOS_string_reverse(ctx, this_obj);
 }
@@ -5183,6 +5243,7 @@ int kos_module_base_init(KOS_CONTEXT ctx, KOS_OBJ_ID module_obj)
     TRY_ADD_FUNCTION( ctx, module.o, "print",     print,     KOS_NULL);
     TRY_ADD_FUNCTION( ctx, module.o, "stringify", stringify, KOS_NULL);
     TRY_ADD_GENERATOR(ctx, module.o, "deep",      deep,      deep_args);
+    TRY_ADD_GENERATOR(ctx, module.o, "range",     kos_range_generator, range_args);
     TRY_ADD_GENERATOR(ctx, module.o, "shallow",   shallow,   deep_args);
 
     TRY_ADD_GLOBAL(   ctx, module.o, "args",      ctx->inst->args);
@@ -5203,62 +5264,62 @@ int kos_module_base_init(KOS_CONTEXT ctx, KOS_OBJ_ID module_obj)
     TRY_CREATE_CONSTRUCTOR(thread,        module.o, KOS_NULL);
     TRY_CREATE_CONSTRUCTOR(module,        module.o, KOS_NULL);
 
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "cas",          array_cas,           array_cas_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "insert_array", insert_array,        insert_array_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "fill",         fill,                fill_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "pop",          pop,                 pop_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "push",         push,                KOS_NULL);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "reserve",      reserve,             reserve_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "resize",       resize,              resize_array_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "slice",        slice,               slice_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "sort",         sort,                sort_args);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(array),     "size",         get_array_size,      KOS_NULL);
-
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(buffer),    "copy_buffer",  copy_buffer,         copy_buffer_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(buffer),    "fill",         fill,                fill_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(buffer),    "pack",         pack,                pack_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(buffer),    "reserve",      reserve,             reserve_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(buffer),    "resize",       resize,              resize_buffer_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(buffer),    "slice",        slice,               slice_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(buffer),    "unpack",       unpack,              unpack_args);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(buffer),    "size",         get_buffer_size,     KOS_NULL);
-
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(exception), "print",        print_exception,     KOS_NULL);
-
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(function),  "apply",        apply,               apply_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(function),  "async",        async,               apply_args);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(function),  "instructions", get_instructions,    KOS_NULL);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(function),  "line",         get_function_line,   KOS_NULL);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(function),  "module",       get_function_module, KOS_NULL);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(function),  "name",         get_function_name,   KOS_NULL);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(function),  "registers",    get_registers,       KOS_NULL);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(function),  "size",         get_code_size,       KOS_NULL);
-
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(generator), "state",        get_gen_state,       KOS_NULL);
-
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(module),    "get",          get_module_global,   module_global_args);
-    TRY_ADD_STATIC_FUNCTION( ctx, module.o, "module",         "load",         module_load,         module_load_args);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(module),    "exports",      get_module_exports,  KOS_NULL);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(module),    "name",         get_module_name,     KOS_NULL);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(module),    "path",         get_module_path,     KOS_NULL);
-
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "ends_with",    ends_with,           ends_with_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "find",         find,                find_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "code",         code,                code_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "code_points",  code_points,         KOS_NULL);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "lowercase",    lowercase,           KOS_NULL);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "repeats",      repeats,             repeats_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "rfind",        rfind,               rfind_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "rscan",        rscan,               rscan_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "reverse",      reverse,             KOS_NULL);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "scan",         scan,                scan_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "slice",        slice,               slice_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "starts_with",  starts_with,         ends_with_args);
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "uppercase",    uppercase,           KOS_NULL);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(string),    "size",         get_string_size,     KOS_NULL);
-    TRY_ADD_MEMBER_PROPERTY( ctx, module.o, PROTO(string),    "ascii",        get_string_ascii,    KOS_NULL);
-
-    TRY_ADD_MEMBER_FUNCTION( ctx, module.o, PROTO(thread),    "wait",         wait,                KOS_NULL);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(array),     "cas",          array_cas,           array_cas_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(array),     "insert_array", insert_array,        insert_array_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(array),     "fill",         fill,                fill_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "pop",          pop,                 pop_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "push",         push,                KOS_NULL);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(array),     "reserve",      reserve,             reserve_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(array),     "resize",       resize,              resize_array_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(array),     "slice",        slice,               slice_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(array),     "sort",         sort,                sort_args);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(array),     "size",         get_array_size,      KOS_NULL);
+
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(buffer),    "copy_buffer",  copy_buffer,         copy_buffer_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(buffer),    "fill",         fill,                fill_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(buffer),    "pack",         pack,                pack_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(buffer),    "reserve",      reserve,             reserve_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(buffer),    "resize",       resize,              resize_buffer_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(buffer),    "slice",        slice,               slice_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(buffer),    "unpack",       unpack,              unpack_args);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(buffer),    "size",         get_buffer_size,     KOS_NULL);
+
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(exception), "print",        print_exception,     KOS_NULL);
+
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(function),  "apply",        apply,               apply_args);
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(function),  "async",        async,               apply_args);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(function),  "instructions", get_instructions,    KOS_NULL);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(function),  "line",         get_function_line,   KOS_NULL);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(function),  "module",       get_function_module, KOS_NULL);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(function),  "name",         get_function_name,   KOS_NULL);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(function),  "registers",    get_registers,       KOS_NULL);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(function),  "size",         get_code_size,       KOS_NULL);
+
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(generator), "state",        get_gen_state,       KOS_NULL);
+
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(module),    "get",          get_module_global,   module_global_args);
+    TRY_ADD_STATIC_FUNCTION(      ctx, module.o, "module",         "load",         module_load,         module_load_args);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(module),    "exports",      get_module_exports,  KOS_NULL);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(module),    "name",         get_module_name,     KOS_NULL);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(module),    "path",         get_module_path,     KOS_NULL);
+
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "ends_with",    ends_with,           ends_with_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "find",         find,                find_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "code",         code,                code_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "code_points",  code_points,         KOS_NULL);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "lowercase",    lowercase,           KOS_NULL);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "repeats",      repeats,             repeats_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "rfind",        rfind,               rfind_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "rscan",        rscan,               rscan_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "reverse",      reverse,             KOS_NULL);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "scan",         scan,                scan_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "slice",        slice,               slice_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "starts_with",  starts_with,         ends_with_args);
+    TRY_ADD_FAST_MEMBER_FUNCTION( ctx, module.o, PROTO(string),    "uppercase",    uppercase,           KOS_NULL);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(string),    "size",         get_string_size,     KOS_NULL);
+    TRY_ADD_MEMBER_PROPERTY(      ctx, module.o, PROTO(string),    "ascii",        get_string_ascii,    KOS_NULL);
+
+    TRY_ADD_MEMBER_FUNCTION(      ctx, module.o, PROTO(thread),    "wait",         wait,                KOS_NULL);
 
 cleanup:
     KOS_destroy_top_local(ctx, &module);
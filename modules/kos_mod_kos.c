@@ -16,6 +16,7 @@
 #include "../inc/kos_string.h"
 #include "../inc/kos_utils.h"
 #include "../inc/kos_version.h"
+#include "../core/kos_disasm.h"
 #include "../core/kos_heap.h"
 #include "../core/kos_lexer.h"
 #include "../core/kos_object_internal.h"
@@ -24,6 +25,7 @@
 
 KOS_DECLARE_STATIC_CONST_STRING(str_base,                     "base");
 KOS_DECLARE_STATIC_CONST_STRING(str_column,                   "column");
+KOS_DECLARE_STATIC_CONST_STRING(str_deoptimized,              "deoptimized");
 KOS_DECLARE_STATIC_CONST_STRING(str_err_bad_ignore_errors,    "`ignore_errors` argument is not a boolean");
 KOS_DECLARE_STATIC_CONST_STRING(str_err_gen_line_not_string,  "data from generator fed to lexer is not a string");
 KOS_DECLARE_STATIC_CONST_STRING(str_err_invalid_arg,          "invalid argument");
@@ -38,6 +40,7 @@ KOS_DECLARE_STATIC_CONST_STRING(str_line,                     "line");
 KOS_DECLARE_STATIC_CONST_STRING(str_lines,                    "lines");
 KOS_DECLARE_STATIC_CONST_STRING(str_name,                     "name");
 KOS_DECLARE_STATIC_CONST_STRING(str_op,                       "op");
+KOS_DECLARE_STATIC_CONST_STRING(str_quickened,                "quickened");
 KOS_DECLARE_STATIC_CONST_STRING(str_script,                   "script");
 KOS_DECLARE_STATIC_CONST_STRING(str_sep,                      "sep");
 KOS_DECLARE_STATIC_CONST_STRING(str_token,                    "token");
@@ -402,8 +405,16 @@ KOS_DECLARE_STATIC_CONST_STRING(str_time_evac_us,           "time_evac_us");
 KOS_DECLARE_STATIC_CONST_STRING(str_time_update_us,         "time_update_us");
 KOS_DECLARE_STATIC_CONST_STRING(str_time_finish_us,         "time_finish_us");
 KOS_DECLARE_STATIC_CONST_STRING(str_time_total_us,          "time_total_us");
-
-static const KOS_CONVERT conv_gc_stats[22] = {
+KOS_DECLARE_STATIC_CONST_STRING(str_num_slices,             "num_slices");
+KOS_DECLARE_STATIC_CONST_STRING(str_time_max_slice_us,      "time_max_slice_us");
+KOS_DECLARE_STATIC_CONST_STRING(str_time_slice_us,          "time_slice_us");
+KOS_DECLARE_STATIC_CONST_STRING(str_num_minor_cycles,       "num_minor_cycles");
+KOS_DECLARE_STATIC_CONST_STRING(str_num_major_cycles,       "num_major_cycles");
+KOS_DECLARE_STATIC_CONST_STRING(str_heap_sizing,            "heap_sizing");
+KOS_DECLARE_STATIC_CONST_STRING(str_gc_threshold,           "gc_threshold");
+KOS_DECLARE_STATIC_CONST_STRING(str_gc_time_percent,        "gc_time_percent");
+
+static const KOS_CONVERT conv_gc_stats[30] = {
     { KOS_CONST_ID(str_num_objs_evacuated),     KOS_BADPTR, offsetof(KOS_GC_STATS, num_objs_evacuated),     0, KOS_NATIVE_UINT32 },
     { KOS_CONST_ID(str_num_objs_freed),         KOS_BADPTR, offsetof(KOS_GC_STATS, num_objs_freed),         0, KOS_NATIVE_UINT32 },
     { KOS_CONST_ID(str_num_objs_finalized),     KOS_BADPTR, offsetof(KOS_GC_STATS, num_objs_finalized),     0, KOS_NATIVE_UINT32 },
@@ -425,6 +436,14 @@ static const KOS_CONVERT conv_gc_stats[22] = {
     { KOS_CONST_ID(str_time_update_us),         KOS_BADPTR, offsetof(KOS_GC_STATS, time_update_us),         0, KOS_NATIVE_UINT32 },
     { KOS_CONST_ID(str_time_finish_us),         KOS_BADPTR, offsetof(KOS_GC_STATS, time_finish_us),         0, KOS_NATIVE_UINT32 },
     { KOS_CONST_ID(str_time_total_us),          KOS_BADPTR, offsetof(KOS_GC_STATS, time_total_us),          0, KOS_NATIVE_UINT32 },
+    { KOS_CONST_ID(str_num_slices),             KOS_BADPTR, offsetof(KOS_GC_STATS, num_slices),             0, KOS_NATIVE_UINT32 },
+    { KOS_CONST_ID(str_time_max_slice_us),      KOS_BADPTR, offsetof(KOS_GC_STATS, time_max_slice_us),      0, KOS_NATIVE_UINT32 },
+    { KOS_CONST_ID(str_time_slice_us),          KOS_BADPTR, offsetof(KOS_GC_STATS, time_slice_us),          KOS_GC_SLICE_BUCKETS * sizeof(unsigned), KOS_NATIVE_UINT32 },
+    { KOS_CONST_ID(str_num_minor_cycles),       KOS_BADPTR, offsetof(KOS_GC_STATS, num_minor_cycles),       0, KOS_NATIVE_UINT32 },
+    { KOS_CONST_ID(str_num_major_cycles),       KOS_BADPTR, offsetof(KOS_GC_STATS, num_major_cycles),       0, KOS_NATIVE_UINT32 },
+    { KOS_CONST_ID(str_heap_sizing),            KOS_BADPTR, offsetof(KOS_GC_STATS, heap_sizing),            0, KOS_NATIVE_UINT32 },
+    { KOS_CONST_ID(str_gc_threshold),           KOS_BADPTR, offsetof(KOS_GC_STATS, gc_threshold),           0, KOS_NATIVE_UINT32 },
+    { KOS_CONST_ID(str_gc_time_percent),        KOS_BADPTR, offsetof(KOS_GC_STATS, gc_time_percent),        0, KOS_NATIVE_UINT32 },
     KOS_DEFINE_TAIL_ARG()
 };
 
@@ -564,6 +583,66 @@ cleanup:
     return error ? KOS_BADPTR : ret;
 }
 
+/* @item kos quicken_stats()
+ *
+ *     quicken_stats()
+ *
+ * Returns an object containing statistics of instruction quickening.
+ *
+ * The interpreter rewrites generic instructions, such as `ADD`, to variants
+ * specialized for the operand types it encounters, such as `ADD.SMALLINT`.
+ * When the operand types change, the specialized instruction is rewritten
+ * back to the generic one, i.e. deoptimized.
+ *
+ * The returned object has a property for every specialized instruction.
+ * Each property is an object with `quickened` and `deoptimized` properties,
+ * containing the number of times the instruction has been quickened and
+ * deoptimized, respectively, in the current instance.
+ *
+ * Example:
+ *
+ *     > kos.quicken_stats()["CMP.LT.SMALLINT"]
+ *     {"quickened": 3, "deoptimized": 0}
+ */
+static KOS_OBJ_ID quicken_stats(KOS_CONTEXT ctx,
+                                KOS_OBJ_ID  this_obj,
+                                KOS_OBJ_ID  args_obj)
+{
+    KOS_INSTANCE *const inst  = ctx->inst;
+    int                 error = KOS_SUCCESS;
+    int                 i;
+    KOS_LOCAL           stats;
+    KOS_LOCAL           name;
+    KOS_LOCAL           out;
+
+    KOS_init_locals(ctx, &stats, &name, &out, kos_end_locals);
+
+    out.o = KOS_new_object(ctx);
+    TRY_OBJID(out.o);
+
+    for (i = 0; i < KOS_NUM_QUICK_INSTRS; i++) {
+        const char *const cname = kos_get_instr_name((KOS_BYTECODE_INSTR)(KOS_FIRST_QUICK_INSTR + i));
+        const uint32_t    num_quickened   = KOS_atomic_read_relaxed_u32(inst->quicken.num_quickened[i]);
+        const uint32_t    num_deoptimized = KOS_atomic_read_relaxed_u32(inst->quicken.num_deoptimized[i]);
+
+        name.o = KOS_new_cstring(ctx, cname);
+        TRY_OBJID(name.o);
+
+        stats.o = KOS_new_object(ctx);
+        TRY_OBJID(stats.o);
+
+        TRY(KOS_set_property(ctx, stats.o, KOS_CONST_ID(str_quickened),   TO_SMALL_INT((intptr_t)num_quickened)));
+        TRY(KOS_set_property(ctx, stats.o, KOS_CONST_ID(str_deoptimized), TO_SMALL_INT((intptr_t)num_deoptimized)));
+
+        TRY(KOS_set_property(ctx, out.o, name.o, stats.o));
+    }
+
+cleanup:
+    out.o = KOS_destroy_top_locals(ctx, &stats, &out);
+
+    return error ? KOS_BADPTR : out.o;
+}
+
 /* @item kos search_paths()
  *
  *     search_paths()
@@ -602,6 +681,7 @@ int kos_module_kos_init(KOS_CONTEXT ctx, KOS_OBJ_ID module_obj)
 
     TRY_ADD_FUNCTION(        ctx, module.o, "collect_garbage",      collect_garbage, KOS_NULL);
     TRY_ADD_FUNCTION(        ctx, module.o, "execute",              execute,         execute_args);
+    TRY_ADD_FUNCTION(        ctx, module.o, "quicken_stats",        quicken_stats,   KOS_NULL);
     TRY_ADD_FUNCTION(        ctx, module.o, "search_paths",         search_paths,    KOS_NULL);
     TRY_ADD_GENERATOR(       ctx, module.o, "raw_lexer",            raw_lexer,       raw_lexer_args);
 
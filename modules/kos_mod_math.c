@@ -228,7 +228,7 @@ static KOS_OBJ_ID kos_ceil(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            ret = KOS_new_float(ctx, ceil(OBJPTR(FLOAT, arg)->value));
+            ret = KOS_new_float(ctx, ceil(KOS_get_float(arg)));
             break;
 
         default:
@@ -389,7 +389,7 @@ static KOS_OBJ_ID kos_floor(KOS_CONTEXT ctx,
             break;
 
         case OBJ_FLOAT:
-            ret = KOS_new_float(ctx, floor(OBJPTR(FLOAT, arg)->value));
+            ret = KOS_new_float(ctx, floor(KOS_get_float(arg)));
             break;
 
         default:
@@ -565,7 +565,7 @@ static KOS_OBJ_ID kos_is_infinity(KOS_CONTEXT ctx,
 
         KOS_NUMERIC_VALUE value;
 
-        value.d = OBJPTR(FLOAT, arg)->value;
+        value.d = KOS_get_float(arg);
         ret     = KOS_BOOL(((value.i >> 52) & 0x7FF) == 0x7FF && ! ((uint64_t)value.i << 12));
     }
     else
@@ -603,7 +603,7 @@ static KOS_OBJ_ID kos_is_nan(KOS_CONTEXT ctx,
 
         KOS_NUMERIC_VALUE value;
 
-        value.d = OBJPTR(FLOAT, arg)->value;
+        value.d = KOS_get_float(arg);
         ret     = KOS_BOOL(((value.i >> 52) & 0x7FF) == 0x7FF && ((uint64_t)value.i << 12));
     }
     else
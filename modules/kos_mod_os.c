@@ -748,7 +748,14 @@ static int append_to_pid_slot(PID_ARRAY_PTR pids, pid_t pid)
  * so that its state can get cleaned up later. */
 static void release_pid(struct KOS_WAIT_S *wait_info)
 {
-    const pid_t ret_pid = check_pid(wait_info->pid);
+    pid_t ret_pid;
+
+    /* Spawn failed, there is no child.  Note that waitpid() with pid 0 would
+     * reap any child in our process group. */
+    if (wait_info->pid <= 0)
+        return;
+
+    ret_pid = check_pid(wait_info->pid);
 
     if (ret_pid == 0) {
 
@@ -146,11 +146,45 @@ int main(void)
 
         TEST(IS_NUMERIC_OBJ(number));
 
+#ifdef KOS_SMALL_FLOATS
+        TEST(IS_SMALL_FLOAT(number));
+
+        TEST(!kos_is_heap_object(number));
+#else
         TEST(kos_is_heap_object(number));
+#endif
 
         TEST(GET_OBJ_TYPE(number) == OBJ_FLOAT);
 
-        TEST(OBJPTR(FLOAT, number)->value == 1.5);
+        TEST(KOS_get_float(number) == 1.5);
+    }
+
+    /************************************************************************/
+    {
+        static const double values[] = {
+            0.0, 1.0, -1.0, 0.1, -2.75, 3.0e-70, -3.0e-70, 1.0e70, -1.0e70,
+            1.0e-200, -1.0e-200, 1.0e200, -1.0e200, 1.0e-310, 1.7e308, -1.7e308
+        };
+        int i;
+
+        for (i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+            const KOS_OBJ_ID number = KOS_new_float(ctx, values[i]);
+
+            TEST(!IS_BAD_PTR(number));
+            TEST(GET_OBJ_TYPE(number) == OBJ_FLOAT);
+            TEST(KOS_get_float(number) == values[i]);
+        }
+    }
+
+    /************************************************************************/
+    {
+        const KOS_OBJ_ID number = KOS_new_float(ctx, -0.0);
+
+        TEST(!IS_BAD_PTR(number));
+        TEST(GET_OBJ_TYPE(number) == OBJ_FLOAT);
+        TEST(KOS_get_float(number) == 0.0);
+        TEST(1.0 / KOS_get_float(number) < 0.0);
+        TEST(!IS_SMALL_FLOAT(number));
     }
 
     /************************************************************************/
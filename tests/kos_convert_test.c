@@ -898,7 +898,7 @@ int main(void)
         TEST_NO_EXCEPTION();
 
         TEST(GET_OBJ_TYPE(obj) == OBJ_FLOAT);
-        TEST(OBJPTR(FLOAT, obj)->value == 8.5);
+        TEST(KOS_get_float(obj) == 8.5);
     }
 
     /************************************************************************/
@@ -912,7 +912,7 @@ int main(void)
         TEST_NO_EXCEPTION();
 
         TEST(GET_OBJ_TYPE(obj) == OBJ_FLOAT);
-        TEST(OBJPTR(FLOAT, obj)->value == 8.5);
+        TEST(KOS_get_float(obj) == 8.5);
     }
 
     /************************************************************************/
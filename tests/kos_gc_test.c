@@ -15,6 +15,7 @@
 #include "../core/kos_math.h"
 #include "../core/kos_misc.h"
 #include "../core/kos_object_internal.h"
+#include "../core/kos_threads_internal.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -37,6 +38,9 @@ typedef struct OBJECT_DESC_S {
 
 #define REMAINING_SIZE 0xDEAD0000U
 
+/* Number of objects in a mark group in kos_heap.c */
+#define MARK_GROUP_SIZE 62U
+
 static int alloc_page_with_objects(KOS_CONTEXT        ctx,
                                    KOS_OBJ_ID        *dest,
                                    const OBJECT_DESC *descs,
@@ -670,6 +674,102 @@ static KOS_OBJ_ID alloc_object(KOS_CONTEXT  ctx,
     return obj_id[0];
 }
 
+static int verify_shaped_obj(KOS_OBJ_ID obj_id)
+{
+    KOS_OBJ_ID v;
+    KOS_OBJ_ID shape;
+    KOS_OBJ_ID key;
+    uint32_t   i;
+
+    TEST(GET_OBJ_TYPE(obj_id) == OBJ_OBJECT);
+
+    TEST(IS_BAD_PTR(OBJPTR(OBJECT, obj_id)->prototype));
+
+    v = KOS_atomic_read_relaxed_obj(OBJPTR(OBJECT, obj_id)->props);
+    TEST( ! IS_BAD_PTR(v));
+    TEST(GET_OBJ_TYPE(v) == OBJ_SHAPED_STORAGE);
+    TEST(KOS_atomic_read_relaxed_u32(OBJPTR(SHAPED_STORAGE, v)->capacity)       == 4);
+    TEST(KOS_atomic_read_relaxed_u32(OBJPTR(SHAPED_STORAGE, v)->num_slots_open) == 4);
+    TEST(KOS_atomic_read_relaxed_u32(OBJPTR(SHAPED_STORAGE, v)->active_copies)  == 0);
+    TEST(IS_BAD_PTR(KOS_atomic_read_relaxed_obj(OBJPTR(SHAPED_STORAGE, v)->new_prop_table)));
+
+    shape = KOS_atomic_read_relaxed_obj(OBJPTR(SHAPED_STORAGE, v)->shape);
+    TEST( ! IS_BAD_PTR(shape));
+    TEST(GET_OBJ_TYPE(shape) == OBJ_SHAPE);
+    TEST(OBJPTR(SHAPE, shape)->num_props == 1);
+    TEST(IS_BAD_PTR(KOS_atomic_read_relaxed_obj(OBJPTR(SHAPE, shape)->transitions)));
+    TEST(KOS_SHAPE_HASHES(OBJPTR(SHAPE, shape))[0] == 0x1234U);
+
+    key = OBJPTR(SHAPE, shape)->keys[0];
+    TEST( ! IS_BAD_PTR(key));
+    TEST(GET_OBJ_TYPE(key) == OBJ_STRING);
+    TEST(OBJPTR(STRING, key)->header.flags == KOS_STRING_LOCAL);
+    TEST(OBJPTR(STRING, key)->header.length == (uint16_t)(sizeof(string_local_test) - 1));
+    TEST(memcmp(&OBJPTR(STRING, key)->local.data[0], string_local_test, sizeof(string_local_test) - 1) == 0);
+
+    for (i = 0; i < 4; i++) {
+        const KOS_OBJ_ID value = KOS_atomic_read_relaxed_obj(OBJPTR(SHAPED_STORAGE, v)->values[i]);
+
+        if (i == 0) {
+            TEST( ! IS_BAD_PTR(value));
+            TEST(GET_OBJ_TYPE(value) == OBJ_INTEGER);
+            TEST(OBJPTR(INTEGER, value)->value == 47);
+        }
+        else
+            TEST(IS_BAD_PTR(value));
+    }
+    return 0;
+}
+
+static KOS_OBJ_ID alloc_shaped_obj(KOS_CONTEXT  ctx,
+                                   uint32_t    *num_objs,
+                                   uint32_t    *total_size,
+                                   VERIFY_FUNC *verify)
+{
+    uint32_t    i;
+    KOS_OBJ_ID  obj_id[5];
+    OBJECT_DESC desc[5] = {
+        { OBJ_OBJECT,         (uint32_t)sizeof(KOS_OBJECT) },
+        { OBJ_SHAPED_STORAGE, (uint32_t)(sizeof(KOS_SHAPED_STORAGE) + sizeof(KOS_OBJ_ID) * 3) },
+        { OBJ_SHAPE,          (uint32_t)(sizeof(KOS_SHAPE) + sizeof(uint32_t)) },
+        { OBJ_INTEGER,        (uint32_t)sizeof(KOS_INTEGER) },
+        { OBJ_STRING,         (uint32_t)sizeof(struct KOS_STRING_LOCAL_S) }
+    };
+
+    if (alloc_page_with_objects(ctx, obj_id, desc, NELEMS(obj_id)))
+        return KOS_BADPTR;
+
+    kos_init_object(OBJPTR(OBJECT, obj_id[0]), KOS_BADPTR);
+    KOS_atomic_write_relaxed_ptr(OBJPTR(OBJECT, obj_id[0])->props, obj_id[1]);
+
+    KOS_atomic_write_relaxed_u32(OBJPTR(SHAPED_STORAGE, obj_id[1])->capacity,       4);
+    KOS_atomic_write_relaxed_u32(OBJPTR(SHAPED_STORAGE, obj_id[1])->num_slots_open, 4);
+    KOS_atomic_write_relaxed_u32(OBJPTR(SHAPED_STORAGE, obj_id[1])->active_copies,  0);
+    KOS_atomic_write_relaxed_ptr(OBJPTR(SHAPED_STORAGE, obj_id[1])->shape,          obj_id[2]);
+    KOS_atomic_write_relaxed_ptr(OBJPTR(SHAPED_STORAGE, obj_id[1])->new_prop_table, KOS_BADPTR);
+
+    for (i = 0; i < 4; i++)
+        KOS_atomic_write_relaxed_ptr(OBJPTR(SHAPED_STORAGE, obj_id[1])->values[i],
+                                     i ? KOS_BADPTR : obj_id[3]);
+
+    OBJPTR(SHAPE, obj_id[2])->num_props = 1;
+    OBJPTR(SHAPE, obj_id[2])->keys[0]   = obj_id[4];
+    KOS_atomic_write_relaxed_ptr(OBJPTR(SHAPE, obj_id[2])->transitions, KOS_BADPTR);
+    KOS_SHAPE_HASHES(OBJPTR(SHAPE, obj_id[2]))[0] = 0x1234U;
+
+    OBJPTR(INTEGER, obj_id[3])->value = 47;
+
+    OBJPTR(STRING, obj_id[4])->header.flags  = KOS_STRING_LOCAL;
+    OBJPTR(STRING, obj_id[4])->header.length = (uint16_t)(sizeof(string_local_test) - 1);
+    memcpy(&OBJPTR(STRING, obj_id[4])->local.data[0], string_local_test, sizeof(string_local_test) - 1);
+
+    *num_objs   = NELEMS(obj_id);
+    *total_size = get_obj_sizes(obj_id, NELEMS(obj_id));
+    *verify     = &verify_shaped_obj;
+
+    return obj_id[0];
+}
+
 static int verify_finalize(KOS_OBJ_ID obj_id)
 {
     TEST(GET_OBJ_TYPE(obj_id) == OBJ_OBJECT);
@@ -1534,6 +1634,76 @@ static KOS_OBJ_ID alloc_ballast(KOS_CONTEXT ctx,
     return KOS_destroy_top_local(ctx, &obj);
 }
 
+/* Creates two arrays, fills the first one with integers and promotes
+ * the arrays and their contents to the old generation */
+static int init_old_arrays(KOS_CONTEXT   ctx,
+                           KOS_LOCAL    *src,
+                           KOS_LOCAL    *dst,
+                           uint32_t      num_objs,
+                           KOS_GC_STATS *stats)
+{
+    uint32_t i;
+
+    KOS_init_local_with(ctx, src, KOS_new_array(ctx, num_objs));
+    TEST( ! IS_BAD_PTR(src->o));
+
+    KOS_init_local_with(ctx, dst, KOS_new_array(ctx, num_objs));
+    TEST( ! IS_BAD_PTR(dst->o));
+
+    for (i = 0; i < num_objs; i++) {
+        KOS_INTEGER *const value = (KOS_INTEGER *)kos_alloc_object(ctx,
+                                                                   KOS_ALLOC_MOVABLE,
+                                                                   OBJ_INTEGER,
+                                                                   sizeof(KOS_INTEGER));
+        TEST(value);
+        value->value = i;
+
+        TEST(KOS_array_write(ctx, src->o, (int)i, OBJID(INTEGER, value)) == KOS_SUCCESS);
+    }
+
+    TEST(KOS_collect_garbage(ctx, stats) == KOS_SUCCESS);
+
+    return KOS_SUCCESS;
+}
+
+static int verify_moved_objects(KOS_CONTEXT ctx,
+                                KOS_OBJ_ID  array,
+                                uint32_t    num_objs)
+{
+    uint32_t i;
+
+    for (i = 0; i < num_objs; i++) {
+        const KOS_OBJ_ID value = KOS_array_read(ctx, array, (int)i);
+
+        TEST(GET_OBJ_TYPE(value) == OBJ_INTEGER);
+        TEST(OBJPTR(INTEGER, value)->value == (int64_t)i);
+    }
+
+    return KOS_SUCCESS;
+}
+
+/* Begins marking on the next page allocation */
+static int start_marking(KOS_CONTEXT ctx)
+{
+    ctx->inst->heap.gc_threshold = 0U;
+    TEST(kos_alloc_object_page(ctx, OBJ_OPAQUE));
+    TEST(KOS_atomic_read_relaxed_u32(ctx->inst->heap.concurrent_mark) != CONCURRENT_IDLE);
+
+    return KOS_SUCCESS;
+}
+
+/* Returns the heap page holding array storage or the tracker of huge storage,
+ * this is the page which the write barrier marks as dirty */
+static KOS_PAGE *get_storage_page(KOS_OBJ_ID array)
+{
+    KOS_OBJ_ID obj_id = OBJPTR(ARRAY, array)->data;
+
+    if ( ! kos_is_heap_object(obj_id))
+        obj_id = *(KOS_OBJ_ID *)((intptr_t)obj_id - 1 - sizeof(KOS_OBJ_ID));
+
+    return (KOS_PAGE *)((uintptr_t)obj_id & ~(uintptr_t)(KOS_PAGE_SIZE - 1));
+}
+
 #ifndef CONFIG_MAD_GC
 static uint32_t off_heap_array_size(KOS_OBJ_ID obj_id)
 {
@@ -1610,6 +1780,7 @@ int main(void)
         TEST(test_object(alloc_ext_buffer,   inst_flags, &base_stats) == KOS_SUCCESS);
         TEST(test_object(alloc_empty_object, inst_flags, &base_stats) == KOS_SUCCESS);
         TEST(test_object(alloc_object,       inst_flags, &base_stats) == KOS_SUCCESS);
+        TEST(test_object(alloc_shaped_obj,   inst_flags, &base_stats) == KOS_SUCCESS);
         TEST(test_object(alloc_finalize,     inst_flags, &base_stats) == KOS_SUCCESS);
         TEST(test_object(alloc_function,     inst_flags, &base_stats) == KOS_SUCCESS);
         TEST(test_object(alloc_class,        inst_flags, &base_stats) == KOS_SUCCESS);
@@ -1701,6 +1872,446 @@ int main(void)
         KOS_instance_destroy(&inst);
     }
 
+    /************************************************************************/
+    /* Test minor collection of objects referenced from old objects */
+    {
+        KOS_GC_STATS stats = KOS_GC_STATS_INIT(~0U);
+        unsigned     num_major_cycles;
+        KOS_LOCAL    array;
+        KOS_LOCAL    obj;
+        KOS_OBJ_ID   obj_id[3];
+        OBJECT_DESC  desc[3] = {
+            /* Unreachable object, large enough for the page to be evacuated */
+            { OBJ_OPAQUE,  MIN_GC_SIZE         },
+            { OBJ_INTEGER, sizeof(KOS_INTEGER) },
+            { OBJ_FLOAT,   sizeof(KOS_FLOAT)   }
+        };
+
+        KOS_DECLARE_STATIC_CONST_STRING(str_value, "value");
+
+        TEST(KOS_instance_init(&inst, inst_flags, &ctx) == KOS_SUCCESS);
+
+        KOS_init_local_with(ctx, &array, KOS_new_array(ctx, 1));
+        TEST( ! IS_BAD_PTR(array.o));
+
+        KOS_init_local_with(ctx, &obj, KOS_new_object(ctx));
+        TEST( ! IS_BAD_PTR(obj.o));
+
+        /* Promote the array and the object to the old generation */
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        num_major_cycles = stats.num_major_cycles;
+        TEST(num_major_cycles       >= 1U);
+        TEST(stats.num_minor_cycles == 0U);
+
+        /* Store young objects in the old ones, write barrier tracks them */
+        TEST(alloc_page_with_objects(ctx, obj_id, desc, NELEMS(desc)) == KOS_SUCCESS);
+
+        OBJPTR(INTEGER, obj_id[1])->value = 42;
+        OBJPTR(FLOAT,   obj_id[2])->value = 42.0;
+
+        TEST(KOS_array_write(ctx, array.o, 0, obj_id[1]) == KOS_SUCCESS);
+        TEST(KOS_set_property(ctx, obj.o, KOS_CONST_ID(str_value), obj_id[2]) == KOS_SUCCESS);
+
+        TEST(KOS_collect_young_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        TEST(stats.num_minor_cycles == 1U);
+        TEST(stats.num_major_cycles == num_major_cycles);
+#ifndef CONFIG_MAD_GC
+        TEST(stats.num_objs_evacuated >= 2U);
+        TEST(stats.num_objs_freed     >= 1U);
+#endif
+
+        TEST(verify_integer(KOS_array_read(ctx, array.o, 0)) == KOS_SUCCESS);
+        TEST(verify_float(KOS_get_property(ctx, obj.o, KOS_CONST_ID(str_value))) == KOS_SUCCESS);
+
+        /* Survivors are old now, nothing left to evacuate */
+        TEST(KOS_collect_young_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        TEST(stats.num_minor_cycles == 2U);
+        TEST(stats.num_major_cycles == num_major_cycles);
+#ifndef CONFIG_MAD_GC
+        TEST(stats.num_objs_evacuated == 0U);
+        TEST(stats.num_pages_kept     == 0U);
+#endif
+
+        TEST(verify_integer(KOS_array_read(ctx, array.o, 0)) == KOS_SUCCESS);
+        TEST(verify_float(KOS_get_property(ctx, obj.o, KOS_CONST_ID(str_value))) == KOS_SUCCESS);
+
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        TEST(stats.num_minor_cycles == 2U);
+        TEST(stats.num_major_cycles == num_major_cycles + 1U);
+
+        KOS_destroy_top_locals(ctx, &obj, &array);
+
+        KOS_instance_destroy(&inst);
+    }
+
+    /************************************************************************/
+    /* Test concurrent marking while objects are moved between old arrays */
+    {
+        KOS_GC_STATS   stats    = KOS_GC_STATS_INIT(~0U);
+        const uint32_t num_objs = 1024U;
+        KOS_OBJ_ID     objs[1024];
+        KOS_PAGE      *page;
+        unsigned       num_major_cycles;
+        uint32_t       i;
+        KOS_LOCAL      src;
+        KOS_LOCAL      dst;
+
+        TEST(KOS_instance_init(&inst, KOS_INST_CONCURRENT_GC, &ctx) == KOS_SUCCESS);
+
+        TEST(init_old_arrays(ctx, &src, &dst, num_objs, &stats) == KOS_SUCCESS);
+
+        num_major_cycles = stats.num_major_cycles;
+
+        /* Keep the objects only in a C array, like a mutator holding them
+         * in registers.  Marking does not find them, because the source
+         * array becomes garbage. */
+        for (i = 0; i < num_objs; i++) {
+            objs[i] = KOS_array_read(ctx, src.o, (int)i);
+            TEST(GET_OBJ_TYPE(objs[i]) == OBJ_INTEGER);
+        }
+        src.o = KOS_VOID;
+
+        page = get_storage_page(dst.o);
+        TEST(KOS_atomic_read_relaxed_u32(page->flags) & KOS_PAGE_OLD);
+        TEST( ! (KOS_atomic_read_relaxed_u32(page->flags) & KOS_PAGE_DIRTY));
+
+        TEST(start_marking(ctx) == KOS_SUCCESS);
+        TEST(inst.heap.mark_thread);
+
+        /* Wait until the destination array has been scanned in the background */
+        kos_lock_mutex(inst.heap.mutex);
+
+        while (KOS_atomic_read_relaxed_u32(inst.heap.concurrent_mark) == CONCURRENT_ACTIVE)
+            kos_wait_cond_var(inst.heap.mark_cond, inst.heap.mutex);
+
+        kos_unlock_mutex(inst.heap.mutex);
+
+        TEST(KOS_atomic_read_relaxed_u32(inst.heap.concurrent_mark) == CONCURRENT_DONE);
+        TEST( ! (KOS_atomic_read_relaxed_u32(page->flags) & KOS_PAGE_DIRTY));
+
+        /* Store unmarked objects in the already marked array, write barrier
+         * makes remark scan the array again and find them */
+        for (i = 0; i < num_objs; i++)
+            TEST(KOS_array_write(ctx, dst.o, (int)i, objs[i]) == KOS_SUCCESS);
+
+        TEST(KOS_atomic_read_relaxed_u32(page->flags) & KOS_PAGE_DIRTY);
+
+        /* Remark and evacuate */
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        TEST(stats.num_major_cycles == num_major_cycles + 1U);
+        TEST(KOS_atomic_read_relaxed_u32(inst.heap.concurrent_mark) == CONCURRENT_IDLE);
+
+        TEST(verify_moved_objects(ctx, dst.o, num_objs) == KOS_SUCCESS);
+
+        /* Instance can be destroyed while marking in the background */
+        TEST(start_marking(ctx) == KOS_SUCCESS);
+
+        KOS_destroy_top_locals(ctx, &dst, &src);
+
+        KOS_instance_destroy(&inst);
+    }
+
+    /************************************************************************/
+    /* Test incremental marking in slices triggered by page allocations */
+    {
+        KOS_GC_STATS   stats      = KOS_GC_STATS_INIT(~0U);
+        const uint32_t num_objs   = 1024U;
+        unsigned       num_slices = 0U;
+        unsigned       num_allocs = 0U;
+        uint32_t       i;
+        KOS_LOCAL      src;
+        KOS_LOCAL      dst;
+
+        TEST(KOS_instance_init(&inst, 0U, &ctx) == KOS_SUCCESS);
+
+        /* Every group of integers exceeds the budget, so each slice marks
+         * at most one group of them */
+        KOS_instance_set_gc_budget(&inst, 0U, 64U);
+
+        TEST(init_old_arrays(ctx, &src, &dst, num_objs, &stats) == KOS_SUCCESS);
+
+        TEST(stats.num_slices >= 1U);
+        TEST(stats.time_max_slice_us >= stats.time_total_us);
+
+        /* Roots are marked in the first slice, when marking begins */
+        TEST(start_marking(ctx) == KOS_SUCCESS);
+        TEST( ! inst.heap.mark_thread);
+        TEST(inst.heap.num_slices == 1U);
+
+        /* Each page allocation performs one slice until marking is done */
+        while (KOS_atomic_read_relaxed_u32(inst.heap.concurrent_mark) == CONCURRENT_ACTIVE) {
+            TEST(num_allocs < num_objs);
+            TEST(kos_alloc_object_page(ctx, OBJ_OPAQUE));
+            ++num_allocs;
+        }
+
+        TEST(KOS_atomic_read_relaxed_u32(inst.heap.concurrent_mark) == CONCURRENT_DONE);
+        TEST(inst.heap.num_slices == 1U + num_allocs);
+        TEST(num_allocs >= num_objs / MARK_GROUP_SIZE);
+
+        /* Remark and evacuate in the final pause */
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        TEST(KOS_atomic_read_relaxed_u32(inst.heap.concurrent_mark) == CONCURRENT_IDLE);
+        TEST(stats.num_slices == 2U + num_allocs);
+        TEST(stats.time_max_slice_us >= stats.time_total_us);
+
+        for (i = 0; i < KOS_GC_SLICE_BUCKETS; i++)
+            num_slices += stats.time_slice_us[i];
+        TEST(num_slices == stats.num_slices);
+
+        TEST(verify_moved_objects(ctx, src.o, num_objs) == KOS_SUCCESS);
+
+        /* Move objects between arrays while slices are performed */
+        TEST(start_marking(ctx) == KOS_SUCCESS);
+        TEST(kos_alloc_object_page(ctx, OBJ_OPAQUE));
+        TEST(KOS_atomic_read_relaxed_u32(inst.heap.concurrent_mark) == CONCURRENT_ACTIVE);
+
+        for (i = 0; i < num_objs; i++) {
+            const KOS_OBJ_ID value = KOS_array_read(ctx, src.o, (int)i);
+
+            TEST( ! IS_BAD_PTR(value));
+            TEST(KOS_array_write(ctx, dst.o, (int)i, value) == KOS_SUCCESS);
+            TEST(KOS_array_write(ctx, src.o, (int)i, KOS_VOID) == KOS_SUCCESS);
+
+            if ((i % MARK_GROUP_SIZE) == 0U)
+                TEST(kos_alloc_object_page(ctx, OBJ_OPAQUE));
+        }
+
+        /* Mark remaining objects, remark and evacuate */
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        TEST(KOS_atomic_read_relaxed_u32(inst.heap.concurrent_mark) == CONCURRENT_IDLE);
+        TEST(stats.num_slices > 2U);
+
+        TEST(verify_moved_objects(ctx, dst.o, num_objs) == KOS_SUCCESS);
+
+        /* Without a tight budget, marking finishes in a single slice */
+        KOS_instance_set_gc_budget(&inst, 0U, 0x7FFFFFFFU);
+
+        TEST(start_marking(ctx) == KOS_SUCCESS);
+        TEST(kos_alloc_object_page(ctx, OBJ_OPAQUE));
+        TEST(KOS_atomic_read_relaxed_u32(inst.heap.concurrent_mark) == CONCURRENT_DONE);
+        TEST(inst.heap.num_slices == 2U);
+
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        TEST(stats.num_slices == 3U);
+
+        TEST(verify_moved_objects(ctx, dst.o, num_objs) == KOS_SUCCESS);
+
+        KOS_destroy_top_locals(ctx, &dst, &src);
+
+        KOS_instance_destroy(&inst);
+    }
+
+    /************************************************************************/
+    /* Test marking, evacuation and pointer update by dedicated GC threads */
+    {
+        KOS_GC_STATS   stats     = KOS_GC_STATS_INIT(~0U);
+        const uint32_t num_objs  = 4096U;
+        int            finalized = 0;
+        uint32_t       i;
+        KOS_LOCAL      array;
+        KOS_LOCAL      elem;
+
+        TEST(KOS_instance_init(&inst, inst_flags, &ctx) == KOS_SUCCESS);
+
+        TEST(KOS_instance_set_gc_workers(&inst, 4U) == KOS_SUCCESS);
+        TEST(inst.heap.num_gc_workers == 4U);
+
+        KOS_init_local_with(ctx, &array, KOS_new_array(ctx, num_objs));
+        TEST( ! IS_BAD_PTR(array.o));
+
+        KOS_init_local(ctx, &elem);
+
+        /* Each element is an array holding an integer */
+        for (i = 0; i < num_objs; i++) {
+            KOS_INTEGER *value;
+
+            elem.o = KOS_new_array(ctx, 1);
+            TEST( ! IS_BAD_PTR(elem.o));
+
+            value = (KOS_INTEGER *)kos_alloc_object(ctx, KOS_ALLOC_MOVABLE, OBJ_INTEGER, sizeof(KOS_INTEGER));
+            TEST(value);
+            value->value = i;
+
+            TEST(KOS_array_write(ctx, elem.o, 0, OBJID(INTEGER, value)) == KOS_SUCCESS);
+            TEST(KOS_array_write(ctx, array.o, (int)i, elem.o) == KOS_SUCCESS);
+        }
+
+        /* Unreachable object finalized on any thread */
+        elem.o = KOS_new_object_with_private(ctx, KOS_VOID, &priv_class_47, finalize_47);
+        TEST( ! IS_BAD_PTR(elem.o));
+        KOS_object_set_private_ptr(elem.o, &finalized);
+        elem.o = KOS_VOID;
+
+        /* Half of the elements become garbage */
+        for (i = 0; i < num_objs; i += 2)
+            TEST(KOS_array_write(ctx, array.o, (int)i, KOS_VOID) == KOS_SUCCESS);
+
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        TEST(finalized == 47);
+        TEST(stats.num_objs_finalized >= 1U);
+        TEST(stats.num_objs_freed     >= num_objs);
+#ifndef CONFIG_MAD_GC
+        TEST(stats.num_objs_evacuated >= num_objs);
+#endif
+
+        for (i = 0; i < num_objs; i++) {
+            const KOS_OBJ_ID value = KOS_array_read(ctx, array.o, (int)i);
+
+            if (i & 1U) {
+                KOS_OBJ_ID int_id;
+
+                TEST(GET_OBJ_TYPE(value) == OBJ_ARRAY);
+
+                int_id = KOS_array_read(ctx, value, 0);
+                TEST(GET_OBJ_TYPE(int_id) == OBJ_INTEGER);
+                TEST(OBJPTR(INTEGER, int_id)->value == (int64_t)i);
+            }
+            else
+                TEST(value == KOS_VOID);
+        }
+
+        /* Minor GC only moves young objects */
+        for (i = 0; i < num_objs; i += 2) {
+            elem.o = KOS_new_array(ctx, 1);
+            TEST( ! IS_BAD_PTR(elem.o));
+
+            TEST(KOS_array_write(ctx, elem.o, 0, TO_SMALL_INT((int)i)) == KOS_SUCCESS);
+            TEST(KOS_array_write(ctx, array.o, (int)i, elem.o) == KOS_SUCCESS);
+        }
+
+        TEST(KOS_collect_young_garbage(ctx, &stats) == KOS_SUCCESS);
+        TEST(stats.num_minor_cycles == 1U);
+
+        /* Stop the workers */
+        TEST(KOS_instance_set_gc_workers(&inst, 0U) == KOS_SUCCESS);
+        TEST(inst.heap.num_gc_workers == 0U);
+
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+
+        for (i = 0; i < num_objs; i++) {
+            const KOS_OBJ_ID value = KOS_array_read(ctx, array.o, (int)i);
+            KOS_OBJ_ID       int_id;
+
+            TEST(GET_OBJ_TYPE(value) == OBJ_ARRAY);
+
+            int_id = KOS_array_read(ctx, value, 0);
+
+            if (i & 1U) {
+                TEST(GET_OBJ_TYPE(int_id) == OBJ_INTEGER);
+                TEST(OBJPTR(INTEGER, int_id)->value == (int64_t)i);
+            }
+            else
+                TEST(int_id == TO_SMALL_INT((int)i));
+        }
+
+        /* Workers are stopped when the instance is destroyed */
+        TEST(KOS_instance_set_gc_workers(&inst, 2U) == KOS_SUCCESS);
+        TEST(inst.heap.num_gc_workers == 2U);
+
+        KOS_destroy_top_locals(ctx, &elem, &array);
+
+        KOS_instance_destroy(&inst);
+    }
+
+    /************************************************************************/
+    /* Test adaptive heap sizing */
+    {
+        KOS_GC_STATS   stats     = KOS_GC_STATS_INIT(~0U);
+        const uint32_t min_size  = 4U << KOS_PAGE_BITS;
+        const uint32_t max_size  = 16U << KOS_PAGE_BITS;
+        uint32_t       threshold;
+        KOS_LOCAL      array;
+
+        TEST(KOS_instance_init(&inst, inst_flags, &ctx) == KOS_SUCCESS);
+
+        TEST(inst.heap.gc_threshold  == inst.heap.min_heap_size);
+        TEST(inst.heap.soft_max_size <= inst.heap.max_heap_size);
+
+        /* Threshold is moved within the new limits immediately */
+        KOS_instance_set_heap_size(&inst, min_size, min_size, 5U);
+        TEST(inst.heap.gc_threshold == min_size);
+
+        KOS_instance_set_heap_size(&inst, min_size, max_size, 5U);
+        TEST(inst.heap.gc_threshold == min_size);
+
+        KOS_init_local_with(ctx, &array, KOS_new_array(ctx, 16));
+        TEST( ! IS_BAD_PTR(array.o));
+
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+        TEST(stats.gc_threshold    >= min_size);
+        TEST(stats.gc_threshold    <= max_size);
+        TEST(stats.gc_threshold    == inst.heap.gc_threshold);
+        TEST(stats.gc_time_percent <= 100U);
+        TEST(stats.heap_sizing     <= KOS_HEAP_SHRINK);
+
+        /* Threshold never grows if all time can be spent in GC */
+        KOS_instance_set_heap_size(&inst, min_size, max_size, 100U);
+
+        threshold = inst.heap.gc_threshold;
+
+        TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+        TEST(stats.heap_sizing  != KOS_HEAP_GROW);
+        TEST(stats.gc_threshold <= threshold);
+
+        /* Minor GC does not change the threshold */
+        threshold = inst.heap.gc_threshold;
+
+        TEST(KOS_collect_young_garbage(ctx, &stats) == KOS_SUCCESS);
+        TEST(stats.heap_sizing  == KOS_HEAP_KEEP);
+        TEST(stats.gc_threshold == threshold);
+
+#ifndef CONFIG_MAD_GC
+        /* Heap grows beyond the soft limit if live objects don't fit */
+        {
+            const uint32_t num_objs = (3U * KOS_NURSERY_SIZE) / sizeof(KOS_INTEGER);
+            uint32_t       heap_size;
+            uint32_t       i;
+
+            TEST(KOS_array_resize(ctx, array.o, num_objs) == KOS_SUCCESS);
+
+            for (i = 0; i < num_objs; i++) {
+                KOS_INTEGER *const value = (KOS_INTEGER *)kos_alloc_object(ctx,
+                                                                           KOS_ALLOC_MOVABLE,
+                                                                           OBJ_INTEGER,
+                                                                           sizeof(KOS_INTEGER));
+                TEST(value);
+                value->value = i;
+
+                TEST(KOS_array_write(ctx, array.o, (int)i, OBJID(INTEGER, value)) == KOS_SUCCESS);
+            }
+
+            TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+            TEST(stats.heap_sizing    == KOS_HEAP_OVER_LIMIT);
+            TEST(stats.gc_threshold   == inst.heap.max_heap_size);
+            TEST(stats.used_heap_size >  max_size);
+
+            heap_size = stats.heap_size;
+
+            /* Heap shrinks when the objects are gone */
+            TEST(KOS_array_resize(ctx, array.o, 0) == KOS_SUCCESS);
+
+            TEST(KOS_collect_garbage(ctx, &stats) == KOS_SUCCESS);
+            TEST(stats.heap_sizing  == KOS_HEAP_SHRINK);
+            TEST(stats.gc_threshold <= max_size);
+            TEST(stats.heap_size    <  heap_size);
+        }
+#endif
+
+        KOS_destroy_top_local(ctx, &array);
+
+        KOS_instance_destroy(&inst);
+    }
+
     /************************************************************************/
     /* Test local refs, one at a time, destroy all */
     {
@@ -31,9 +31,10 @@ static int iterate_object(KOS_CONTEXT      ctx,
 
         unsigned i;
 
-        /* Find this key and value on the expected list */
+        /* Find this key and value on the expected list.  Keys are compared by
+         * contents, because objects with the same shape share key strings. */
         for (i = 0; i < num_expected; i += 2) {
-            if (KOS_get_walk_key(iter)   == expected[i] &&
+            if ( ! KOS_string_compare(KOS_get_walk_key(iter), expected[i]) &&
                 KOS_get_walk_value(iter) == expected[i + 1])
                 break;
         }
@@ -46,6 +46,7 @@ static const char *const node_types[] = {
     "assignment",
     "multi_assignment",
     "interpolated_string",
+    "inline",
     "left_hand_side",
     "name",
     "name_const",
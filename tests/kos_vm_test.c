@@ -236,6 +236,45 @@ int main(void)
         TEST_NO_EXCEPTION();
     }
 
+    /************************************************************************/
+    /* LOAD.CONST - constant index out of range */
+    {
+        const uint8_t code[] = {
+            INSTR_LOAD_CONST,   0, 5,
+            INSTR_RETURN,       0
+        };
+
+        TEST(run_code(&inst, ctx, &code[0], sizeof(code), 1, 0, 0, 0) == KOS_BADPTR);
+        TEST_EXCEPTION();
+    }
+
+    /************************************************************************/
+    /* GET.PROP8 - constant index out of range */
+    {
+        const uint8_t code[] = {
+            INSTR_NEW_OBJ,      0, 255,
+            INSTR_GET_PROP8,    1, 0, 5,
+            INSTR_RETURN,       1
+        };
+
+        TEST(run_code(&inst, ctx, &code[0], sizeof(code), 2, 0, 0, 0) == KOS_BADPTR);
+        TEST_EXCEPTION();
+    }
+
+    /************************************************************************/
+    /* SET.PROP8 - constant index out of range */
+    {
+        const uint8_t code[] = {
+            INSTR_NEW_OBJ,      0, 255,
+            INSTR_LOAD_INT8,    1, 1,
+            INSTR_SET_PROP8,    0, 5, 1,
+            INSTR_RETURN,       0
+        };
+
+        TEST(run_code(&inst, ctx, &code[0], sizeof(code), 2, 0, 0, 0) == KOS_BADPTR);
+        TEST_EXCEPTION();
+    }
+
     /************************************************************************/
     /* SET, GET.ELEM8 */
     {
@@ -1553,7 +1592,7 @@ int main(void)
             INSTR_NEW_ITER,    0, 0,       /* convert to iterator   */
 
             INSTR_NEXT_JUMP,   1, 0, SIMM8(7), /* generator ends, does not jump */
-            INSTR_NEXT_JUMP,   1, 0, SIMM8(3), /* generator was already ended, throw */
+            INSTR_NEXT_JUMP,   1, 0, SIMM8(3), /* generator was already ended, does not jump */
             INSTR_LOAD_INT8,   1, 42,
             INSTR_RETURN,      1,
 
@@ -1566,8 +1605,8 @@ int main(void)
         opts.this_reg = 0;
         func = create_gen(ctx, &code[0], sizeof(code), 24, &opts);
 
-        TEST(run_code(&inst, ctx, &code[0], sizeof(code), 2, 0, &func, 1) == KOS_BADPTR);
-        TEST_EXCEPTION();
+        TEST(run_code(&inst, ctx, &code[0], sizeof(code), 2, 0, &func, 1) == TO_SMALL_INT(42));
+        TEST_NO_EXCEPTION();
     }
 
     /************************************************************************/
@@ -479,7 +479,7 @@ static int test_instr(KOS_CONTEXT           ctx,
                 error = KOS_ERROR_EXCEPTION;
             }
             else {
-                uint64_t value = kos_double_to_uint64_t(OBJPTR(FLOAT, ret)->value);
+                uint64_t value = kos_double_to_uint64_t(KOS_get_float(ret));
                 if ((uint32_t)(value >> 32) != ret_val->high ||
                     (uint32_t)value         != ret_val->low) {
 